@@ -1,6 +1,7 @@
 // button_task.cpp
 
 #include "button_task.hpp"
+#include "event_bus.hpp"
 #include "lcd_task.hpp"
 #include "esp_log.h"
 
@@ -56,6 +57,11 @@ void Button::button_task_loop() {
     while (true) {
         if (xSemaphoreTake(xButtonSignaler, portMAX_DELAY) == pdTRUE) {
             ESP_LOGI(TAG, "BUTTON PRESSED");
+
+            bus_event_t event  = {};
+            event.topic        = EVENT_TOPIC_INPUT;
+            event.input.source = EVENT_INPUT_SOURCE_BUTTON;
+            EventBus::get_instance()->publish(event);
             LCDDisplay::get_instance()->cycle_mode();
         }
     }
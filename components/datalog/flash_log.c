@@ -0,0 +1,276 @@
+// flash_log.c
+
+#include "flash_log.h"
+#include <string.h>
+
+#define FLASH_LOG_VERSION 1
+
+static uint16_t _crc16(const void* data, size_t len) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint16_t crc         = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)bytes[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static uint16_t _header_crc(const flash_log_segment_header_t* header) {
+    return _crc16(header, offsetof(flash_log_segment_header_t, crc));
+}
+
+static uint16_t _record_crc(const flash_log_record_t* record) {
+    return _crc16(record, offsetof(flash_log_record_t, crc));
+}
+
+static size_t _segment_offset(uint32_t segment) {
+    return (size_t)segment * FLASH_LOG_SECTOR_SIZE;
+}
+
+static size_t _record_offset(uint32_t segment, uint32_t record) {
+    return _segment_offset(segment) + sizeof(flash_log_segment_header_t) + record * sizeof(flash_log_record_t);
+}
+
+static bool _read_header(const flash_log_io_t* io, uint32_t segment, flash_log_segment_header_t* header) {
+    if (io->read(io->ctx, _segment_offset(segment), header, sizeof(*header)) != ESP_OK) {
+        return false;
+    }
+    return header->magic == FLASH_LOG_SEGMENT_MAGIC && header->crc == _header_crc(header);
+}
+
+static esp_err_t _start_segment(flash_log_t* log, uint32_t segment, uint32_t sequence) {
+    esp_err_t ret = log->io.erase_sector(log->io.ctx, _segment_offset(segment));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    log->stats.sectors_erased++;
+
+    flash_log_segment_header_t header = {
+        .magic    = FLASH_LOG_SEGMENT_MAGIC,
+        .sequence = sequence,
+        .reserved = FLASH_LOG_ERASED_WORD,
+        .crc      = 0,
+        .version  = FLASH_LOG_VERSION,
+    };
+    header.crc = _header_crc(&header);
+
+    ret = log->io.write(log->io.ctx, _segment_offset(segment), &header, sizeof(header));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    log->stats.bytes_programmed += sizeof(header);
+
+    log->head_segment  = segment;
+    log->head_sequence = sequence;
+    log->head_record   = 0;
+    return ESP_OK;
+}
+
+static esp_err_t _advance_head(flash_log_t* log) {
+    uint32_t next = (log->head_segment + 1) % log->num_segments;
+    if (next == log->tail_segment) {
+        log->tail_segment = (log->tail_segment + 1) % log->num_segments;
+        log->tail_sequence++;
+    }
+    return _start_segment(log, next, log->head_sequence + 1);
+}
+
+static esp_err_t _write_record(flash_log_t* log, const flash_log_record_t* record) {
+    if (log->head_record >= FLASH_LOG_RECORDS_PER_SEGMENT) {
+        esp_err_t ret = _advance_head(log);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    // A failed write is retried into the same slot: reprogramming identical bytes only clears the bits it missed
+    esp_err_t ret =
+        log->io.write(log->io.ctx, _record_offset(log->head_segment, log->head_record), record, sizeof(*record));
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    log->stats.bytes_programmed += sizeof(*record);
+    log->stats.record_writes++;
+    log->head_record++;
+    return ESP_OK;
+}
+
+static uint32_t _find_first_free_record(flash_log_t* log, uint32_t segment) {
+    uint32_t low  = 0;
+    uint32_t high = FLASH_LOG_RECORDS_PER_SEGMENT;
+
+    while (low < high) {
+        uint32_t mid       = low + (high - low) / 2;
+        uint32_t timestamp = 0;
+        log->stats.recovery_reads++;
+        if (log->io.read(log->io.ctx, _record_offset(segment, mid), &timestamp, sizeof(timestamp)) != ESP_OK) {
+            return FLASH_LOG_RECORDS_PER_SEGMENT;
+        }
+        if (timestamp == FLASH_LOG_ERASED_WORD) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+static bool _record_erased(flash_log_t* log, uint32_t segment, uint32_t record) {
+    uint8_t bytes[sizeof(flash_log_record_t)];
+    log->stats.recovery_reads++;
+    if (log->io.read(log->io.ctx, _record_offset(segment, record), bytes, sizeof(bytes)) != ESP_OK) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(bytes); i++) {
+        if (bytes[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+esp_err_t flash_log_open(flash_log_t* log, const flash_log_io_t* io) {
+    memset(log, 0, sizeof(*log));
+    log->io           = *io;
+    log->num_segments = io->size / FLASH_LOG_SECTOR_SIZE;
+
+    if (log->num_segments < 2) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    bool found = false;
+    for (uint32_t segment = 0; segment < log->num_segments; segment++) {
+        flash_log_segment_header_t header;
+        log->stats.recovery_reads++;
+        if (!_read_header(io, segment, &header)) {
+            continue;
+        }
+        if (!found || header.sequence > log->head_sequence) {
+            log->head_segment  = segment;
+            log->head_sequence = header.sequence;
+        }
+        if (!found || header.sequence < log->tail_sequence) {
+            log->tail_segment  = segment;
+            log->tail_sequence = header.sequence;
+        }
+        found = true;
+    }
+
+    if (!found) {
+        log->tail_segment  = 0;
+        log->tail_sequence = 1;
+        return _start_segment(log, 0, 1);
+    }
+
+    log->head_record = _find_first_free_record(log, log->head_segment);
+
+    // A write cut short by a reset can leave the timestamp erased but later bytes programmed. Zeroing the slot marks it
+    // used, so the binary search above still finds the free space contiguous, and its CRC no longer matches.
+    if (log->head_record < FLASH_LOG_RECORDS_PER_SEGMENT && !_record_erased(log, log->head_segment, log->head_record)) {
+        flash_log_record_t zero = {0};
+        esp_err_t ret = log->io.write(log->io.ctx, _record_offset(log->head_segment, log->head_record), &zero, sizeof(zero));
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        log->head_record++;
+        log->stats.corrupt_records++;
+    }
+    return ESP_OK;
+}
+
+esp_err_t flash_log_append(flash_log_t* log, uint32_t timestamp, int16_t temperature_deci, int16_t humidity_deci) {
+    if (log->pending_count == FLASH_LOG_PENDING_RECORDS) {
+        memmove(log->pending, log->pending + 1, (FLASH_LOG_PENDING_RECORDS - 1) * sizeof(flash_log_record_t));
+        log->pending_count--;
+        log->stats.records_dropped++;
+    }
+
+    flash_log_record_t* record = &log->pending[log->pending_count++];
+    record->timestamp          = timestamp;
+    record->temperature_deci   = temperature_deci;
+    record->humidity_deci      = humidity_deci;
+    record->crc                = _record_crc(record);
+    record->reserved           = 0xFFFF;
+    log->stats.records_appended++;
+
+    return flash_log_flush(log);
+}
+
+esp_err_t flash_log_flush(flash_log_t* log) {
+    uint32_t written = 0;
+    esp_err_t ret    = ESP_OK;
+    while (written < log->pending_count) {
+        ret = _write_record(log, &log->pending[written]);
+        if (ret != ESP_OK) {
+            log->stats.write_failures++;
+            break;
+        }
+        written++;
+    }
+
+    log->pending_count -= written;
+    memmove(log->pending, log->pending + written, log->pending_count * sizeof(flash_log_record_t));
+    return ret;
+}
+
+uint32_t flash_log_capacity(const flash_log_t* log) {
+    return (log->num_segments - 1) * FLASH_LOG_RECORDS_PER_SEGMENT;
+}
+
+void flash_log_iter_begin(const flash_log_t* log, flash_log_iter_t* iter) {
+    memset(iter, 0, sizeof(*iter));
+    iter->segment       = log->tail_segment;
+    iter->sequence      = log->tail_sequence;
+    iter->last_sequence = log->head_sequence;
+    iter->last_record   = log->head_record;
+}
+
+bool flash_log_iter_next(const flash_log_t* log, flash_log_iter_t* iter, flash_log_record_t* record) {
+    while (!iter->done) {
+        if (iter->buffer_pos < iter->buffered) {
+            *record = iter->buffer[iter->buffer_pos++];
+            if (record->timestamp != FLASH_LOG_ERASED_WORD && record->crc == _record_crc(record)) {
+                return true;
+            }
+            continue;
+        }
+
+        bool is_last     = iter->sequence == iter->last_sequence;
+        uint32_t limit   = is_last ? iter->last_record : FLASH_LOG_RECORDS_PER_SEGMENT;
+        if (iter->record >= limit) {
+            if (is_last) {
+                iter->done = true;
+                break;
+            }
+            iter->segment = (iter->segment + 1) % log->num_segments;
+            iter->sequence++;
+            iter->record = 0;
+            continue;
+        }
+
+        uint32_t count = limit - iter->record;
+        if (count > FLASH_LOG_BATCH_RECORDS) {
+            count = FLASH_LOG_BATCH_RECORDS;
+        }
+
+        iter->buffered   = 0;
+        iter->buffer_pos = 0;
+        if (log->io.read(log->io.ctx, _record_offset(iter->segment, iter->record), iter->buffer, count * sizeof(flash_log_record_t)) != ESP_OK) {
+            iter->done = true;
+            break;
+        }
+
+        // The writer may have reclaimed this segment while we were reading it
+        flash_log_segment_header_t header;
+        if (!_read_header(&log->io, iter->segment, &header) || header.sequence != iter->sequence) {
+            iter->record = limit;
+            continue;
+        }
+
+        iter->buffered = count;
+        iter->record += count;
+    }
+    return false;
+}
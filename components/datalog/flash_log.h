@@ -0,0 +1,106 @@
+// flash_log.h
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FLASH_LOG_PARTITION_LABEL     "datalog"
+#define FLASH_LOG_PARTITION_SUBTYPE   0x40
+
+#define FLASH_LOG_SECTOR_SIZE         4096
+#define FLASH_LOG_SEGMENT_MAGIC       0x474F4C44
+#define FLASH_LOG_BATCH_RECORDS       16
+#define FLASH_LOG_PENDING_RECORDS     16
+#define FLASH_LOG_ERASED_WORD         0xFFFFFFFF
+
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;
+    uint32_t reserved;
+    uint16_t crc;
+    uint16_t version;
+} flash_log_segment_header_t;
+
+typedef struct {
+    uint32_t timestamp;
+    int16_t temperature_deci;
+    int16_t humidity_deci;
+    uint16_t crc;
+    uint16_t reserved;
+} flash_log_record_t;
+
+#define FLASH_LOG_RECORDS_PER_SEGMENT ((FLASH_LOG_SECTOR_SIZE - sizeof(flash_log_segment_header_t)) / sizeof(flash_log_record_t))
+
+// Backing storage, offsets are relative to the start of the log area
+typedef struct {
+    esp_err_t (*read)(void* ctx, size_t offset, void* dst, size_t len);
+    esp_err_t (*write)(void* ctx, size_t offset, const void* src, size_t len);
+    esp_err_t (*erase_sector)(void* ctx, size_t offset);
+    void* ctx;
+    size_t size;
+} flash_log_io_t;
+
+typedef struct {
+    uint32_t records_appended;
+    uint32_t bytes_programmed;
+    uint32_t sectors_erased;
+    uint32_t record_writes;
+    uint32_t write_failures;
+    uint32_t records_dropped;
+    uint32_t recovery_reads;
+    uint32_t corrupt_records;
+} flash_log_stats_t;
+
+typedef struct {
+    flash_log_io_t io;
+    uint32_t num_segments;
+    uint32_t head_segment;
+    uint32_t head_sequence;
+    uint32_t head_record;
+    uint32_t tail_segment;
+    uint32_t tail_sequence;
+    // Records whose write failed, retried oldest first before the next one is written
+    flash_log_record_t pending[FLASH_LOG_PENDING_RECORDS];
+    uint32_t pending_count;
+    flash_log_stats_t stats;
+} flash_log_t;
+
+typedef struct {
+    uint32_t segment;
+    uint32_t sequence;
+    uint32_t record;
+    uint32_t last_sequence;
+    uint32_t last_record;
+    flash_log_record_t buffer[FLASH_LOG_BATCH_RECORDS];
+    uint32_t buffered;
+    uint32_t buffer_pos;
+    bool done;
+} flash_log_iter_t;
+
+// Recovers the log by reading one header per segment and binary searching the head segment
+esp_err_t flash_log_open(flash_log_t* log, const flash_log_io_t* io);
+
+// Each record is programmed straight into the erased space of the head segment, so only the erase and header of a new
+// segment are paid once per FLASH_LOG_RECORDS_PER_SEGMENT records. A record whose write fails stays pending and is
+// retried by the next append or flush; when FLASH_LOG_PENDING_RECORDS are waiting the oldest is dropped.
+esp_err_t flash_log_append(flash_log_t* log, uint32_t timestamp, int16_t temperature_deci, int16_t humidity_deci);
+esp_err_t flash_log_flush(flash_log_t* log);
+uint32_t flash_log_capacity(const flash_log_t* log);
+
+// Iterates flushed records oldest first; records of a segment reclaimed mid-iteration are skipped
+void flash_log_iter_begin(const flash_log_t* log, flash_log_iter_t* iter);
+bool flash_log_iter_next(const flash_log_t* log, flash_log_iter_t* iter, flash_log_record_t* record);
+
+// Opens the log on the "datalog" data partition
+esp_err_t flash_log_open_partition(flash_log_t* log);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,54 @@
+// flash_log_partition.c
+
+#include "flash_log.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+
+static const char* TAG = "FLASH_LOG";
+
+static esp_err_t _partition_read(void* ctx, size_t offset, void* dst, size_t len) {
+    return esp_partition_read((const esp_partition_t*)ctx, offset, dst, len);
+}
+
+static esp_err_t _partition_write(void* ctx, size_t offset, const void* src, size_t len) {
+    return esp_partition_write((const esp_partition_t*)ctx, offset, src, len);
+}
+
+static esp_err_t _partition_erase_sector(void* ctx, size_t offset) {
+    return esp_partition_erase_range((const esp_partition_t*)ctx, offset, FLASH_LOG_SECTOR_SIZE);
+}
+
+esp_err_t flash_log_open_partition(flash_log_t* log) {
+    const esp_partition_t* partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA,
+        (esp_partition_subtype_t)FLASH_LOG_PARTITION_SUBTYPE,
+        FLASH_LOG_PARTITION_LABEL);
+
+    if (partition == NULL) {
+        ESP_LOGE(TAG, "Partition \"%s\" not found", FLASH_LOG_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    flash_log_io_t io = {
+        .read         = _partition_read,
+        .write        = _partition_write,
+        .erase_sector = _partition_erase_sector,
+        .ctx          = (void*)partition,
+        .size         = partition->size,
+    };
+
+    uint64_t start_time = esp_timer_get_time();
+    esp_err_t ret       = flash_log_open(log, &io);
+    uint64_t elapsed_us = esp_timer_get_time() - start_time;
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open log: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Recovered log in %llu us (%lu reads): %lu segments, head %lu (seq %lu, %lu records), tail %lu",
+             elapsed_us, log->stats.recovery_reads, log->num_segments, log->head_segment,
+             log->head_sequence, log->head_record, log->tail_segment);
+    return ESP_OK;
+}
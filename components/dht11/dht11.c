@@ -1,17 +1,144 @@
 // dht11.c
 
-#include "dht11.h"     
+#include "dht11.h"
+#include "dht11_decode.h"
 #include <stdbool.h>
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
 #include "rom/ets_sys.h"
 
+#if DHT11_USE_RMT
+#include "driver/rmt_rx.h"
+#endif
+
 static const char* TAG = "DHT11_DRIVER";
 
-esp_err_t read_dht_data(float* temperature, float* humidity, bool suppressLogErrors) {
-    uint8_t data[5] = {0, 0, 0, 0, 0};
-    esp_err_t ret   = ESP_OK;
+#if DHT11_USE_RMT
+
+static rmt_channel_handle_t rx_channel = NULL;
+static QueueHandle_t rx_done_queue     = NULL;
+static rmt_symbol_word_t rx_symbols[DHT11_RMT_MAX_SYMBOLS];
+
+static bool IRAM_ATTR _rmt_rx_done_callback(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t* edata, void* user_data) {
+    BaseType_t higher_priority_task = pdFALSE;
+    QueueHandle_t queue             = (QueueHandle_t)user_data;
+    xQueueSendFromISR(queue, edata, &higher_priority_task);
+    return higher_priority_task == pdTRUE;
+}
+
+esp_err_t dht11_driver_init(void) {
+    if (rx_channel) {
+        return ESP_OK;
+    }
 
+    rx_done_queue = xQueueCreate(1, sizeof(rmt_rx_done_event_data_t));
+    if (rx_done_queue == NULL) {
+        ESP_LOGE(TAG, "FAILED TO CREATE RMT QUEUE");
+        return ESP_FAIL;
+    }
+
+    rmt_rx_channel_config_t rx_config = {
+        .gpio_num          = DHT11_PIN,
+        .clk_src           = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz     = DHT11_RMT_RESOLUTION_HZ,
+        .mem_block_symbols = DHT11_RMT_MAX_SYMBOLS,
+    };
+
+    esp_err_t ret = rmt_new_rx_channel(&rx_config, &rx_channel);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create RMT RX channel: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    rmt_rx_event_callbacks_t callbacks = {
+        .on_recv_done = _rmt_rx_done_callback,
+    };
+    ESP_ERROR_CHECK(rmt_rx_register_event_callbacks(rx_channel, &callbacks, rx_done_queue));
+    ESP_ERROR_CHECK(rmt_enable(rx_channel));
+
+    // The RMT channel only routes the input; the start signal is driven through the open-drain output
+    gpio_set_direction(DHT11_PIN, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_set_level(DHT11_PIN, 1);
+
+    ESP_LOGI(TAG, "RMT capture initialized");
+    return ESP_OK;
+}
+
+static size_t _symbols_to_pulses(const rmt_symbol_word_t* symbols, size_t num_symbols, dht11_pulse_t* pulses, size_t max_pulses) {
+    size_t num_pulses = 0;
+    for (size_t i = 0; i < num_symbols && num_pulses + 2 <= max_pulses; i++) {
+        if (symbols[i].duration0 == 0) {
+            break;
+        }
+        pulses[num_pulses].level         = symbols[i].level0;
+        pulses[num_pulses++].duration_us = symbols[i].duration0;
+
+        if (symbols[i].duration1 == 0) {
+            break;
+        }
+        pulses[num_pulses].level         = symbols[i].level1;
+        pulses[num_pulses++].duration_us = symbols[i].duration1;
+    }
+    return num_pulses;
+}
+
+static esp_err_t _read_frame(uint8_t data[DHT11_FRAME_BYTES]) {
+    if (!rx_channel) {
+        ESP_LOGE(TAG, "RMT CAPTURE NOT INITIALIZED");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    rmt_receive_config_t receive_config = {
+        .signal_range_min_ns = 1000,
+        .signal_range_max_ns = 200 * 1000,
+    };
+
+    xQueueReset(rx_done_queue);
+
+    // 1. Send start signal, sleeping instead of spinning for the 20ms low period
+    gpio_set_level(DHT11_PIN, 0);
+    vTaskDelay(pdMS_TO_TICKS(DHT11_START_SIGNAL_MS) + 1);
+
+    esp_err_t ret = rmt_receive(rx_channel, rx_symbols, sizeof(rx_symbols), &receive_config);
+    gpio_set_level(DHT11_PIN, 1);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // 2. Wait for the hardware to capture the whole frame
+    rmt_rx_done_event_data_t rx_data;
+    if (xQueueReceive(rx_done_queue, &rx_data, pdMS_TO_TICKS(DHT11_RMT_TIMEOUT_MS)) != pdTRUE) {
+        rmt_disable(rx_channel);
+        rmt_enable(rx_channel);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // 3. Decode captured edges
+    dht11_pulse_t pulses[DHT11_RMT_MAX_SYMBOLS * 2];
+    size_t num_pulses = _symbols_to_pulses(rx_data.received_symbols, rx_data.num_symbols, pulses, DHT11_RMT_MAX_SYMBOLS * 2);
+
+    switch (dht11_decode_pulses(pulses, num_pulses, data)) {
+    case DHT11_DECODE_OK:
+        return ESP_OK;
+    case DHT11_DECODE_CHECKSUM:
+        return ESP_ERR_INVALID_CRC;
+    case DHT11_DECODE_TRUNCATED:
+        return ESP_ERR_INVALID_SIZE;
+    default:
+        return ESP_FAIL;
+    }
+}
+
+#else
+
+esp_err_t dht11_driver_init(void) {
+    return ESP_OK;
+}
+
+static esp_err_t _read_frame(uint8_t data[DHT11_FRAME_BYTES]) {
     // 1. Send start signal
     gpio_set_direction(DHT11_PIN, GPIO_MODE_OUTPUT);
     gpio_set_level(DHT11_PIN, 0);
@@ -25,48 +152,44 @@ esp_err_t read_dht_data(float* temperature, float* humidity, bool suppressLogErr
 
     while (gpio_get_level(DHT11_PIN) == 1) {
         if (esp_timer_get_time() - start_time > 100) {
-            ret = ESP_FAIL;
-            goto exit_critical;
+            return ESP_FAIL;
         }
     }
 
     start_time = esp_timer_get_time();
     while (gpio_get_level(DHT11_PIN) == 0) {
         if (esp_timer_get_time() - start_time > 100) {
-            ret = ESP_FAIL;
-            goto exit_critical;
+            return ESP_FAIL;
         }
     }
 
     start_time = esp_timer_get_time();
     while (gpio_get_level(DHT11_PIN) == 1) {
         if (esp_timer_get_time() - start_time > 100) {
-            ret = ESP_FAIL;
-            goto exit_critical;
+            return ESP_FAIL;
         }
     }
 
     // 3. Data Transmission
-    for (uint8_t i = 0; i < 5; i++) {
+    for (uint8_t i = 0; i < DHT11_FRAME_BYTES; i++) {
+        data[i] = 0;
         for (uint8_t j = 0; j < 8; j++) {
             start_time = esp_timer_get_time();
             while (gpio_get_level(DHT11_PIN) == 0) {
                 if (esp_timer_get_time() - start_time > 70) {
-                    ret = ESP_FAIL;
-                    goto exit_critical;
+                    return ESP_FAIL;
                 }
             }
             start_time = esp_timer_get_time();
             while (gpio_get_level(DHT11_PIN) == 1) {
                 if (esp_timer_get_time() - start_time > 120) {
-                    ret = ESP_FAIL;
-                    goto exit_critical;
+                    return ESP_FAIL;
                 }
             }
 
             uint64_t pulse_duration = esp_timer_get_time() - start_time;
             data[i] <<= 1;
-            if (pulse_duration > 40) {
+            if (pulse_duration > DHT11_BIT_ONE_THRESHOLD_US) {
                 data[i] |= 1;
             }
         }
@@ -74,28 +197,31 @@ esp_err_t read_dht_data(float* temperature, float* humidity, bool suppressLogErr
 
     // 4. Checksum
     if (data[4] != ((data[0] + data[1] + data[2] + data[3]) & 0xFF)) {
-        ret = ESP_ERR_INVALID_CRC;
-    } else {
-        *humidity    = (float)data[0] + (float)data[1] / 10.0f;
-        *temperature = (float)data[2] + (float)data[3] / 10.0f;
-
-        ret = ESP_OK;
+        return ESP_ERR_INVALID_CRC;
     }
 
-exit_critical:
+    return ESP_OK;
+}
 
-    if (ret != ESP_OK && !suppressLogErrors) {
-        if (ret == ESP_ERR_INVALID_CRC) {
-            ESP_LOGE(TAG, "CHECKSUM FAILED");
-            return ESP_FAIL;
-        } else {
-            ESP_LOGE(TAG, "DHT timing error: %s", esp_err_to_name(ret));
-            return ESP_FAIL;
+#endif
+
+esp_err_t read_dht_data(float* temperature, float* humidity, bool suppressLogErrors) {
+    uint8_t data[DHT11_FRAME_BYTES] = {0, 0, 0, 0, 0};
+
+    esp_err_t ret = _read_frame(data);
+
+    if (ret != ESP_OK) {
+        if (!suppressLogErrors) {
+            if (ret == ESP_ERR_INVALID_CRC) {
+                ESP_LOGE(TAG, "CHECKSUM FAILED");
+            } else {
+                ESP_LOGE(TAG, "DHT timing error: %s", esp_err_to_name(ret));
+            }
         }
-    } else {
-        ESP_LOGI(TAG, "This round of data is VALID");
-        return ESP_OK;
+        return ESP_FAIL;
     }
 
+    dht11_decode_to_values(data, temperature, humidity);
+    ESP_LOGI(TAG, "This round of data is VALID");
     return ESP_OK;
-}
\ No newline at end of file
+}
@@ -6,15 +6,24 @@
 extern "C" {
 #endif
 
-#include "driver/gpio.h" 
-#include "esp_err.h"     
+#include "driver/gpio.h"
+#include "esp_err.h"
 #include <stdbool.h>
 
 // DHT11 Pin Definition
 #define DHT11_PIN GPIO_NUM_4
 
+// Capture the frame with the RMT peripheral instead of busy-polling the pin
+#define DHT11_USE_RMT 1
+
+#define DHT11_RMT_RESOLUTION_HZ 1000000
+#define DHT11_RMT_MAX_SYMBOLS 64
+#define DHT11_RMT_TIMEOUT_MS 20
+#define DHT11_START_SIGNAL_MS 20
+
+esp_err_t dht11_driver_init(void);
 esp_err_t read_dht_data(float* temperature, float* humidity, bool suppressLogErrors);
 
 #ifdef __cplusplus
 }
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,64 @@
+// dht11_decode.c
+
+#include "dht11_decode.h"
+#include <stdbool.h>
+
+static bool _in_range(uint16_t value, uint16_t min, uint16_t max) {
+    return value >= min && value <= max;
+}
+
+static size_t _find_response(const dht11_pulse_t* pulses, size_t num_pulses) {
+    for (size_t i = 0; i + 1 < num_pulses; i++) {
+        if (pulses[i].level == 0 && pulses[i + 1].level == 1 &&
+            _in_range(pulses[i].duration_us, DHT11_RESPONSE_MIN_US, DHT11_RESPONSE_MAX_US) &&
+            _in_range(pulses[i + 1].duration_us, DHT11_RESPONSE_MIN_US, DHT11_RESPONSE_MAX_US)) {
+            return i + 2;
+        }
+    }
+    return num_pulses;
+}
+
+dht11_decode_status_t dht11_decode_pulses(const dht11_pulse_t* pulses, size_t num_pulses, uint8_t data[DHT11_FRAME_BYTES]) {
+    for (int i = 0; i < DHT11_FRAME_BYTES; i++) {
+        data[i] = 0;
+    }
+
+    size_t idx = _find_response(pulses, num_pulses);
+    if (idx >= num_pulses) {
+        return DHT11_DECODE_NO_RESPONSE;
+    }
+
+    for (int bit = 0; bit < DHT11_FRAME_BITS; bit++) {
+        if (idx + 1 >= num_pulses) {
+            return DHT11_DECODE_TRUNCATED;
+        }
+
+        const dht11_pulse_t* low  = &pulses[idx];
+        const dht11_pulse_t* high = &pulses[idx + 1];
+        idx += 2;
+
+        if (low->level != 0 || high->level != 1) {
+            return DHT11_DECODE_TIMING;
+        }
+        if (!_in_range(low->duration_us, DHT11_BIT_LOW_MIN_US, DHT11_BIT_LOW_MAX_US) ||
+            high->duration_us == 0 || high->duration_us > DHT11_BIT_HIGH_MAX_US) {
+            return DHT11_DECODE_TIMING;
+        }
+
+        data[bit / 8] <<= 1;
+        if (high->duration_us > DHT11_BIT_ONE_THRESHOLD_US) {
+            data[bit / 8] |= 1;
+        }
+    }
+
+    if (data[4] != ((data[0] + data[1] + data[2] + data[3]) & 0xFF)) {
+        return DHT11_DECODE_CHECKSUM;
+    }
+
+    return DHT11_DECODE_OK;
+}
+
+void dht11_decode_to_values(const uint8_t data[DHT11_FRAME_BYTES], float* temperature, float* humidity) {
+    *humidity    = (float)data[0] + (float)data[1] / 10.0f;
+    *temperature = (float)data[2] + (float)data[3] / 10.0f;
+}
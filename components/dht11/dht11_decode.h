@@ -0,0 +1,43 @@
+// dht11_decode.h
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DHT11_FRAME_BITS           40
+#define DHT11_FRAME_BYTES          5
+
+#define DHT11_RESPONSE_MIN_US      50
+#define DHT11_RESPONSE_MAX_US      110
+#define DHT11_BIT_LOW_MIN_US       30
+#define DHT11_BIT_LOW_MAX_US       80
+#define DHT11_BIT_HIGH_MAX_US      120
+#define DHT11_BIT_ONE_THRESHOLD_US 40
+
+typedef struct {
+    uint16_t duration_us;
+    uint8_t level;
+} dht11_pulse_t;
+
+typedef enum {
+    DHT11_DECODE_OK,
+    DHT11_DECODE_NO_RESPONSE,
+    DHT11_DECODE_TRUNCATED,
+    DHT11_DECODE_TIMING,
+    DHT11_DECODE_CHECKSUM,
+} dht11_decode_status_t;
+
+// Decodes a captured DHT11 frame from a list of line levels and their durations.
+// Anything before the 80us/80us sensor response (e.g. the tail of the start signal) is skipped.
+dht11_decode_status_t dht11_decode_pulses(const dht11_pulse_t* pulses, size_t num_pulses, uint8_t data[DHT11_FRAME_BYTES]);
+
+void dht11_decode_to_values(const uint8_t data[DHT11_FRAME_BYTES], float* temperature, float* humidity);
+
+#ifdef __cplusplus
+}
+#endif
@@ -2,13 +2,14 @@
 
 #include "dht11_task.hpp"
 #include "dht11.h"
+#include "event_bus.hpp"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "speaker_task.hpp"
-#include "lcd_task.hpp"
 #include <math.h>
+#include <new>
 #include <stdbool.h>
 #include <time.h>
 
@@ -21,12 +22,43 @@ DHT11Sensor::DHT11Sensor() {
     if (!this->mutex) {
         ESP_LOGE(TAG, "Failed to create mutex!");
     }
+
+    this->read_events = xEventGroupCreate();
+    if (!this->read_events) {
+        ESP_LOGE(TAG, "Failed to create read event group!");
+    }
+
+#if CONFIG_SPIRAM
+    void* history_storage = heap_caps_malloc(sizeof(dht_history_store_t), MALLOC_CAP_SPIRAM);
+#else
+    void* history_storage = heap_caps_malloc(sizeof(dht_history_store_t), MALLOC_CAP_8BIT);
+#endif
+    if (history_storage) {
+        this->history = new (history_storage) dht_history_store_t();
+    } else {
+        ESP_LOGE(TAG, "Failed to allocate history store!");
+    }
+
+    dht11_snapshot_t empty = {
+        .temperature  = NAN,
+        .humidity     = NAN,
+        .timestamp    = 0,
+        .monotonic_us = 0,
+        .sequence     = 0};
+    this->latest.write(empty);
 }
 
 DHT11Sensor::~DHT11Sensor() {
     if (this->mutex) {
         vSemaphoreDelete(this->mutex);
     }
+    if (this->read_events) {
+        vEventGroupDelete(this->read_events);
+    }
+    if (this->history) {
+        this->history->~dht_history_store_t();
+        heap_caps_free(this->history);
+    }
     if (this->task_handle) {
         vTaskDelete(this->task_handle);
     }
@@ -41,9 +73,21 @@ DHT11Sensor* DHT11Sensor::get_instance() {
 }
 
 esp_err_t DHT11Sensor::start_task(BaseType_t priority, uint32_t stack_depth) {
-    if (!this->mutex) {
+    if (!this->mutex || !this->read_events || !this->history) {
         return ESP_FAIL;
     }
+    esp_err_t init_result = dht11_driver_init();
+    if (init_result != ESP_OK) {
+        return init_result;
+    }
+
+    if (flash_log_open_partition(&this->log) == ESP_OK) {
+        this->log_ready = true;
+        this->restore_history_from_log();
+    } else {
+        ESP_LOGW(TAG, "Persistent log unavailable, readings will not survive a reboot");
+    }
+
     BaseType_t result = xTaskCreate(read_data_task_wrapper, "dht11_task", stack_depth, this, priority, &this->task_handle);
     if (result != pdPASS) {
         ESP_LOGE(TAG, "Failed to create DHT11 task!");
@@ -53,61 +97,185 @@ esp_err_t DHT11Sensor::start_task(BaseType_t priority, uint32_t stack_depth) {
     return ESP_OK;
 }
 
-void DHT11Sensor::notify_read() {
-    if (this->task_handle) {
-        xTaskNotifyGive(this->task_handle);
-        ESP_LOGI(TAG, "Sent notification to DHT11 task to read NOW");
-    } else {
+bool DHT11Sensor::request_read() {
+    if (!this->task_handle) {
         ESP_LOGE(TAG, "DHT11 TASK HANDLE IS NULL, CAN'T SEND NOTIF");
+        return false;
     }
+
+    // Only the first request of an acquisition window wakes the task, later ones share its result
+    if (this->read_in_flight.exchange(true)) {
+        return false;
+    }
+    xEventGroupClearBits(this->read_events, DHT11_READ_DONE_BIT);
+    xTaskNotifyGive(this->task_handle);
+    ESP_LOGI(TAG, "Sent notification to DHT11 task to read NOW");
+    return true;
 }
 
-float DHT11Sensor::get_temperature() {
-    float temp_read = NAN;
+// Claims the acquisition window for a periodic read, so requests arriving while it runs share its result
+void DHT11Sensor::begin_read() {
+    if (!this->read_in_flight.exchange(true)) {
+        xEventGroupClearBits(this->read_events, DHT11_READ_DONE_BIT);
+    }
+}
+
+// Called from the task. A request that claimed this window just before the task did also left a notification,
+// which this read has already served, so drop it before reopening the window.
+void DHT11Sensor::finish_read() {
+    xTaskNotifyStateClear(nullptr);
+    this->read_in_flight.store(false);
+    xEventGroupSetBits(this->read_events, DHT11_READ_DONE_BIT);
+}
+
+uint64_t DHT11Sensor::get_next_read_allowed() {
+    uint64_t next_read_allowed = 0;
     if (xSemaphoreTake(this->mutex, portMAX_DELAY) == pdTRUE) {
-        temp_read = this->temperature;
+        next_read_allowed = this->last_read_attempt_us + MIN_READ_INTERVAL_US;
         xSemaphoreGive(this->mutex);
-    } else {
-        ESP_LOGE(TAG, "ERROR: dht11_get_temperature failed to take mutex!");
     }
-    return temp_read;
+    return next_read_allowed;
+}
+
+void DHT11Sensor::notify_read() {
+    this->request_read();
+}
+
+dht11_read_outcome_t DHT11Sensor::read_fresh(TickType_t timeout, dht11_snapshot_t* reading) {
+    uint64_t request_us    = esp_timer_get_time();
+    TickType_t start_ticks = xTaskGetTickCount();
+
+    uint64_t next_read_allowed = this->get_next_read_allowed();
+    if (next_read_allowed > request_us && pdMS_TO_TICKS((next_read_allowed - request_us) / 1000) >= timeout) {
+        *reading = this->snapshot();
+        return DHT11_READ_STALE_MIN_INTERVAL;
+    }
+
+    dht11_read_outcome_t outcome = this->request_read() ? DHT11_READ_FRESH : DHT11_READ_COALESCED;
+
+    while (true) {
+        TickType_t elapsed = xTaskGetTickCount() - start_ticks;
+        if (elapsed >= timeout) {
+            *reading = this->snapshot();
+            return DHT11_READ_TIMEOUT;
+        }
+
+        xEventGroupWaitBits(this->read_events, DHT11_READ_DONE_BIT, pdFALSE, pdFALSE, timeout - elapsed);
+
+        dht11_snapshot_t latest_reading = this->snapshot();
+        if (latest_reading.monotonic_us >= request_us) {
+            *reading = latest_reading;
+            return outcome;
+        }
+
+        // The window we joined ended without a newer reading (failed, or finished just before we asked)
+        if (!this->read_in_flight.load() && this->request_read()) {
+            outcome = DHT11_READ_FRESH;
+        }
+        vTaskDelay(1);
+    }
+}
+
+dht11_snapshot_t DHT11Sensor::snapshot() const {
+    return this->latest.read();
+}
+
+float DHT11Sensor::get_temperature() {
+    return this->snapshot().temperature;
 }
 
 float DHT11Sensor::get_humidity() {
-    float hum_read = NAN;
+    return this->snapshot().humidity;
+}
+
+dht_history_store_t::Cursor DHT11Sensor::history_cursor() const {
+    return this->history->cursor();
+}
+
+void DHT11Sensor::get_history(dht11_reading_t* history_buffer, uint32_t* num_readings) {
+    dht_history_store_t::Cursor cursor = this->history_cursor();
+    uint32_t count                     = 0;
+    while (count < DHT_HISTORY_SIZE &&
+           cursor.next(&history_buffer[count].temperature, &history_buffer[count].humidity, &history_buffer[count].timestamp)) {
+        count++;
+    }
+    *num_readings = count;
+}
+
+void DHT11Sensor::record_reading(float temperature, float humidity, time_t timestamp) {
+    this->history->append(temperature, humidity, timestamp);
+
+    int16_t temperature_deci = (int16_t)lroundf(temperature * 10.0f);
+    int16_t humidity_deci    = (int16_t)lroundf(humidity * 10.0f);
+
     if (xSemaphoreTake(this->mutex, portMAX_DELAY) == pdTRUE) {
-        hum_read = this->humidity;
+        this->rollup_15m.add((uint32_t)timestamp, temperature_deci, humidity_deci);
+        this->rollup_1h.add((uint32_t)timestamp, temperature_deci, humidity_deci);
         xSemaphoreGive(this->mutex);
     } else {
-        ESP_LOGE(TAG, "ERROR: dht11_get_humidity failed to take mutex!");
+        ESP_LOGE(TAG, "ERROR: record_reading failed to take mutex!");
     }
-    return hum_read;
 }
 
-void DHT11Sensor::get_history(dht11_reading_t* history_buffer, uint32_t* num_readings) {
-    if (xSemaphoreTake(this->mutex, portMAX_DELAY) == pdTRUE) {
-        *num_readings = this->num_history_readings;
-        if (this->num_history_readings > 0) {
-            int start_idx = (this->history_idx - this->num_history_readings + DHT_HISTORY_SIZE) % DHT_HISTORY_SIZE;
-            for (int i = 0; i < this->num_history_readings; i++) {
-                int current_buffer_idx = (start_idx + i) % DHT_HISTORY_SIZE;
-                history_buffer[i]      = this->dht_history[current_buffer_idx];
-            }
+const RollupTierView* DHT11Sensor::select_rollup_tier(uint32_t range_seconds, uint32_t max_points) {
+    // Use the finest resolution that covers the range within the point budget; nullptr selects raw readings
+    if (range_seconds <= DHT_HISTORY_SIZE * (READ_INTERVAL_MS / 1000) && range_seconds / (READ_INTERVAL_MS / 1000) <= max_points) {
+        return nullptr;
+    }
+
+    const RollupTierView* tiers[] = {&this->rollup_15m, &this->rollup_1h};
+    for (const RollupTierView* tier : tiers) {
+        if (range_seconds <= tier->retention_seconds() && range_seconds / tier->get_bucket_seconds() <= max_points) {
+            return tier;
         }
-        xSemaphoreGive(this->mutex);
-    } else {
-        ESP_LOGE(TAG, "ERROR: dht11_get_history failed to take mutex!");
-        *num_readings = 0;
     }
+    return &this->rollup_1h;
 }
 
-uint64_t DHT11Sensor::get_last_read() {
-    uint64_t time_read = 0;
+size_t DHT11Sensor::copy_rollups(const RollupTierView* tier, uint32_t since, rollup_bucket_t* out, size_t max_buckets) {
+    size_t copied = 0;
     if (xSemaphoreTake(this->mutex, portMAX_DELAY) == pdTRUE) {
-        time_read = this->last_successful_read;
+        copied = tier->copy_since(since, out, max_buckets);
         xSemaphoreGive(this->mutex);
+    } else {
+        ESP_LOGE(TAG, "ERROR: copy_rollups failed to take mutex!");
+    }
+    return copied;
+}
+
+void DHT11Sensor::restore_history_from_log() {
+    flash_log_iter_t iter;
+    flash_log_record_t record;
+    uint32_t restored = 0;
+
+    flash_log_iter_begin(&this->log, &iter);
+    while (flash_log_iter_next(&this->log, &iter, &record)) {
+        this->record_reading(record.temperature_deci / 10.0f, record.humidity_deci / 10.0f, record.timestamp);
+        restored++;
+    }
+
+    ESP_LOGI(TAG, "Restored %lu readings from flash", restored);
+}
+
+bool DHT11Sensor::log_iter_begin(flash_log_iter_t* iter) {
+    if (!this->log_ready) {
+        return false;
     }
-    return time_read;
+    if (xSemaphoreTake(this->mutex, portMAX_DELAY) != pdTRUE) {
+        ESP_LOGE(TAG, "ERROR: log_iter_begin failed to take mutex!");
+        return false;
+    }
+    flash_log_iter_begin(&this->log, iter);
+    xSemaphoreGive(this->mutex);
+    return true;
+}
+
+bool DHT11Sensor::log_iter_next(flash_log_iter_t* iter, flash_log_record_t* record) {
+    return flash_log_iter_next(&this->log, iter, record);
+}
+
+uint64_t DHT11Sensor::get_last_read() {
+    return this->snapshot().monotonic_us;
 }
 
 esp_err_t start_dht11_sensor_task(BaseType_t priority, uint32_t stack_depth) {
@@ -118,6 +286,30 @@ esp_err_t start_dht11_sensor_task(BaseType_t priority, uint32_t stack_depth) {
     return ESP_FAIL;
 }
 
+dht11_snapshot_t dht11_get_snapshot() {
+    DHT11Sensor* instance = DHT11Sensor::get_instance();
+    if (instance) {
+        return instance->snapshot();
+    }
+    dht11_snapshot_t empty = {NAN, NAN, 0, 0, 0};
+    return empty;
+}
+
+const char* dht11_read_outcome_name(dht11_read_outcome_t outcome) {
+    switch (outcome) {
+    case DHT11_READ_FRESH:
+        return "fresh";
+    case DHT11_READ_COALESCED:
+        return "coalesced";
+    case DHT11_READ_STALE_MIN_INTERVAL:
+        return "stale";
+    case DHT11_READ_TIMEOUT:
+        return "timeout";
+    default:
+        return "unknown";
+    }
+}
+
 float dht11_get_temperature() {
     DHT11Sensor* instance = DHT11Sensor::get_instance();
     if (instance) {
@@ -171,27 +363,33 @@ void DHT11Sensor::read_data_task_wrapper(void* pvParameters) {
 void DHT11Sensor::read_data_loop() {
     ESP_LOGI(TAG, "DHT11 reading task started");
 
-    float temp_c                    = 0.0f;
-    float hum_c                     = 0.0f;
-    uint64_t last_read_attempt_time = 0.0f;
+    float temp_c = 0.0f;
+    float hum_c  = 0.0f;
 
     read_dht_data(&temp_c, &hum_c, true);
-    last_read_attempt_time = esp_timer_get_time();
+    if (xSemaphoreTake(this->mutex, portMAX_DELAY) == pdTRUE) {
+        this->last_read_attempt_us = esp_timer_get_time();
+        xSemaphoreGive(this->mutex);
+    }
     ESP_LOGI(TAG, "Dummy reading taken");
     vTaskDelay(pdMS_TO_TICKS(DHT11_COOLDOWN));
 
     while (true) {
         esp_err_t ret;
-        uint64_t current_time_us      = esp_timer_get_time();
-        uint64_t time_since_last_read = current_time_us - last_read_attempt_time;
+        uint64_t current_time_us   = esp_timer_get_time();
+        uint64_t next_read_allowed = this->get_next_read_allowed();
 
-        if (time_since_last_read < MIN_READ_INTERVAL_US) {
-            uint64_t remaining_wait = MIN_READ_INTERVAL_US - time_since_last_read;
+        if (current_time_us < next_read_allowed) {
+            uint64_t remaining_wait = next_read_allowed - current_time_us;
             xTaskNotifyWait(0, 0, nullptr, pdMS_TO_TICKS(remaining_wait / 1000));
             continue;
         }
 
-        last_read_attempt_time = esp_timer_get_time();
+        this->begin_read();
+        if (xSemaphoreTake(this->mutex, portMAX_DELAY) == pdTRUE) {
+            this->last_read_attempt_us = esp_timer_get_time();
+            xSemaphoreGive(this->mutex);
+        }
 
         for (int attempts = 1; attempts <= MAXATTEMPTS; attempts++) {
             bool suppress_driver_logs = (attempts < MAXATTEMPTS);
@@ -208,32 +406,37 @@ void DHT11Sensor::read_data_loop() {
         if (ret != ESP_OK) {
             ESP_LOGE(TAG, "CRITICAL ERROR, FAILED TO READ DHT11 DATA");
         } else {
-            if (xSemaphoreTake(this->mutex, portMAX_DELAY) == pdTRUE) {
-                this->temperature = temp_c * (9.0 / 5.0) + 32;
-                this->humidity    = hum_c;
-
-                this->dht_history[this->history_idx].temperature = this->temperature;
-                this->dht_history[this->history_idx].humidity    = this->humidity;
-                this->dht_history[this->history_idx].timestamp   = time(NULL);
-                this->history_idx++;
-                if (this->history_idx == DHT_HISTORY_SIZE) {
-                    this->history_idx = 0;
-                }
-                if (this->num_history_readings < DHT_HISTORY_SIZE) {
-                    this->num_history_readings++;
-                }
-                this->last_successful_read = esp_timer_get_time();
-
+            dht11_snapshot_t reading;
+            reading.temperature  = temp_c * (9.0 / 5.0) + 32;
+            reading.humidity     = hum_c;
+            reading.timestamp    = time(NULL);
+            reading.monotonic_us = esp_timer_get_time();
+            reading.sequence     = this->snapshot().sequence + 1;
+
+            this->record_reading(reading.temperature, reading.humidity, reading.timestamp);
+
+            if (this->log_ready && xSemaphoreTake(this->mutex, portMAX_DELAY) == pdTRUE) {
+                esp_err_t log_ret = flash_log_append(&this->log, (uint32_t)reading.timestamp,
+                                                     (int16_t)lroundf(reading.temperature * 10.0f),
+                                                     (int16_t)lroundf(reading.humidity * 10.0f));
                 xSemaphoreGive(this->mutex);
-
-                Speaker::get_instance() -> play_sound();
-                LCDDisplay::get_instance() -> notify_new_data();
-            } else {
-                ESP_LOGE(TAG, "ERROR: dht11 read task failed to take mutex");
+                if (log_ret != ESP_OK) {
+                    ESP_LOGE(TAG, "Failed to append reading to flash log: %s", esp_err_to_name(log_ret));
+                }
             }
+            this->latest.write(reading);
+
+            bus_event_t event         = {};
+            event.topic               = EVENT_TOPIC_NEW_READING;
+            event.reading.temperature = reading.temperature;
+            event.reading.humidity    = reading.humidity;
+            event.reading.timestamp   = reading.timestamp;
+            event.reading.sequence    = reading.sequence;
+            EventBus::get_instance()->publish(event);
 
-            ESP_LOGI(TAG, "Temperature: %.2f F, Humidity: %.1f %%", this->temperature, this->humidity);
+            ESP_LOGI(TAG, "Temperature: %.2f F, Humidity: %.1f %%", reading.temperature, reading.humidity);
         }
-        xTaskNotifyWait(0, 0, nullptr, pdMS_TO_TICKS(60000));
+        this->finish_read();
+        xTaskNotifyWait(0, 0, nullptr, pdMS_TO_TICKS(READ_INTERVAL_MS));
     }
 }
\ No newline at end of file
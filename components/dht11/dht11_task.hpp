@@ -3,14 +3,29 @@
 #pragma once
 
 #include "esp_err.h"
+#include "flash_log.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
 #include "freertos/semphr.h"
+#include "sdkconfig.h"
 #include "time.h"
 
 #define DHT11_COOLDOWN 3000
 #define MAXATTEMPTS 3
 #define MIN_READ_INTERVAL_US 3000000
-#define DHT_HISTORY_SIZE 60
+#define READ_INTERVAL_MS 60000
+#define DHT11_READ_DONE_BIT BIT0
+
+// Minute readings retained in RAM: 3 days when PSRAM is available, 4 hours otherwise
+#if CONFIG_SPIRAM
+#define DHT_HISTORY_SIZE 4320
+#else
+#define DHT_HISTORY_SIZE 240
+#endif
+
+// Rollup tiers: 15-minute buckets for a day, hourly buckets for a week
+#define DHT_ROLLUP_15M_BUCKETS 96
+#define DHT_ROLLUP_1H_BUCKETS 168
 
 typedef struct {
     float temperature;
@@ -18,22 +33,56 @@ typedef struct {
     time_t timestamp;
 } dht11_reading_t;
 
+typedef struct {
+    float temperature;
+    float humidity;
+    time_t timestamp;
+    uint64_t monotonic_us;
+    uint32_t sequence;
+} dht11_snapshot_t;
+
+typedef enum {
+    DHT11_READ_FRESH,
+    DHT11_READ_COALESCED,
+    DHT11_READ_STALE_MIN_INTERVAL,
+    DHT11_READ_TIMEOUT,
+} dht11_read_outcome_t;
+
 #ifdef __cplusplus
+#include "history_store.hpp"
+#include "rollup_tier.hpp"
+#include "seqlock.hpp"
+#include <atomic>
 #include <cmath>
 
+typedef HistoryStore<DHT_HISTORY_SIZE> dht_history_store_t;
+
 class DHT11Sensor {
   private:
     static DHT11Sensor* s_dht11_instance;
     TaskHandle_t task_handle     = nullptr;
 
     SemaphoreHandle_t mutex = nullptr;
-    dht11_reading_t dht_history[DHT_HISTORY_SIZE];
-    float temperature             = NAN;
-    float humidity                = NAN;
-    int history_idx               = 0;
-    int num_history_readings      = 0;
-    uint64_t last_successful_read = 0;
+    dht_history_store_t* history = nullptr;
+
+    RollupTier<15 * 60, DHT_ROLLUP_15M_BUCKETS> rollup_15m;
+    RollupTier<60 * 60, DHT_ROLLUP_1H_BUCKETS> rollup_1h;
+
+    flash_log_t log;
+    bool log_ready = false;
+
+    SeqLock<dht11_snapshot_t> latest;
+
+    EventGroupHandle_t read_events = nullptr;
+    std::atomic<bool> read_in_flight{false};
+    uint64_t last_read_attempt_us = 0;
 
+    bool request_read();
+    void begin_read();
+    void finish_read();
+    uint64_t get_next_read_allowed();
+    void record_reading(float temperature, float humidity, time_t timestamp);
+    void restore_history_from_log();
     static void read_data_task_wrapper(void* pvParameters);
     void read_data_loop();
 
@@ -44,10 +93,17 @@ class DHT11Sensor {
 
     esp_err_t start_task(BaseType_t priority, uint32_t stack_depth);
     void notify_read();
+    dht11_read_outcome_t read_fresh(TickType_t timeout, dht11_snapshot_t* reading);
+    dht11_snapshot_t snapshot() const;
     float get_temperature();
     float get_humidity();
+    dht_history_store_t::Cursor history_cursor() const;
     void get_history(dht11_reading_t* history_buffer, uint32_t* num_readings);
     uint64_t get_last_read();
+    const RollupTierView* select_rollup_tier(uint32_t range_seconds, uint32_t max_points);
+    size_t copy_rollups(const RollupTierView* tier, uint32_t since, rollup_bucket_t* out, size_t max_buckets);
+    bool log_iter_begin(flash_log_iter_t* iter);
+    bool log_iter_next(flash_log_iter_t* iter, flash_log_record_t* record);
 };
 #endif
 
@@ -56,9 +112,11 @@ extern "C" {
 #endif
 
 esp_err_t start_dht11_sensor_task(BaseType_t priority, uint32_t stack_depth);
+dht11_snapshot_t dht11_get_snapshot();
 float dht11_get_temperature();
 float dht11_get_humidity();
 void dht11_notify_read();
+const char* dht11_read_outcome_name(dht11_read_outcome_t outcome);
 void dht11_get_history(dht11_reading_t* history_buffer, uint32_t* num_readings);
 uint64_t dht11_get_last_read();
 
@@ -0,0 +1,172 @@
+// history_store.hpp
+
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+// Ring of readings kept as separate fixed-point columns. Temperature and humidity are stored in tenths,
+// timestamps as 16-bit deltas from the previous entry with an absolute keyframe every KEYFRAME_INTERVAL
+// entries, so each reading costs a little over 6 bytes.
+//
+// There is a single writer. Cursors read the columns in place without locking and re-seek to the oldest
+// surviving entry if the writer overwrote the block they were reading.
+template <size_t Capacity>
+class HistoryStore {
+  public:
+    static constexpr size_t KEYFRAME_INTERVAL = 16;
+
+  private:
+    static_assert(Capacity > 0 && Capacity % KEYFRAME_INTERVAL == 0, "History capacity must be a multiple of the keyframe interval");
+
+    // One spare block keeps the keyframe of the oldest visible entry alive while its block is partially overwritten
+    static constexpr size_t SLOTS = Capacity + KEYFRAME_INTERVAL;
+
+    int16_t temperature_deci[SLOTS];
+    int16_t humidity_deci[SLOTS];
+    uint16_t time_delta[SLOTS];
+    uint32_t keyframe_time[SLOTS / KEYFRAME_INTERVAL];
+    uint32_t last_timestamp = 0;
+
+    std::atomic<uint32_t> reserved{0};
+    std::atomic<uint32_t> committed{0};
+
+    static int16_t to_deci(float value) {
+        if (std::isnan(value)) {
+            return INT16_MIN;
+        }
+        long scaled = lroundf(value * 10.0f);
+        if (scaled > INT16_MAX) {
+            return INT16_MAX;
+        }
+        if (scaled <= INT16_MIN) {
+            return INT16_MIN + 1;
+        }
+        return (int16_t)scaled;
+    }
+
+    static float from_deci(int16_t value) {
+        return value == INT16_MIN ? NAN : value / 10.0f;
+    }
+
+  public:
+    class Cursor {
+      private:
+        const HistoryStore* store;
+        uint32_t position;
+        uint32_t end;
+        uint32_t timestamp = 0;
+        bool positioned    = false;
+
+        bool still_valid(uint32_t index) const {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t block_start = index - (index % KEYFRAME_INTERVAL);
+            return store->reserved.load(std::memory_order_relaxed) <= block_start + SLOTS;
+        }
+
+        void seek() {
+            while (true) {
+                uint32_t oldest = store->oldest_index();
+                if (position < oldest) {
+                    position = oldest;
+                }
+                if (position >= end) {
+                    return;
+                }
+
+                uint32_t block_start = position - (position % KEYFRAME_INTERVAL);
+                uint32_t time        = store->keyframe_time[(block_start % SLOTS) / KEYFRAME_INTERVAL];
+                for (uint32_t i = block_start + 1; i <= position; i++) {
+                    time += store->time_delta[i % SLOTS];
+                }
+
+                if (still_valid(position)) {
+                    timestamp  = time;
+                    positioned = true;
+                    return;
+                }
+            }
+        }
+
+      public:
+        Cursor(const HistoryStore* store, uint32_t start, uint32_t end)
+            : store(store), position(start), end(end) {}
+
+        bool next(float* temperature, float* humidity, time_t* time) {
+            while (position < end) {
+                if (!positioned) {
+                    seek();
+                    continue;
+                }
+
+                size_t slot = position % SLOTS;
+                if (position % KEYFRAME_INTERVAL == 0) {
+                    timestamp = store->keyframe_time[slot / KEYFRAME_INTERVAL];
+                }
+                int16_t temp = store->temperature_deci[slot];
+                int16_t hum  = store->humidity_deci[slot];
+
+                if (!still_valid(position)) {
+                    positioned = false;
+                    continue;
+                }
+
+                *temperature = from_deci(temp);
+                *humidity    = from_deci(hum);
+                *time        = (time_t)timestamp;
+
+                position++;
+                if (position < end && position % KEYFRAME_INTERVAL != 0) {
+                    timestamp += store->time_delta[position % SLOTS];
+                }
+                return true;
+            }
+            return false;
+        }
+    };
+
+    void append(float temperature, float humidity, time_t timestamp) {
+        uint32_t index = committed.load(std::memory_order_relaxed);
+        size_t slot    = index % SLOTS;
+
+        reserved.store(index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        uint32_t time = (uint32_t)timestamp;
+        if (index % KEYFRAME_INTERVAL == 0) {
+            keyframe_time[slot / KEYFRAME_INTERVAL] = time;
+            time_delta[slot]                        = 0;
+        } else {
+            // Gaps longer than ~18 hours saturate; the next keyframe restores the exact time
+            uint32_t delta   = time > last_timestamp ? time - last_timestamp : 0;
+            time_delta[slot] = delta > UINT16_MAX ? UINT16_MAX : (uint16_t)delta;
+        }
+        temperature_deci[slot] = to_deci(temperature);
+        humidity_deci[slot]    = to_deci(humidity);
+        last_timestamp         = time;
+
+        committed.store(index + 1, std::memory_order_release);
+    }
+
+    uint32_t oldest_index() const {
+        uint32_t end = committed.load(std::memory_order_acquire);
+        return end > Capacity ? end - Capacity : 0;
+    }
+
+    uint32_t size() const {
+        uint32_t end = committed.load(std::memory_order_acquire);
+        return end > Capacity ? Capacity : end;
+    }
+
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+
+    Cursor cursor() const {
+        uint32_t end = committed.load(std::memory_order_acquire);
+        return Cursor(this, end > Capacity ? end - Capacity : 0, end);
+    }
+};
@@ -0,0 +1,111 @@
+// rollup_tier.hpp
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+typedef struct {
+    uint32_t start;
+    int32_t temperature_sum;
+    int32_t humidity_sum;
+    int16_t temperature_min;
+    int16_t temperature_max;
+    int16_t humidity_min;
+    int16_t humidity_max;
+    uint16_t count;
+} rollup_bucket_t;
+
+// Fixed-size ring of min/max/sum/count buckets aligned to bucket_seconds. Values are in tenths.
+// Each reading updates the newest bucket or opens a new one, so add() is O(1) regardless of retention.
+class RollupTierView {
+  private:
+    rollup_bucket_t* buckets;
+    size_t capacity;
+    uint32_t bucket_seconds;
+    size_t head  = 0;
+    size_t count = 0;
+
+  public:
+    RollupTierView(rollup_bucket_t* buckets, size_t capacity, uint32_t bucket_seconds)
+        : buckets(buckets), capacity(capacity), bucket_seconds(bucket_seconds) {}
+
+    void add(uint32_t timestamp, int16_t temperature_deci, int16_t humidity_deci) {
+        uint32_t start = timestamp - (timestamp % bucket_seconds);
+
+        // Readings from before the newest bucket (e.g. after the clock is stepped back) are folded into it
+        if (count == 0 || start > buckets[head].start) {
+            if (count > 0) {
+                head = (head + 1) % capacity;
+            }
+            if (count < capacity) {
+                count++;
+            }
+
+            rollup_bucket_t* bucket = &buckets[head];
+            bucket->start           = start;
+            bucket->temperature_sum = 0;
+            bucket->humidity_sum    = 0;
+            bucket->temperature_min = temperature_deci;
+            bucket->temperature_max = temperature_deci;
+            bucket->humidity_min    = humidity_deci;
+            bucket->humidity_max    = humidity_deci;
+            bucket->count           = 0;
+        }
+
+        rollup_bucket_t* bucket = &buckets[head];
+        bucket->temperature_sum += temperature_deci;
+        bucket->humidity_sum += humidity_deci;
+        if (temperature_deci < bucket->temperature_min) {
+            bucket->temperature_min = temperature_deci;
+        }
+        if (temperature_deci > bucket->temperature_max) {
+            bucket->temperature_max = temperature_deci;
+        }
+        if (humidity_deci < bucket->humidity_min) {
+            bucket->humidity_min = humidity_deci;
+        }
+        if (humidity_deci > bucket->humidity_max) {
+            bucket->humidity_max = humidity_deci;
+        }
+        if (bucket->count < UINT16_MAX) {
+            bucket->count++;
+        }
+    }
+
+    // Copies buckets starting at or after `since`, oldest first
+    size_t copy_since(uint32_t since, rollup_bucket_t* out, size_t max_buckets) const {
+        size_t copied = 0;
+        for (size_t i = 0; i < count && copied < max_buckets; i++) {
+            const rollup_bucket_t* bucket = &buckets[(head + capacity - count + 1 + i) % capacity];
+            if (bucket->start + bucket_seconds > since) {
+                out[copied++] = *bucket;
+            }
+        }
+        return copied;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    uint32_t get_bucket_seconds() const {
+        return bucket_seconds;
+    }
+
+    uint32_t retention_seconds() const {
+        return capacity * bucket_seconds;
+    }
+};
+
+template <uint32_t BucketSeconds, size_t Capacity>
+class RollupTier : public RollupTierView {
+  private:
+    rollup_bucket_t storage[Capacity];
+
+  public:
+    RollupTier() : RollupTierView(storage, Capacity, BucketSeconds) {}
+
+    RollupTier(const RollupTier&)            = delete;
+    RollupTier& operator=(const RollupTier&) = delete;
+};
@@ -0,0 +1,60 @@
+// seqlock.hpp
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer sequence lock. Readers never block the writer; they retry if a write raced their copy.
+// The payload is stored as relaxed atomic words so concurrent reads are well defined.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+
+  private:
+    static constexpr size_t NUM_WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<uint32_t> words[NUM_WORDS] = {};
+
+  public:
+    void write(const T& value) {
+        uint32_t buffer[NUM_WORDS] = {};
+        memcpy(buffer, &value, sizeof(T));
+
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < NUM_WORDS; i++) {
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    T read() const {
+        uint32_t buffer[NUM_WORDS];
+        uint32_t seq_before;
+        uint32_t seq_after;
+
+        do {
+            seq_before = sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < NUM_WORDS; i++) {
+                buffer[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            seq_after = sequence.load(std::memory_order_relaxed);
+        } while ((seq_before & 1) || seq_before != seq_after);
+
+        T value;
+        memcpy(&value, buffer, sizeof(T));
+        return value;
+    }
+
+    uint32_t version() const {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+};
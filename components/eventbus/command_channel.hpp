@@ -0,0 +1,68 @@
+// command_channel.hpp
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+typedef struct {
+    uint32_t submitted;
+    uint32_t coalesced;
+    uint32_t dropped;
+} command_channel_stats_t;
+
+// Lossless mailbox for a task. Every command kind keeps a pending count instead of sharing one notification
+// value, so a request is never overwritten and the task can fold a burst into a single action. One notification
+// bit wakes the task; it can share the notification value with other bits (e.g. an event bus subscription).
+template <size_t NumKinds>
+class CommandChannel {
+  private:
+    TaskHandle_t task = nullptr;
+    uint32_t wake_bit = 0;
+
+    std::atomic<uint32_t> pending[NumKinds]{};
+    std::atomic<uint32_t> submitted{0};
+    std::atomic<uint32_t> coalesced{0};
+    std::atomic<uint32_t> dropped{0};
+
+  public:
+    void bind(TaskHandle_t task, uint32_t wake_bit) {
+        this->wake_bit = wake_bit;
+        this->task     = task;
+    }
+
+    bool is_bound() const {
+        return this->task != nullptr;
+    }
+
+    // Returns false if the command was dropped because no task is listening yet
+    bool submit(size_t kind) {
+        if (kind >= NumKinds || !this->task) {
+            this->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        this->submitted.fetch_add(1, std::memory_order_relaxed);
+        if (this->pending[kind].fetch_add(1, std::memory_order_acq_rel) > 0) {
+            this->coalesced.fetch_add(1, std::memory_order_relaxed);
+        }
+        xTaskNotify(this->task, this->wake_bit, eSetBits);
+        return true;
+    }
+
+    // Returns how many commands of this kind arrived since the last take
+    uint32_t take(size_t kind) {
+        return kind < NumKinds ? this->pending[kind].exchange(0, std::memory_order_acq_rel) : 0;
+    }
+
+    command_channel_stats_t get_stats() const {
+        command_channel_stats_t stats;
+        stats.submitted = this->submitted.load(std::memory_order_relaxed);
+        stats.coalesced = this->coalesced.load(std::memory_order_relaxed);
+        stats.dropped   = this->dropped.load(std::memory_order_relaxed);
+        return stats;
+    }
+};
@@ -0,0 +1,107 @@
+// event_bus.cpp
+
+#include "event_bus.hpp"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char* TAG = "EVENT_BUS";
+
+EventBus* EventBus::s_bus_instance = nullptr;
+
+EventBus* EventBus::get_instance() {
+    if (!s_bus_instance) {
+        s_bus_instance = new EventBus();
+    }
+    return s_bus_instance;
+}
+
+void EventBus::update_max(std::atomic<uint32_t>& target, uint32_t value) {
+    uint32_t current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+esp_err_t EventBus::subscribe(EventSubscriberBase* subscriber, uint32_t topic_mask, TaskHandle_t task, uint32_t notify_bits) {
+    if (!subscriber || !subscriber->queue) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    subscriber->task        = task;
+    subscriber->notify_bits = notify_bits;
+    subscriber->topic_mask  = topic_mask;
+
+    esp_err_t ret = ESP_OK;
+    taskENTER_CRITICAL(&this->subscribe_lock);
+    uint32_t index = this->num_subscribers.load(std::memory_order_relaxed);
+    if (index < EVENT_BUS_MAX_SUBSCRIBERS) {
+        this->subscribers[index] = subscriber;
+        // Publishers only look at slots below num_subscribers, so the slot is filled in before it becomes visible
+        this->num_subscribers.store(index + 1, std::memory_order_release);
+    } else {
+        ret = ESP_ERR_NO_MEM;
+    }
+    taskEXIT_CRITICAL(&this->subscribe_lock);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Subscriber table full (%d)", EVENT_BUS_MAX_SUBSCRIBERS);
+    }
+    return ret;
+}
+
+void EventBus::publish(const bus_event_t& event) {
+    if (event.topic >= EVENT_TOPIC_MAX) {
+        return;
+    }
+
+    uint64_t start_us      = esp_timer_get_time();
+    TopicCounters* counter = &this->counters[event.topic];
+    uint32_t topic_bit     = EVENT_TOPIC_BIT(event.topic);
+    uint32_t count         = this->num_subscribers.load(std::memory_order_acquire);
+
+    for (uint32_t i = 0; i < count; i++) {
+        EventSubscriberBase* subscriber = this->subscribers[i];
+        if (!(subscriber->topic_mask & topic_bit)) {
+            continue;
+        }
+
+        // Never wait on a slow subscriber: a full queue costs that subscriber the event, not the publisher its time
+        if (xQueueSend(subscriber->queue, &event, 0) != pdTRUE) {
+            counter->dropped.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            update_max(counter->queue_high_water, subscriber->queue_depth - uxQueueSpacesAvailable(subscriber->queue));
+        }
+
+        if (subscriber->task) {
+            xTaskNotify(subscriber->task, subscriber->notify_bits, eSetBits);
+        }
+    }
+
+    counter->published.fetch_add(1, std::memory_order_relaxed);
+    update_max(counter->max_publish_us, (uint32_t)(esp_timer_get_time() - start_us));
+}
+
+event_topic_stats_t EventBus::get_stats(event_topic_t topic) {
+    event_topic_stats_t stats = {};
+    if (topic < EVENT_TOPIC_MAX) {
+        stats.published        = this->counters[topic].published.load(std::memory_order_relaxed);
+        stats.dropped          = this->counters[topic].dropped.load(std::memory_order_relaxed);
+        stats.queue_high_water = this->counters[topic].queue_high_water.load(std::memory_order_relaxed);
+        stats.max_publish_us   = this->counters[topic].max_publish_us.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+const char* event_topic_name(event_topic_t topic) {
+    switch (topic) {
+    case EVENT_TOPIC_NEW_READING:
+        return "new_reading";
+    case EVENT_TOPIC_DISPLAY_STATE:
+        return "display_state";
+    case EVENT_TOPIC_SPEAKER_STATE:
+        return "speaker_state";
+    case EVENT_TOPIC_INPUT:
+        return "input";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,132 @@
+// event_bus.hpp
+
+#pragma once
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include <time.h>
+
+#define EVENT_BUS_MAX_SUBSCRIBERS 8
+
+typedef enum {
+    EVENT_TOPIC_NEW_READING,
+    EVENT_TOPIC_DISPLAY_STATE,
+    EVENT_TOPIC_SPEAKER_STATE,
+    EVENT_TOPIC_INPUT,
+    EVENT_TOPIC_MAX,
+} event_topic_t;
+
+#define EVENT_TOPIC_BIT(topic) (1UL << (topic))
+
+typedef enum {
+    EVENT_INPUT_SOURCE_IR,
+    EVENT_INPUT_SOURCE_BUTTON,
+} event_input_source_t;
+
+typedef struct {
+    event_topic_t topic;
+    union {
+        struct {
+            float temperature;
+            float humidity;
+            time_t timestamp;
+            uint32_t sequence;
+        } reading;
+        struct {
+            bool on;
+        } state;
+        struct {
+            event_input_source_t source;
+            uint8_t code;
+        } input;
+    };
+} bus_event_t;
+
+typedef struct {
+    uint32_t published;
+    uint32_t dropped;
+    uint32_t queue_high_water;
+    uint32_t max_publish_us;
+} event_topic_stats_t;
+
+#ifdef __cplusplus
+#include <atomic>
+
+class EventSubscriberBase {
+    friend class EventBus;
+
+  protected:
+    QueueHandle_t queue  = nullptr;
+    TaskHandle_t task    = nullptr;
+    uint32_t notify_bits = 0;
+    uint32_t topic_mask  = 0;
+    uint32_t queue_depth = 0;
+
+  public:
+    // Non-blocking; returns false once the queue is drained
+    bool receive(bus_event_t* event) {
+        return queue && xQueueReceive(queue, event, 0) == pdTRUE;
+    }
+
+    bool wait(bus_event_t* event, TickType_t timeout) {
+        return queue && xQueueReceive(queue, event, timeout) == pdTRUE;
+    }
+};
+
+// Statically allocated per-subscriber queue, so publishing never touches the heap
+template <size_t Depth>
+class EventSubscriber : public EventSubscriberBase {
+  private:
+    StaticQueue_t queue_buffer;
+    uint8_t queue_storage[Depth * sizeof(bus_event_t)];
+
+  public:
+    EventSubscriber() {
+        queue       = xQueueCreateStatic(Depth, sizeof(bus_event_t), queue_storage, &queue_buffer);
+        queue_depth = Depth;
+    }
+
+    EventSubscriber(const EventSubscriber&)            = delete;
+    EventSubscriber& operator=(const EventSubscriber&) = delete;
+};
+
+class EventBus {
+  private:
+    static EventBus* s_bus_instance;
+
+    EventSubscriberBase* subscribers[EVENT_BUS_MAX_SUBSCRIBERS] = {};
+    std::atomic<uint32_t> num_subscribers{0};
+    portMUX_TYPE subscribe_lock = portMUX_INITIALIZER_UNLOCKED;
+
+    struct TopicCounters {
+        std::atomic<uint32_t> published{0};
+        std::atomic<uint32_t> dropped{0};
+        std::atomic<uint32_t> queue_high_water{0};
+        std::atomic<uint32_t> max_publish_us{0};
+    };
+    TopicCounters counters[EVENT_TOPIC_MAX];
+
+    static void update_max(std::atomic<uint32_t>& target, uint32_t value);
+
+  public:
+    static EventBus* get_instance();
+
+    // When task is set, every delivery also ORs notify_bits into that task's notification value
+    esp_err_t subscribe(EventSubscriberBase* subscriber, uint32_t topic_mask, TaskHandle_t task = nullptr, uint32_t notify_bits = 0);
+    void publish(const bus_event_t& event);
+    event_topic_stats_t get_stats(event_topic_t topic);
+};
+
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const char* event_topic_name(event_topic_t topic);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,377 @@
+// i2c_bus.c
+
+#include "i2c_bus.h"
+#include "i2c_bus_hw.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char* TAG = "I2C_BUS_DRIVER";
+
+typedef enum {
+    I2C_BUS_STATE_UNINITIALIZED,
+    I2C_BUS_STATE_INITIALIZING,
+    I2C_BUS_STATE_READY
+} i2c_bus_state_t;
+
+// Lives on the submitting task's stack, which stays blocked on `done` until the worker has finished with it
+typedef struct {
+    i2c_bus_device_t* device;
+    const uint8_t* tx;
+    size_t tx_len;
+    uint8_t* rx;
+    size_t rx_len;
+    int64_t submitted_us;
+    int64_t deadline_us;
+    esp_err_t result;
+    SemaphoreHandle_t done;
+} i2c_bus_request_t;
+
+typedef struct {
+    volatile i2c_bus_state_t state;
+    i2c_bus_transport_t transport;
+    TaskHandle_t worker;
+
+    QueueHandle_t queues[I2C_BUS_PRIORITY_MAX];
+    StaticQueue_t queue_storage[I2C_BUS_PRIORITY_MAX];
+    uint8_t queue_buffers[I2C_BUS_PRIORITY_MAX][I2C_BUS_QUEUE_DEPTH * sizeof(i2c_bus_request_t*)];
+
+    i2c_bus_device_t devices[I2C_BUS_MAX_DEVICES];
+    size_t device_count;
+
+    uint8_t batch[I2C_BUS_BATCH_SIZE];
+    i2c_bus_stats_t stats;
+} i2c_bus_t;
+
+static i2c_bus_t s_bus;
+static portMUX_TYPE s_bus_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void _i2c_bus_recover(void) {
+    esp_err_t ret = s_bus.transport.reset ? s_bus.transport.reset(s_bus.transport.ctx) : ESP_ERR_NOT_SUPPORTED;
+
+    taskENTER_CRITICAL(&s_bus_lock);
+    if (ret == ESP_OK) {
+        s_bus.stats.bus_resets++;
+    } else {
+        s_bus.stats.reset_failures++;
+    }
+    taskEXIT_CRITICAL(&s_bus_lock);
+
+    if (ret == ESP_OK) {
+        ESP_LOGW(TAG, "Bus timed out, reset it");
+    } else {
+        ESP_LOGE(TAG, "Bus timed out and could not be reset: %s", esp_err_to_name(ret));
+    }
+}
+
+static esp_err_t _i2c_bus_execute(i2c_bus_device_t* device, const uint8_t* tx, size_t tx_len, uint8_t* rx, size_t rx_len) {
+    // A stream write that failed part way may already have moved the device, so only whole transactions are retried
+    int max_attempts = device->flags & I2C_BUS_DEVICE_FLAG_STREAM ? 1 : 1 + I2C_BUS_MAX_RETRIES;
+    esp_err_t ret    = ESP_FAIL;
+
+    for (int attempt = 0; attempt < max_attempts; attempt++) {
+        if (attempt > 0) {
+            taskENTER_CRITICAL(&s_bus_lock);
+            device->stats.retries++;
+            taskEXIT_CRITICAL(&s_bus_lock);
+        }
+
+        ret = s_bus.transport.transfer(s_bus.transport.ctx, device, tx, tx_len, rx, rx_len, I2C_BUS_TIMEOUT_MS);
+
+        taskENTER_CRITICAL(&s_bus_lock);
+        s_bus.stats.transactions++;
+        if (ret == ESP_ERR_TIMEOUT) {
+            device->stats.timeouts++;
+        }
+        taskEXIT_CRITICAL(&s_bus_lock);
+
+        if (ret == ESP_OK) {
+            break;
+        }
+        if (ret == ESP_ERR_TIMEOUT) {
+            _i2c_bus_recover();
+        }
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Transfer to %s (0x%02x) failed: %s", device->name, device->address, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+static void _i2c_bus_complete(i2c_bus_request_t* request, esp_err_t result) {
+    i2c_bus_device_t* device = request->device;
+    uint32_t latency_us      = (uint32_t)(esp_timer_get_time() - request->submitted_us);
+
+    taskENTER_CRITICAL(&s_bus_lock);
+    device->stats.transfers++;
+    if (result == ESP_OK) {
+        device->stats.bytes += request->tx_len + request->rx_len;
+    } else {
+        device->stats.errors++;
+    }
+    device->stats.last_latency_us = latency_us;
+    device->stats.total_latency_us += latency_us;
+    if (latency_us > device->stats.max_latency_us) {
+        device->stats.max_latency_us = latency_us;
+    }
+    taskEXIT_CRITICAL(&s_bus_lock);
+
+    // The submitter may return as soon as it is woken, so the request must not be touched after this
+    request->result = result;
+    xSemaphoreGive(request->done);
+}
+
+static bool _i2c_bus_can_merge(const i2c_bus_request_t* next, const i2c_bus_device_t* device, size_t batch_len, int64_t now) {
+    return next->device == device && next->rx_len == 0 && batch_len + next->tx_len <= I2C_BUS_BATCH_SIZE && now <= next->deadline_us;
+}
+
+static void _i2c_bus_service(i2c_bus_request_t* request, i2c_bus_priority_t priority) {
+    i2c_bus_device_t* device = request->device;
+    int64_t now              = esp_timer_get_time();
+
+    if (now > request->deadline_us) {
+        taskENTER_CRITICAL(&s_bus_lock);
+        device->stats.deadline_misses++;
+        taskEXIT_CRITICAL(&s_bus_lock);
+        _i2c_bus_complete(request, ESP_ERR_TIMEOUT);
+        return;
+    }
+
+    if (!(device->flags & I2C_BUS_DEVICE_FLAG_STREAM) || request->rx_len > 0 || request->tx_len > I2C_BUS_BATCH_SIZE) {
+        _i2c_bus_complete(request, _i2c_bus_execute(device, request->tx, request->tx_len, request->rx, request->rx_len));
+        return;
+    }
+
+    // Writes to a stream device queued back to back at this priority go out as one transaction
+    i2c_bus_request_t* batch[I2C_BUS_QUEUE_DEPTH + 1];
+    size_t count     = 0;
+    size_t batch_len = 0;
+
+    memcpy(s_bus.batch, request->tx, request->tx_len);
+    batch_len      = request->tx_len;
+    batch[count++] = request;
+
+    i2c_bus_request_t* next = NULL;
+    while (count < sizeof(batch) / sizeof(batch[0]) && xQueuePeek(s_bus.queues[priority], &next, 0) == pdTRUE &&
+           _i2c_bus_can_merge(next, device, batch_len, now)) {
+        xQueueReceive(s_bus.queues[priority], &next, 0);
+        memcpy(s_bus.batch + batch_len, next->tx, next->tx_len);
+        batch_len += next->tx_len;
+        batch[count++] = next;
+    }
+
+    esp_err_t ret = _i2c_bus_execute(device, s_bus.batch, batch_len, NULL, 0);
+
+    taskENTER_CRITICAL(&s_bus_lock);
+    device->stats.merged += count - 1;
+    taskEXIT_CRITICAL(&s_bus_lock);
+
+    for (size_t i = 0; i < count; i++) {
+        _i2c_bus_complete(batch[i], ret);
+    }
+}
+
+static i2c_bus_request_t* _i2c_bus_next(i2c_bus_priority_t* priority) {
+    i2c_bus_request_t* request = NULL;
+    for (int p = 0; p < I2C_BUS_PRIORITY_MAX; p++) {
+        if (xQueueReceive(s_bus.queues[p], &request, 0) == pdTRUE) {
+            *priority = (i2c_bus_priority_t)p;
+            return request;
+        }
+    }
+    return NULL;
+}
+
+static void _i2c_bus_task(void* pvParameters) {
+    ESP_LOGI(TAG, "I2C bus worker started");
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Priorities are re-checked after every transfer, so a high priority request waits for at most one transfer
+        i2c_bus_priority_t priority;
+        i2c_bus_request_t* request;
+        while ((request = _i2c_bus_next(&priority)) != NULL) {
+            _i2c_bus_service(request, priority);
+        }
+    }
+}
+
+esp_err_t i2c_bus_init(const i2c_bus_config_t* config) {
+    i2c_bus_config_t defaults = I2C_BUS_DEFAULT_CONFIG();
+    if (config == NULL) {
+        config = &defaults;
+    }
+
+    taskENTER_CRITICAL(&s_bus_lock);
+    bool claimed = s_bus.state == I2C_BUS_STATE_UNINITIALIZED;
+    if (claimed) {
+        s_bus.state = I2C_BUS_STATE_INITIALIZING;
+    }
+    taskEXIT_CRITICAL(&s_bus_lock);
+
+    if (!claimed) {
+        while (s_bus.state == I2C_BUS_STATE_INITIALIZING) {
+            vTaskDelay(1);
+        }
+        return s_bus.state == I2C_BUS_STATE_READY ? ESP_OK : ESP_ERR_INVALID_STATE;
+    }
+
+    for (int p = 0; p < I2C_BUS_PRIORITY_MAX; p++) {
+        s_bus.queues[p] = xQueueCreateStatic(I2C_BUS_QUEUE_DEPTH, sizeof(i2c_bus_request_t*), s_bus.queue_buffers[p],
+                                             &s_bus.queue_storage[p]);
+    }
+
+    if (config->transport) {
+        s_bus.transport = *config->transport;
+        ESP_LOGW(TAG, "I2C bus uses a custom transport");
+    } else {
+        esp_err_t ret = i2c_bus_hw_transport_init(config, &s_bus.transport);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create I2C master bus: %s", esp_err_to_name(ret));
+            s_bus.state = I2C_BUS_STATE_UNINITIALIZED;
+            return ret;
+        }
+    }
+
+    if (xTaskCreate(_i2c_bus_task, "i2c_bus", I2C_BUS_TASK_STACK, NULL, I2C_BUS_TASK_PRIORITY, &s_bus.worker) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create I2C bus task");
+        if (!config->transport) {
+            i2c_bus_hw_transport_deinit(&s_bus.transport);
+        }
+        s_bus.state = I2C_BUS_STATE_UNINITIALIZED;
+        return ESP_ERR_NO_MEM;
+    }
+
+    s_bus.state = I2C_BUS_STATE_READY;
+    ESP_LOGI(TAG, "I2C bus ready on port %d", config->port);
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_add_device(const char* name, uint16_t address, uint32_t scl_speed_hz, uint32_t flags,
+                             i2c_bus_device_t** out_device) {
+    if (out_device == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_device = NULL;
+
+    if (s_bus.state != I2C_BUS_STATE_READY) {
+        ESP_LOGE(TAG, "I2C bus not initialized, cannot add %s", name);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Slots are never reused, a device that fails to attach keeps its slot but is not reported
+    taskENTER_CRITICAL(&s_bus_lock);
+    i2c_bus_device_t* device = NULL;
+    if (s_bus.device_count < I2C_BUS_MAX_DEVICES) {
+        device = &s_bus.devices[s_bus.device_count++];
+    }
+    taskEXIT_CRITICAL(&s_bus_lock);
+
+    if (device == NULL) {
+        ESP_LOGE(TAG, "No room for I2C device %s", name);
+        return ESP_ERR_NO_MEM;
+    }
+
+    device->name         = name;
+    device->address      = address;
+    device->scl_speed_hz = scl_speed_hz;
+    device->flags        = flags;
+
+    esp_err_t ret = s_bus.transport.attach ? s_bus.transport.attach(s_bus.transport.ctx, device) : ESP_OK;
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to attach %s (0x%02x): %s", name, address, esp_err_to_name(ret));
+        return ret;
+    }
+
+    device->attached = true;
+    *out_device      = device;
+    ESP_LOGI(TAG, "Added %s at 0x%02x, %lu Hz", name, address, (unsigned long)scl_speed_hz);
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_transfer(i2c_bus_device_t* device, const uint8_t* tx, size_t tx_len, uint8_t* rx, size_t rx_len,
+                           i2c_bus_priority_t priority, uint32_t deadline_ms) {
+    if (device == NULL || !device->attached || (tx_len > 0 && tx == NULL) || (rx_len > 0 && rx == NULL) ||
+        (tx_len == 0 && rx_len == 0) || priority >= I2C_BUS_PRIORITY_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_bus.state != I2C_BUS_STATE_READY) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    StaticSemaphore_t done_storage;
+    i2c_bus_request_t request = {
+        .device       = device,
+        .tx           = tx,
+        .tx_len       = tx_len,
+        .rx           = rx,
+        .rx_len       = rx_len,
+        .submitted_us = esp_timer_get_time(),
+        .deadline_us  = INT64_MAX,
+        .result       = ESP_FAIL,
+        .done         = xSemaphoreCreateBinaryStatic(&done_storage)};
+    if (deadline_ms > 0) {
+        request.deadline_us = request.submitted_us + (int64_t)deadline_ms * 1000;
+    }
+
+    i2c_bus_request_t* request_ptr = &request;
+    TickType_t send_wait           = deadline_ms > 0 ? pdMS_TO_TICKS(deadline_ms) : portMAX_DELAY;
+    if (xQueueSend(s_bus.queues[priority], &request_ptr, send_wait) != pdTRUE) {
+        taskENTER_CRITICAL(&s_bus_lock);
+        s_bus.stats.queue_full++;
+        device->stats.deadline_misses++;
+        taskEXIT_CRITICAL(&s_bus_lock);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    uint32_t depth = I2C_BUS_QUEUE_DEPTH - uxQueueSpacesAvailable(s_bus.queues[priority]);
+    taskENTER_CRITICAL(&s_bus_lock);
+    if (depth > s_bus.stats.queue_high_water) {
+        s_bus.stats.queue_high_water = depth;
+    }
+    taskEXIT_CRITICAL(&s_bus_lock);
+
+    xTaskNotifyGive(s_bus.worker);
+
+    // Every queued request is completed, expired ones without touching the bus, so this cannot wait forever
+    xSemaphoreTake(request.done, portMAX_DELAY);
+    return request.result;
+}
+
+esp_err_t i2c_bus_write(i2c_bus_device_t* device, const uint8_t* data, size_t len, i2c_bus_priority_t priority,
+                        uint32_t deadline_ms) {
+    return i2c_bus_transfer(device, data, len, NULL, 0, priority, deadline_ms);
+}
+
+size_t i2c_bus_get_device_count(void) {
+    return s_bus.device_count;
+}
+
+const i2c_bus_device_t* i2c_bus_get_device(size_t index) {
+    if (index >= s_bus.device_count || !s_bus.devices[index].attached) {
+        return NULL;
+    }
+    return &s_bus.devices[index];
+}
+
+void i2c_bus_get_device_stats(const i2c_bus_device_t* device, i2c_bus_device_stats_t* stats) {
+    if (device == NULL) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    taskENTER_CRITICAL(&s_bus_lock);
+    *stats = device->stats;
+    taskEXIT_CRITICAL(&s_bus_lock);
+}
+
+void i2c_bus_get_stats(i2c_bus_stats_t* stats) {
+    taskENTER_CRITICAL(&s_bus_lock);
+    *stats = s_bus.stats;
+    taskEXIT_CRITICAL(&s_bus_lock);
+}
@@ -0,0 +1,118 @@
+// i2c_bus.h
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define I2C_BUS_PORT                0
+#define I2C_BUS_SDA_IO              21
+#define I2C_BUS_SCL_IO              22
+#define I2C_BUS_GLITCH_IGNORE_CNT   7
+
+#define I2C_BUS_MAX_DEVICES         8
+#define I2C_BUS_QUEUE_DEPTH         8
+#define I2C_BUS_BATCH_SIZE          256
+#define I2C_BUS_TIMEOUT_MS          50
+#define I2C_BUS_MAX_RETRIES         1
+
+#define I2C_BUS_TASK_PRIORITY       11
+#define I2C_BUS_TASK_STACK          3072
+
+// Consecutive queued writes to the device may be sent as one transaction (e.g. a PCF8574 output stream)
+#define I2C_BUS_DEVICE_FLAG_STREAM  0x01
+
+typedef enum {
+    I2C_BUS_PRIORITY_HIGH,
+    I2C_BUS_PRIORITY_NORMAL,
+    I2C_BUS_PRIORITY_LOW,
+    I2C_BUS_PRIORITY_MAX
+} i2c_bus_priority_t;
+
+typedef struct {
+    uint32_t transfers;
+    uint32_t bytes;
+    uint32_t merged;
+    uint32_t errors;
+    uint32_t timeouts;
+    uint32_t retries;
+    uint32_t deadline_misses;
+
+    // Submission to completion, including time spent queued behind other devices
+    uint32_t last_latency_us;
+    uint32_t max_latency_us;
+    uint64_t total_latency_us;
+} i2c_bus_device_stats_t;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bus_resets;
+    uint32_t reset_failures;
+    uint32_t queue_full;
+    uint32_t queue_high_water;
+} i2c_bus_stats_t;
+
+typedef struct i2c_bus_device {
+    const char* name;
+    uint16_t address;
+    uint32_t scl_speed_hz;
+    uint32_t flags;
+    bool attached;
+    void* transport_handle;
+    i2c_bus_device_stats_t stats;
+} i2c_bus_device_t;
+
+// What the worker drives. The default talks to the ESP-IDF master driver; a simulated bus supplies its own
+// functions so device drivers can run unchanged on the Linux target.
+typedef struct {
+    esp_err_t (*attach)(void* ctx, i2c_bus_device_t* device);
+    esp_err_t (*transfer)(void* ctx, i2c_bus_device_t* device, const uint8_t* tx, size_t tx_len, uint8_t* rx, size_t rx_len,
+                          uint32_t timeout_ms);
+    esp_err_t (*reset)(void* ctx);
+    void* ctx;
+} i2c_bus_transport_t;
+
+// Port and pins are plain numbers so the header builds without the driver; only the hardware transport reads them
+typedef struct {
+    int port;
+    int sda_io;
+    int scl_io;
+    bool internal_pullup;
+    const i2c_bus_transport_t* transport;
+} i2c_bus_config_t;
+
+#define I2C_BUS_DEFAULT_CONFIG() {  \
+    .port            = I2C_BUS_PORT,   \
+    .sda_io          = I2C_BUS_SDA_IO, \
+    .scl_io          = I2C_BUS_SCL_IO, \
+    .internal_pullup = false,          \
+    .transport       = NULL,           \
+}
+
+// Safe to call from every driver that uses the bus; only the first call configures it, a NULL config means defaults
+esp_err_t i2c_bus_init(const i2c_bus_config_t* config);
+
+esp_err_t i2c_bus_add_device(const char* name, uint16_t address, uint32_t scl_speed_hz, uint32_t flags,
+                             i2c_bus_device_t** out_device);
+
+// Blocks the caller until the worker has run the transfer. A request still queued when deadline_ms expires is
+// dropped with ESP_ERR_TIMEOUT without touching the bus; 0 means no deadline.
+esp_err_t i2c_bus_transfer(i2c_bus_device_t* device, const uint8_t* tx, size_t tx_len, uint8_t* rx, size_t rx_len,
+                           i2c_bus_priority_t priority, uint32_t deadline_ms);
+esp_err_t i2c_bus_write(i2c_bus_device_t* device, const uint8_t* data, size_t len, i2c_bus_priority_t priority,
+                        uint32_t deadline_ms);
+
+size_t i2c_bus_get_device_count(void);
+const i2c_bus_device_t* i2c_bus_get_device(size_t index);
+void i2c_bus_get_device_stats(const i2c_bus_device_t* device, i2c_bus_device_stats_t* stats);
+void i2c_bus_get_stats(i2c_bus_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,64 @@
+// i2c_bus_hw.c
+
+#include "i2c_bus_hw.h"
+#include "driver/i2c_master.h"
+
+static esp_err_t _i2c_bus_hw_attach(void* ctx, i2c_bus_device_t* device) {
+    i2c_device_config_t dev_cfg = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address  = device->address,
+        .scl_speed_hz    = device->scl_speed_hz};
+
+    i2c_master_dev_handle_t dev_handle = NULL;
+    esp_err_t ret                      = i2c_master_bus_add_device((i2c_master_bus_handle_t)ctx, &dev_cfg, &dev_handle);
+    device->transport_handle           = dev_handle;
+    return ret;
+}
+
+static esp_err_t _i2c_bus_hw_transfer(void* ctx, i2c_bus_device_t* device, const uint8_t* tx, size_t tx_len, uint8_t* rx,
+                                      size_t rx_len, uint32_t timeout_ms) {
+    i2c_master_dev_handle_t dev_handle = (i2c_master_dev_handle_t)device->transport_handle;
+
+    if (rx_len == 0) {
+        return i2c_master_transmit(dev_handle, tx, tx_len, timeout_ms);
+    }
+    if (tx_len == 0) {
+        return i2c_master_receive(dev_handle, rx, rx_len, timeout_ms);
+    }
+    return i2c_master_transmit_receive(dev_handle, tx, tx_len, rx, rx_len, timeout_ms);
+}
+
+// Clocks SCL until a slave holding SDA low lets go, then re-issues a stop condition
+static esp_err_t _i2c_bus_hw_reset(void* ctx) {
+    return i2c_master_bus_reset((i2c_master_bus_handle_t)ctx);
+}
+
+esp_err_t i2c_bus_hw_transport_init(const i2c_bus_config_t* config, i2c_bus_transport_t* transport) {
+    i2c_master_bus_config_t bus_conf = {
+        .clk_source                   = I2C_CLK_SRC_DEFAULT,
+        .i2c_port                     = config->port,
+        .scl_io_num                   = config->scl_io,
+        .sda_io_num                   = config->sda_io,
+        .glitch_ignore_cnt            = I2C_BUS_GLITCH_IGNORE_CNT,
+        .flags.enable_internal_pullup = config->internal_pullup,
+    };
+
+    i2c_master_bus_handle_t master = NULL;
+    esp_err_t ret                  = i2c_new_master_bus(&bus_conf, &master);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    transport->attach   = _i2c_bus_hw_attach;
+    transport->transfer = _i2c_bus_hw_transfer;
+    transport->reset    = _i2c_bus_hw_reset;
+    transport->ctx      = master;
+    return ESP_OK;
+}
+
+void i2c_bus_hw_transport_deinit(i2c_bus_transport_t* transport) {
+    if (transport->ctx) {
+        i2c_del_master_bus((i2c_master_bus_handle_t)transport->ctx);
+        transport->ctx = NULL;
+    }
+}
@@ -0,0 +1,31 @@
+// i2c_bus_hw.h
+
+#pragma once
+
+#include "i2c_bus.h"
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_IDF_TARGET_LINUX
+// No I2C peripheral to drive; every bus on this target needs a transport in its config
+static inline esp_err_t i2c_bus_hw_transport_init(const i2c_bus_config_t* config, i2c_bus_transport_t* transport) {
+    (void)config;
+    (void)transport;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+static inline void i2c_bus_hw_transport_deinit(i2c_bus_transport_t* transport) {
+    (void)transport;
+}
+#else
+// Creates the master bus described by config and fills transport with functions that drive it
+esp_err_t i2c_bus_hw_transport_init(const i2c_bus_config_t* config, i2c_bus_transport_t* transport);
+void i2c_bus_hw_transport_deinit(i2c_bus_transport_t* transport);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
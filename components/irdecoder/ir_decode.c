@@ -0,0 +1,329 @@
+// ir_decode.c
+
+#include "ir_decode.h"
+#include <stdio.h>
+
+static bool _ir_match(uint16_t value, uint16_t target, uint8_t tolerance_percent) {
+    uint32_t margin = (uint32_t)target * tolerance_percent / 100;
+    return target > 0 && (uint32_t)value + margin >= target && value <= target + margin;
+}
+
+static void _decoder_reset(ir_decoder_t* decoder) {
+    decoder->state        = IR_DECODER_STATE_IDLE;
+    decoder->bit_count    = 0;
+    decoder->pending_half = -1;
+    decoder->data         = 0;
+}
+
+static void _decoder_push_bit(ir_decoder_t* decoder, bool bit) {
+    decoder->data = (decoder->data << 1) | (bit ? 1 : 0);
+    decoder->bit_count++;
+}
+
+// Only a frame that validates may touch result, another protocol can still be mid-frame on the same edges
+static ir_decode_status_t _decoder_complete(ir_decoder_t* decoder, ir_result_t* result) {
+    ir_result_t candidate = {
+        .type     = IR_FRAME_TYPE_DATA,
+        .protocol = decoder->protocol->id,
+        .address  = 0,
+        .command  = 0};
+
+    ir_decode_status_t status = decoder->protocol->validate(decoder->data, decoder->bit_count, &candidate);
+    if (status == IR_DECODE_OK) {
+        *result = candidate;
+    }
+    return status;
+}
+
+static ir_decode_status_t _decoder_feed(ir_decoder_t* decoder, bool mark, uint16_t duration_us, ir_result_t* result);
+
+// Gives up on the current frame; the edge that broke it may itself begin the next one
+static ir_decode_status_t _decoder_abandon(ir_decoder_t* decoder, bool mark, uint16_t duration_us, ir_decode_status_t status) {
+    ir_result_t ignored;
+    _decoder_reset(decoder);
+    _decoder_feed(decoder, mark, duration_us, &ignored);
+    return status;
+}
+
+static ir_decode_status_t _pulse_feed(ir_decoder_t* decoder, bool mark, uint16_t duration_us, ir_result_t* result) {
+    const ir_protocol_t* protocol = decoder->protocol;
+    uint8_t tolerance             = protocol->tolerance_percent;
+    bool pulse_width              = protocol->encoding == IR_ENCODING_PULSE_WIDTH;
+
+    switch (decoder->state) {
+    case IR_DECODER_STATE_IDLE:
+        if (mark && _ir_match(duration_us, protocol->header_mark, tolerance)) {
+            decoder->state = IR_DECODER_STATE_HEADER_SPACE;
+        }
+        return IR_DECODE_IN_PROGRESS;
+
+    case IR_DECODER_STATE_HEADER_SPACE:
+        if (mark) {
+            return _decoder_abandon(decoder, mark, duration_us, IR_DECODE_BAD_HEADER);
+        }
+        if (_ir_match(duration_us, protocol->repeat_space, tolerance)) {
+            decoder->state = IR_DECODER_STATE_REPEAT_MARK;
+            return IR_DECODE_IN_PROGRESS;
+        }
+        if (_ir_match(duration_us, protocol->header_space, tolerance)) {
+            decoder->state = IR_DECODER_STATE_BIT_MARK;
+            return IR_DECODE_IN_PROGRESS;
+        }
+        return _decoder_abandon(decoder, mark, duration_us, IR_DECODE_BAD_HEADER);
+
+    case IR_DECODER_STATE_REPEAT_MARK:
+        if (!mark || !_ir_match(duration_us, protocol->zero_mark, tolerance)) {
+            return _decoder_abandon(decoder, mark, duration_us, IR_DECODE_TIMING);
+        }
+        _decoder_reset(decoder);
+        result->type     = IR_FRAME_TYPE_REPEAT;
+        result->protocol = protocol->id;
+        result->address  = 0;
+        result->command  = 0;
+        return IR_DECODE_OK;
+
+    case IR_DECODER_STATE_BIT_MARK:
+        if (!mark) {
+            return _decoder_abandon(decoder, mark, duration_us, IR_DECODE_TIMING);
+        }
+        if (pulse_width && _ir_match(duration_us, protocol->one_mark, tolerance)) {
+            _decoder_push_bit(decoder, true);
+        } else if (pulse_width && _ir_match(duration_us, protocol->zero_mark, tolerance)) {
+            _decoder_push_bit(decoder, false);
+        } else if (pulse_width || !_ir_match(duration_us, protocol->zero_mark, tolerance)) {
+            return _decoder_abandon(decoder, mark, duration_us, IR_DECODE_TIMING);
+        }
+
+        // Nothing follows the last mark of a pulse-width frame at full length
+        if (pulse_width && decoder->bit_count == protocol->max_bits) {
+            ir_decode_status_t status = _decoder_complete(decoder, result);
+            _decoder_reset(decoder);
+            return status;
+        }
+        decoder->state = IR_DECODER_STATE_BIT_SPACE;
+        return IR_DECODE_IN_PROGRESS;
+
+    case IR_DECODER_STATE_BIT_SPACE:
+        if (mark) {
+            return _decoder_abandon(decoder, mark, duration_us, IR_DECODE_TIMING);
+        }
+        if (pulse_width) {
+            if (_ir_match(duration_us, protocol->zero_space, tolerance)) {
+                decoder->state = IR_DECODER_STATE_BIT_MARK;
+                return IR_DECODE_IN_PROGRESS;
+            }
+            // A shorter frame ends in the gap before the next one
+            if (duration_us > protocol->zero_space && decoder->bit_count >= protocol->min_bits) {
+                ir_decode_status_t status = _decoder_complete(decoder, result);
+                _decoder_reset(decoder);
+                return status;
+            }
+            return _decoder_abandon(decoder, mark, duration_us, IR_DECODE_TIMING);
+        }
+
+        if (_ir_match(duration_us, protocol->one_space, tolerance)) {
+            _decoder_push_bit(decoder, true);
+        } else if (_ir_match(duration_us, protocol->zero_space, tolerance)) {
+            _decoder_push_bit(decoder, false);
+        } else {
+            return _decoder_abandon(decoder, mark, duration_us, IR_DECODE_TIMING);
+        }
+        if (decoder->bit_count == protocol->max_bits) {
+            decoder->state = IR_DECODER_STATE_STOP_MARK;
+            return _decoder_complete(decoder, result);
+        }
+        decoder->state = IR_DECODER_STATE_BIT_MARK;
+        return IR_DECODE_IN_PROGRESS;
+
+    case IR_DECODER_STATE_STOP_MARK:
+    default:
+        // The frame was already reported, the stop mark only ends it
+        return _decoder_abandon(decoder, mark, duration_us, IR_DECODE_IN_PROGRESS);
+    }
+}
+
+// A frame ending in a zero bit finishes with a mark half; its space half is indistinguishable from idle
+static ir_decode_status_t _manchester_end(ir_decoder_t* decoder, ir_result_t* result) {
+    ir_decode_status_t status = decoder->state == IR_DECODER_STATE_IDLE ? IR_DECODE_IN_PROGRESS : IR_DECODE_TRUNCATED;
+    if (decoder->bit_count == decoder->protocol->max_bits - 1 && decoder->pending_half == 1) {
+        _decoder_push_bit(decoder, false);
+        status = _decoder_complete(decoder, result);
+    }
+    _decoder_reset(decoder);
+    return status;
+}
+
+static ir_decode_status_t _manchester_feed(ir_decoder_t* decoder, bool mark, uint16_t duration_us, ir_result_t* result) {
+    const ir_protocol_t* protocol = decoder->protocol;
+    uint16_t half_bit             = protocol->zero_mark;
+    uint8_t units                 = _ir_match(duration_us, half_bit, protocol->tolerance_percent)         ? 1
+                                    : _ir_match(duration_us, half_bit * 2, protocol->tolerance_percent) ? 2
+                                                                                                        : 0;
+
+    if (decoder->state == IR_DECODER_STATE_IDLE) {
+        if (!mark || units == 0) {
+            return IR_DECODE_IN_PROGRESS;
+        }
+        // The start bit is a one, its leading space half merges with the idle line
+        decoder->state        = IR_DECODER_STATE_BIT_MARK;
+        decoder->pending_half = 0;
+    } else if (units == 0) {
+        if (!mark && duration_us > half_bit * 2) {
+            return _manchester_end(decoder, result);
+        }
+        return _decoder_abandon(decoder, mark, duration_us, IR_DECODE_TIMING);
+    }
+
+    for (uint8_t unit = 0; unit < units; unit++) {
+        if (decoder->pending_half < 0) {
+            decoder->pending_half = mark ? 1 : 0;
+            continue;
+        }
+        // Each bit changes level in its middle, two equal halves mean a lost edge
+        if (decoder->pending_half == (mark ? 1 : 0)) {
+            return _decoder_abandon(decoder, mark, duration_us, IR_DECODE_TIMING);
+        }
+        _decoder_push_bit(decoder, mark);
+        decoder->pending_half = -1;
+
+        if (decoder->bit_count == protocol->max_bits) {
+            ir_decode_status_t status = _decoder_complete(decoder, result);
+            _decoder_reset(decoder);
+            return status;
+        }
+    }
+    return IR_DECODE_IN_PROGRESS;
+}
+
+static ir_decode_status_t _decoder_feed(ir_decoder_t* decoder, bool mark, uint16_t duration_us, ir_result_t* result) {
+    if (decoder->protocol->encoding == IR_ENCODING_MANCHESTER) {
+        return _manchester_feed(decoder, mark, duration_us, result);
+    }
+    return _pulse_feed(decoder, mark, duration_us, result);
+}
+
+static ir_decode_status_t _decoder_end(ir_decoder_t* decoder, ir_result_t* result) {
+    if (decoder->protocol->encoding == IR_ENCODING_MANCHESTER) {
+        return _manchester_end(decoder, result);
+    }
+
+    ir_decode_status_t status = IR_DECODE_IN_PROGRESS;
+    if (decoder->protocol->encoding == IR_ENCODING_PULSE_WIDTH && decoder->state == IR_DECODER_STATE_BIT_SPACE &&
+        decoder->bit_count >= decoder->protocol->min_bits) {
+        status = _decoder_complete(decoder, result);
+    } else if (decoder->state != IR_DECODER_STATE_IDLE && decoder->state != IR_DECODER_STATE_STOP_MARK) {
+        status = IR_DECODE_TRUNCATED;
+    }
+    _decoder_reset(decoder);
+    return status;
+}
+
+// Keeps the failure of whichever protocol got furthest into the frame, that is the one worth reporting
+static void _engine_note_error(ir_engine_t* engine, ir_decode_status_t status, uint8_t bits) {
+    if (status != IR_DECODE_OK && status != IR_DECODE_IN_PROGRESS && bits >= engine->last_error_bits) {
+        engine->last_error      = status;
+        engine->last_error_bits = bits;
+    }
+}
+
+void ir_engine_reset(ir_engine_t* engine) {
+    for (int i = 0; i < IR_PROTOCOL_DECODERS; i++) {
+        engine->decoders[i].protocol = &ir_protocols[i];
+        _decoder_reset(&engine->decoders[i]);
+    }
+    engine->last_error      = IR_DECODE_BAD_HEADER;
+    engine->last_error_bits = 0;
+}
+
+ir_decode_status_t ir_engine_feed(ir_engine_t* engine, bool mark, uint16_t duration_us, ir_result_t* result) {
+    for (int i = 0; i < IR_PROTOCOL_DECODERS; i++) {
+        ir_decoder_t* decoder     = &engine->decoders[i];
+        uint8_t bits              = decoder->bit_count;
+        ir_decode_status_t status = _decoder_feed(decoder, mark, duration_us, result);
+
+        // First match wins, the other decoders start over rather than finish a second reading of the same frame
+        if (status == IR_DECODE_OK) {
+            ir_engine_reset(engine);
+            return IR_DECODE_OK;
+        }
+        _engine_note_error(engine, status, bits);
+    }
+    return IR_DECODE_IN_PROGRESS;
+}
+
+ir_decode_status_t ir_engine_finish(ir_engine_t* engine, ir_result_t* result) {
+    for (int i = 0; i < IR_PROTOCOL_DECODERS; i++) {
+        ir_decoder_t* decoder     = &engine->decoders[i];
+        uint8_t bits              = decoder->bit_count;
+        ir_decode_status_t status = _decoder_end(decoder, result);
+
+        if (status == IR_DECODE_OK) {
+            ir_engine_reset(engine);
+            return IR_DECODE_OK;
+        }
+        _engine_note_error(engine, status, bits);
+    }
+
+    ir_decode_status_t status = engine->last_error;
+    ir_engine_reset(engine);
+    return status;
+}
+
+ir_decode_status_t ir_decode_frame(const uint16_t* durations, size_t num_durations, ir_result_t* result) {
+    ir_engine_t engine;
+    ir_engine_reset(&engine);
+
+    result->type     = IR_FRAME_TYPE_INVALID;
+    result->protocol = IR_PROTOCOL_NONE;
+    result->address  = 0;
+    result->command  = 0;
+
+    for (size_t i = 0; i < num_durations; i++) {
+        if (ir_engine_feed(&engine, i % 2 == 0, durations[i], result) == IR_DECODE_OK) {
+            return IR_DECODE_OK;
+        }
+    }
+    return ir_engine_finish(&engine, result);
+}
+
+const char* ir_frame_type_name(ir_frame_type_t type) {
+    switch (type) {
+    case IR_FRAME_TYPE_DATA:
+        return "data";
+    case IR_FRAME_TYPE_REPEAT:
+        return "repeat";
+    default:
+        return "invalid";
+    }
+}
+
+int ir_corpus_format_line(const ir_result_t* expected, const uint16_t* durations, size_t num_durations, char* buf,
+                          size_t buf_len) {
+    int len = snprintf(buf, buf_len, "%s,%s,0x%04X,0x%02X,", ir_protocol_name(expected->protocol),
+                       ir_frame_type_name(expected->type), expected->address, expected->command);
+    for (size_t i = 0; i < num_durations && len >= 0; i++) {
+        size_t used = (size_t)len < buf_len ? (size_t)len : buf_len;
+        int n       = snprintf(buf + used, buf_len - used, i > 0 ? " %u" : "%u", durations[i]);
+        len         = n < 0 ? n : len + n;
+    }
+    return len;
+}
+
+const char* ir_decode_status_name(ir_decode_status_t status) {
+    switch (status) {
+    case IR_DECODE_OK:
+        return "ok";
+    case IR_DECODE_IN_PROGRESS:
+        return "in progress";
+    case IR_DECODE_BAD_HEADER:
+        return "bad header";
+    case IR_DECODE_TRUNCATED:
+        return "truncated";
+    case IR_DECODE_TIMING:
+        return "bad bit timing";
+    case IR_DECODE_CHECKSUM:
+        return "checksum failed";
+    default:
+        return "unknown";
+    }
+}
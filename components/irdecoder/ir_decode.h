@@ -0,0 +1,139 @@
+// ir_decode.h
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Timing tolerance of every pulse-distance protocol; override at build time to tune against a recorded corpus
+#ifndef NEC_TOLERANCE_PERCENT
+#define NEC_TOLERANCE_PERCENT   30
+#endif
+
+typedef enum {
+    IR_FRAME_TYPE_DATA,
+    IR_FRAME_TYPE_REPEAT,
+    IR_FRAME_TYPE_INVALID,
+} ir_frame_type_t;
+
+typedef enum {
+    IR_PROTOCOL_NONE,
+    IR_PROTOCOL_NEC,
+    IR_PROTOCOL_NEC_EXTENDED,
+    IR_PROTOCOL_SAMSUNG,
+    IR_PROTOCOL_SONY_SIRC,
+    IR_PROTOCOL_RC5,
+    IR_PROTOCOL_MAX
+} ir_protocol_id_t;
+
+#define IR_PROTOCOL_DECODERS (IR_PROTOCOL_MAX - 1)
+
+typedef struct {
+    ir_frame_type_t type;
+    ir_protocol_id_t protocol;
+    uint16_t address;
+    uint8_t command;
+} ir_result_t;
+
+typedef enum {
+    IR_DECODE_OK,
+    IR_DECODE_IN_PROGRESS,
+    IR_DECODE_BAD_HEADER,
+    IR_DECODE_TRUNCATED,
+    IR_DECODE_TIMING,
+    IR_DECODE_CHECKSUM,
+    IR_DECODE_STATUS_MAX
+} ir_decode_status_t;
+
+typedef enum {
+    // Fixed mark, bit value in the space length (NEC, Samsung)
+    IR_ENCODING_PULSE_DISTANCE,
+    // Bit value in the mark length, fixed space (Sony SIRC)
+    IR_ENCODING_PULSE_WIDTH,
+    // Bi-phase, each bit is a space/mark or mark/space pair of half-bit units (RC5)
+    IR_ENCODING_MANCHESTER,
+} ir_encoding_t;
+
+// Timing and framing of one protocol; all durations in microseconds, 0 where the protocol has no such element.
+// Bits are collected first-received in the most significant position and the validator extracts the fields.
+typedef struct {
+    ir_protocol_id_t id;
+    const char* name;
+    ir_encoding_t encoding;
+    uint8_t tolerance_percent;
+    uint16_t header_mark;
+    uint16_t header_space;
+    uint16_t repeat_space;
+    uint16_t zero_mark;
+    uint16_t zero_space;
+    uint16_t one_mark;
+    uint16_t one_space;
+    uint8_t min_bits;
+    uint8_t max_bits;
+    ir_decode_status_t (*validate)(uint32_t data, uint8_t num_bits, ir_result_t* result);
+} ir_protocol_t;
+
+// Every supported protocol, in the order ties are broken when two complete on the same edge
+extern const ir_protocol_t ir_protocols[IR_PROTOCOL_DECODERS];
+
+typedef enum {
+    IR_DECODER_STATE_IDLE,
+    IR_DECODER_STATE_HEADER_SPACE,
+    IR_DECODER_STATE_REPEAT_MARK,
+    IR_DECODER_STATE_BIT_MARK,
+    IR_DECODER_STATE_BIT_SPACE,
+    IR_DECODER_STATE_STOP_MARK,
+} ir_decoder_state_t;
+
+typedef struct {
+    const ir_protocol_t* protocol;
+    ir_decoder_state_t state;
+    uint8_t bit_count;
+    int8_t pending_half;
+    uint32_t data;
+} ir_decoder_t;
+
+// One decoder per protocol, all advanced by the same edges so no protocol re-scans the frame
+typedef struct {
+    ir_decoder_t decoders[IR_PROTOCOL_DECODERS];
+    ir_decode_status_t last_error;
+    uint8_t last_error_bits;
+} ir_engine_t;
+
+void ir_engine_reset(ir_engine_t* engine);
+
+// Advances every decoder by one mark (receiver output active) or space duration. Returns IR_DECODE_OK with result
+// filled as soon as a protocol recognizes a frame, otherwise IR_DECODE_IN_PROGRESS; a header mark always starts a new
+// frame, so noise ahead of it is skipped.
+ir_decode_status_t ir_engine_feed(ir_engine_t* engine, bool mark, uint16_t duration_us, ir_result_t* result);
+
+// Called when the line has gone idle. Completes frames whose end is only marked by silence (Sony SIRC, RC5 ending in
+// a zero bit) and otherwise reports why the capture did not decode.
+ir_decode_status_t ir_engine_finish(ir_engine_t* engine, ir_result_t* result);
+
+// Decodes one captured frame. durations holds the receiver output, alternating mark and space and starting with a
+// mark; the idle time after the final mark is not included.
+ir_decode_status_t ir_decode_frame(const uint16_t* durations, size_t num_durations, ir_result_t* result);
+
+const char* ir_decode_status_name(ir_decode_status_t status);
+const char* ir_frame_type_name(ir_frame_type_t type);
+const char* ir_protocol_name(ir_protocol_id_t protocol);
+
+// Recorded frames are exchanged as text, one frame per line after this header; '#' starts a comment line:
+//   <protocol>,<type>,<address>,<command>,<d0> <d1> ...
+// e.g. "NEC,data,0x0000,0x68,9000 4500 560 560 ...". The fields are the expected result (protocol "none" and type
+// "invalid" when the frame must be rejected) and the durations are as for ir_decode_frame, in microseconds.
+#define IR_CORPUS_HEADER "# ir-corpus v1: protocol,type,address,command,durations_us"
+
+// Returns the line length without the terminator, or the length needed if it did not fit, like snprintf
+int ir_corpus_format_line(const ir_result_t* expected, const uint16_t* durations, size_t num_durations, char* buf,
+                          size_t buf_len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,162 @@
+// ir_keymap.c
+
+#include "ir_keymap.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include <string.h>
+
+static const char* TAG = "IR_KEYMAP";
+
+typedef struct {
+    const char* name;
+    bool repeats;
+} ir_action_info_t;
+
+static const ir_action_info_t action_info[IR_ACTION_MAX] = {
+    [IR_ACTION_NONE]           = {"none", false},
+    [IR_ACTION_READ_SENSOR]    = {"read_sensor", false},
+    [IR_ACTION_CYCLE_DISPLAY]  = {"cycle_display", true},
+    [IR_ACTION_PLAY_SOUND]     = {"play_sound", false},
+    [IR_ACTION_TOGGLE_LCD]     = {"toggle_lcd", false},
+    [IR_ACTION_TOGGLE_SPEAKER] = {"toggle_speaker", false},
+};
+
+static int _find_remote(const ir_keymap_t* keymap, ir_protocol_id_t protocol, uint16_t address, uint8_t flags) {
+    for (int i = 0; i < IR_KEYMAP_MAX_REMOTES; i++) {
+        const ir_remote_map_t* remote = &keymap->remotes[i];
+        if (remote->protocol == protocol && remote->flags == flags &&
+            ((flags & IR_REMOTE_FLAG_ANY_ADDRESS) || remote->address == address)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void ir_keymap_load_defaults(ir_keymap_t* keymap) {
+    memset(keymap, 0, sizeof(*keymap));
+    keymap->version = IR_KEYMAP_VERSION;
+
+    ir_remote_map_t* remote = &keymap->remotes[0];
+    remote->protocol        = IR_PROTOCOL_NEC;
+    remote->flags           = IR_REMOTE_FLAG_ANY_ADDRESS;
+
+    remote->actions[BUTTON_FORWARD] = IR_ACTION_READ_SENSOR;
+    remote->actions[BUTTON_CYCLE]   = IR_ACTION_CYCLE_DISPLAY;
+    remote->actions[BUTTON_EQ]      = IR_ACTION_PLAY_SOUND;
+    remote->actions[BUTTON_U_SD]    = IR_ACTION_TOGGLE_LCD;
+    remote->actions[BUTTON_MUTE]    = IR_ACTION_TOGGLE_SPEAKER;
+}
+
+ir_action_t ir_keymap_lookup(const ir_keymap_t* keymap, ir_protocol_id_t protocol, uint16_t address, uint8_t command) {
+    const ir_remote_map_t* any_address = NULL;
+    for (int i = 0; i < IR_KEYMAP_MAX_REMOTES; i++) {
+        const ir_remote_map_t* remote = &keymap->remotes[i];
+        if (remote->protocol != protocol) {
+            continue;
+        }
+        if (remote->flags & IR_REMOTE_FLAG_ANY_ADDRESS) {
+            any_address = remote;
+        } else if (remote->address == address && remote->actions[command] != IR_ACTION_NONE) {
+            return (ir_action_t)remote->actions[command];
+        }
+    }
+    return any_address ? (ir_action_t)any_address->actions[command] : IR_ACTION_NONE;
+}
+
+esp_err_t ir_keymap_bind(ir_keymap_t* keymap, ir_protocol_id_t protocol, uint16_t address, uint8_t command,
+                         ir_action_t action) {
+    if (protocol == IR_PROTOCOL_NONE || protocol >= IR_PROTOCOL_MAX || action >= IR_ACTION_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int index               = _find_remote(keymap, protocol, address, 0);
+    ir_remote_map_t* remote = index >= 0 ? &keymap->remotes[index] : NULL;
+    for (int i = 0; remote == NULL && i < IR_KEYMAP_MAX_REMOTES; i++) {
+        if (keymap->remotes[i].protocol == IR_PROTOCOL_NONE) {
+            remote           = &keymap->remotes[i];
+            remote->protocol = protocol;
+            remote->flags    = 0;
+            remote->address  = address;
+            memset(remote->actions, IR_ACTION_NONE, sizeof(remote->actions));
+        }
+    }
+    if (remote == NULL) {
+        ESP_LOGW(TAG, "No free remote slot for %s address 0x%04X", ir_protocol_name(protocol), address);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (action != IR_ACTION_NONE) {
+        for (int i = 0; i < 256; i++) {
+            if (remote->actions[i] == action) {
+                remote->actions[i] = IR_ACTION_NONE;
+            }
+        }
+    }
+    remote->actions[command] = action;
+    return ESP_OK;
+}
+
+esp_err_t ir_keymap_load(ir_keymap_t* keymap) {
+    ir_keymap_load_defaults(keymap);
+
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(IR_KEYMAP_NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (ret == ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGI(TAG, "No stored keymap, using defaults");
+        return ESP_OK;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to open NVS (%s), using defaults", esp_err_to_name(ret));
+        return ret;
+    }
+
+    static ir_keymap_t stored;
+    size_t size = sizeof(stored);
+    ret         = nvs_get_blob(handle, IR_KEYMAP_NVS_KEY, &stored, &size);
+    nvs_close(handle);
+
+    if (ret == ESP_OK && size == sizeof(stored) && stored.version == IR_KEYMAP_VERSION) {
+        memcpy(keymap, &stored, sizeof(stored));
+        ESP_LOGI(TAG, "Keymap loaded from NVS");
+    } else if (ret != ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGW(TAG, "Ignoring stored keymap (%s, %u bytes), using defaults", esp_err_to_name(ret), (unsigned)size);
+    }
+    return ESP_OK;
+}
+
+esp_err_t ir_keymap_save(const ir_keymap_t* keymap) {
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(IR_KEYMAP_NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = nvs_set_blob(handle, IR_KEYMAP_NVS_KEY, keymap, sizeof(*keymap));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to store keymap: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+const char* ir_action_name(ir_action_t action) {
+    return action < IR_ACTION_MAX ? action_info[action].name : "unknown";
+}
+
+ir_action_t ir_action_from_name(const char* name) {
+    for (int i = 0; i < IR_ACTION_MAX; i++) {
+        if (strcmp(action_info[i].name, name) == 0) {
+            return (ir_action_t)i;
+        }
+    }
+    return IR_ACTION_MAX;
+}
+
+bool ir_action_repeats(ir_action_t action) {
+    return action < IR_ACTION_MAX && action_info[action].repeats;
+}
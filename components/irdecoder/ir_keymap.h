@@ -0,0 +1,97 @@
+// ir_keymap.h
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "ir_decode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_KEYMAP_MAX_REMOTES   4
+#define IR_KEYMAP_VERSION       1
+
+#define IR_KEYMAP_NVS_NAMESPACE "ir_keymap"
+#define IR_KEYMAP_NVS_KEY       "remotes"
+
+// Commands of the NEC remote the keymap ships with
+typedef enum {
+    BUTTON_0                = 0x68,
+    BUTTON_1                = 0x30,
+    BUTTON_2                = 0x18,
+    BUTTON_3                = 0x7A,
+    BUTTON_4                = 0x10,
+    BUTTON_5                = 0x38,
+    BUTTON_6                = 0x5A,
+    BUTTON_7                = 0x42,
+    BUTTON_8                = 0x4A,
+    BUTTON_9                = 0x52,
+    BUTTON_PLUS             = 0x90,
+    BUTTON_MINUS            = 0xA8,
+    BUTTON_EQ               = 0xE0,
+    BUTTON_U_SD             = 0xB0,
+    BUTTON_CYCLE            = 0x98,
+    BUTTON_PLAY_PAUSE       = 0x22,
+    BUTTON_BACKWARD         = 0x02,
+    BUTTON_FORWARD          = 0xC2,
+    BUTTON_POWER            = 0xA2,
+    BUTTON_MUTE             = 0xE2,
+    BUTTON_MODE             = 0x62,
+    BUTTON_UNKNOWN_OR_ERROR = 0xFF
+} button_press_t;
+
+typedef enum {
+    IR_ACTION_NONE,
+    IR_ACTION_READ_SENSOR,
+    IR_ACTION_CYCLE_DISPLAY,
+    IR_ACTION_PLAY_SOUND,
+    IR_ACTION_TOGGLE_LCD,
+    IR_ACTION_TOGGLE_SPEAKER,
+    IR_ACTION_MAX
+} ir_action_t;
+
+// Matches every address of the protocol; consulted after a remote bound to the exact address
+#define IR_REMOTE_FLAG_ANY_ADDRESS 0x01
+
+// Dispatch table for one remote, indexed directly by command. An unused slot has protocol IR_PROTOCOL_NONE.
+typedef struct {
+    uint8_t protocol;
+    uint8_t flags;
+    uint16_t address;
+    uint8_t actions[256];
+} ir_remote_map_t;
+
+// Stored in NVS as one blob; a blob of another size or version is ignored in favour of the defaults
+typedef struct {
+    uint32_t version;
+    ir_remote_map_t remotes[IR_KEYMAP_MAX_REMOTES];
+} ir_keymap_t;
+
+void ir_keymap_load_defaults(ir_keymap_t* keymap);
+
+// One pass over the remote slots and at most two table reads: the remote with the exact address, then the
+// protocol's any-address remote
+ir_action_t ir_keymap_lookup(const ir_keymap_t* keymap, ir_protocol_id_t protocol, uint16_t address, uint8_t command);
+
+// Binds the key on that remote, moving the action off any other key of the same remote. Returns ESP_ERR_NO_MEM
+// when the key belongs to a new remote and every slot is taken.
+esp_err_t ir_keymap_bind(ir_keymap_t* keymap, ir_protocol_id_t protocol, uint16_t address, uint8_t command,
+                         ir_action_t action);
+
+// Falls back to the defaults when nothing valid is stored
+esp_err_t ir_keymap_load(ir_keymap_t* keymap);
+esp_err_t ir_keymap_save(const ir_keymap_t* keymap);
+
+const char* ir_action_name(ir_action_t action);
+// IR_ACTION_MAX when no action has that name
+ir_action_t ir_action_from_name(const char* name);
+
+// Whether holding the key keeps firing the action (e.g. scrolling through display modes)
+bool ir_action_repeats(ir_action_t action);
+
+#ifdef __cplusplus
+}
+#endif
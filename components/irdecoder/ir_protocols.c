@@ -0,0 +1,180 @@
+// ir_protocols.c
+
+#include "ir_decode.h"
+
+#define NEC_START_PULSE         9000
+#define NEC_START_SPACE         4500
+#define NEC_REPEAT_SPACE        2250
+#define NEC_BIT_PULSE           560
+#define NEC_ZERO_SPACE          560
+#define NEC_ONE_SPACE           1690
+#define NEC_FRAME_BITS          32
+
+#define SAMSUNG_START_PULSE     4500
+#define SAMSUNG_START_SPACE     4500
+
+#define SIRC_START_PULSE        2400
+#define SIRC_BIT_SPACE          600
+#define SIRC_ZERO_PULSE         600
+#define SIRC_ONE_PULSE          1200
+#ifndef SIRC_TOLERANCE_PERCENT
+#define SIRC_TOLERANCE_PERCENT  30
+#endif
+#define SIRC_MIN_BITS           12
+#define SIRC_MAX_BITS           20
+#define SIRC_COMMAND_BITS       7
+
+#define RC5_HALF_BIT            889
+#ifndef RC5_TOLERANCE_PERCENT
+#define RC5_TOLERANCE_PERCENT   30
+#endif
+#define RC5_FRAME_BITS          14
+
+static uint8_t _byte(uint32_t data, int index) {
+    return (data >> (24 - index * 8)) & 0xFF;
+}
+
+static ir_decode_status_t _validate_nec(uint32_t data, uint8_t num_bits, ir_result_t* result) {
+    if ((_byte(data, 0) ^ _byte(data, 1)) != 0xFF || (_byte(data, 2) ^ _byte(data, 3)) != 0xFF) {
+        return IR_DECODE_CHECKSUM;
+    }
+    result->address = _byte(data, 0);
+    result->command = _byte(data, 2);
+    return IR_DECODE_OK;
+}
+
+// Extended NEC gives up the inverted address for a 16-bit one; frames that pass the standard check stay NEC
+static ir_decode_status_t _validate_nec_extended(uint32_t data, uint8_t num_bits, ir_result_t* result) {
+    if ((_byte(data, 0) ^ _byte(data, 1)) == 0xFF || (_byte(data, 2) ^ _byte(data, 3)) != 0xFF) {
+        return IR_DECODE_CHECKSUM;
+    }
+    result->address = (uint16_t)(data >> 16);
+    result->command = _byte(data, 2);
+    return IR_DECODE_OK;
+}
+
+static ir_decode_status_t _validate_samsung(uint32_t data, uint8_t num_bits, ir_result_t* result) {
+    if (_byte(data, 0) != _byte(data, 1) || (_byte(data, 2) ^ _byte(data, 3)) != 0xFF) {
+        return IR_DECODE_CHECKSUM;
+    }
+    result->address = _byte(data, 0);
+    result->command = _byte(data, 2);
+    return IR_DECODE_OK;
+}
+
+// 7 command bits then 5, 8 or 13 address bits, least significant first
+static ir_decode_status_t _validate_sirc(uint32_t data, uint8_t num_bits, ir_result_t* result) {
+    if (num_bits != 12 && num_bits != 15 && num_bits != 20) {
+        return IR_DECODE_TRUNCATED;
+    }
+
+    uint32_t fields = 0;
+    for (int i = 0; i < num_bits; i++) {
+        fields |= ((data >> (num_bits - 1 - i)) & 1) << i;
+    }
+    result->command = fields & ((1 << SIRC_COMMAND_BITS) - 1);
+    result->address = (uint16_t)(fields >> SIRC_COMMAND_BITS);
+    return IR_DECODE_OK;
+}
+
+// Start bit, field bit (inverted command bit 6 on RC5X), toggle, 5 address bits, 6 command bits
+static ir_decode_status_t _validate_rc5(uint32_t data, uint8_t num_bits, ir_result_t* result) {
+    if (!(data & (1 << 13))) {
+        return IR_DECODE_TIMING;
+    }
+    result->address = (data >> 6) & 0x1F;
+    result->command = (data & 0x3F) | ((data & (1 << 12)) ? 0 : 0x40);
+    return IR_DECODE_OK;
+}
+
+const ir_protocol_t ir_protocols[IR_PROTOCOL_DECODERS] = {
+    {
+        .id                = IR_PROTOCOL_NEC,
+        .name              = "NEC",
+        .encoding          = IR_ENCODING_PULSE_DISTANCE,
+        .tolerance_percent = NEC_TOLERANCE_PERCENT,
+        .header_mark       = NEC_START_PULSE,
+        .header_space      = NEC_START_SPACE,
+        .repeat_space      = NEC_REPEAT_SPACE,
+        .zero_mark         = NEC_BIT_PULSE,
+        .zero_space        = NEC_ZERO_SPACE,
+        .one_mark          = NEC_BIT_PULSE,
+        .one_space         = NEC_ONE_SPACE,
+        .min_bits          = NEC_FRAME_BITS,
+        .max_bits          = NEC_FRAME_BITS,
+        .validate          = _validate_nec,
+    },
+    {
+        .id                = IR_PROTOCOL_NEC_EXTENDED,
+        .name              = "NEC extended",
+        .encoding          = IR_ENCODING_PULSE_DISTANCE,
+        .tolerance_percent = NEC_TOLERANCE_PERCENT,
+        .header_mark       = NEC_START_PULSE,
+        .header_space      = NEC_START_SPACE,
+        .repeat_space      = 0,
+        .zero_mark         = NEC_BIT_PULSE,
+        .zero_space        = NEC_ZERO_SPACE,
+        .one_mark          = NEC_BIT_PULSE,
+        .one_space         = NEC_ONE_SPACE,
+        .min_bits          = NEC_FRAME_BITS,
+        .max_bits          = NEC_FRAME_BITS,
+        .validate          = _validate_nec_extended,
+    },
+    {
+        .id                = IR_PROTOCOL_SAMSUNG,
+        .name              = "Samsung",
+        .encoding          = IR_ENCODING_PULSE_DISTANCE,
+        .tolerance_percent = NEC_TOLERANCE_PERCENT,
+        .header_mark       = SAMSUNG_START_PULSE,
+        .header_space      = SAMSUNG_START_SPACE,
+        .repeat_space      = 0,
+        .zero_mark         = NEC_BIT_PULSE,
+        .zero_space        = NEC_ZERO_SPACE,
+        .one_mark          = NEC_BIT_PULSE,
+        .one_space         = NEC_ONE_SPACE,
+        .min_bits          = NEC_FRAME_BITS,
+        .max_bits          = NEC_FRAME_BITS,
+        .validate          = _validate_samsung,
+    },
+    {
+        .id                = IR_PROTOCOL_SONY_SIRC,
+        .name              = "Sony SIRC",
+        .encoding          = IR_ENCODING_PULSE_WIDTH,
+        .tolerance_percent = SIRC_TOLERANCE_PERCENT,
+        .header_mark       = SIRC_START_PULSE,
+        .header_space      = SIRC_BIT_SPACE,
+        .repeat_space      = 0,
+        .zero_mark         = SIRC_ZERO_PULSE,
+        .zero_space        = SIRC_BIT_SPACE,
+        .one_mark          = SIRC_ONE_PULSE,
+        .one_space         = SIRC_BIT_SPACE,
+        .min_bits          = SIRC_MIN_BITS,
+        .max_bits          = SIRC_MAX_BITS,
+        .validate          = _validate_sirc,
+    },
+    {
+        .id                = IR_PROTOCOL_RC5,
+        .name              = "RC5",
+        .encoding          = IR_ENCODING_MANCHESTER,
+        .tolerance_percent = RC5_TOLERANCE_PERCENT,
+        .header_mark       = 0,
+        .header_space      = 0,
+        .repeat_space      = 0,
+        .zero_mark         = RC5_HALF_BIT,
+        .zero_space        = RC5_HALF_BIT,
+        .one_mark          = RC5_HALF_BIT,
+        .one_space         = RC5_HALF_BIT,
+        .min_bits          = RC5_FRAME_BITS,
+        .max_bits          = RC5_FRAME_BITS,
+        .validate          = _validate_rc5,
+    },
+};
+
+const char* ir_protocol_name(ir_protocol_id_t protocol) {
+    for (int i = 0; i < IR_PROTOCOL_DECODERS; i++) {
+        if (ir_protocols[i].id == protocol) {
+            return ir_protocols[i].name;
+        }
+    }
+    return "none";
+}
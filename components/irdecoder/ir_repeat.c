@@ -0,0 +1,43 @@
+// ir_repeat.c
+
+#include "ir_repeat.h"
+
+static ir_key_event_t _auto_repeat(ir_held_key_t* held, uint32_t timestamp_us) {
+    held->last_frame_us = timestamp_us;
+    if (!ir_action_repeats(held->action) || timestamp_us - held->pressed_us < IR_REPEAT_DELAY_MS * 1000 ||
+        timestamp_us - held->last_fire_us < IR_REPEAT_INTERVAL_MS * 1000) {
+        return IR_KEY_EVENT_NONE;
+    }
+
+    held->last_fire_us = timestamp_us;
+    return IR_KEY_EVENT_REPEAT;
+}
+
+ir_key_event_t ir_held_key_frame(ir_held_key_t* held, const ir_result_t* frame, uint32_t timestamp_us) {
+    bool held_recently = held->valid && timestamp_us - held->last_frame_us <= IR_REPEAT_GAP_MS * 1000;
+
+    if (frame->type == IR_FRAME_TYPE_REPEAT) {
+        return held_recently ? _auto_repeat(held, timestamp_us) : IR_KEY_EVENT_NONE;
+    }
+    if (frame->type != IR_FRAME_TYPE_DATA) {
+        return IR_KEY_EVENT_NONE;
+    }
+
+    // Remotes without a repeat code resend the whole frame while the key is down
+    if (held_recently && held->protocol == frame->protocol && held->address == frame->address &&
+        held->command == frame->command) {
+        return _auto_repeat(held, timestamp_us);
+    }
+    return IR_KEY_EVENT_PRESS;
+}
+
+void ir_held_key_press(ir_held_key_t* held, const ir_result_t* frame, ir_action_t action, uint32_t timestamp_us) {
+    held->valid         = true;
+    held->protocol      = frame->protocol;
+    held->address       = frame->address;
+    held->command       = frame->command;
+    held->action        = action;
+    held->pressed_us    = timestamp_us;
+    held->last_frame_us = timestamp_us;
+    held->last_fire_us  = timestamp_us;
+}
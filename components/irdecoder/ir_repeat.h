@@ -0,0 +1,46 @@
+// ir_repeat.h
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ir_decode.h"
+#include "ir_keymap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A key counts as held while its frames (or NEC repeat codes) keep arriving within the gap; repeating actions
+// fire again after the delay and then every interval
+#define IR_REPEAT_GAP_MS        200
+#define IR_REPEAT_DELAY_MS      500
+#define IR_REPEAT_INTERVAL_MS   200
+
+typedef struct {
+    bool valid;
+    ir_protocol_id_t protocol;
+    uint16_t address;
+    uint8_t command;
+    ir_action_t action;
+    uint32_t pressed_us;
+    uint32_t last_frame_us;
+    uint32_t last_fire_us;
+} ir_held_key_t;
+
+typedef enum {
+    // Nothing to do: a repeat of no held key, a held key not due to fire, or a frame that is not a key
+    IR_KEY_EVENT_NONE,
+    // A new key; look up its action and record it with ir_held_key_press
+    IR_KEY_EVENT_PRESS,
+    // The held key's action fires again
+    IR_KEY_EVENT_REPEAT,
+} ir_key_event_t;
+
+// Timestamps are the capture time of the frame's last edge, so the repeat timing is independent of decode latency
+ir_key_event_t ir_held_key_frame(ir_held_key_t* held, const ir_result_t* frame, uint32_t timestamp_us);
+void ir_held_key_press(ir_held_key_t* held, const ir_result_t* frame, ir_action_t action, uint32_t timestamp_us);
+
+#ifdef __cplusplus
+}
+#endif
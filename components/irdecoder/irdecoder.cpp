@@ -0,0 +1,160 @@
+// irdecoder.cpp
+
+#include "irdecoder.h"
+#include "driver/rmt_rx.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+#include "spsc_ring.hpp"
+
+static const char* TAG = "IR_DRIVER";
+
+static rmt_channel_handle_t rx_channel = NULL;
+static TaskHandle_t notify_task        = NULL;
+
+// Edges are copied out in the interrupt, so one buffer is enough and the receiver is re-armed straight away
+static rmt_symbol_word_t rx_symbols[IR_RMT_MAX_SYMBOLS];
+static volatile bool rx_rearm_pending = false;
+
+static SpscRing<ir_edge_t, IR_EDGE_RING_SIZE> edge_ring;
+static volatile ir_capture_stats_t capture_stats = {};
+
+static const rmt_receive_config_t receive_config = {
+    .signal_range_min_ns = IR_RMT_MIN_PULSE_NS,
+    .signal_range_max_ns = IR_RMT_IDLE_NS,
+};
+
+// The receiver idles high and pulls the line low for a mark; a zero-length duration ends the capture
+static inline uint16_t _symbol_duration(const rmt_symbol_word_t* symbols, size_t index) {
+    const rmt_symbol_word_t* symbol = &symbols[index / 2];
+    return index % 2 ? symbol->duration1 : symbol->duration0;
+}
+
+static inline bool _symbol_mark(const rmt_symbol_word_t* symbols, size_t index) {
+    const rmt_symbol_word_t* symbol = &symbols[index / 2];
+    return (index % 2 ? symbol->level1 : symbol->level0) == 0;
+}
+
+// One interrupt per frame: the RMT records every edge and only calls back once the line goes idle. A capture is
+// queued whole or not at all so the decoders never see half a frame.
+static bool IRAM_ATTR _rmt_rx_done_callback(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t* edata, void* user_data) {
+    const rmt_symbol_word_t* symbols = edata->received_symbols;
+    size_t num_edges                 = 0;
+    uint32_t frame_us                = 0;
+
+    while (num_edges < edata->num_symbols * 2) {
+        uint16_t duration = _symbol_duration(symbols, num_edges);
+        if (duration == 0) {
+            break;
+        }
+        frame_us += duration;
+        num_edges++;
+    }
+
+    capture_stats.captures = capture_stats.captures + 1;
+    if (edge_ring.write_available() < num_edges + 1) {
+        capture_stats.dropped_captures = capture_stats.dropped_captures + 1;
+    } else {
+        // The callback comes an idle timeout after the last edge
+        uint32_t timestamp_us = (uint32_t)esp_timer_get_time() - IR_RMT_IDLE_NS / 1000 - frame_us;
+        for (size_t i = 0; i < num_edges; i++) {
+            ir_edge_t edge = {
+                .timestamp_us   = timestamp_us,
+                .duration_us    = _symbol_duration(symbols, i),
+                .mark           = _symbol_mark(symbols, i),
+                .end_of_capture = 0,
+            };
+            edge_ring.push(edge);
+            timestamp_us += edge.duration_us;
+        }
+        edge_ring.push({.timestamp_us = timestamp_us, .duration_us = 0, .mark = 0, .end_of_capture = 1});
+        capture_stats.edges = capture_stats.edges + num_edges;
+    }
+
+#if CONFIG_RMT_RECV_FUNC_IN_IRAM
+    if (rmt_receive(rx_channel, rx_symbols, sizeof(rx_symbols), &receive_config) != ESP_OK) {
+        capture_stats.rearm_failures = capture_stats.rearm_failures + 1;
+    }
+#else
+    rx_rearm_pending = true;
+#endif
+
+    BaseType_t higher_priority_task = pdFALSE;
+    vTaskNotifyGiveFromISR(notify_task, &higher_priority_task);
+    return higher_priority_task == pdTRUE;
+}
+
+static esp_err_t _ir_arm_receive(void) {
+    esp_err_t ret = rmt_receive(rx_channel, rx_symbols, sizeof(rx_symbols), &receive_config);
+    if (ret != ESP_OK) {
+        capture_stats.rearm_failures = capture_stats.rearm_failures + 1;
+        ESP_LOGE(TAG, "Failed to start RMT receive: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t ir_decoder_init(TaskHandle_t task) {
+    if (rx_channel) {
+        return ESP_OK;
+    }
+    if (task == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    notify_task = task;
+
+    rmt_rx_channel_config_t rx_config = {
+        .gpio_num          = IR_PIN,
+        .clk_src           = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz     = IR_RMT_RESOLUTION_HZ,
+        .mem_block_symbols = IR_RMT_MAX_SYMBOLS,
+    };
+
+    esp_err_t ret = rmt_new_rx_channel(&rx_config, &rx_channel);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create RMT RX channel: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    rmt_rx_event_callbacks_t callbacks = {
+        .on_recv_done = _rmt_rx_done_callback,
+    };
+    ret = rmt_rx_register_event_callbacks(rx_channel, &callbacks, NULL);
+    if (ret == ESP_OK) {
+        ret = rmt_enable(rx_channel);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to enable RMT RX channel: %s", esp_err_to_name(ret));
+        rmt_del_channel(rx_channel);
+        rx_channel = NULL;
+        return ret;
+    }
+
+#if !CONFIG_RMT_RECV_FUNC_IN_IRAM
+    ESP_LOGW(TAG, "CONFIG_RMT_RECV_FUNC_IN_IRAM is off, the receiver is re-armed from the task");
+#endif
+    ESP_LOGI(TAG, "RMT capture initialized");
+    return _ir_arm_receive();
+}
+
+// Consumer side of the edge ring; only the task passed to ir_decoder_init may call this
+bool ir_decoder_read_edge(ir_edge_t* edge) {
+    if (edge_ring.pop(*edge)) {
+        return true;
+    }
+    if (rx_rearm_pending) {
+        rx_rearm_pending = false;
+        _ir_arm_receive();
+    }
+    return false;
+}
+
+void ir_decoder_get_stats(ir_capture_stats_t* stats) {
+    stats->captures         = capture_stats.captures;
+    stats->edges            = capture_stats.edges;
+    stats->dropped_captures = capture_stats.dropped_captures;
+    stats->ring_overflows   = edge_ring.overflow_count();
+    stats->ring_high_water  = edge_ring.high_water_mark();
+    stats->rearm_failures   = capture_stats.rearm_failures;
+}
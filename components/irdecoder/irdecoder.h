@@ -6,46 +6,51 @@
 #include <stdbool.h>
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
-
-extern SemaphoreHandle_t xDecoderSignaler;
+#include "freertos/task.h"
+#include "ir_decode.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #define IR_PIN GPIO_NUM_14
-#define IR_TIMES_SIZE 128
-
-#define TIMEOUT_US 100000
 
-#define NEC_START_PULSE 9000
-#define NEC_START_SPACE 4500
-#define NEC_BIT_PULSE 560
-#define NEC_ZERO_SPACE 560
-#define NEC_ONE_SPACE 1690
-#define NEC_TOLERANCE_PERCENT 30
+#define IR_RMT_RESOLUTION_HZ 1000000
+#define IR_RMT_MAX_SYMBOLS 64
 
-#define IR_MATCH(value, target)                                          \
-    ((value) >= ((target) - ((target) * NEC_TOLERANCE_PERCENT / 100)) && \
-     (value) <= ((target) + ((target) * NEC_TOLERANCE_PERCENT / 100)))
+// Shorter pulses are filtered out as noise; the frame ends once the line has been idle this long
+#define IR_RMT_MIN_PULSE_NS 1250
+#define IR_RMT_IDLE_NS 12000000
 
-typedef enum {
-    IR_FRAME_TYPE_DATA,
-    IR_FRAME_TYPE_REPEAT,
-    IR_FRAME_TYPE_INVALID,
-} ir_frame_type_t;
+// Edges queued between the RMT interrupt and the decoder task, a few full-length frames. Must be a power of two.
+#define IR_EDGE_RING_SIZE 256
 
 typedef struct {
-    ir_frame_type_t type;
-    uint8_t address;
-    uint8_t command;
-} ir_result_t;
+    // When the edge began, low 32 bits of esp_timer time
+    uint32_t timestamp_us;
+    uint16_t duration_us;
+    // Receiver output active (line pulled low)
+    uint8_t mark;
+    // The line went idle and the capture is over; carries no duration
+    uint8_t end_of_capture;
+} ir_edge_t;
 
-esp_err_t ir_decoder_init();
-bool ir_decoder_has_data();
-void ir_decoder_get_data(ir_result_t* result);
+typedef struct {
+    uint32_t captures;
+    uint32_t edges;
+    // Whole captures discarded because the ring could not take every edge
+    uint32_t dropped_captures;
+    uint32_t ring_overflows;
+    uint32_t ring_high_water;
+    uint32_t rearm_failures;
+} ir_capture_stats_t;
+
+// Every capture is queued as edges from the RMT interrupt, which then wakes notify_task with a direct task
+// notification; the task drains the queue with ir_decoder_read_edge.
+esp_err_t ir_decoder_init(TaskHandle_t notify_task);
+bool ir_decoder_read_edge(ir_edge_t* edge);
+void ir_decoder_get_stats(ir_capture_stats_t* stats);
 
 #ifdef __cplusplus
 }
-#endif
\ No newline at end of file
+#endif
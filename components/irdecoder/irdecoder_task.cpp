@@ -3,40 +3,33 @@
 #include "irdecoder_task.hpp"
 #include "dht11_task.hpp"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "event_bus.hpp"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "lcd_task.hpp"
 #include "speaker_task.hpp"
-#include <map>
 
 static const char* TAG = "IR_DECODER_TASK";
 
 IRDecoder* IRDecoder::s_decoder_instance = nullptr;
 
-const std::map<uint8_t, button_press_t> IRDecoder::command_map = {
-    {0x68, BUTTON_0},
-    {0x30, BUTTON_1},
-    {0x18, BUTTON_2},
-    {0x7A, BUTTON_3},
-    {0x10, BUTTON_4},
-    {0x38, BUTTON_5},
-    {0x5A, BUTTON_6},
-    {0x42, BUTTON_7},
-    {0x4A, BUTTON_8},
-    {0x52, BUTTON_9},
-    {0x90, BUTTON_PLUS},
-    {0xA8, BUTTON_MINUS},
-    {0xE0, BUTTON_EQ},
-    {0xB0, BUTTON_U_SD},
-    {0x98, BUTTON_CYCLE},
-    {0x22, BUTTON_PLAY_PAUSE},
-    {0x02, BUTTON_BACKWARD},
-    {0xC2, BUTTON_FORWARD},
-    {0xA2, BUTTON_POWER},
-    {0xE2, BUTTON_MUTE},
-    {0x62, BUTTON_MODE}};
+// Indexed by ir_action_t
+typedef void (*ir_action_handler_t)();
+static const ir_action_handler_t action_handlers[] = {
+    nullptr,
+    [] { DHT11Sensor::get_instance()->notify_read(); },
+    [] { LCDDisplay::get_instance()->cycle_mode(); },
+    [] { Speaker::get_instance()->play_sound(); },
+    [] { LCDDisplay::get_instance()->toggle_power(); },
+    [] { Speaker::get_instance()->toggle_power(); },
+};
+static_assert(sizeof(action_handlers) / sizeof(action_handlers[0]) == IR_ACTION_MAX, "one handler per IR action");
 
 IRDecoder::IRDecoder() {
+    keymap_mutex  = xSemaphoreCreateMutex();
+    capture_mutex = xSemaphoreCreateMutex();
+    ir_keymap_load_defaults(&keymap);
 }
 
 IRDecoder::~IRDecoder() {
@@ -53,39 +46,140 @@ IRDecoder* IRDecoder::get_instance() {
     return s_decoder_instance;
 }
 
-void IRDecoder::map_command_to_action(uint8_t cmd) {
-    std::map<uint8_t, button_press_t>::const_iterator it = command_map.find(cmd);
-
-    if (it != command_map.end()) {
-        button_press_t button = it->second;
-        switch (button) {
-        case BUTTON_FORWARD:
-            DHT11Sensor::get_instance()->notify_read();
-            ESP_LOGI(TAG, "Button: FORWARD");
-            break;
-        case BUTTON_CYCLE:
-            LCDDisplay::get_instance()->cycle_mode();
-            ESP_LOGI(TAG, "Button: CYCLE");
-            break;
-        case BUTTON_EQ:
-            Speaker::get_instance()->play_sound();
-            ESP_LOGI(TAG, "Button: EQ");
-            break;
-        case BUTTON_U_SD:
-            LCDDisplay::get_instance()->toggle_power();
-            ESP_LOGI(TAG, "Button: U/SD");
-            break;
-        case BUTTON_MUTE:
-            Speaker::get_instance()->toggle_power();
-            ESP_LOGI(TAG, "Button: MUTE"); 
-            break;
-        default:
-            ESP_LOGI(TAG, "Button: %s (Command: 0x%02X)", get_button_name(button), cmd);
-            break;
+void IRDecoder::publish_input(uint8_t cmd) {
+    bus_event_t event  = {};
+    event.topic        = EVENT_TOPIC_INPUT;
+    event.input.source = EVENT_INPUT_SOURCE_IR;
+    event.input.code   = cmd;
+    EventBus::get_instance()->publish(event);
+}
+
+esp_err_t IRDecoder::start_learning(ir_action_t action) {
+    if (action >= IR_ACTION_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(keymap_mutex, portMAX_DELAY);
+    learn_all_actions = action == IR_ACTION_NONE;
+    learn_action      = learn_all_actions ? (ir_action_t)(IR_ACTION_NONE + 1) : action;
+    learn_deadline_us = esp_timer_get_time() + IR_LEARN_TIMEOUT_MS * 1000LL;
+    learning.store(true);
+    xSemaphoreGive(keymap_mutex);
+
+    ESP_LOGI(TAG, "Learning: press the key for %s", ir_action_name(learn_action));
+    return ESP_OK;
+}
+
+void IRDecoder::stop_learning() {
+    learning.store(false);
+}
+
+ir_learn_status_t IRDecoder::get_learn_status() {
+    ir_learn_status_t status = {};
+    int64_t now_us           = esp_timer_get_time();
+
+    xSemaphoreTake(keymap_mutex, portMAX_DELAY);
+    status.active = learning.load() && now_us < learn_deadline_us;
+    if (status.active) {
+        status.all_actions  = learn_all_actions;
+        status.action       = learn_action;
+        status.remaining_ms = (learn_deadline_us - now_us) / 1000;
+    }
+    xSemaphoreGive(keymap_mutex);
+    return status;
+}
+
+size_t IRDecoder::get_bindings(ir_binding_t* bindings, size_t max_bindings) {
+    size_t count = 0;
+
+    xSemaphoreTake(keymap_mutex, portMAX_DELAY);
+    for (int i = 0; i < IR_KEYMAP_MAX_REMOTES; i++) {
+        const ir_remote_map_t* remote = &keymap.remotes[i];
+        for (int command = 0; remote->protocol != IR_PROTOCOL_NONE && command < 256 && count < max_bindings; command++) {
+            if (remote->actions[command] != IR_ACTION_NONE) {
+                bindings[count++] = {
+                    .protocol    = (ir_protocol_id_t)remote->protocol,
+                    .address     = remote->address,
+                    .any_address = (remote->flags & IR_REMOTE_FLAG_ANY_ADDRESS) != 0,
+                    .command     = (uint8_t)command,
+                    .action      = (ir_action_t)remote->actions[command],
+                };
+            }
         }
+    }
+    xSemaphoreGive(keymap_mutex);
+    return count;
+}
+
+// Returns true when the key was taken for learning rather than dispatched
+bool IRDecoder::learn_key(const ir_result_t& frame) {
+    xSemaphoreTake(keymap_mutex, portMAX_DELAY);
+    if (!learning.load()) {
+        xSemaphoreGive(keymap_mutex);
+        return false;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    if (now_us >= learn_deadline_us) {
+        learning.store(false);
+        xSemaphoreGive(keymap_mutex);
+        ESP_LOGW(TAG, "Learning timed out");
+        return false;
+    }
+
+    ir_action_t action = learn_action;
+    esp_err_t ret      = ir_keymap_bind(&keymap, frame.protocol, frame.address, frame.command, action);
+    if (ret == ESP_OK && learn_all_actions && action + 1 < IR_ACTION_MAX) {
+        learn_action      = (ir_action_t)(action + 1);
+        learn_deadline_us = now_us + IR_LEARN_TIMEOUT_MS * 1000LL;
     } else {
-        ESP_LOGW(TAG, "Unmapped IR command: 0x%02X", cmd);
+        learning.store(false);
+    }
+    xSemaphoreGive(keymap_mutex);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to learn key: %s", esp_err_to_name(ret));
+        return true;
     }
+
+    ESP_LOGI(TAG, "Learned %s address 0x%04X command 0x%02X as %s", ir_protocol_name(frame.protocol), frame.address,
+             frame.command, ir_action_name(action));
+    ir_keymap_save(&keymap);
+    if (learning.load()) {
+        ESP_LOGI(TAG, "Learning: press the key for %s", ir_action_name(learn_action));
+    }
+    return true;
+}
+
+void IRDecoder::run_action(ir_action_t action) {
+    ESP_LOGI(TAG, "Action: %s", ir_action_name(action));
+    action_handlers[action]();
+}
+
+void IRDecoder::handle_frame(const ir_result_t& frame, uint32_t timestamp_us) {
+    ir_key_event_t event = ir_held_key_frame(&held, &frame, timestamp_us);
+    if (event == IR_KEY_EVENT_REPEAT) {
+        run_action(held.action);
+    }
+    if (event != IR_KEY_EVENT_PRESS) {
+        return;
+    }
+
+    publish_input(frame.command);
+
+    ir_action_t action = IR_ACTION_NONE;
+    if (!learning.load() || !learn_key(frame)) {
+        action = ir_keymap_lookup(&keymap, frame.protocol, frame.address, frame.command);
+        if (action == IR_ACTION_NONE) {
+            ESP_LOGW(TAG, "Unmapped %s key: address 0x%04X command 0x%02X", ir_protocol_name(frame.protocol),
+                     frame.address, frame.command);
+        } else {
+            run_action(action);
+        }
+    }
+
+    // A key held while learning stays bound to nothing, so it cannot run on into the next action
+    ir_held_key_press(&held, &frame, action, timestamp_us);
 }
 
 const char* get_button_name(button_press_t button) {
@@ -139,6 +233,77 @@ const char* get_button_name(button_press_t button) {
     }
 }
 
+void IRDecoder::set_capture_mode(bool enabled) {
+    capture_enabled.store(enabled);
+    ESP_LOGI(TAG, "Capture mode %s", enabled ? "on" : "off");
+}
+
+bool IRDecoder::is_capture_mode() {
+    return capture_enabled.load();
+}
+
+void IRDecoder::clear_captures() {
+    xSemaphoreTake(capture_mutex, portMAX_DELAY);
+    capture_count = 0;
+    xSemaphoreGive(capture_mutex);
+}
+
+size_t IRDecoder::get_capture_count() {
+    xSemaphoreTake(capture_mutex, portMAX_DELAY);
+    size_t count = capture_count;
+    xSemaphoreGive(capture_mutex);
+    return count;
+}
+
+bool IRDecoder::get_capture(size_t index, ir_capture_t* capture) {
+    xSemaphoreTake(capture_mutex, portMAX_DELAY);
+    bool found = index < capture_count;
+    if (found) {
+        *capture = captures[(capture_next + IR_CAPTURE_HISTORY - capture_count + index) % IR_CAPTURE_HISTORY];
+    }
+    xSemaphoreGive(capture_mutex);
+    return found;
+}
+
+void IRDecoder::get_decode_stats(ir_decode_stats_t* stats) {
+    xSemaphoreTake(capture_mutex, portMAX_DELAY);
+    *stats = decode_stats;
+    xSemaphoreGive(capture_mutex);
+}
+
+// A leading space cannot belong to a frame, so recorded captures always start with a mark like a corpus entry
+void IRDecoder::record_edge(const ir_edge_t& edge) {
+    if (capture_scratch.num_durations == 0 && !edge.mark) {
+        return;
+    }
+    if (capture_scratch.num_durations < IR_CAPTURE_MAX_DURATIONS) {
+        capture_scratch.durations[capture_scratch.num_durations++] = edge.duration_us;
+    }
+}
+
+void IRDecoder::end_capture(uint32_t timestamp_us, ir_decode_status_t status) {
+    if (status != IR_DECODE_OK && status < IR_DECODE_STATUS_MAX) {
+        xSemaphoreTake(capture_mutex, portMAX_DELAY);
+        decode_stats.rejects[status]++;
+        xSemaphoreGive(capture_mutex);
+    }
+
+    if (capture_scratch.num_durations > 0) {
+        capture_scratch.timestamp_us = timestamp_us;
+        capture_scratch.status       = status;
+        if (status != IR_DECODE_OK) {
+            capture_scratch.result = {IR_FRAME_TYPE_INVALID, IR_PROTOCOL_NONE, 0, 0};
+        }
+
+        xSemaphoreTake(capture_mutex, portMAX_DELAY);
+        captures[capture_next] = capture_scratch;
+        capture_next           = (capture_next + 1) % IR_CAPTURE_HISTORY;
+        capture_count          = capture_count < IR_CAPTURE_HISTORY ? capture_count + 1 : IR_CAPTURE_HISTORY;
+        xSemaphoreGive(capture_mutex);
+    }
+    capture_scratch.num_durations = 0;
+}
+
 void IRDecoder::decoder_task_wrapper(void* pvParameters) {
     IRDecoder* instance = static_cast<IRDecoder*>(pvParameters);
     if (instance) {
@@ -148,10 +313,11 @@ void IRDecoder::decoder_task_wrapper(void* pvParameters) {
 }
 
 esp_err_t IRDecoder::start_task(BaseType_t priority, uint32_t stack_depth) {
-    esp_err_t result = ir_decoder_init();
-    if (result != ESP_OK) {
-        return result;
+    if (keymap_mutex == nullptr || capture_mutex == nullptr) {
+        return ESP_ERR_NO_MEM;
     }
+    ir_keymap_load(&keymap);
+
     BaseType_t task_result = xTaskCreate(
         decoder_task_wrapper,
         "ir_decoder_task",
@@ -163,22 +329,75 @@ esp_err_t IRDecoder::start_task(BaseType_t priority, uint32_t stack_depth) {
         ESP_LOGE(TAG, "Failed to create IR decoder task");
         return ESP_FAIL;
     }
-    return ESP_OK;
+
+    // The task only waits for notifications until the receiver is running, so it must exist first
+    esp_err_t result = ir_decoder_init(this->task_handle);
+    if (result != ESP_OK) {
+        vTaskDelete(this->task_handle);
+        this->task_handle = nullptr;
+    }
+    return result;
 }
 
+// Drains every queued edge per wakeup, so captures that arrived while the task was busy are not lost
 void IRDecoder::decoder_task_loop() {
     ESP_LOGI(TAG, "IR decoder task started");
+    ir_engine_reset(&engine);
+    bool frame_decoded      = false;
+    bool capturing          = capture_enabled.load();
+    uint32_t reported_drops = 0;
+
     while (true) {
-        if (xSemaphoreTake(xDecoderSignaler, portMAX_DELAY) == pdTRUE) {
-            ir_result_t decoded_signal;
-            ir_decoder_get_data(&decoded_signal);
-            if (decoded_signal.type == IR_FRAME_TYPE_DATA) {
-                map_command_to_action(decoded_signal.command);
-            } else if (decoded_signal.type == IR_FRAME_TYPE_REPEAT) {
-                ESP_LOGI(TAG, "Repeat Code Detected");
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        ir_edge_t edge;
+        while (ir_decoder_read_edge(&edge)) {
+            ir_result_t frame         = {};
+            ir_decode_status_t status = IR_DECODE_IN_PROGRESS;
+
+            if (!edge.end_of_capture) {
+                if (capturing) {
+                    record_edge(edge);
+                }
+                status = ir_engine_feed(&engine, edge.mark, edge.duration_us, &frame);
+            } else if (frame_decoded) {
+                // Whatever follows a decoded frame in the same capture is only its stop mark
+                ir_engine_reset(&engine);
             } else {
-                ESP_LOGW(TAG, "Invalid Frame Detected");
+                // Sony and some RC5 frames are only complete once the line has gone idle
+                status = ir_engine_finish(&engine, &frame);
+                if (status != IR_DECODE_OK) {
+                    ESP_LOGE(TAG, "IR FRAME REJECTED: %s", ir_decode_status_name(status));
+                }
+            }
+
+            if (status == IR_DECODE_OK) {
+                if (!frame_decoded) {
+                    capture_scratch.result = frame;
+                }
+                frame_decoded = true;
+                xSemaphoreTake(capture_mutex, portMAX_DELAY);
+                if (frame.type == IR_FRAME_TYPE_REPEAT) {
+                    decode_stats.repeats++;
+                } else {
+                    decode_stats.frames[frame.protocol]++;
+                }
+                xSemaphoreGive(capture_mutex);
+                handle_frame(frame, edge.timestamp_us);
             }
+
+            if (edge.end_of_capture) {
+                end_capture(edge.timestamp_us, frame_decoded ? IR_DECODE_OK : status);
+                frame_decoded = false;
+                capturing     = capture_enabled.load();
+            }
+        }
+
+        ir_capture_stats_t stats;
+        ir_decoder_get_stats(&stats);
+        if (stats.dropped_captures != reported_drops) {
+            ESP_LOGW(TAG, "Edge ring full, %u IR captures dropped so far", (unsigned)stats.dropped_captures);
+            reported_drops = stats.dropped_captures;
         }
     }
 }
@@ -4,37 +4,54 @@
 
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
+#include "ir_keymap.h"
+#include "ir_repeat.h"
 #include "irdecoder.h"
 
+#define IR_LEARN_TIMEOUT_MS     30000
+
+// Raw captures kept while capture mode is on, for dumping as a frame corpus
+#define IR_CAPTURE_HISTORY          8
+#define IR_CAPTURE_MAX_DURATIONS    (IR_RMT_MAX_SYMBOLS * 2)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-typedef enum {
-    BUTTON_0                = 0x68,
-    BUTTON_1                = 0x30,
-    BUTTON_2                = 0x18,
-    BUTTON_3                = 0x7A,
-    BUTTON_4                = 0x10,
-    BUTTON_5                = 0x38,
-    BUTTON_6                = 0x5A,
-    BUTTON_7                = 0x42,
-    BUTTON_8                = 0x4A,
-    BUTTON_9                = 0x52,
-    BUTTON_PLUS             = 0x90,
-    BUTTON_MINUS            = 0xA8,
-    BUTTON_EQ               = 0xE0,
-    BUTTON_U_SD             = 0xB0,
-    BUTTON_CYCLE            = 0x98,
-    BUTTON_PLAY_PAUSE       = 0x22,
-    BUTTON_BACKWARD         = 0x02,
-    BUTTON_FORWARD          = 0xC2,
-    BUTTON_POWER            = 0xA2,
-    BUTTON_MUTE             = 0xE2,
-    BUTTON_MODE             = 0x62,
-    BUTTON_UNKNOWN_OR_ERROR = 0xFF
-} button_press_t;
+typedef struct {
+    bool active;
+    // Every action is learned in turn rather than just one
+    bool all_actions;
+    // The action the next key will be bound to
+    ir_action_t action;
+    uint32_t remaining_ms;
+} ir_learn_status_t;
+
+typedef struct {
+    ir_protocol_id_t protocol;
+    uint16_t address;
+    bool any_address;
+    uint8_t command;
+    ir_action_t action;
+} ir_binding_t;
+
+typedef struct {
+    uint32_t timestamp_us;
+    // First frame decoded from the capture, type IR_FRAME_TYPE_INVALID with the reject reason in status if none
+    ir_result_t result;
+    ir_decode_status_t status;
+    uint16_t num_durations;
+    uint16_t durations[IR_CAPTURE_MAX_DURATIONS];
+} ir_capture_t;
+
+typedef struct {
+    uint32_t frames[IR_PROTOCOL_MAX];
+    uint32_t repeats;
+    // Captures without any frame, by the reason the closest decoder gave up
+    uint32_t rejects[IR_DECODE_STATUS_MAX];
+} ir_decode_stats_t;
 
 const char* get_button_name(button_press_t button);
 
@@ -44,16 +61,41 @@ const char* get_button_name(button_press_t button);
 
 #ifdef __cplusplus
 
-#include <map>
+#include <atomic>
 
 class IRDecoder {
   private:
     static IRDecoder* s_decoder_instance;
     TaskHandle_t task_handle = nullptr;
-
-    static const std::map<uint8_t, button_press_t> command_map;
-
-    void map_command_to_action(uint8_t cmd);
+    ir_engine_t engine;
+
+    // Only the decoder task writes the keymap and reads it unlocked; the mutex covers the other readers and the
+    // learning state shared with the web server
+    ir_keymap_t keymap;
+    SemaphoreHandle_t keymap_mutex = nullptr;
+    std::atomic<bool> learning{false};
+    bool learn_all_actions    = false;
+    ir_action_t learn_action  = IR_ACTION_NONE;
+    int64_t learn_deadline_us = 0;
+
+    ir_held_key_t held = {};
+
+    // Captures are assembled in the scratch slot by the task and copied into the history under the mutex, which also
+    // covers the decode counters
+    std::atomic<bool> capture_enabled{false};
+    SemaphoreHandle_t capture_mutex = nullptr;
+    ir_capture_t capture_scratch    = {};
+    ir_capture_t captures[IR_CAPTURE_HISTORY];
+    size_t capture_next             = 0;
+    size_t capture_count            = 0;
+    ir_decode_stats_t decode_stats  = {};
+
+    void publish_input(uint8_t cmd);
+    bool learn_key(const ir_result_t& frame);
+    void run_action(ir_action_t action);
+    void handle_frame(const ir_result_t& frame, uint32_t timestamp_us);
+    void record_edge(const ir_edge_t& edge);
+    void end_capture(uint32_t timestamp_us, ir_decode_status_t status);
     static void decoder_task_wrapper(void* pvParameters);
     void decoder_task_loop();
 
@@ -63,6 +105,20 @@ class IRDecoder {
     static IRDecoder* get_instance();
 
     esp_err_t start_task(BaseType_t priority, uint32_t stack_depth);
+
+    // Binds the next key pressed to action, or with IR_ACTION_NONE the next keys to every action in turn
+    esp_err_t start_learning(ir_action_t action);
+    void stop_learning();
+    ir_learn_status_t get_learn_status();
+    size_t get_bindings(ir_binding_t* bindings, size_t max_bindings);
+
+    void set_capture_mode(bool enabled);
+    bool is_capture_mode();
+    void clear_captures();
+    size_t get_capture_count();
+    // index 0 is the oldest capture still kept
+    bool get_capture(size_t index, ir_capture_t* capture);
+    void get_decode_stats(ir_decode_stats_t* stats);
 };
 #endif
 
@@ -74,4 +130,4 @@ esp_err_t start_ir_decoder_task(BaseType_t priority, uint32_t stack_depth);
 
 #ifdef __cplusplus
 }
-#endif
\ No newline at end of file
+#endif
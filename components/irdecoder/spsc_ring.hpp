@@ -0,0 +1,85 @@
+// spsc_ring.hpp
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Lock-free ring for exactly one producer and one consumer, e.g. an ISR and the task it wakes. Head and tail are
+// free-running counters each owned by one side, so neither side ever needs a read-modify-write or a critical section.
+// The counters are only written by the producer and may be read from anywhere.
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+    static_assert(N <= UINT32_MAX / 2, "SpscRing capacity too large for 32-bit indices");
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRing items must be trivially copyable");
+
+  private:
+    static constexpr uint32_t MASK = N - 1;
+
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    std::atomic<uint32_t> overflows{0};
+    std::atomic<uint32_t> high_water{0};
+    T slots[N];
+
+  public:
+    static constexpr size_t capacity() {
+        return N;
+    }
+
+    // Producer side. A full ring rejects the item and counts it; nothing already queued is overwritten.
+    bool push(const T& item) {
+        uint32_t h    = head.load(std::memory_order_relaxed);
+        uint32_t used = h - tail.load(std::memory_order_acquire);
+        if (used >= N) {
+            overflows.store(overflows.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        slots[h & MASK] = item;
+        head.store(h + 1, std::memory_order_release);
+
+        if (used + 1 > high_water.load(std::memory_order_relaxed)) {
+            high_water.store(used + 1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // Producer side. Never more than is really free, since the consumer can only release slots meanwhile.
+    size_t write_available() const {
+        return N - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+    }
+
+    // Consumer side
+    bool pop(T& item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        item = slots[t & MASK];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Tail is read first so a concurrent pop can never make the difference negative
+    size_t size() const {
+        uint32_t t = tail.load(std::memory_order_acquire);
+        return head.load(std::memory_order_acquire) - t;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    uint32_t overflow_count() const {
+        return overflows.load(std::memory_order_relaxed);
+    }
+
+    uint32_t high_water_mark() const {
+        return high_water.load(std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,169 @@
+// lcd_emulator.c
+
+#include "lcd_emulator.h"
+#include <string.h>
+
+// PCF8574 pins, kept local so the emulator builds without the ESP-IDF headers lcd_i2c.h pulls in
+#define EMU_RS          0x01
+#define EMU_RW          0x02
+#define EMU_EN          0x04
+#define EMU_BL          0x08
+#define EMU_DATA_MASK   0xF0
+#define EMU_DATA_SHIFT  4
+
+static uint64_t _bit_ns(const lcd_emulator_t* emu) {
+    return 1000000000ULL / emu->scl_hz;
+}
+
+static void _advance_address(lcd_emulator_t* emu) {
+    if (emu->two_line) {
+        // Two-line mode maps DDRAM as 0x00-0x27 and 0x40-0x67, each line continuing into the other
+        if (emu->increment) {
+            emu->address = emu->address == 0x27 ? 0x40 : emu->address == 0x67 ? 0x00 : emu->address + 1;
+        } else {
+            emu->address = emu->address == 0x40 ? 0x27 : emu->address == 0x00 ? 0x67 : emu->address - 1;
+        }
+    } else {
+        if (emu->increment) {
+            emu->address = emu->address == 0x4F ? 0x00 : emu->address + 1;
+        } else {
+            emu->address = emu->address == 0x00 ? 0x4F : emu->address - 1;
+        }
+    }
+}
+
+static uint32_t _execute_command(lcd_emulator_t* emu, uint8_t cmd) {
+    emu->stats.commands++;
+
+    if (cmd & 0x80) {
+        emu->address = cmd & 0x7F;
+    } else if (cmd & 0x40) {
+        // CGRAM writes are accepted but not modeled
+    } else if (cmd & 0x20) {
+        emu->four_bit = !(cmd & 0x10);
+        emu->two_line = (cmd & 0x08) != 0;
+    } else if (cmd & 0x10) {
+        // Cursor or display shift, not modeled
+    } else if (cmd & 0x08) {
+        emu->display_on = (cmd & 0x04) != 0;
+    } else if (cmd & 0x04) {
+        emu->increment = (cmd & 0x02) != 0;
+    } else if (cmd & 0x02) {
+        emu->address = 0;
+        return LCD_EMU_CLEAR_EXEC_US;
+    } else if (cmd & 0x01) {
+        memset(emu->ddram, ' ', sizeof(emu->ddram));
+        emu->address   = 0;
+        emu->increment = true;
+        return LCD_EMU_CLEAR_EXEC_US;
+    }
+    return LCD_EMU_EXEC_US;
+}
+
+// Called on each falling edge of EN with the value the pins held while EN was high
+static void _latch(lcd_emulator_t* emu, uint8_t pins) {
+    if (emu->now_ns < emu->busy_until_ns) {
+        emu->stats.busy_errors++;
+    }
+
+    uint8_t nibble = (pins & EMU_DATA_MASK) >> EMU_DATA_SHIFT;
+    uint8_t value;
+
+    if (!emu->four_bit) {
+        // D0-D3 are not wired on the backpack and read as zero
+        value = nibble << 4;
+    } else if (!emu->have_high_nibble) {
+        emu->high_nibble      = nibble;
+        emu->have_high_nibble = true;
+        return;
+    } else {
+        value                 = (emu->high_nibble << 4) | nibble;
+        emu->have_high_nibble = false;
+    }
+
+    uint32_t exec_us;
+    if (pins & EMU_RS) {
+        emu->stats.data_writes++;
+        emu->ddram[emu->address & (LCD_EMU_DDRAM_SIZE - 1)] = value;
+        _advance_address(emu);
+        exec_us = LCD_EMU_EXEC_US;
+    } else {
+        exec_us = _execute_command(emu, value);
+    }
+    emu->busy_until_ns = emu->now_ns + exec_us * 1000ULL;
+}
+
+void lcd_emulator_init(lcd_emulator_t* emu, uint8_t cols, uint8_t rows, uint32_t scl_hz) {
+    memset(emu, 0, sizeof(*emu));
+    memset(emu->ddram, ' ', sizeof(emu->ddram));
+    emu->cols      = cols;
+    emu->rows      = rows;
+    emu->scl_hz    = scl_hz;
+    emu->increment = true;
+}
+
+void lcd_emulator_transmit(lcd_emulator_t* emu, const uint8_t* data, size_t len, uint64_t start_us) {
+    uint64_t bit_ns = _bit_ns(emu);
+
+    if (start_us * 1000ULL > emu->now_ns) {
+        emu->now_ns = start_us * 1000ULL;
+    }
+    emu->stats.transactions++;
+    emu->stats.bytes += len;
+    emu->stats.bus_bits += LCD_EMU_TRANSACTION_BITS + len * LCD_EMU_BYTE_BITS;
+
+    // Start condition and address byte
+    emu->now_ns += (1 + LCD_EMU_BYTE_BITS) * bit_ns;
+
+    for (size_t i = 0; i < len; i++) {
+        // The PCF8574 updates its outputs when the byte is acknowledged
+        emu->now_ns += LCD_EMU_BYTE_BITS * bit_ns;
+
+        uint8_t previous = emu->port;
+        uint8_t current  = data[i];
+        emu->port        = current;
+
+        if (current & EMU_EN) {
+            if (current & EMU_RW) {
+                emu->stats.rw_errors++;
+            }
+            if ((previous & EMU_EN) && ((previous ^ current) & (EMU_RS | EMU_DATA_MASK))) {
+                emu->stats.enable_errors++;
+            }
+            continue;
+        }
+
+        if (previous & EMU_EN) {
+            // Data has to be held through the falling edge, changing it in the same write violates hold time
+            if ((previous ^ current) & (EMU_RS | EMU_DATA_MASK)) {
+                emu->stats.enable_errors++;
+            }
+            _latch(emu, previous);
+        }
+    }
+
+    emu->now_ns += bit_ns;
+}
+
+void lcd_emulator_read_row(const lcd_emulator_t* emu, uint8_t row, char* out) {
+    uint8_t base = 0;
+    if (row & 1) {
+        base = 0x40;
+    }
+    if (row >= 2) {
+        base += emu->cols;
+    }
+
+    for (uint8_t col = 0; col < emu->cols; col++) {
+        out[col] = emu->display_on && row < emu->rows ? (char)emu->ddram[(base + col) & (LCD_EMU_DDRAM_SIZE - 1)] : ' ';
+    }
+    out[emu->cols] = '\0';
+}
+
+bool lcd_emulator_backlight(const lcd_emulator_t* emu) {
+    return (emu->port & EMU_BL) != 0;
+}
+
+uint64_t lcd_emulator_bus_time_us(const lcd_emulator_t* emu, uint32_t scl_hz) {
+    return emu->stats.bus_bits * 1000000ULL / scl_hz;
+}
@@ -0,0 +1,74 @@
+// lcd_emulator.h
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LCD_EMU_DDRAM_SIZE          0x80
+#define LCD_EMU_EXEC_US             37
+#define LCD_EMU_CLEAR_EXEC_US       1520
+
+// Bits on the wire per transaction besides the payload: start, address byte with ACK, stop
+#define LCD_EMU_TRANSACTION_BITS    11
+#define LCD_EMU_BYTE_BITS           9
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint64_t bus_bits;
+    uint32_t commands;
+    uint32_t data_writes;
+
+    // Protocol errors: data or RS changed while EN was high, RW asserted, or a write latched while busy
+    uint32_t enable_errors;
+    uint32_t rw_errors;
+    uint32_t busy_errors;
+} lcd_emulator_stats_t;
+
+// PCF8574 backpack driving an HD44780 in the pin layout used by lcd_i2c.c
+typedef struct {
+    uint8_t cols;
+    uint8_t rows;
+    uint32_t scl_hz;
+
+    uint8_t port;
+    bool four_bit;
+    bool have_high_nibble;
+    uint8_t high_nibble;
+
+    uint8_t ddram[LCD_EMU_DDRAM_SIZE];
+    uint8_t address;
+    bool increment;
+    bool two_line;
+    bool display_on;
+
+    // Modeled time, advanced by the bytes on the wire
+    uint64_t now_ns;
+    uint64_t busy_until_ns;
+
+    lcd_emulator_stats_t stats;
+} lcd_emulator_t;
+
+void lcd_emulator_init(lcd_emulator_t* emu, uint8_t cols, uint8_t rows, uint32_t scl_hz);
+
+// Feeds one I2C write transaction. start_us places it on the modeled clock; a value earlier than the end of the
+// previous transaction means "immediately after it".
+void lcd_emulator_transmit(lcd_emulator_t* emu, const uint8_t* data, size_t len, uint64_t start_us);
+
+// Copies what row `row` shows into out, which must hold cols + 1 bytes
+void lcd_emulator_read_row(const lcd_emulator_t* emu, uint8_t row, char* out);
+
+bool lcd_emulator_backlight(const lcd_emulator_t* emu);
+
+// Time the recorded traffic would occupy the bus at the given clock
+uint64_t lcd_emulator_bus_time_us(const lcd_emulator_t* emu, uint32_t scl_hz);
+
+#ifdef __cplusplus
+}
+#endif
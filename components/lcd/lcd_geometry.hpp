@@ -0,0 +1,73 @@
+// lcd_geometry.hpp
+
+#pragma once
+
+#include "lcd_i2c.h"
+#include <cstdint>
+
+// HD44780 panel layout. Rows 2 and 3 of four-line panels continue rows 0 and 1 in DDRAM, so their offsets
+// depend on the width (0x14/0x54 on a 20x4).
+template <uint8_t Cols, uint8_t Rows>
+struct LcdGeometry {
+    static_assert(Cols > 0 && Cols <= LCD_MAX_COLS, "Unsupported LCD width");
+    static_assert(Rows > 0 && Rows <= LCD_MAX_ROWS, "Unsupported LCD height");
+    static_assert(Cols * Rows <= 80, "HD44780 DDRAM only holds 80 characters");
+    static_assert(Rows <= 2 || Cols <= 20, "Four-line panels wider than 20 columns use two controllers");
+
+    static constexpr uint8_t cols = Cols;
+    static constexpr uint8_t rows = Rows;
+    static constexpr uint8_t row_offsets[LCD_MAX_ROWS] = {0x00, 0x40, Cols, 0x40 + Cols};
+
+    template <uint8_t Col, uint8_t Row>
+    static constexpr uint8_t address() {
+        static_assert(Col < Cols, "Column out of range for this panel");
+        static_assert(Row < Rows, "Row out of range for this panel");
+        return row_offsets[Row] + Col;
+    }
+};
+
+using Lcd16x2 = LcdGeometry<16, 2>;
+using Lcd20x2 = LcdGeometry<20, 2>;
+using Lcd20x4 = LcdGeometry<20, 4>;
+using Lcd40x2 = LcdGeometry<40, 2>;
+
+static_assert(Lcd20x4::address<0, 2>() == 0x14 && Lcd20x4::address<0, 3>() == 0x54, "20x4 row offsets");
+
+// Typed front end to the lcd_i2c framebuffer; positions are checked against the geometry at compile time
+template <typename Geometry>
+class LcdPanel {
+  private:
+    lcd_i2c_handle_t* handle = nullptr;
+
+  public:
+    using geometry = Geometry;
+
+    lcd_i2c_handle_t* init() {
+        handle = lcd_i2c_init_geometry(Geometry::cols, Geometry::rows, Geometry::row_offsets);
+        return handle;
+    }
+
+    lcd_i2c_handle_t* get_handle() const {
+        return handle;
+    }
+
+    void clear() {
+        lcd_i2c_clear(handle);
+    }
+
+    template <uint8_t Row, uint8_t Col = 0, typename... Args>
+    esp_err_t write_at(const char* format, Args... args) {
+        static_assert(Row < Geometry::rows, "Row out of range for this panel");
+        static_assert(Col < Geometry::cols, "Column out of range for this panel");
+        lcd_i2c_set_cursor(handle, Col, Row);
+        return lcd_i2c_write_string(handle, format, args...);
+    }
+
+    esp_err_t flush() {
+        return lcd_i2c_flush(handle);
+    }
+
+    void backlight(bool on) {
+        lcd_i2c_backlight(handle, on);
+    }
+};
@@ -2,64 +2,109 @@
 
 #include "lcd_i2c.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "rom/ets_sys.h"
 #include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
 
 static const char* TAG = "LCD_I2C_DRIVER";
 
-static i2c_master_bus_handle_t _lcd_i2c_master_init(void) {
-    i2c_master_bus_config_t i2c_conf = {
-        .clk_source                   = I2C_CLK_SRC_DEFAULT,
-        .i2c_port                     = I2C_MASTER_NUM,
-        .scl_io_num                   = I2C_MASTER_SCL_IO,
-        .sda_io_num                   = I2C_MASTER_SDA_IO,
-        .glitch_ignore_cnt            = 7,
-        .flags.enable_internal_pullup = false,
-    };
-
-    i2c_master_bus_handle_t i2c_bus_handle;
-    ESP_ERROR_CHECK(i2c_new_master_bus(&i2c_conf, &i2c_bus_handle));
-    return i2c_bus_handle;
+#if LCD_I2C_EMULATOR
+static lcd_emulator_t s_emulator;
+
+static esp_err_t _lcd_emulator_transfer(void* ctx, i2c_bus_device_t* device, const uint8_t* tx, size_t tx_len, uint8_t* rx,
+                                        size_t rx_len, uint32_t timeout_ms) {
+    if (rx_len > 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    lcd_emulator_transmit((lcd_emulator_t*)ctx, tx, tx_len, esp_timer_get_time());
+    return ESP_OK;
 }
 
-static esp_err_t _lcd_send_byte_i2c(lcd_i2c_handle_t* lcd, uint8_t val) {
-    uint8_t write_buffer[1] = {val};
-    ESP_ERROR_CHECK(i2c_master_transmit(
-        lcd->i2c_dev_handle,
-        write_buffer,
-        sizeof(write_buffer),
-        pdMS_TO_TICKS(1000)));
+static const i2c_bus_transport_t s_emulator_transport = {
+    .attach   = NULL,
+    .transfer = _lcd_emulator_transfer,
+    .reset    = NULL,
+    .ctx      = &s_emulator,
+};
 
-    return ESP_OK;
+const lcd_emulator_t* lcd_i2c_get_emulator(void) {
+    return &s_emulator;
 }
+#endif
 
-static lcd_i2c_handle_t* _lcd_i2c_create(i2c_master_bus_handle_t i2c_bus_handle, uint8_t address, uint8_t cols, uint8_t rows) {
-    if (i2c_bus_handle == NULL) {
-        ESP_LOGE(TAG, "I2C BUS HANDLE IS NULL, CANNOT CREATE LCD");
-        return NULL;
+static void _lcd_wait_ready(lcd_i2c_handle_t* lcd) {
+    int64_t now = esp_timer_get_time();
+    if (now >= lcd->busy_until_us) {
+        return;
     }
 
-    i2c_device_config_t dev_cfg = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address  = address,
-        .scl_speed_hz    = I2C_MASTER_FREQ_HZ};
+    // One extra tick because a delay of n ticks can end up to a tick early
+    int64_t wait_us = lcd->busy_until_us - now;
+    vTaskDelay((TickType_t)((wait_us + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000)) + 1);
+    lcd->stats.settle_waits++;
+    lcd->stats.settle_wait_us += (uint32_t)(esp_timer_get_time() - now);
+}
+
+static esp_err_t _lcd_tx_flush(lcd_i2c_handle_t* lcd) {
+    if (lcd->tx_len == 0) {
+        return ESP_OK;
+    }
+    _lcd_wait_ready(lcd);
 
-    i2c_master_dev_handle_t i2c_dev_handle = NULL;
-    ESP_ERROR_CHECK(i2c_master_bus_add_device(i2c_bus_handle, &dev_cfg, &i2c_dev_handle));
+    esp_err_t ret = i2c_bus_write(lcd->bus_device, lcd->tx_buffer, lcd->tx_len, LCD_I2C_PRIORITY, LCD_I2C_DEADLINE_MS);
+    lcd->stats.i2c_transactions++;
+    lcd->stats.i2c_bytes += lcd->tx_len;
+    lcd->tx_len = 0;
 
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "I2C transmit failed: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+static esp_err_t _lcd_tx_byte(lcd_i2c_handle_t* lcd, uint8_t val) {
+    if (lcd->tx_len == LCD_TX_BUFFER_SIZE) {
+        esp_err_t ret = _lcd_tx_flush(lcd);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    lcd->tx_buffer[lcd->tx_len++] = val;
+    return ESP_OK;
+}
+
+// Sends what is queued and records how long the controller needs before the next transfer
+static esp_err_t _lcd_settle(lcd_i2c_handle_t* lcd, uint32_t settle_us) {
+    esp_err_t ret      = _lcd_tx_flush(lcd);
+    lcd->busy_until_us = esp_timer_get_time() + settle_us;
+    return ret;
+}
+
+static lcd_i2c_handle_t* _lcd_i2c_create(uint8_t address, uint8_t cols, uint8_t rows, const uint8_t row_offsets[LCD_MAX_ROWS]) {
     lcd_i2c_handle_t* lcd = (lcd_i2c_handle_t*)calloc(1, sizeof(lcd_i2c_handle_t));
     if (lcd == NULL) {
         ESP_LOGE(TAG, "Failed to allocate memory for LCD handle!");
-        i2c_master_bus_rm_device(i2c_dev_handle);
         return NULL;
     }
 
-    lcd->i2c_dev_handle  = i2c_dev_handle;
-    lcd->cols            = cols;
-    lcd->rows            = rows;
+    // The PCF8574 just latches every byte onto its pins, so writes queued back to back can share a transaction
+    esp_err_t ret = i2c_bus_add_device("lcd", address, LCD_I2C_FREQ_HZ, I2C_BUS_DEVICE_FLAG_STREAM, &lcd->bus_device);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add LCD to the I2C bus: %s", esp_err_to_name(ret));
+        free(lcd);
+        return NULL;
+    }
+
+    lcd->cols            = cols > LCD_MAX_COLS ? LCD_MAX_COLS : cols;
+    lcd->rows            = rows > LCD_MAX_ROWS ? LCD_MAX_ROWS : rows;
     lcd->backlight_state = 0;
+    lcd->ddram_address   = -1;
+    memcpy(lcd->row_offsets, row_offsets, sizeof(lcd->row_offsets));
+    memset(lcd->frame, ' ', sizeof(lcd->frame));
+    memset(lcd->shadow, ' ', sizeof(lcd->shadow));
 
     return lcd;
 }
@@ -85,53 +130,103 @@ static esp_err_t _lcd_write_4bit_nibble(lcd_i2c_handle_t* lcd, uint8_t nibble, u
         data_to_send |= PCF8574_D7;
     }
 
-    data_to_send |= PCF8574_EN;
-    ESP_ERROR_CHECK(_lcd_send_byte_i2c(lcd, data_to_send));
-    esp_rom_delay_us(1);
-
-    data_to_send &= ~PCF8574_EN;
-    ESP_ERROR_CHECK(_lcd_send_byte_i2c(lcd, data_to_send));
-    esp_rom_delay_us(50);
-
-    return ESP_OK;
+    // Each queued byte takes at least 22 us on the wire even at 400 kHz, which covers the 450 ns enable pulse,
+    // and the next falling edge comes two bytes later, after the 37 us a command or data write needs to settle
+    esp_err_t ret = _lcd_tx_byte(lcd, data_to_send | PCF8574_EN);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return _lcd_tx_byte(lcd, data_to_send & ~PCF8574_EN);
 }
 
 static esp_err_t _lcd_send_cmd(lcd_i2c_handle_t* lcd, uint8_t cmd) {
-    ESP_ERROR_CHECK(_lcd_write_4bit_nibble(lcd, (cmd >> 4) & 0x0F, LCD_RS_COMMAND));
-    ESP_ERROR_CHECK(_lcd_write_4bit_nibble(lcd, cmd & 0x0F, LCD_RS_COMMAND));
+    esp_err_t ret = _lcd_write_4bit_nibble(lcd, (cmd >> 4) & 0x0F, LCD_RS_COMMAND);
+    if (ret == ESP_OK) {
+        ret = _lcd_write_4bit_nibble(lcd, cmd & 0x0F, LCD_RS_COMMAND);
+    }
 
-    if (cmd == LCD_CLEARDISPLAY || cmd == LCD_RETURNHOME) {
-        esp_rom_delay_us(30000);
-    } else {
-        esp_rom_delay_us(300);
+    // Clear and home take milliseconds, far longer than the byte time that paces everything else
+    if (ret == ESP_OK && (cmd == LCD_CLEARDISPLAY || cmd == LCD_RETURNHOME)) {
+        ret = _lcd_settle(lcd, LCD_CLEAR_SETTLE_US);
     }
 
-    return ESP_OK;
+    return ret;
 }
 
 static esp_err_t _lcd_send_data(lcd_i2c_handle_t* lcd, uint8_t data) {
-    ESP_ERROR_CHECK(_lcd_write_4bit_nibble(lcd, (data >> 4) & 0x0F, LCD_RS_DATA));
-    ESP_ERROR_CHECK(_lcd_write_4bit_nibble(lcd, data & 0x0F, LCD_RS_DATA));
-    esp_rom_delay_us(50);
+    esp_err_t ret = _lcd_write_4bit_nibble(lcd, (data >> 4) & 0x0F, LCD_RS_DATA);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return _lcd_write_4bit_nibble(lcd, data & 0x0F, LCD_RS_DATA);
+}
+
+static uint8_t _lcd_row_address(lcd_i2c_handle_t* lcd, uint8_t row) {
+    return lcd->row_offsets[row];
+}
+
+static esp_err_t _lcd_flush_row(lcd_i2c_handle_t* lcd, uint8_t row) {
+    const char* frame = lcd->frame[row];
+    char* shadow      = lcd->shadow[row];
+    uint8_t col       = 0;
+
+    while (col < lcd->cols) {
+        if (frame[col] == shadow[col]) {
+            col++;
+            continue;
+        }
 
+        // Extend the run across short unchanged gaps, rewriting a cell costs no more than a cursor move
+        uint8_t end = col + 1;
+        uint8_t gap = 0;
+        for (uint8_t next = end; next < lcd->cols; next++) {
+            if (frame[next] != shadow[next]) {
+                end = next + 1;
+                gap = 0;
+            } else if (++gap > LCD_FLUSH_MAX_GAP) {
+                break;
+            }
+        }
+
+        uint8_t address = _lcd_row_address(lcd, row) + col;
+        if (lcd->ddram_address != address) {
+            esp_err_t ret = _lcd_send_cmd(lcd, LCD_SETDDRAMADDR | address);
+            if (ret != ESP_OK) {
+                lcd->ddram_address = -1;
+                return ret;
+            }
+            lcd->stats.cursor_moves++;
+        }
+
+        for (; col < end; col++) {
+            esp_err_t ret = _lcd_send_data(lcd, (uint8_t)frame[col]);
+            if (ret != ESP_OK) {
+                lcd->ddram_address = -1;
+                return ret;
+            }
+            shadow[col] = frame[col];
+            lcd->stats.cells_written++;
+        }
+        lcd->ddram_address = _lcd_row_address(lcd, row) + end;
+    }
     return ESP_OK;
 }
 
 static void _lcd_init(lcd_i2c_handle_t* lcd) {
     ESP_LOGI(TAG, "INITIALIZING LCD DISPLAY SEQUENCE");
-    esp_rom_delay_us(50000);
+    lcd->busy_until_us = esp_timer_get_time() + LCD_POWER_ON_SETTLE_US;
 
     _lcd_write_4bit_nibble(lcd, 0x03, LCD_RS_COMMAND);
-    esp_rom_delay_us(2000);
+    _lcd_settle(lcd, 2000);
 
     _lcd_write_4bit_nibble(lcd, 0x03, LCD_RS_COMMAND);
-    esp_rom_delay_us(150);
+    _lcd_settle(lcd, 150);
 
     _lcd_write_4bit_nibble(lcd, 0x03, LCD_RS_COMMAND);
-    esp_rom_delay_us(150);
+    _lcd_settle(lcd, 150);
 
     _lcd_write_4bit_nibble(lcd, 0x02, LCD_RS_COMMAND);
-    esp_rom_delay_us(100);
+    _lcd_settle(lcd, 100);
 
     _lcd_send_cmd(lcd, LCD_FUNCTIONSET | LCD_4BITMODE | LCD_2LINE | LCD_5x8DOTS);
     _lcd_send_cmd(lcd, LCD_DISPLAYMODECONTROL | LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF);
@@ -139,6 +234,7 @@ static void _lcd_init(lcd_i2c_handle_t* lcd) {
 
     _lcd_send_cmd(lcd, LCD_ENTRYMODESET | LCD_ENTRYSHIFTINCREMENT);
     _lcd_send_cmd(lcd, LCD_RETURNHOME);
+    lcd->ddram_address = 0;
 
     lcd_i2c_backlight(lcd, true);
     ESP_LOGI(TAG, "LCD INITIALIZING SEQUENCE COMPLETE");
@@ -155,7 +251,9 @@ void lcd_i2c_backlight(lcd_i2c_handle_t* lcd, bool on) {
         lcd->backlight_state = 0;
         ESP_LOGI(TAG, "LCD Backlight OFF");
     }
-    ESP_ERROR_CHECK(_lcd_send_byte_i2c(lcd, data_to_send));
+    if (_lcd_tx_byte(lcd, data_to_send) == ESP_OK) {
+        _lcd_tx_flush(lcd);
+    }
 }
 
 esp_err_t lcd_i2c_clear(lcd_i2c_handle_t* lcd) {
@@ -164,8 +262,11 @@ esp_err_t lcd_i2c_clear(lcd_i2c_handle_t* lcd) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    ESP_LOGD(TAG, "Clearing LCD display");
-    return _lcd_send_cmd(lcd, LCD_CLEARDISPLAY);
+    ESP_LOGD(TAG, "Clearing LCD framebuffer");
+    memset(lcd->frame, ' ', sizeof(lcd->frame));
+    lcd->cursor_col = 0;
+    lcd->cursor_row = 0;
+    return ESP_OK;
 }
 
 esp_err_t lcd_i2c_home(lcd_i2c_handle_t* lcd) {
@@ -175,8 +276,9 @@ esp_err_t lcd_i2c_home(lcd_i2c_handle_t* lcd) {
     }
 
     ESP_LOGD(TAG, "Returning Cursor to Home");
-
-    return _lcd_send_cmd(lcd, LCD_RETURNHOME);
+    lcd->cursor_col = 0;
+    lcd->cursor_row = 0;
+    return ESP_OK;
 }
 
 esp_err_t lcd_i2c_set_cursor(lcd_i2c_handle_t* lcd, uint8_t col, uint8_t row) {
@@ -195,21 +297,10 @@ esp_err_t lcd_i2c_set_cursor(lcd_i2c_handle_t* lcd, uint8_t col, uint8_t row) {
         row = lcd->rows - 1;
     }
 
-    uint8_t address = 0;
-    if (row == 0) {
-        address = 0x0;
-    } else if (row == 1) {
-        address = 0x40;
-    } else {
-        ESP_LOGE(TAG, "Invalid row %d for LCD type", row);
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    address += col;
-
-    ESP_LOGD(TAG, "Setting cursor to col %d, row %d (DDRAM address 0x%02x)", col, row, address);
-
-    return _lcd_send_cmd(lcd, LCD_SETDDRAMADDR | address);
+    ESP_LOGD(TAG, "Setting cursor to col %d, row %d", col, row);
+    lcd->cursor_col = col;
+    lcd->cursor_row = row;
+    return ESP_OK;
 }
 
 esp_err_t lcd_i2c_write_char(lcd_i2c_handle_t* lcd, char c) {
@@ -220,7 +311,11 @@ esp_err_t lcd_i2c_write_char(lcd_i2c_handle_t* lcd, char c) {
 
     ESP_LOGD(TAG, "Printing character '%c' (0x%02x)", c, c);
 
-    return _lcd_send_data(lcd, (uint8_t)c);
+    // Characters past the end of the row are dropped, the panel does not wrap rows in display order
+    if (lcd->cursor_col < lcd->cols) {
+        lcd->frame[lcd->cursor_row][lcd->cursor_col++] = c;
+    }
+    return ESP_OK;
 }
 
 esp_err_t lcd_i2c_write_string(lcd_i2c_handle_t* lcd, const char* str, ...) {
@@ -234,7 +329,7 @@ esp_err_t lcd_i2c_write_string(lcd_i2c_handle_t* lcd, const char* str, ...) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    char print_buffer[40];
+    char print_buffer[LCD_MAX_COLS + 1];
 
     va_list args;
     va_start(args, str);
@@ -267,16 +362,60 @@ esp_err_t lcd_i2c_write_string(lcd_i2c_handle_t* lcd, const char* str, ...) {
     return ESP_OK;
 }
 
+esp_err_t lcd_i2c_flush(lcd_i2c_handle_t* lcd) {
+    if (lcd == NULL) {
+        ESP_LOGE(TAG, "LCD handle is NULL in lcd_i2c_flush");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    lcd->stats.flushes++;
+    esp_err_t ret = ESP_OK;
+    for (uint8_t row = 0; row < lcd->rows && ret == ESP_OK; row++) {
+        ret = _lcd_flush_row(lcd, row);
+    }
+    if (ret == ESP_OK) {
+        ret = _lcd_tx_flush(lcd);
+    }
+
+    // Part of the update may not have reached the panel, so repaint everything next time
+    if (ret != ESP_OK) {
+        lcd->tx_len        = 0;
+        lcd->ddram_address = -1;
+        memset(lcd->shadow, 0, sizeof(lcd->shadow));
+    }
+    return ret;
+}
+
+void lcd_i2c_get_stats(lcd_i2c_handle_t* lcd, lcd_i2c_stats_t* stats) {
+    if (lcd == NULL) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = lcd->stats;
+}
+
 lcd_i2c_handle_t* lcd_i2c_init(void) {
-    ESP_LOGI(TAG, "Initializing LCD");
-    i2c_master_bus_handle_t i2c_bus = _lcd_i2c_master_init();
-    if (i2c_bus == NULL) {
-        ESP_LOGE(TAG, "FAILED TO INITIALIZE I2C BUS");
+    const uint8_t row_offsets[LCD_MAX_ROWS] = {0x00, 0x40, LCD_COLS, 0x40 + LCD_COLS};
+    return lcd_i2c_init_geometry(LCD_COLS, LCD_ROWS, row_offsets);
+}
+
+lcd_i2c_handle_t* lcd_i2c_init_geometry(uint8_t cols, uint8_t rows, const uint8_t row_offsets[LCD_MAX_ROWS]) {
+    ESP_LOGI(TAG, "Initializing %dx%d LCD", cols, rows);
+#if LCD_I2C_EMULATOR
+    lcd_emulator_init(&s_emulator, cols, rows, LCD_I2C_FREQ_HZ);
+    i2c_bus_config_t bus_config = I2C_BUS_DEFAULT_CONFIG();
+    bus_config.transport        = &s_emulator_transport;
+    esp_err_t ret               = i2c_bus_init(&bus_config);
+    ESP_LOGW(TAG, "LCD output goes to the emulator, not the I2C bus");
+#else
+    esp_err_t ret = i2c_bus_init(NULL);
+#endif
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "FAILED TO INITIALIZE I2C BUS: %s", esp_err_to_name(ret));
         return NULL;
     }
-    ESP_LOGI(TAG, "INITIALIZED I2C BUS");
 
-    lcd_i2c_handle_t* lcd_handle = _lcd_i2c_create(i2c_bus, LCD_I2C_ADDR, LCD_COLS, LCD_ROWS);
+    lcd_i2c_handle_t* lcd_handle = _lcd_i2c_create(LCD_I2C_ADDR, cols, rows, row_offsets);
     if (lcd_handle == NULL) {
         ESP_LOGE(TAG, "Failed to create LCD handle!");
         return NULL;
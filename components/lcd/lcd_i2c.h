@@ -6,21 +6,31 @@
 extern "C" {
 #endif
 
-#include "driver/i2c_master.h"
 #include "esp_err.h"
+#include "i2c_bus.h"
 
-#define I2C_MASTER_SDA_IO           GPIO_NUM_21
-#define I2C_MASTER_SCL_IO           GPIO_NUM_22
-#define I2C_MASTER_NUM              I2C_NUM_0
-
-#define I2C_MASTER_FREQ_HZ          100000
-#define I2C_MASTER_TX_BUF_DISABLE   0
-#define I2C_MASTER_RX_BUF_DISABLE   0
+// Install lcd_emulator as the I2C bus transport instead of the hardware bus
+#ifndef LCD_I2C_EMULATOR
+#define LCD_I2C_EMULATOR            0
+#endif
 
 #define LCD_I2C_ADDR                0x27
+#ifndef LCD_I2C_FREQ_HZ
+#define LCD_I2C_FREQ_HZ             100000
+#endif
+#define LCD_I2C_PRIORITY            I2C_BUS_PRIORITY_NORMAL
+#define LCD_I2C_DEADLINE_MS         1000
 #define LCD_COLS                    16
 #define LCD_ROWS                    2
 
+#define LCD_MAX_COLS                40
+#define LCD_MAX_ROWS                4
+#define LCD_FLUSH_MAX_GAP           1
+#define LCD_TX_BUFFER_SIZE          128
+
+#define LCD_POWER_ON_SETTLE_US      50000
+#define LCD_CLEAR_SETTLE_US         2000
+
 #define PCF8574_RS                  0b00000001
 #define PCF8574_RW                  0b00000010
 #define PCF8574_EN                  0b00000100
@@ -61,13 +71,50 @@ extern "C" {
 #define LCD_5x8DOTS                 0b00000000
 
 typedef struct {
-    i2c_master_dev_handle_t i2c_dev_handle;
+    uint32_t flushes;
+    uint32_t cells_written;
+    uint32_t cursor_moves;
+    uint32_t i2c_transactions;
+    uint32_t i2c_bytes;
+    uint32_t settle_waits;
+    uint32_t settle_wait_us;
+} lcd_i2c_stats_t;
+
+typedef struct {
+    i2c_bus_device_t* bus_device;
     uint8_t cols;
     uint8_t rows;
+    uint8_t row_offsets[LCD_MAX_ROWS];
     uint8_t backlight_state;
+
+    // What the next flush should show, and what the panel currently shows
+    char frame[LCD_MAX_ROWS][LCD_MAX_COLS];
+    char shadow[LCD_MAX_ROWS][LCD_MAX_COLS];
+    uint8_t cursor_col;
+    uint8_t cursor_row;
+    int16_t ddram_address;
+
+    // PCF8574 output bytes waiting to be sent in one I2C transaction
+    uint8_t tx_buffer[LCD_TX_BUFFER_SIZE];
+    size_t tx_len;
+
+    // The controller may not be written before this time; the next transfer sleeps until then instead of spinning
+    int64_t busy_until_us;
+
+    lcd_i2c_stats_t stats;
 } lcd_i2c_handle_t;
 
 lcd_i2c_handle_t* lcd_i2c_init(void);
+lcd_i2c_handle_t* lcd_i2c_init_geometry(uint8_t cols, uint8_t rows, const uint8_t row_offsets[LCD_MAX_ROWS]);
+
+// Text functions only draw into the framebuffer, lcd_i2c_flush() sends the cells that changed since the last flush
+esp_err_t lcd_i2c_flush(lcd_i2c_handle_t* lcd);
+void lcd_i2c_get_stats(lcd_i2c_handle_t* lcd, lcd_i2c_stats_t* stats);
+
+#if LCD_I2C_EMULATOR
+#include "lcd_emulator.h"
+const lcd_emulator_t* lcd_i2c_get_emulator(void);
+#endif
 
 void lcd_i2c_backlight(lcd_i2c_handle_t* lcd, bool on);
 esp_err_t lcd_i2c_home(lcd_i2c_handle_t* lcd);
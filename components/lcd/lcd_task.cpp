@@ -2,10 +2,10 @@
 
 #include "lcd_task.hpp"
 #include "dht11_task.hpp"
-#include "webserver.hpp"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "lcd_i2c.h"
+#include <time.h>
 
 static const char* TAG = "LCD_TASK";
 
@@ -34,31 +34,47 @@ esp_err_t LCDDisplay::start_task(BaseType_t priority, uint32_t stack_depth) {
         ESP_LOGE(TAG, "Failed to create LCD task");
         return ESP_FAIL;
     }
-    return ESP_OK;
+    commands.bind(task_handle, LCD_NOTIFY_COMMAND);
+    return EventBus::get_instance()->subscribe(&events, EVENT_TOPIC_BIT(EVENT_TOPIC_NEW_READING), task_handle, LCD_NOTIFY_EVENT);
 }
 
 void LCDDisplay::cycle_mode() {
-    if (task_handle) {
-        xTaskNotify(task_handle, CYCLE_MODE, eSetValueWithoutOverwrite);
-    }
+    commands.submit(LCD_COMMAND_CYCLE_MODE);
 }
 
 void LCDDisplay::toggle_power() {
-    if (task_handle) {
-        xTaskNotify(task_handle, TOGGLE_POWER, eSetValueWithoutOverwrite);
-        is_lcd_on ^= 1; 
-        char json_buffer[64];
-        snprintf(json_buffer, sizeof(json_buffer), "{\"lcd_on\": %s}", is_lcd_on ? "true" : "false");
-        Webserver::get_instance()->send_state_update(json_buffer);
+    if (!commands.is_bound()) {
+        commands.submit(LCD_COMMAND_TOGGLE_POWER);
+        return;
     }
+
+    // Flip the requested state before waking the task, it reconciles the backlight against it
+    bool was_on = is_lcd_on.load();
+    while (!is_lcd_on.compare_exchange_weak(was_on, !was_on)) {
+    }
+    commands.submit(LCD_COMMAND_TOGGLE_POWER);
+
+    bus_event_t event = {};
+    event.topic       = EVENT_TOPIC_DISPLAY_STATE;
+    event.state.on    = !was_on;
+    EventBus::get_instance()->publish(event);
 }
 
 bool LCDDisplay::is_on() {
-    return is_lcd_on;
+    return is_lcd_on.load();
 }
 
-void LCDDisplay::notify_new_data() {
-    xTaskNotify(task_handle, NEW_DATA, eSetValueWithoutOverwrite);
+command_channel_stats_t LCDDisplay::get_command_stats() {
+    return commands.get_stats();
+}
+
+bool LCDDisplay::get_driver_stats(lcd_refresh_stats_t* refresh, lcd_i2c_stats_t* driver) {
+    if (!lcd_handle) {
+        return false;
+    }
+    *refresh = refresh_stats;
+    lcd_i2c_get_stats(lcd_handle, driver);
+    return true;
 }
 
 esp_err_t start_lcd_display_task(BaseType_t priority, uint32_t stack_depth) {
@@ -78,34 +94,61 @@ void lcd_cycle_mode() {
     }
 }
 
-void LCDDisplay::render_current_mode(DHT11Sensor* sensor) {
-    vTaskDelay(pdMS_TO_TICKS(100));
-    switch (current_mode) {
-        case DisplayMode::TEMPERATURE: {
-            float temperature = sensor->get_temperature();
-            lcd_i2c_write_string(lcd_handle, "Temp: %.2f %cF", temperature, 223);
-            lcd_i2c_set_cursor(lcd_handle, 0, 1);
-            lcd_i2c_write_string(lcd_handle, "Next: Hum");
-            break;
-        }
-        case DisplayMode::HUMIDITY: {
-            float humidity = sensor->get_humidity();
-            lcd_i2c_write_string(lcd_handle, "Hum: %.2f%%", humidity);
-            lcd_i2c_set_cursor(lcd_handle, 0, 1);
-            lcd_i2c_write_string(lcd_handle, "Next: LR");
-            break;
-        }
-        case DisplayMode::LAST_READ: {
-            uint64_t last_read_us    = sensor->get_last_read();
-            uint64_t current_time_us = esp_timer_get_time();
-            uint32_t seconds_since_last_read = (current_time_us - last_read_us) / 1000000;
-            lcd_i2c_write_string(lcd_handle, "LR: %lu secs ago", seconds_since_last_read);
-            lcd_i2c_set_cursor(lcd_handle, 0, 1);
-            lcd_i2c_write_string(lcd_handle, "Next: Temp");
-            break;
+// A template over the panel so that only the layout matching the configured geometry is instantiated
+template <typename Panel>
+static void render_frame(Panel& panel, DisplayMode mode, const dht11_snapshot_t& reading, uint32_t seconds_since_last_read) {
+    panel.clear();
+
+    if constexpr (Panel::geometry::rows >= 4) {
+        // Tall panels show everything at once, so cycling the mode has nothing to switch between
+        struct tm time_info;
+        localtime_r(&reading.timestamp, &time_info);
+        panel.template write_at<0>("Temp: %.2f %cF", reading.temperature, 223);
+        panel.template write_at<1>("Hum:  %.2f%%", reading.humidity);
+        panel.template write_at<2>("LR: %lu secs ago", seconds_since_last_read);
+        panel.template write_at<3>("At: %02d:%02d:%02d", time_info.tm_hour, time_info.tm_min, time_info.tm_sec);
+    } else {
+        switch (mode) {
+            case DisplayMode::TEMPERATURE: {
+                panel.template write_at<0>("Temp: %.2f %cF", reading.temperature, 223);
+                panel.template write_at<1>("Next: Hum");
+                break;
+            }
+            case DisplayMode::HUMIDITY: {
+                panel.template write_at<0>("Hum: %.2f%%", reading.humidity);
+                panel.template write_at<1>("Next: LR");
+                break;
+            }
+            case DisplayMode::LAST_READ: {
+                panel.template write_at<0>("LR: %lu secs ago", seconds_since_last_read);
+                panel.template write_at<1>("Next: Temp");
+                break;
+            }
+            default:
+                break;
         }
-        default:
-            break;
+    }
+}
+
+void LCDDisplay::render_current_mode(DHT11Sensor* sensor) {
+    uint64_t start_us = esp_timer_get_time();
+    lcd_i2c_stats_t before;
+    lcd_i2c_get_stats(lcd_handle, &before);
+
+    dht11_snapshot_t reading         = sensor->snapshot();
+    uint32_t seconds_since_last_read = (esp_timer_get_time() - reading.monotonic_us) / 1000000;
+    render_frame(panel, current_mode, reading, seconds_since_last_read);
+    panel.flush();
+
+    lcd_i2c_stats_t after;
+    lcd_i2c_get_stats(lcd_handle, &after);
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us) - (after.settle_wait_us - before.settle_wait_us);
+
+    refresh_stats.refreshes++;
+    refresh_stats.last_us = elapsed_us;
+    refresh_stats.total_us += elapsed_us;
+    if (elapsed_us > refresh_stats.max_us) {
+        refresh_stats.max_us = elapsed_us;
     }
 }
 
@@ -118,7 +161,7 @@ void LCDDisplay::display_task_wrapper(void* pvParameters) {
 }
 
 void LCDDisplay::display_task_loop() {
-    lcd_handle = lcd_i2c_init();
+    lcd_handle = panel.init();
     vTaskDelay(pdMS_TO_TICKS(100));
 
     if (!lcd_handle) {
@@ -133,43 +176,76 @@ void LCDDisplay::display_task_loop() {
         vTaskDelete(nullptr);
     }
 
+    uint64_t splash_until_us = 0;
+    bool render_pending      = false;
+
     while (true) {
-        uint32_t ulNotifiedValue;
-        BaseType_t xResult = xTaskNotifyWait(0, UINT32_MAX, &ulNotifiedValue, pdMS_TO_TICKS(5000));
-        
-        if (xResult == pdTRUE) {
-            if (!is_lcd_on && ulNotifiedValue != TOGGLE_POWER) {
-                continue;
+        // While the power-on splash is up the task keeps taking commands and renders once it expires
+        TickType_t wait_ticks = pdMS_TO_TICKS(5000);
+        if (splash_until_us) {
+            uint64_t now_us = esp_timer_get_time();
+            wait_ticks      = now_us >= splash_until_us ? 0 : pdMS_TO_TICKS((splash_until_us - now_us) / 1000) + 1;
+        }
+
+        uint32_t ulNotifiedValue = 0;
+        BaseType_t xResult       = xTaskNotifyWait(0, UINT32_MAX, &ulNotifiedValue, wait_ticks);
+
+        if (xResult != pdTRUE && !splash_until_us) {
+            continue;
+        }
+
+        bus_event_t event;
+        while (events.receive(&event)) {
+            if (event.topic == EVENT_TOPIC_NEW_READING) {
+                render_pending = true;
             }
-            lcd_i2c_clear(lcd_handle);
-            lcd_i2c_home(lcd_handle);
-
-            switch (ulNotifiedValue) {
-                case TOGGLE_POWER:
-                if (is_lcd_on) {
-                    ESP_LOGI(TAG, "LCD turning ON");
-                    lcd_i2c_backlight(lcd_handle, true);
-                    lcd_i2c_write_string(lcd_handle, "LCD Power ON!");
-                    vTaskDelay(pdMS_TO_TICKS(5000));
-                    lcd_i2c_clear(lcd_handle);
-                    lcd_i2c_home(lcd_handle);
-                    render_current_mode(dht11_sensor);
-                }
-                else {
-                    ESP_LOGI(TAG, "LCD turning OFF");
-                    lcd_i2c_backlight(lcd_handle, false);
-                }
-                break;
+        }
+
+        // An even number of toggles since the last wake leaves the requested state where it was
+        commands.take(LCD_COMMAND_TOGGLE_POWER);
+        bool lcd_on = is_lcd_on.load();
+        if (lcd_on != backlight_on) {
+            backlight_on = lcd_on;
+            if (lcd_on) {
+                ESP_LOGI(TAG, "LCD turning ON");
+                panel.clear();
+                panel.backlight(true);
+                panel.write_at<0>("LCD Power ON!");
+                panel.flush();
+                splash_until_us = esp_timer_get_time() + LCD_SPLASH_MS * 1000ULL;
+                render_pending  = true;
+            } else {
+                ESP_LOGI(TAG, "LCD turning OFF");
+                panel.backlight(false);
+                splash_until_us = 0;
+            }
+        }
 
-                case CYCLE_MODE:
-                ESP_LOGI(TAG, "Changing Mode");
-                current_mode = static_cast<DisplayMode>((static_cast<int>(current_mode) + 1) % static_cast<int>(DisplayMode::MAX_MODES));
+        // Mode changes requested while the display is off are discarded, as before
+        uint32_t cycles = commands.take(LCD_COMMAND_CYCLE_MODE);
+        if (!backlight_on) {
+            render_pending = false;
+            continue;
+        }
 
-                [[fallthrough]];
+        if (cycles > 0) {
+            ESP_LOGI(TAG, "Changing Mode (%lu requests)", cycles);
+            int num_modes  = static_cast<int>(DisplayMode::MAX_MODES);
+            current_mode   = static_cast<DisplayMode>((static_cast<int>(current_mode) + cycles % num_modes) % num_modes);
+            render_pending = true;
+        }
+
+        if (splash_until_us) {
+            if (esp_timer_get_time() < splash_until_us) {
+                continue;
+            }
+            splash_until_us = 0;
+        }
 
-                case NEW_DATA:
-                render_current_mode(dht11_sensor);
+        // Everything that arrived since the last refresh is folded into this one frame
+        if (render_pending) {
+            render_pending = false;
+            render_current_mode(dht11_sensor);
         }
     }
 }
-}
\ No newline at end of file
@@ -2,17 +2,39 @@
 
 #pragma once
 
+#include "command_channel.hpp"
 #include "dht11_task.hpp"
+#include "event_bus.hpp"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "lcd_geometry.hpp"
 #include "lcd_i2c.h"
 
-#define CYCLE_MODE 9
-#define NEW_DATA 11
-#define TOGGLE_POWER 10
+#define LCD_NOTIFY_COMMAND      BIT0
+#define LCD_NOTIFY_EVENT        BIT1
+
+#define LCD_EVENT_QUEUE_DEPTH   4
+#define LCD_SPLASH_MS           5000
+
+// Time spent rendering and flushing, excluding time asleep waiting for the controller to settle
+typedef struct {
+    uint32_t refreshes;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} lcd_refresh_stats_t;
 
 #ifdef __cplusplus
 
+// Panel fitted to this build; LCD_COLS/LCD_ROWS are checked against the supported geometries at compile time
+using LcdDisplayGeometry = LcdGeometry<LCD_COLS, LCD_ROWS>;
+
+enum LCDCommand {
+    LCD_COMMAND_CYCLE_MODE,
+    LCD_COMMAND_TOGGLE_POWER,
+    LCD_COMMAND_MAX
+};
+
 enum class DisplayMode {
     TEMPERATURE,
     HUMIDITY,
@@ -25,9 +47,16 @@ class LCDDisplay {
     static LCDDisplay* s_lcd_instance;
     TaskHandle_t task_handle     = nullptr;
     lcd_i2c_handle_t* lcd_handle = nullptr;
+    LcdPanel<LcdDisplayGeometry> panel;
 
     DisplayMode current_mode = DisplayMode::TEMPERATURE;
-    bool is_lcd_on = true;
+    std::atomic<bool> is_lcd_on{true};
+    bool backlight_on = true;
+
+    lcd_refresh_stats_t refresh_stats = {};
+
+    CommandChannel<LCD_COMMAND_MAX> commands;
+    EventSubscriber<LCD_EVENT_QUEUE_DEPTH> events;
 
     void render_current_mode(DHT11Sensor* sensor);
     static void display_task_wrapper(void* pvParameters);
@@ -38,11 +67,12 @@ class LCDDisplay {
     ~LCDDisplay();
     static LCDDisplay* get_instance();
 
-    void notify_new_data();
     esp_err_t start_task(BaseType_t priority, uint32_t stack_depth);
     void cycle_mode();
     void toggle_power();
     bool is_on();
+    command_channel_stats_t get_command_stats();
+    bool get_driver_stats(lcd_refresh_stats_t* refresh, lcd_i2c_stats_t* driver);
 };
 
 #endif
@@ -0,0 +1,61 @@
+// adpcm.c
+
+#include "adpcm.h"
+
+#define ADPCM_MAX_STEP_INDEX 88
+
+static const int16_t step_table[ADPCM_MAX_STEP_INDEX + 1] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,    28,
+    31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,   337,   371,   408,   449,   494,
+    544,   598,   658,   724,   796,   876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,
+    9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static const int8_t index_table[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+static inline int _decode_nibble(int* predictor, int* step_index, uint8_t nibble) {
+    int step  = step_table[*step_index];
+    int delta = step >> 3;
+    if (nibble & 1) {
+        delta += step >> 2;
+    }
+    if (nibble & 2) {
+        delta += step >> 1;
+    }
+    if (nibble & 4) {
+        delta += step;
+    }
+
+    int sample = (nibble & 8) ? *predictor - delta : *predictor + delta;
+    if (sample > INT16_MAX) {
+        sample = INT16_MAX;
+    } else if (sample < INT16_MIN) {
+        sample = INT16_MIN;
+    }
+    *predictor = sample;
+
+    int index = *step_index + index_table[nibble & 7];
+    *step_index = index < 0 ? 0 : index > ADPCM_MAX_STEP_INDEX ? ADPCM_MAX_STEP_INDEX : index;
+    return sample;
+}
+
+void adpcm_decode(adpcm_state_t* state, const uint8_t* data, size_t num_samples, int16_t* out) {
+    // Working copies in registers rather than through the state pointer
+    int predictor  = state->predictor;
+    int step_index = state->step_index > ADPCM_MAX_STEP_INDEX ? ADPCM_MAX_STEP_INDEX : state->step_index;
+
+    size_t pairs = num_samples / 2;
+    for (size_t i = 0; i < pairs; i++) {
+        uint8_t byte = data[i];
+        *out++       = (int16_t)_decode_nibble(&predictor, &step_index, byte & 0x0F);
+        *out++       = (int16_t)_decode_nibble(&predictor, &step_index, byte >> 4);
+    }
+    if (num_samples & 1) {
+        *out = (int16_t)_decode_nibble(&predictor, &step_index, data[pairs] & 0x0F);
+    }
+
+    state->predictor  = (int16_t)predictor;
+    state->step_index = (uint8_t)step_index;
+}
@@ -0,0 +1,24 @@
+// adpcm.h
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// IMA-ADPCM: 4 bits per sample, two samples per byte with the first in the low nibble
+typedef struct {
+    int16_t predictor;
+    uint8_t step_index;
+} adpcm_state_t;
+
+// Decodes num_samples starting at the first nibble of data, carrying the state across calls. Every call but the last
+// must decode an even number of samples so the next one starts on a byte.
+void adpcm_decode(adpcm_state_t* state, const uint8_t* data, size_t num_samples, int16_t* out);
+
+#ifdef __cplusplus
+}
+#endif
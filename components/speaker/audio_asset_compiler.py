@@ -0,0 +1,246 @@
+import math
+import os
+import struct
+import sys
+
+def parse_wav(wav_file_path):
+    with open(wav_file_path, "rb") as f:
+        riff_id = f.read(4)
+        if riff_id != b'RIFF':
+            raise ValueError("Not a valid RIFF file")
+
+        f.read(4)
+
+        wave_id = f.read(4)
+        if wave_id != b'WAVE':
+            raise ValueError("Not a valid WAVE file.")
+        
+        audio_format = 0
+        num_channels = 0
+        sample_rate = 0
+        bits_per_sample = 0
+        
+        fmt_found = False
+        while not fmt_found:
+            chunk_id = f.read(4)
+            if len(chunk_id) < 4:
+                raise ValueError("Required 'fmt ' chunk not found or file ended unexpectedly.")
+            
+            chunk_size_bytes = f.read(4)
+            if len(chunk_size_bytes) < 4:
+                raise ValueError("File ended unexpectedly while reading chunk size.")
+            chunk_size = struct.unpack('<I', chunk_size_bytes)[0]
+
+            if chunk_id == b'fmt ':
+                fmt_found = True
+                
+                audio_format = struct.unpack('<H', f.read(2))[0]
+                num_channels = struct.unpack('<H', f.read(2))[0]
+                sample_rate = struct.unpack('<I', f.read(4))[0]
+                f.read(4)
+                f.read(2) 
+                bits_per_sample = struct.unpack('<H', f.read(2))[0]
+
+                if audio_format != 1:
+                    raise ValueError(f"Unsupported audio format: {audio_format}. Only PCM (1) is supported.")
+                if bits_per_sample not in [8, 16]: 
+                    raise ValueError(f"Unsupported bits per sample: {bits_per_sample}. Only 8 or 16 are supported.")
+                
+                if chunk_size > 16:
+                    f.read(chunk_size - 16)
+            else:
+                f.seek(chunk_size, 1)
+
+        data_found = False
+        raw_audio_data = b''
+        while not data_found:
+            chunk_id = f.read(4)
+            if len(chunk_id) < 4:
+                raise ValueError("Required 'data' chunk not found or file ended unexpectedly.")
+
+            chunk_size_bytes = f.read(4)
+            if len(chunk_size_bytes) < 4:
+                raise ValueError("File ended unexpectedly while reading chunk size.")
+            chunk_size = struct.unpack('<I', chunk_size_bytes)[0]
+
+            if chunk_id == b'data':
+                data_found = True
+                raw_audio_data = f.read(chunk_size)
+                if len(raw_audio_data) < chunk_size:
+                    raise ValueError("File ended unexpectedly while reading audio data.")
+            else:
+                f.seek(chunk_size, 1)
+
+        # Downmixed to mono by averaging each frame, so a sound on any one channel survives
+        processed_data = []
+        frame_size = bits_per_sample // 8 * num_channels
+        for i in range(0, len(raw_audio_data) - frame_size + 1, frame_size):
+            frame = raw_audio_data[i : i + frame_size]
+            if bits_per_sample == 8:
+                channels = [(sample - 128) << 8 for sample in frame]
+            else:
+                channels = struct.unpack(f'<{num_channels}h', frame)
+            processed_data.append(round(sum(channels) / num_channels))
+    
+    return processed_data, sample_rate
+
+# Windowed-sinc interpolation; when downsampling the cutoff follows the output rate so nothing aliases
+def resample(samples, rate_in, rate_out, zero_crossings=16):
+    if rate_in == rate_out:
+        return [float(sample) for sample in samples]
+
+    ratio = rate_out / rate_in
+    cutoff = min(1.0, ratio) * 0.95
+    half_width = zero_crossings / cutoff
+    resampled = []
+    for j in range(int(len(samples) * ratio)):
+        centre = j / ratio
+        first = max(0, math.ceil(centre - half_width))
+        last = min(len(samples) - 1, math.floor(centre + half_width))
+        acc = 0.0
+        for i in range(first, last + 1):
+            x = i - centre
+            t = math.pi * x * cutoff
+            sinc = 1.0 if t == 0 else math.sin(t) / t
+            window = 0.5 + 0.5 * math.cos(math.pi * x / half_width)
+            acc += samples[i] * sinc * window * cutoff
+        resampled.append(acc)
+    return resampled
+
+# Drops leading and trailing silence, keeping a short margin so the first and last sounds are not clipped
+def trim_silence(samples, sample_rate, threshold_db=-45.0, margin_ms=2):
+    peak = max((abs(sample) for sample in samples), default=0.0)
+    threshold = peak * 10 ** (threshold_db / 20)
+    loud = [i for i, sample in enumerate(samples) if abs(sample) > threshold]
+    if not loud:
+        return []
+    margin = sample_rate * margin_ms // 1000
+    return samples[max(0, loud[0] - margin) : loud[-1] + 1 + margin]
+
+def normalize(samples, peak_db=-1.0):
+    peak = max((abs(sample) for sample in samples), default=0.0)
+    gain = 32767 * 10 ** (peak_db / 20) / peak if peak > 0 else 1.0
+    return [max(-32768, min(32767, round(sample * gain))) for sample in samples]
+
+STEP_TABLE = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97,
+    107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871,
+    5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623,
+    27086, 29794, 32767
+]
+INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8]
+
+# IMA-ADPCM, first sample of each pair in the low nibble. The encoder tracks the decoder's reconstruction exactly,
+# so adpcm.c reproduces the same samples.
+def adpcm_encode(samples, step_index=0):
+    predictor = samples[0] if samples else 0
+    initial = (predictor, step_index)
+    nibbles = []
+    error = 0
+    for sample in samples:
+        step = STEP_TABLE[step_index]
+        diff = sample - predictor
+        nibble = 8 if diff < 0 else 0
+        diff = abs(diff)
+        delta = step >> 3
+        if diff >= step:
+            nibble |= 4
+            diff -= step
+            delta += step
+        if diff >= step >> 1:
+            nibble |= 2
+            diff -= step >> 1
+            delta += step >> 1
+        if diff >= step >> 2:
+            nibble |= 1
+            delta += step >> 2
+
+        predictor = predictor - delta if nibble & 8 else predictor + delta
+        predictor = max(-32768, min(32767, predictor))
+        step_index = max(0, min(len(STEP_TABLE) - 1, step_index + INDEX_TABLE[nibble & 7]))
+        nibbles.append(nibble)
+        error += (sample - predictor) ** 2
+
+    if len(nibbles) % 2:
+        nibbles.append(0)
+    encoded = bytes(nibbles[i] | (nibbles[i + 1] << 4) for i in range(0, len(nibbles), 2))
+    return encoded, initial, error
+
+# A sound that starts loud would otherwise spend its attack ramping the step size up from the smallest one
+def best_initial_step_index(samples, lookahead=256):
+    head = samples[:lookahead]
+    return min(range(len(STEP_TABLE)), key=lambda index: adpcm_encode(head, index)[2])
+
+# Blob layout, all little-endian; speaker_assets.c reads the same structures:
+#   header  magic "SNDA", u16 version, u16 count, u32 sample rate
+#   index   count entries of u32 data offset, u32 samples, i16 initial predictor, u8 initial step index, u8 pad
+#   data    IMA-ADPCM streams, each shared by every asset that encodes to the same bytes
+BLOB_MAGIC = b'SNDA'
+BLOB_VERSION = 1
+BLOB_HEADER = struct.Struct('<4sHHI')
+BLOB_ENTRY = struct.Struct('<IIhBx')
+
+def compile_asset(wav_path, sample_rate):
+    samples, wav_rate = parse_wav(wav_path)
+    samples = resample(samples, wav_rate, sample_rate)
+    samples = normalize(trim_silence(samples, sample_rate))
+    encoded, (predictor, step_index), _ = adpcm_encode(samples, best_initial_step_index(samples))
+    return len(samples), predictor, step_index, encoded
+
+def build_blob(assets, sample_rate):
+    data = bytearray()
+    offsets = {}
+    entries = []
+    data_start = BLOB_HEADER.size + BLOB_ENTRY.size * len(assets)
+    for num_samples, predictor, step_index, encoded in assets:
+        key = (num_samples, predictor, step_index, encoded)
+        if key not in offsets:
+            offsets[key] = data_start + len(data)
+            data += encoded
+        entries.append(BLOB_ENTRY.pack(offsets[key], num_samples, predictor, step_index))
+    header = BLOB_HEADER.pack(BLOB_MAGIC, BLOB_VERSION, len(assets), sample_rate)
+    return header + b''.join(entries) + bytes(data), len(offsets)
+
+def sound_id_name(wav_path):
+    base_name = os.path.splitext(os.path.basename(wav_path))[0]
+    return "SPEAKER_SOUND_" + "".join(c if c.isalnum() else "_" for c in base_name).upper()
+
+def generate_header(output_header_path, wav_paths):
+    with open(output_header_path, "w") as f:
+        f.write("// audio_assets.h\n\n")
+        f.write("#pragma once\n\n")
+        f.write("// Generated by audio_asset_compiler.py; each ID indexes the packed asset blob\n")
+        f.write("typedef enum {\n")
+        for wav_path in wav_paths:
+            f.write(f"    {sound_id_name(wav_path)},\n")
+        f.write("    SPEAKER_SOUND_MAX\n")
+        f.write("} speaker_sound_id_t;\n")
+
+if __name__ == "__main__":
+    if len(sys.argv) < 4:
+        print("Usage: python audio_asset_compiler.py <sample_rate_hz> <output_blob> <output_c_header_file> [<input_wav_file>...]")
+        sys.exit(1)
+
+    sample_rate = int(sys.argv[1])
+    output_blob_path = sys.argv[2]
+    output_header_path = sys.argv[3]
+    wav_paths = sys.argv[4:]
+
+    try:
+        assets = []
+        for wav_path in wav_paths:
+            if not os.path.exists(wav_path):
+                raise ValueError(f"Input WAV file not found at '{wav_path}'")
+            asset = compile_asset(wav_path, sample_rate)
+            assets.append(asset)
+            print(f"{os.path.basename(wav_path)}: {asset[0]} samples at {sample_rate} Hz, {len(asset[3])} bytes")
+
+        blob, unique = build_blob(assets, sample_rate)
+        with open(output_blob_path, "wb") as f:
+            f.write(blob)
+        generate_header(output_header_path, wav_paths)
+        print(f"Packed {len(assets)} sounds ({unique} unique) into {output_blob_path}, {len(blob)} bytes")
+    except Exception as e:
+        print(f"Error compiling audio assets: {e}")
+        sys.exit(1)
@@ -1,52 +1,255 @@
 // speaker.c
 
 #include "speaker.h"
+#include <string.h>
 #include "driver/dac_continuous.h"
+#include "esp_attr.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 #include "freertos/task.h"
+#include "sdkconfig.h"
 
 #define I2S_PORT I2S_NUM_0
 
 static const char* TAG = "SPEAKER_DRIVER";
 static dac_continuous_handle_t dac_handle;
+static TaskHandle_t notify_task;
+static uint32_t notify_bit;
+static bool powered;
+static int64_t powered_since_us;
 
-esp_err_t speaker_driver_init(void) {
+// Free buffers, at most one entry per DMA descriptor
+static QueueHandle_t free_buffers;
+static StaticQueue_t free_buffers_queue;
+static uint8_t free_buffers_storage[SPEAKER_DMA_DESC_NUM * sizeof(speaker_dma_buffer_t)];
+
+// The DMA buffers are learned from the interrupt as they come round, and stay pending until they are refilled
+static uint8_t* dma_buffers[SPEAKER_DMA_DESC_NUM];
+static volatile bool dma_pending[SPEAKER_DMA_DESC_NUM];
+static size_t dma_buffer_size;
+static size_t dma_buffer_samples;
+
+// Starting the DMA zeroes every buffer, so each power-up plays a ramp from 0 up to silence before any sound, rather
+// than stepping there with a pop. Until the buffers are known, the first one to come back takes it.
+#define LEAD_IN_RAMP_SAMPLES 256
+static uint8_t lead_in[SPEAKER_WRITE_SAMPLES];
+static uint8_t silence[SPEAKER_WRITE_SAMPLES];
+static bool lead_in_pending;
+
+static volatile speaker_driver_stats_t driver_stats;
+
+static bool IRAM_ATTR _dac_convert_done_callback(dac_continuous_handle_t handle, const dac_event_data_t* event,
+                                                 void* user_data) {
+    int slot = 0;
+    while (slot < SPEAKER_DMA_DESC_NUM && dma_buffers[slot] != NULL && dma_buffers[slot] != event->buf) {
+        slot++;
+    }
+    if (slot == SPEAKER_DMA_DESC_NUM) {
+        return false;
+    }
+    dma_buffers[slot] = (uint8_t*)event->buf;
+
+    // Still waiting for the task from its last turn, so the DAC has just played stale samples again
+    if (dma_pending[slot]) {
+        driver_stats.underruns = driver_stats.underruns + 1;
+        return false;
+    }
+
+#if CONFIG_DAC_DMA_AUTO_16BIT_ALIGN
+    size_t num_samples = event->buf_size / 2;
+#else
+    size_t num_samples = event->buf_size;
+#endif
+    if (num_samples > SPEAKER_WRITE_SAMPLES) {
+        num_samples = SPEAKER_WRITE_SAMPLES;
+    }
+
+    dma_buffer_size    = event->buf_size;
+    dma_buffer_samples = num_samples & ~(size_t)1;
+
+    speaker_dma_buffer_t buffer = {
+        .buf         = (uint8_t*)event->buf,
+        .size        = dma_buffer_size,
+        .num_samples = dma_buffer_samples,
+        .slot        = (uint8_t)slot,
+    };
+    dma_pending[slot]               = true;
+    BaseType_t higher_priority_task = pdFALSE;
+    xQueueSendFromISR(free_buffers, &buffer, &higher_priority_task);
+    xTaskNotifyFromISR(notify_task, notify_bit, eSetBits, &higher_priority_task);
+    return higher_priority_task == pdTRUE;
+}
+
+esp_err_t speaker_driver_init(TaskHandle_t task, uint32_t bit) {
     if (dac_handle) {
         return ESP_OK;
     }
+    if (task == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    notify_task = task;
+    notify_bit  = bit;
+    if (free_buffers == NULL) {
+        free_buffers = xQueueCreateStatic(SPEAKER_DMA_DESC_NUM, sizeof(speaker_dma_buffer_t), free_buffers_storage,
+                                          &free_buffers_queue);
+        memset(silence, SPEAKER_DAC_SILENCE, sizeof(silence));
+        memset(lead_in, SPEAKER_DAC_SILENCE, sizeof(lead_in));
+        for (int i = 0; i < LEAD_IN_RAMP_SAMPLES; i++) {
+            lead_in[i] = (uint8_t)(i * SPEAKER_DAC_SILENCE / LEAD_IN_RAMP_SAMPLES);
+        }
+    }
 
     dac_continuous_config_t dac_cfg = {
         .chan_mask = DAC_CHANNEL_MASK_CH0,
-        .desc_num  = 4,
-        .buf_size  = 1024,
-        .freq_hz   = 16000,
+        .desc_num  = SPEAKER_DMA_DESC_NUM,
+        .buf_size  = SPEAKER_DMA_BUF_SIZE,
+        .freq_hz   = SPEAKER_SAMPLE_RATE_HZ,
         .offset    = 0,
         .clk_src   = DAC_DIGI_CLK_SRC_APLL,
     };
 
-    ESP_ERROR_CHECK(dac_continuous_new_channels(&dac_cfg, &dac_handle));
-    ESP_ERROR_CHECK(dac_continuous_enable(dac_handle));
-    return ESP_OK;
+    esp_err_t ret = dac_continuous_new_channels(&dac_cfg, &dac_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create DAC channel: %s", esp_err_to_name(ret));
+        dac_handle = NULL;
+        return ret;
+    }
+
+    // Has to be in place before the channel is first enabled
+    dac_event_callbacks_t callbacks = {
+        .on_convert_done = _dac_convert_done_callback,
+        .on_stop         = NULL,
+    };
+    ret = dac_continuous_register_event_callback(dac_handle, &callbacks, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register DAC callback: %s", esp_err_to_name(ret));
+        dac_continuous_del_channels(dac_handle);
+        dac_handle = NULL;
+    }
+    return ret;
 }
 
 esp_err_t speaker_driver_deinit(void) {
-    if (dac_handle) {
+    if (!dac_handle) {
         return ESP_OK;
     }
-    dac_continuous_disable(dac_handle);
+    speaker_driver_power_down();
     dac_continuous_del_channels(dac_handle);
     dac_handle = NULL;
+    memset(dma_buffers, 0, sizeof(dma_buffers));
     return ESP_OK;
 }
 
-esp_err_t speaker_driver_play_sound(uint8_t* audio_data, size_t data_len) {
+static esp_err_t _write_slot(int slot, const uint8_t* samples) {
+    size_t loaded = 0;
+    return dac_continuous_write_asynchronously(dac_handle, dma_buffers[slot], dma_buffer_size, samples,
+                                               dma_buffer_samples, &loaded);
+}
+
+// The DAC draws nothing while disabled. dac_continuous_start_async_writing zeroes the buffers before linking them, so
+// the DMA is started first and nothing is written until it runs. It starts on the first buffer: once the buffers are
+// known that one takes the ramp at once and the rest are handed out, so the first sound lands in the second.
+esp_err_t speaker_driver_power_up(void) {
     if (!dac_handle) {
         ESP_LOGE(TAG, "DAC NOT INITIALIZED");
-        return ESP_FAIL;
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (powered) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = dac_continuous_enable(dac_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to power up DAC: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    ret = dac_continuous_start_async_writing(dac_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start DAC DMA: %s", esp_err_to_name(ret));
+        dac_continuous_disable(dac_handle);
+        return ret;
+    }
+    powered = true;
+
+    if (dma_buffers[SPEAKER_DMA_DESC_NUM - 1] != NULL) {
+        _write_slot(0, lead_in);
+        for (int i = 1; i < SPEAKER_DMA_DESC_NUM; i++) {
+            _write_slot(i, silence);
+            speaker_dma_buffer_t buffer = {
+                .buf         = dma_buffers[i],
+                .size        = dma_buffer_size,
+                .num_samples = dma_buffer_samples,
+                .slot        = (uint8_t)i,
+            };
+            dma_pending[i] = true;
+            xQueueSend(free_buffers, &buffer, 0);
+        }
+    } else {
+        lead_in_pending = true;
+    }
+
+    powered_since_us       = esp_timer_get_time();
+    driver_stats.power_ups = driver_stats.power_ups + 1;
+    return ESP_OK;
+}
+
+esp_err_t speaker_driver_power_down(void) {
+    if (!dac_handle || !powered) {
+        return ESP_OK;
+    }
+
+    dac_continuous_stop_async_writing(dac_handle);
+    dac_continuous_disable(dac_handle);
+    powered                 = false;
+    lead_in_pending         = false;
+    driver_stats.powered_us = driver_stats.powered_us + (esp_timer_get_time() - powered_since_us);
+
+    // Nothing completes while the DMA is stopped, so the hand-outs can be cleared without racing the interrupt
+    xQueueReset(free_buffers);
+    for (int i = 0; i < SPEAKER_DMA_DESC_NUM; i++) {
+        dma_pending[i] = false;
     }
-    size_t written = 0;
-    ESP_ERROR_CHECK(dac_continuous_write(dac_handle, audio_data, data_len, &written, portMAX_DELAY));
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+bool speaker_driver_is_powered(void) {
+    return powered;
+}
+
+bool speaker_driver_next_buffer(speaker_dma_buffer_t* buffer) {
+    while (powered && xQueueReceive(free_buffers, buffer, 0) == pdTRUE) {
+        if (!lead_in_pending) {
+            return true;
+        }
+        lead_in_pending = false;
+        speaker_driver_fill(buffer, lead_in, buffer->num_samples);
+    }
+    return false;
+}
+
+esp_err_t speaker_driver_fill(const speaker_dma_buffer_t* buffer, const uint8_t* samples, size_t num_samples) {
+    if (!powered) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t loaded = 0;
+    esp_err_t ret =
+        dac_continuous_write_asynchronously(dac_handle, buffer->buf, buffer->size, samples, num_samples, &loaded);
+    dma_pending[buffer->slot] = false;
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "DAC write failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    driver_stats.buffers = driver_stats.buffers + 1;
+    return ESP_OK;
+}
+
+void speaker_driver_get_stats(speaker_driver_stats_t* stats) {
+    stats->buffers    = driver_stats.buffers;
+    stats->underruns  = driver_stats.underruns;
+    stats->power_ups  = driver_stats.power_ups;
+    stats->powered_us = driver_stats.powered_us + (powered ? esp_timer_get_time() - powered_since_us : 0);
+}
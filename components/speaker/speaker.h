@@ -2,7 +2,12 @@
 
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -10,10 +15,60 @@ extern "C" {
 
 #define SPEAKER_UL_VALUE 9
 
-esp_err_t speaker_driver_init(void);
+// Set by CMakeLists.txt, which also resamples every sound asset to it
+#ifndef SPEAKER_SAMPLE_RATE_HZ
+#define SPEAKER_SAMPLE_RATE_HZ  16000
+#endif
+
+#define SPEAKER_DMA_DESC_NUM    4
+#define SPEAKER_DMA_BUF_SIZE    1024
+
+// Most samples one DMA buffer can take; with 16-bit alignment each sample fills two bytes of it
+#define SPEAKER_WRITE_SAMPLES   SPEAKER_DMA_BUF_SIZE
+
+// The DAC code silence sits at; a powered-down DAC is at 0
+#define SPEAKER_DAC_SILENCE     128
+
+// IMA-ADPCM stream at SPEAKER_SAMPLE_RATE_HZ, played straight from flash
+typedef struct {
+    const uint8_t* data;
+    uint32_t num_samples;
+    int16_t initial_predictor;
+    uint8_t initial_step_index;
+} speaker_sound_t;
+
+// A DMA buffer the DAC has finished playing. It is replayed as is until refilled, so every one handed out must go
+// back through speaker_driver_fill.
+typedef struct {
+    uint8_t* buf;
+    size_t size;
+    size_t num_samples;
+    uint8_t slot;
+} speaker_dma_buffer_t;
+
+typedef struct {
+    uint32_t buffers;
+    // Buffers the DAC had to replay because they were not refilled before their turn came round again
+    uint32_t underruns;
+    uint32_t power_ups;
+    uint64_t powered_us;
+} speaker_driver_stats_t;
+
+// Allocates the DAC channel but leaves it powered down. Each buffer the DAC finishes is queued from the DMA interrupt,
+// which then sets notify_bit on notify_task.
+esp_err_t speaker_driver_init(TaskHandle_t notify_task, uint32_t notify_bit);
 esp_err_t speaker_driver_deinit(void);
-esp_err_t speaker_driver_play_sound(uint8_t* audio_data, size_t data_len);
+
+esp_err_t speaker_driver_power_up(void);
+esp_err_t speaker_driver_power_down(void);
+bool speaker_driver_is_powered(void);
+
+// Non-blocking; false once every buffer is queued for the DAC again
+bool speaker_driver_next_buffer(speaker_dma_buffer_t* buffer);
+esp_err_t speaker_driver_fill(const speaker_dma_buffer_t* buffer, const uint8_t* samples, size_t num_samples);
+
+void speaker_driver_get_stats(speaker_driver_stats_t* stats);
 
 #ifdef __cplusplus
 }
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,47 @@
+// speaker_assets.c
+
+#include "speaker_assets.h"
+#include "audio_assets.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char* TAG = "SPEAKER_ASSETS";
+
+extern const uint8_t _binary_audio_assets_bin_start[] asm("_binary_audio_assets_bin_start");
+extern const uint8_t _binary_audio_assets_bin_end[] asm("_binary_audio_assets_bin_end");
+
+esp_err_t speaker_assets_get(uint16_t id, speaker_sound_t* sound) {
+    const uint8_t* blob = _binary_audio_assets_bin_start;
+    size_t blob_len     = _binary_audio_assets_bin_end - _binary_audio_assets_bin_start;
+
+    speaker_assets_header_t header;
+    if (blob_len < sizeof(header)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(&header, blob, sizeof(header));
+    if (header.magic != SPEAKER_ASSETS_MAGIC || header.version != SPEAKER_ASSETS_VERSION ||
+        header.sample_rate != SPEAKER_SAMPLE_RATE_HZ || header.count != SPEAKER_SOUND_MAX) {
+        ESP_LOGE(TAG, "Unusable asset blob: version %u, %u sounds at %lu Hz", header.version, header.count,
+                 (unsigned long)header.sample_rate);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (id >= header.count) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    speaker_assets_entry_t entry;
+    size_t entry_offset = sizeof(header) + (size_t)id * sizeof(entry);
+    if (entry_offset + sizeof(entry) > blob_len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(&entry, blob + entry_offset, sizeof(entry));
+    if (entry.offset > blob_len || entry.num_samples / 2 + entry.num_samples % 2 > blob_len - entry.offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    sound->data               = blob + entry.offset;
+    sound->num_samples        = entry.num_samples;
+    sound->initial_predictor  = entry.initial_predictor;
+    sound->initial_step_index = entry.initial_step_index;
+    return ESP_OK;
+}
@@ -0,0 +1,38 @@
+// speaker_assets.h
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "speaker.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Layout of audio_assets.bin as written by audio_asset_compiler.py, all little-endian
+#define SPEAKER_ASSETS_MAGIC    0x41444E53  // "SNDA"
+#define SPEAKER_ASSETS_VERSION  1
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t sample_rate;
+} speaker_assets_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t offset;
+    uint32_t num_samples;
+    int16_t initial_predictor;
+    uint8_t initial_step_index;
+    uint8_t reserved;
+} speaker_assets_entry_t;
+
+// Points sound at the flash-resident stream for an ID from the generated audio_assets.h. Fails with
+// ESP_ERR_INVALID_VERSION if the embedded blob is not one this firmware can play at SPEAKER_SAMPLE_RATE_HZ.
+esp_err_t speaker_assets_get(uint16_t id, speaker_sound_t* sound);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,30 @@
+// speaker_earcons.c
+
+#include "speaker_earcons.h"
+
+#define EARCON(notes_array) {.notes = notes_array, .num_notes = sizeof(notes_array) / sizeof(notes_array[0])}
+
+// Rising C major arpeggio
+static const speaker_note_t power_on_notes[] = {
+    {.freq_hz = 523, .duration_ms = 90, .attack_ms = 5, .release_ms = 30, .level = 200, .waveform = SPEAKER_WAVE_SINE},
+    {.freq_hz = 659, .duration_ms = 90, .attack_ms = 5, .release_ms = 30, .level = 200, .waveform = SPEAKER_WAVE_SINE},
+    {.freq_hz = 784, .duration_ms = 180, .attack_ms = 5, .release_ms = 120, .level = 220, .waveform = SPEAKER_WAVE_SINE},
+};
+
+// The same arpeggio falling
+static const speaker_note_t power_off_notes[] = {
+    {.freq_hz = 784, .duration_ms = 90, .attack_ms = 5, .release_ms = 30, .level = 200, .waveform = SPEAKER_WAVE_SINE},
+    {.freq_hz = 659, .duration_ms = 90, .attack_ms = 5, .release_ms = 30, .level = 200, .waveform = SPEAKER_WAVE_SINE},
+    {.freq_hz = 523, .duration_ms = 220, .attack_ms = 5, .release_ms = 180, .level = 220, .waveform = SPEAKER_WAVE_SINE},
+};
+
+// Short two-tone chirp, brighter so it cuts through the chimes
+static const speaker_note_t reading_taken_notes[] = {
+    {.freq_hz = 1319, .duration_ms = 45, .attack_ms = 3, .release_ms = 15, .level = 160, .waveform = SPEAKER_WAVE_TRIANGLE},
+    {.freq_hz = 0, .duration_ms = 20},
+    {.freq_hz = 1760, .duration_ms = 70, .attack_ms = 3, .release_ms = 50, .level = 160, .waveform = SPEAKER_WAVE_TRIANGLE},
+};
+
+const speaker_earcon_t speaker_earcon_power_on      = EARCON(power_on_notes);
+const speaker_earcon_t speaker_earcon_power_off     = EARCON(power_off_notes);
+const speaker_earcon_t speaker_earcon_reading_taken = EARCON(reading_taken_notes);
@@ -0,0 +1,17 @@
+// speaker_earcons.h
+
+#pragma once
+
+#include "speaker_synth.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const speaker_earcon_t speaker_earcon_power_on;
+extern const speaker_earcon_t speaker_earcon_power_off;
+extern const speaker_earcon_t speaker_earcon_reading_taken;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,160 @@
+// speaker_mixer.c
+
+#include "speaker_mixer.h"
+#include <string.h>
+
+#define DAC_SILENCE SPEAKER_DAC_SILENCE
+
+void speaker_mixer_init(speaker_mixer_t* mixer, speaker_voice_done_cb_t on_done, void* arg) {
+    memset(mixer, 0, sizeof(*mixer));
+    mixer->on_done     = on_done;
+    mixer->on_done_arg = arg;
+}
+
+static void _end_voice(speaker_mixer_t* mixer, speaker_voice_t* voice, bool played) {
+    voice->active = false;
+    if (mixer->on_done) {
+        mixer->on_done(voice->tag, played, mixer->on_done_arg);
+    }
+}
+
+// Picks a free voice, else the least important and oldest one if the new sound is at least as important
+static speaker_voice_t* _claim_voice(speaker_mixer_t* mixer, uint16_t gain, uint8_t priority, uint32_t tag) {
+    speaker_voice_t* voice = NULL;
+    for (int i = 0; i < SPEAKER_MIXER_VOICES; i++) {
+        speaker_voice_t* candidate = &mixer->voices[i];
+        if (!candidate->active) {
+            voice = candidate;
+            break;
+        }
+        if (voice == NULL || candidate->priority < voice->priority ||
+            (candidate->priority == voice->priority && (int32_t)(candidate->sequence - voice->sequence) < 0)) {
+            voice = candidate;
+        }
+    }
+
+    if (voice->active) {
+        if (voice->priority > priority) {
+            mixer->stats.rejects++;
+            return NULL;
+        }
+        mixer->stats.steals++;
+        _end_voice(mixer, voice, false);
+    }
+
+    voice->priority = priority;
+    voice->gain     = gain > SPEAKER_GAIN_MAX ? SPEAKER_GAIN_MAX : gain;
+    voice->tag      = tag;
+    voice->sequence = mixer->sequence++;
+    mixer->stats.plays++;
+    return voice;
+}
+
+esp_err_t speaker_mixer_play(speaker_mixer_t* mixer, const speaker_sound_t* sound, uint16_t gain, uint8_t priority,
+                             uint32_t tag) {
+    speaker_voice_t* voice = _claim_voice(mixer, gain, priority, tag);
+    if (voice == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    voice->synthesized      = false;
+    voice->state.predictor  = sound->initial_predictor;
+    voice->state.step_index = sound->initial_step_index;
+    voice->next             = sound->data;
+    voice->remaining        = sound->num_samples;
+    voice->active           = true;
+    if (sound->num_samples == 0) {
+        _end_voice(mixer, voice, true);
+    }
+    return ESP_OK;
+}
+
+esp_err_t speaker_mixer_play_earcon(speaker_mixer_t* mixer, const speaker_earcon_t* earcon, uint16_t gain,
+                                    uint8_t priority, uint32_t tag) {
+    speaker_voice_t* voice = _claim_voice(mixer, gain, priority, tag);
+    if (voice == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    voice->synthesized = true;
+    speaker_synth_start(&voice->synth, earcon, SPEAKER_SAMPLE_RATE_HZ);
+    voice->active = true;
+    if (speaker_synth_done(&voice->synth)) {
+        _end_voice(mixer, voice, true);
+    }
+    return ESP_OK;
+}
+
+void speaker_mixer_stop_all(speaker_mixer_t* mixer) {
+    for (int i = 0; i < SPEAKER_MIXER_VOICES; i++) {
+        if (mixer->voices[i].active) {
+            _end_voice(mixer, &mixer->voices[i], false);
+        }
+    }
+}
+
+size_t speaker_mixer_active_voices(const speaker_mixer_t* mixer) {
+    size_t active = 0;
+    for (int i = 0; i < SPEAKER_MIXER_VOICES; i++) {
+        active += mixer->voices[i].active;
+    }
+    return active;
+}
+
+// Produces the voice's next count samples, or what it has left, and accumulates them at its gain
+static void _mix_voice(speaker_mixer_t* mixer, speaker_voice_t* voice, size_t count) {
+    if (voice->synthesized) {
+        count = speaker_synth_render(&voice->synth, mixer->decoded, count);
+    } else {
+        if (count > voice->remaining) {
+            count = voice->remaining;
+        }
+        adpcm_decode(&voice->state, voice->next, count, mixer->decoded);
+        voice->next += count / 2;
+        voice->remaining -= count;
+    }
+
+    int32_t gain = voice->gain;
+    for (size_t i = 0; i < count; i++) {
+        mixer->mix[i] += mixer->decoded[i] * gain;
+    }
+
+    if (voice->synthesized ? speaker_synth_done(&voice->synth) : voice->remaining == 0) {
+        _end_voice(mixer, voice, true);
+    }
+}
+
+size_t speaker_mixer_render(speaker_mixer_t* mixer, uint8_t* out, size_t num_samples) {
+    for (size_t done = 0; done < num_samples; done += SPEAKER_MIX_BLOCK) {
+        size_t count = num_samples - done < SPEAKER_MIX_BLOCK ? num_samples - done : SPEAKER_MIX_BLOCK;
+        bool mixed   = false;
+
+        memset(mixer->mix, 0, count * sizeof(mixer->mix[0]));
+        for (int v = 0; v < SPEAKER_MIXER_VOICES; v++) {
+            if (mixer->voices[v].active) {
+                _mix_voice(mixer, &mixer->voices[v], count);
+                mixed = true;
+            }
+        }
+
+        uint8_t* block = out + done;
+        if (!mixed) {
+            memset(block, DAC_SILENCE, count);
+            continue;
+        }
+
+        // Back from Q8 gain to 16 bits, then the DAC's top 8 bits
+        for (size_t i = 0; i < count; i++) {
+            int32_t sample = mixer->mix[i] >> 8;
+            if (sample > INT16_MAX) {
+                sample = INT16_MAX;
+                mixer->stats.clipped_samples++;
+            } else if (sample < INT16_MIN) {
+                sample = INT16_MIN;
+                mixer->stats.clipped_samples++;
+            }
+            block[i] = (uint8_t)((sample >> 8) + DAC_SILENCE);
+        }
+    }
+    return speaker_mixer_active_voices(mixer);
+}
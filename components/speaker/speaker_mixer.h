@@ -0,0 +1,89 @@
+// speaker_mixer.h
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "adpcm.h"
+#include "esp_err.h"
+#include "speaker.h"
+#include "speaker_synth.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SPEAKER_MIXER_VOICES    4
+
+// Gains are Q8: SPEAKER_GAIN_UNITY plays a sound at its stored level. The cap keeps a full mix inside 32 bits.
+#define SPEAKER_GAIN_UNITY      256
+#define SPEAKER_GAIN_MAX        (4 * SPEAKER_GAIN_UNITY)
+
+// Voices are mixed this many samples at a time so the working buffers stay small
+#define SPEAKER_MIX_BLOCK       128
+
+typedef enum {
+    SPEAKER_PRIORITY_LOW,
+    SPEAKER_PRIORITY_NORMAL,
+    SPEAKER_PRIORITY_HIGH,
+} speaker_priority_t;
+
+// Called from speaker_mixer_render as a voice plays out (played) and when one is stolen or stopped (not played)
+typedef void (*speaker_voice_done_cb_t)(uint32_t tag, bool played, void* arg);
+
+typedef struct {
+    bool active;
+    uint8_t priority;
+    uint16_t gain;
+    // Whatever the caller uses to recognise the sound when it ends
+    uint32_t tag;
+    // Start order, so the oldest of equally important voices is stolen first
+    uint32_t sequence;
+    // Either an earcon synthesized on the fly or a stored ADPCM stream
+    bool synthesized;
+    speaker_synth_t synth;
+    adpcm_state_t state;
+    const uint8_t* next;
+    uint32_t remaining;
+} speaker_voice_t;
+
+typedef struct {
+    uint32_t plays;
+    uint32_t steals;
+    // Requests dropped because every voice was busy with something more important
+    uint32_t rejects;
+    // Output samples that had to be saturated
+    uint32_t clipped_samples;
+} speaker_mixer_stats_t;
+
+typedef struct {
+    speaker_voice_t voices[SPEAKER_MIXER_VOICES];
+    uint32_t sequence;
+    int32_t mix[SPEAKER_MIX_BLOCK];
+    int16_t decoded[SPEAKER_MIX_BLOCK];
+    speaker_mixer_stats_t stats;
+    speaker_voice_done_cb_t on_done;
+    void* on_done_arg;
+} speaker_mixer_t;
+
+// on_done may be NULL
+void speaker_mixer_init(speaker_mixer_t* mixer, speaker_voice_done_cb_t on_done, void* arg);
+
+// Starts a sound on a free voice, or steals the least important voice (the oldest on a tie) if it is not more
+// important than the new sound. ESP_ERR_NO_MEM when every voice outranks it.
+esp_err_t speaker_mixer_play(speaker_mixer_t* mixer, const speaker_sound_t* sound, uint16_t gain, uint8_t priority,
+                             uint32_t tag);
+esp_err_t speaker_mixer_play_earcon(speaker_mixer_t* mixer, const speaker_earcon_t* earcon, uint16_t gain,
+                                    uint8_t priority, uint32_t tag);
+
+void speaker_mixer_stop_all(speaker_mixer_t* mixer);
+size_t speaker_mixer_active_voices(const speaker_mixer_t* mixer);
+
+// Mixes the active voices into num_samples unsigned 8-bit DAC samples, saturating rather than wrapping, and pads
+// with silence once they finish. num_samples must be even. Returns the number of voices still playing.
+size_t speaker_mixer_render(speaker_mixer_t* mixer, uint8_t* out, size_t num_samples);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,132 @@
+// speaker_synth.c
+
+#include "speaker_synth.h"
+
+#define ENVELOPE_ONE (1u << 16)
+
+// One period plus a guard entry so interpolation never wraps
+static const int16_t sine_table[257] = {
+    0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393, 7179, 7962, 8739,
+    9512, 10278, 11039, 11793, 12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594, 23170, 23731, 24279, 24811,
+    25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521,
+    32609, 32678, 32728, 32757, 32767, 32757, 32728, 32678, 32609, 32521, 32412, 32285,
+    32137, 31971, 31785, 31580, 31356, 31113, 30852, 30571, 30273, 29956, 29621, 29268,
+    28898, 28510, 28105, 27683, 27245, 26790, 26319, 25832, 25329, 24811, 24279, 23731,
+    23170, 22594, 22005, 21403, 20787, 20159, 19519, 18868, 18204, 17530, 16846, 16151,
+    15446, 14732, 14010, 13279, 12539, 11793, 11039, 10278, 9512, 8739, 7962, 7179,
+    6393, 5602, 4808, 4011, 3212, 2410, 1608, 804, 0, -804, -1608, -2410,
+    -3212, -4011, -4808, -5602, -6393, -7179, -7962, -8739, -9512, -10278, -11039, -11793,
+    -12539, -13279, -14010, -14732, -15446, -16151, -16846, -17530, -18204, -18868, -19519, -20159,
+    -20787, -21403, -22005, -22594, -23170, -23731, -24279, -24811, -25329, -25832, -26319, -26790,
+    -27245, -27683, -28105, -28510, -28898, -29268, -29621, -29956, -30273, -30571, -30852, -31113,
+    -31356, -31580, -31785, -31971, -32137, -32285, -32412, -32521, -32609, -32678, -32728, -32757,
+    -32767, -32757, -32728, -32678, -32609, -32521, -32412, -32285, -32137, -31971, -31785, -31580,
+    -31356, -31113, -30852, -30571, -30273, -29956, -29621, -29268, -28898, -28510, -28105, -27683,
+    -27245, -26790, -26319, -25832, -25329, -24811, -24279, -23731, -23170, -22594, -22005, -21403,
+    -20787, -20159, -19519, -18868, -18204, -17530, -16846, -16151, -15446, -14732, -14010, -13279,
+    -12539, -11793, -11039, -10278, -9512, -8739, -7962, -7179, -6393, -5602, -4808, -4011,
+    -3212, -2410, -1608, -804, 0,
+};
+
+static uint32_t _ms_to_samples(uint32_t ms, uint32_t sample_rate) {
+    return ms * sample_rate / 1000;
+}
+
+static void _start_note(speaker_synth_t* synth, uint8_t index) {
+    synth->note     = index;
+    synth->position = 0;
+    synth->phase    = 0;
+    if (index >= synth->earcon->num_notes) {
+        return;
+    }
+
+    const speaker_note_t* note = &synth->earcon->notes[index];
+    synth->note_samples        = _ms_to_samples(note->duration_ms, synth->sample_rate);
+    synth->attack_samples      = _ms_to_samples(note->attack_ms, synth->sample_rate);
+    synth->release_samples     = _ms_to_samples(note->release_ms, synth->sample_rate);
+    synth->attack_inv          = synth->attack_samples ? ENVELOPE_ONE / synth->attack_samples : 0;
+    synth->release_inv         = synth->release_samples ? ENVELOPE_ONE / synth->release_samples : 0;
+    synth->phase_step          = (uint32_t)(((uint64_t)note->freq_hz << 32) / synth->sample_rate);
+}
+
+static inline int32_t _wave(uint8_t waveform, uint32_t phase) {
+    switch (waveform) {
+    case SPEAKER_WAVE_TRIANGLE: {
+        int32_t ramp = (int32_t)(phase >> 15);
+        return ramp < 65536 ? ramp - 32768 : 98303 - ramp;
+    }
+    case SPEAKER_WAVE_SQUARE:
+        return (phase & 0x80000000u) ? -32767 : 32767;
+    default: {
+        uint32_t index = phase >> 24;
+        int32_t frac   = (phase >> 8) & 0xFFFF;
+        int32_t a      = sine_table[index];
+        return a + (((sine_table[index + 1] - a) * frac) >> 16);
+    }
+    }
+}
+
+static void _render_note(speaker_synth_t* synth, const speaker_note_t* note, int16_t* out, size_t count) {
+    if (note->freq_hz == 0) {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = 0;
+        }
+        return;
+    }
+
+    uint32_t phase = synth->phase;
+    for (size_t i = 0; i < count; i++) {
+        uint32_t position = synth->position + i;
+        uint32_t envelope = ENVELOPE_ONE;
+        if (position < synth->attack_samples) {
+            envelope = position * synth->attack_inv;
+        }
+        uint32_t left = synth->note_samples - position;
+        if (left <= synth->release_samples && left * synth->release_inv < envelope) {
+            envelope = left * synth->release_inv;
+        }
+
+        // Level and envelope together stay within 16 bits, so the product with the wave fits in 32
+        int32_t amplitude = (int32_t)((note->level * envelope) >> 8);
+        out[i]            = (int16_t)((_wave(note->waveform, phase) * amplitude) >> 16);
+        phase += synth->phase_step;
+    }
+    synth->phase = phase;
+}
+
+void speaker_synth_start(speaker_synth_t* synth, const speaker_earcon_t* earcon, uint32_t sample_rate) {
+    synth->earcon      = earcon;
+    synth->sample_rate = sample_rate;
+    _start_note(synth, 0);
+}
+
+size_t speaker_synth_render(speaker_synth_t* synth, int16_t* out, size_t num_samples) {
+    size_t done = 0;
+    while (done < num_samples && !speaker_synth_done(synth)) {
+        const speaker_note_t* note = &synth->earcon->notes[synth->note];
+        uint32_t left              = synth->note_samples - synth->position;
+        size_t count               = num_samples - done < left ? num_samples - done : left;
+
+        _render_note(synth, note, out + done, count);
+        done += count;
+        synth->position += count;
+        if (synth->position >= synth->note_samples) {
+            _start_note(synth, synth->note + 1);
+        }
+    }
+    return done;
+}
+
+bool speaker_synth_done(const speaker_synth_t* synth) {
+    return synth->note >= synth->earcon->num_notes;
+}
+
+uint32_t speaker_earcon_samples(const speaker_earcon_t* earcon, uint32_t sample_rate) {
+    uint32_t samples = 0;
+    for (int i = 0; i < earcon->num_notes; i++) {
+        samples += _ms_to_samples(earcon->notes[i].duration_ms, sample_rate);
+    }
+    return samples;
+}
@@ -0,0 +1,61 @@
+// speaker_synth.h
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    SPEAKER_WAVE_SINE,
+    SPEAKER_WAVE_TRIANGLE,
+    SPEAKER_WAVE_SQUARE,
+} speaker_waveform_t;
+
+// One note of an earcon. The envelope ramps linearly up over attack_ms and down over the last release_ms; a
+// frequency of 0 is a rest.
+typedef struct {
+    uint16_t freq_hz;
+    uint16_t duration_ms;
+    uint8_t attack_ms;
+    uint8_t release_ms;
+    uint8_t level;
+    uint8_t waveform;
+} speaker_note_t;
+
+typedef struct {
+    const speaker_note_t* notes;
+    uint8_t num_notes;
+} speaker_earcon_t;
+
+// Direct digital synthesis: a 32-bit phase accumulator indexes an interpolated 256-entry sine table
+typedef struct {
+    const speaker_earcon_t* earcon;
+    uint32_t sample_rate;
+    uint8_t note;
+    uint32_t position;
+    uint32_t note_samples;
+    uint32_t attack_samples;
+    uint32_t release_samples;
+    uint32_t attack_inv;
+    uint32_t release_inv;
+    uint32_t phase;
+    uint32_t phase_step;
+} speaker_synth_t;
+
+void speaker_synth_start(speaker_synth_t* synth, const speaker_earcon_t* earcon, uint32_t sample_rate);
+
+// Renders up to num_samples and returns how many there were before the earcon ended
+size_t speaker_synth_render(speaker_synth_t* synth, int16_t* out, size_t num_samples);
+
+bool speaker_synth_done(const speaker_synth_t* synth);
+
+uint32_t speaker_earcon_samples(const speaker_earcon_t* earcon, uint32_t sample_rate);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,17 +1,18 @@
 // speaker_task.cpp
 
 #include "speaker_task.hpp"
-#include "webserver.hpp"
-#include "power_on.h"
-#include "power_off.h"
-#include "reading_taken.h"
+#include "speaker_earcons.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 static const char* TAG = "SPEAKER_TASK";
 
 Speaker* Speaker::s_speaker_instance = nullptr;
 
-Speaker::Speaker() {}
+Speaker::Speaker() {
+    play_queue = xQueueCreateStatic(SPEAKER_PLAY_QUEUE_DEPTH, sizeof(PlayRequest), play_queue_storage, &play_queue_buffer);
+    play_lock  = xSemaphoreCreateMutexStatic(&play_lock_buffer);
+}
 
 Speaker::~Speaker() {
     if (task_handle) {
@@ -28,23 +29,82 @@ Speaker* Speaker::get_instance() {
 }
 
 void Speaker::play_sound() {
+    commands.submit(SPEAKER_COMMAND_PLAY_SOUND);
+}
+
+speaker_handle_t Speaker::play_earcon(const speaker_earcon_t* earcon, uint16_t gain, speaker_priority_t priority,
+                                      speaker_done_cb_t done, void* arg) {
+    if (earcon == nullptr || !is_speaker_on.load()) {
+        play_rejects++;
+        return SPEAKER_HANDLE_INVALID;
+    }
+
+    xSemaphoreTake(play_lock, portMAX_DELAY);
+    PlayRequest request = {next_handle, earcon, gain, (uint8_t)priority, done, arg};
+    bool queued         = xQueueSend(play_queue, &request, 0) == pdTRUE;
+    if (queued && ++next_handle == SPEAKER_HANDLE_INVALID) {
+        next_handle++;
+    }
+    xSemaphoreGive(play_lock);
+
+    if (!queued) {
+        play_rejects++;
+        ESP_LOGW(TAG, "Play queue full");
+        return SPEAKER_HANDLE_INVALID;
+    }
     if (task_handle) {
-        xTaskNotify(task_handle, SPEAKER_PLAY_SOUND, eSetValueWithOverwrite);
+        xTaskNotify(task_handle, SPEAKER_NOTIFY_PLAY, eSetBits);
+    }
+    return request.handle;
+}
+
+bool Speaker::is_done(speaker_handle_t handle) {
+    if (handle == SPEAKER_HANDLE_INVALID) {
+        return true;
+    }
+    if ((int32_t)(accepted_handle.load() - handle) < 0) {
+        return false;
     }
+    for (int i = 0; i < SPEAKER_MIXER_VOICES; i++) {
+        if (pending_handles[i].load() == handle) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void Speaker::toggle_power() {
-    if (task_handle) {
-        xTaskNotify(task_handle, SPEAKER_POWER_TOGGLE, eSetValueWithOverwrite);
-        is_speaker_on ^= 1;
-        char json_buffer[64];
-        snprintf(json_buffer, sizeof(json_buffer), "{\"speaker_on\": %s}", is_speaker_on ? "true" : "false");
-        Webserver::get_instance()->send_state_update(json_buffer);
+    if (!commands.is_bound()) {
+        commands.submit(SPEAKER_COMMAND_POWER_TOGGLE);
+        return;
     }
+
+    bool was_on = is_speaker_on.load();
+    while (!is_speaker_on.compare_exchange_weak(was_on, !was_on)) {
+    }
+    commands.submit(SPEAKER_COMMAND_POWER_TOGGLE);
+
+    bus_event_t event = {};
+    event.topic       = EVENT_TOPIC_SPEAKER_STATE;
+    event.state.on    = !was_on;
+    EventBus::get_instance()->publish(event);
 }
 
 bool Speaker::is_on() {
-    return is_speaker_on;
+    return is_speaker_on.load();
+}
+
+command_channel_stats_t Speaker::get_command_stats() {
+    return commands.get_stats();
+}
+
+void Speaker::get_stats(speaker_stats_t* stats) {
+    speaker_driver_get_stats(&stats->driver);
+    stats->mixer         = mixer.stats;
+    stats->wakeups       = wakeups;
+    stats->render_us     = render_us;
+    stats->render_max_us = render_max_us;
+    stats->play_rejects  = play_rejects.load();
 }
 
 esp_err_t Speaker::start_task(BaseType_t priority, uint32_t stack_depth) {
@@ -60,7 +120,8 @@ esp_err_t Speaker::start_task(BaseType_t priority, uint32_t stack_depth) {
         ESP_LOGE(TAG, "Failed to create speaker task");
         return ESP_FAIL;
     }
-    return ESP_OK;
+    commands.bind(task_handle, SPEAKER_NOTIFY_COMMAND);
+    return EventBus::get_instance()->subscribe(&events, EVENT_TOPIC_BIT(EVENT_TOPIC_NEW_READING), task_handle, SPEAKER_NOTIFY_EVENT);
 }
 
 void Speaker::speaker_task_wrapper(void* pvParameters) {
@@ -71,28 +132,167 @@ void Speaker::speaker_task_wrapper(void* pvParameters) {
     vTaskDelete(nullptr);
 }
 
+void Speaker::start_earcon(const speaker_earcon_t* earcon, uint16_t gain, speaker_priority_t priority) {
+    esp_err_t ret = speaker_mixer_play_earcon(&mixer, earcon, gain, priority, SPEAKER_HANDLE_INVALID);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Earcon not played: %s", esp_err_to_name(ret));
+    }
+}
+
+// A request can end inside speaker_mixer_play_earcon itself, by being empty, so it is only filed once that returns
+void Speaker::start_request(const PlayRequest& request) {
+    starting      = request;
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+    if (driver_on) {
+        ret = speaker_mixer_play_earcon(&mixer, request.earcon, request.gain, request.priority, request.handle);
+    }
+
+    if (ret != ESP_OK) {
+        complete(request.handle, false);
+    } else if (starting.handle != SPEAKER_HANDLE_INVALID) {
+        for (int i = 0; i < SPEAKER_MIXER_VOICES; i++) {
+            if (pending[i].handle == SPEAKER_HANDLE_INVALID) {
+                pending[i] = starting;
+                pending_handles[i].store(starting.handle);
+                break;
+            }
+        }
+    }
+    starting = {};
+    accepted_handle.store(request.handle);
+}
+
+void Speaker::complete(speaker_handle_t handle, bool played) {
+    if (handle == SPEAKER_HANDLE_INVALID) {
+        return;
+    }
+
+    PlayRequest* request = starting.handle == handle ? &starting : nullptr;
+    int slot             = -1;
+    for (int i = 0; request == nullptr && i < SPEAKER_MIXER_VOICES; i++) {
+        if (pending[i].handle == handle) {
+            request = &pending[i];
+            slot    = i;
+        }
+    }
+    if (request == nullptr) {
+        return;
+    }
+
+    if (request->done) {
+        request->done(handle, played, request->arg);
+    }
+    request->handle = SPEAKER_HANDLE_INVALID;
+    if (slot >= 0) {
+        pending_handles[slot].store(SPEAKER_HANDLE_INVALID);
+    }
+}
+
+void Speaker::voice_done(uint32_t tag, bool played, void* arg) {
+    static_cast<Speaker*>(arg)->complete(tag, played);
+}
+
+void Speaker::handle_requests() {
+    uint32_t plays = commands.take(SPEAKER_COMMAND_PLAY_SOUND);
+    bus_event_t event;
+    while (events.receive(&event)) {
+        if (event.topic == EVENT_TOPIC_NEW_READING) {
+            plays++;
+        }
+    }
+
+    commands.take(SPEAKER_COMMAND_POWER_TOGGLE);
+    bool speaker_on = is_speaker_on.load();
+    if (speaker_on != driver_on) {
+        driver_on = speaker_on;
+        if (!speaker_on) {
+            // The power-off sound is the last thing heard; the DAC is released once it has played
+            speaker_mixer_stop_all(&mixer);
+            start_earcon(&speaker_earcon_power_off, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_HIGH);
+            ESP_LOGI(TAG, "Speaker turned OFF");
+        } else {
+            start_earcon(&speaker_earcon_power_on, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_HIGH);
+            ESP_LOGI(TAG, "Speaker turned ON");
+        }
+    } else if (plays > 0 && speaker_on) {
+        // A burst of requests plays the sound once
+        ESP_LOGI(TAG, "Playing sound");
+        start_earcon(&speaker_earcon_reading_taken, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_NORMAL);
+    }
+
+    PlayRequest request;
+    while (xQueueReceive(play_queue, &request, 0) == pdTRUE) {
+        start_request(request);
+    }
+}
+
+// The DAC channel is only created and powered once there is something to play
+bool Speaker::power_up() {
+    if (speaker_driver_init(task_handle, SPEAKER_NOTIFY_DMA) != ESP_OK || speaker_driver_power_up() != ESP_OK) {
+        return false;
+    }
+    silent_buffers = 0;
+    return true;
+}
+
+// Every buffer the DAC gives back is refilled straight away, with silence once the voices have finished
+void Speaker::refill_buffers() {
+    speaker_dma_buffer_t buffer;
+    while (speaker_driver_next_buffer(&buffer)) {
+        int64_t start_us = esp_timer_get_time();
+        bool audible     = speaker_mixer_active_voices(&mixer) > 0;
+        speaker_mixer_render(&mixer, pcm, buffer.num_samples);
+        speaker_driver_fill(&buffer, pcm, buffer.num_samples);
+
+        if (audible) {
+            silent_buffers = 0;
+        } else if (silent_buffers++ == 0) {
+            idle_since = xTaskGetTickCount();
+        }
+
+        uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start_us);
+        render_us += elapsed_us;
+        if (elapsed_us > render_max_us) {
+            render_max_us = elapsed_us;
+        }
+    }
+}
+
+// Waits for the last sound to drain out of the DMA buffers. Switched off, the channel is released altogether.
+void Speaker::power_down_when_idle() {
+    if (!speaker_driver_is_powered() || speaker_mixer_active_voices(&mixer) > 0 ||
+        silent_buffers < SPEAKER_DMA_DESC_NUM) {
+        return;
+    }
+
+    if (!driver_on) {
+        speaker_driver_deinit();
+        ESP_LOGI(TAG, "DAC released");
+    } else if (xTaskGetTickCount() - idle_since >= pdMS_TO_TICKS(SPEAKER_IDLE_TIMEOUT_MS)) {
+        speaker_driver_power_down();
+        ESP_LOGI(TAG, "DAC powered down after %d ms idle", SPEAKER_IDLE_TIMEOUT_MS);
+    }
+}
+
+// Never blocks on the DAC. While it is powered, each buffer the DMA finishes wakes the task to render the next one,
+// so the task sleeps between buffers and new sounds join the mix at the next buffer.
 void Speaker::speaker_task_loop() {
     ESP_LOGI(TAG, "Speaker task started");
+    speaker_mixer_init(&mixer, Speaker::voice_done, this);
+
     while (true) {
-        uint32_t notified_value;
-        BaseType_t result = xTaskNotifyWait(0, UINT32_MAX, &notified_value, portMAX_DELAY);
-
-        if (result == pdTRUE) {
-            if (notified_value == SPEAKER_POWER_TOGGLE) {
-                if (is_speaker_on) {
-                    speaker_driver_deinit();
-                    speaker_driver_play_sound(power_off_fx, power_off_len);
-                    ESP_LOGI(TAG, "Speaker turned OFF");
-                } else {
-                    speaker_driver_init();
-                    speaker_driver_play_sound(power_on_fx, power_on_len);
-                    ESP_LOGI(TAG, "Speaker turned ON");
-                }
-            } else if (notified_value == SPEAKER_PLAY_SOUND && is_speaker_on) {
-                ESP_LOGI(TAG, "Playing sound");
-                speaker_driver_play_sound(reading_taken_fx, reading_taken_len);
-            }
+        uint32_t notified_value = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &notified_value, portMAX_DELAY);
+        wakeups++;
+        if (notified_value & (SPEAKER_NOTIFY_COMMAND | SPEAKER_NOTIFY_EVENT | SPEAKER_NOTIFY_PLAY)) {
+            handle_requests();
         }
+
+        if (speaker_mixer_active_voices(&mixer) > 0 && !speaker_driver_is_powered() && !power_up()) {
+            speaker_mixer_stop_all(&mixer);
+        }
+        refill_buffers();
+        power_down_when_idle();
     }
 }
 
@@ -103,6 +303,20 @@ void speaker_play_sound(void) {
     }
 }
 
+speaker_handle_t speaker_play_earcon(const speaker_earcon_t* earcon, uint16_t gain, speaker_priority_t priority,
+                                     speaker_done_cb_t done, void* arg) {
+    Speaker* speaker = Speaker::get_instance();
+    if (speaker) {
+        return speaker->play_earcon(earcon, gain, priority, done, arg);
+    }
+    return SPEAKER_HANDLE_INVALID;
+}
+
+bool speaker_is_done(speaker_handle_t handle) {
+    Speaker* speaker = Speaker::get_instance();
+    return speaker == nullptr || speaker->is_done(handle);
+}
+
 esp_err_t start_speaker_task(BaseType_t priority, uint32_t stack_depth) {
     Speaker* speaker = Speaker::get_instance();
     if (speaker) {
@@ -3,15 +3,46 @@
 #pragma once
 
 #include "speaker.h"
+#include "speaker_mixer.h"
+#include "command_channel.hpp"
+#include "event_bus.hpp"
 #include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define SPEAKER_PLAY_SOUND 9
-#define SPEAKER_POWER_TOGGLE 10
+#define SPEAKER_NOTIFY_COMMAND  BIT0
+#define SPEAKER_NOTIFY_EVENT    BIT1
+#define SPEAKER_NOTIFY_PLAY     BIT2
+#define SPEAKER_NOTIFY_DMA      BIT3
+
+#define SPEAKER_EVENT_QUEUE_DEPTH 4
+#define SPEAKER_PLAY_QUEUE_DEPTH  8
+
+// The DAC stays powered this long after the last sound, so sounds close together neither wait for it nor click
+#define SPEAKER_IDLE_TIMEOUT_MS   2000
+
+typedef uint32_t speaker_handle_t;
+#define SPEAKER_HANDLE_INVALID    0
+
+// Runs on the speaker task once the sound's last sample is handed to the DAC, or with played false if it was rejected,
+// stolen or stopped. Must not block.
+typedef void (*speaker_done_cb_t)(speaker_handle_t handle, bool played, void* arg);
+
+typedef struct {
+    speaker_driver_stats_t driver;
+    speaker_mixer_stats_t mixer;
+    uint32_t wakeups;
+    // Rendering and refilling DMA buffers, the only work the task does while a sound plays
+    uint64_t render_us;
+    uint32_t render_max_us;
+    // Requests turned away because the speaker was off or the queue was full
+    uint32_t play_rejects;
+} speaker_stats_t;
 
 #ifdef __cplusplus
 }
@@ -19,12 +50,63 @@ extern "C" {
 
 
 #ifdef __cplusplus
+enum SpeakerCommand {
+    SPEAKER_COMMAND_PLAY_SOUND,
+    SPEAKER_COMMAND_POWER_TOGGLE,
+    SPEAKER_COMMAND_MAX
+};
+
 class Speaker {
 private:
-   static Speaker* s_speaker_instance;
-   TaskHandle_t task_handle = nullptr; 
-    bool is_speaker_on = false;
+    struct PlayRequest {
+        speaker_handle_t handle;
+        const speaker_earcon_t* earcon;
+        uint16_t gain;
+        uint8_t priority;
+        speaker_done_cb_t done;
+        void* arg;
+    };
+
+    static Speaker* s_speaker_instance;
+    TaskHandle_t task_handle = nullptr;
+    std::atomic<bool> is_speaker_on{false};
+    bool driver_on = false;
+    speaker_mixer_t mixer;
+    uint8_t pcm[SPEAKER_WRITE_SAMPLES];
+    CommandChannel<SPEAKER_COMMAND_MAX> commands;
+    EventSubscriber<SPEAKER_EVENT_QUEUE_DEPTH> events;
+
+    // Handles are given out and queued under one lock, so the task dequeues them in increasing order
+    QueueHandle_t play_queue = nullptr;
+    StaticQueue_t play_queue_buffer;
+    uint8_t play_queue_storage[SPEAKER_PLAY_QUEUE_DEPTH * sizeof(PlayRequest)];
+    SemaphoreHandle_t play_lock = nullptr;
+    StaticSemaphore_t play_lock_buffer;
+    speaker_handle_t next_handle = 1;
+
+    // A handle is done once it has been dequeued and is no longer waiting on a voice
+    PlayRequest starting = {};
+    PlayRequest pending[SPEAKER_MIXER_VOICES] = {};
+    std::atomic<speaker_handle_t> accepted_handle{SPEAKER_HANDLE_INVALID};
+    std::atomic<speaker_handle_t> pending_handles[SPEAKER_MIXER_VOICES] = {};
+
+    // Silent buffers handed to the DAC since the last sound; once every descriptor holds one, the sound has played out
+    uint32_t silent_buffers = SPEAKER_DMA_DESC_NUM;
+    TickType_t idle_since   = 0;
+
+    uint32_t wakeups       = 0;
+    uint64_t render_us     = 0;
+    uint32_t render_max_us = 0;
+    std::atomic<uint32_t> play_rejects{0};
 
+    void start_earcon(const speaker_earcon_t* earcon, uint16_t gain, speaker_priority_t priority);
+    void start_request(const PlayRequest& request);
+    void complete(speaker_handle_t handle, bool played);
+    static void voice_done(uint32_t tag, bool played, void* arg);
+    void handle_requests();
+    bool power_up();
+    void refill_buffers();
+    void power_down_when_idle();
     static void speaker_task_wrapper(void* pvParameters);
     void speaker_task_loop();
 public:
@@ -34,8 +116,14 @@ public:
     static Speaker* get_instance();
     esp_err_t start_task(BaseType_t priority, uint32_t stack_depth);
     void play_sound();
+    // Queues the earcon and returns at once; SPEAKER_HANDLE_INVALID if the speaker is off or the queue is full
+    speaker_handle_t play_earcon(const speaker_earcon_t* earcon, uint16_t gain, speaker_priority_t priority,
+                                 speaker_done_cb_t done = nullptr, void* arg = nullptr);
+    bool is_done(speaker_handle_t handle);
     void toggle_power();
     bool is_on();
+    command_channel_stats_t get_command_stats();
+    void get_stats(speaker_stats_t* stats);
 };
 #endif
 
@@ -44,6 +132,9 @@ extern "C" {
 #endif
 
 void speaker_play_sound(void);
+speaker_handle_t speaker_play_earcon(const speaker_earcon_t* earcon, uint16_t gain, speaker_priority_t priority,
+                                     speaker_done_cb_t done, void* arg);
+bool speaker_is_done(speaker_handle_t handle);
 esp_err_t start_speaker_task(BaseType_t priority, uint32_t stack_depth);
 
 #ifdef __cplusplus
@@ -1,10 +1,16 @@
 let myChart;
+let maxChartPoints = 60;
+let lastSequence = null;
 const ctx = document.getElementById('sensorChart').getContext('2d');
 const loader = document.getElementById('loader');
 const readNowBtn = document.getElementById('readNowButton');
 
 const toggleLcd = document.getElementById('lcdToggle');
 const toggleSpeaker = document.getElementById('speakerToggle');
+const irLearnAction = document.getElementById('irLearnAction');
+const irLearnBtn = document.getElementById('irLearnButton');
+const irLearnStatus = document.getElementById('irLearnStatus');
+let irLearnPoll = null;
 
 const ws = new WebSocket(`ws://${window.location.hostname}/ws`);
 
@@ -26,6 +32,9 @@ ws.onmessage = (event) => {
     if (state.speaker_on !== undefined) {
         toggleSpeaker.checked = state.speaker_on;
     }
+    if (state.sequence !== undefined && state.sequence !== lastSequence) {
+        updateDHTdata();
+    }
 };
 
 async function togglePower(endpoint) {
@@ -47,6 +56,8 @@ async function initializeChart() {
         const response = await fetch('/dht_history');
         const data = await response.json();
 
+        maxChartPoints = Math.max(maxChartPoints, data.history.length);
+
         const labels = data.history.map(d => new Date(d.timestamp * 1000).toLocaleTimeString());
         const tempData = data.history.map(d => d.temperature);
         const humidityData = data.history.map(d => d.humidity);
@@ -97,29 +108,30 @@ async function initializeChart() {
     }
 }
 
-async function updateDHTdata() {
+async function updateDHTdata(fresh = false) {
     loader.classList.remove('hidden');
     loader.classList.add('visible');
     readNowBtn.disabled = true;
     try {
-        const response = await fetch('/dht_data');
+        const response = await fetch(fresh ? '/dht_data?fresh=1' : '/dht_data');
         const data = await response.json();
 
         document.getElementById('temperature').textContent = data.temperature.toFixed(2);
         document.getElementById('humidity').textContent = data.humidity.toFixed(1);
 
-        const now = new Date();
-        const newLabel = now.toLocaleTimeString();
+        const readingTime = data.timestamp ? new Date(data.timestamp * 1000) : new Date();
+        const newLabel = readingTime.toLocaleTimeString();
         document.getElementById('lastupdated').textContent = newLabel;
 
-        console.log("Data updated successfully:", data);
+        console.log(`Data updated successfully (${data.outcome}):`, data);
 
-        if (myChart) {
+        if (myChart && data.sequence !== lastSequence) {
+            lastSequence = data.sequence;
             myChart.data.labels.push(newLabel);
             myChart.data.datasets[0].data.push(data.temperature);
             myChart.data.datasets[1].data.push(data.humidity);
 
-            if (myChart.data.labels.length > 60) {
+            if (myChart.data.labels.length > maxChartPoints) {
                 myChart.data.labels.shift();
                 myChart.data.datasets.forEach(dataset => dataset.data.shift());
             }
@@ -139,6 +151,49 @@ async function updateDHTdata() {
     }
 }
 
+function showLearnStatus(learning) {
+    if (learning.active) {
+        irLearnStatus.textContent = `Press the remote key for ${learning.action} (${Math.ceil(learning.remaining_ms / 1000)} s)`;
+        irLearnBtn.textContent = 'Cancel';
+    } else {
+        irLearnStatus.textContent = '';
+        irLearnBtn.textContent = 'Learn';
+    }
+}
+
+async function pollLearnStatus() {
+    try {
+        const response = await fetch('/ir_keymap');
+        const data = await response.json();
+        showLearnStatus(data.learning);
+        if (!data.learning.active && irLearnPoll) {
+            clearInterval(irLearnPoll);
+            irLearnPoll = null;
+            irLearnStatus.textContent = `${data.bindings.length} keys bound`;
+        }
+    } catch (error) {
+        console.error("Error fetching IR keymap:", error);
+    }
+}
+
+async function toggleLearning() {
+    const learning = irLearnPoll !== null;
+    const query = learning ? '?cancel=1' : (irLearnAction.value ? `?action=${irLearnAction.value}` : '');
+    try {
+        const response = await fetch(`/ir_learn${query}`, { method: 'POST' });
+        if (!response.ok) {
+            console.error('Failed to start IR learning:', response.statusText);
+            return;
+        }
+        showLearnStatus(await response.json());
+        if (!learning && !irLearnPoll) {
+            irLearnPoll = setInterval(pollLearnStatus, 1000);
+        }
+    } catch (error) {
+        console.error('Network error:', error);
+    }
+}
+
 async function fetchInitialState() {
     try {
         const response = await fetch('/status');
@@ -158,7 +213,7 @@ async function fetchInitialState() {
 if (readNowBtn) {
     readNowBtn.addEventListener('click', () => {
         console.log("Read Now Button Clicked");
-        updateDHTdata();
+        updateDHTdata(true);
     });
 }
 if (toggleLcd) {
@@ -171,6 +226,11 @@ if (toggleSpeaker) {
         togglePower('/speaker_toggle');
     });
 }
+if (irLearnBtn) {
+    irLearnBtn.addEventListener('click', () => {
+        toggleLearning();
+    });
+}
 
 document.addEventListener('DOMContentLoaded', () => {
     fetchInitialState();
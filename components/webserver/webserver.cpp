@@ -2,15 +2,28 @@
 
 #include "webserver.hpp"
 #include "dht11_task.hpp"
+#include "i2c_bus.h"
+#include "irdecoder_task.hpp"
 #include "lcd_task.hpp"
 #include "speaker_task.hpp"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include <freertos/task.h>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include <string>
+#include <time.h>
 
 static const char* TAG = "WEB_SERVER";
 
+#define HISTORY_CHUNK_SIZE 1024
+#define HISTORY_DEFAULT_POINTS 200
+#define FRESH_READ_TIMEOUT_MS 5000
+#define NOTIFIER_TASK_PRIORITY 4
+#define NOTIFIER_TASK_STACK 4096
+#define IR_KEYMAP_MAX_LISTED 64
+
 Webserver* Webserver::s_webserver_instance = nullptr;
 SemaphoreHandle_t Webserver::s_clients_mutex = nullptr;
 httpd_handle_t Webserver::s_websocket_handle = nullptr;
@@ -42,7 +55,7 @@ Webserver* Webserver::get_instance() {
 
 esp_err_t Webserver::start() {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.max_uri_handlers = 12;
+    config.max_uri_handlers = 20;
     esp_err_t result = httpd_start(&server, &config);
     if (result != ESP_OK) {
         ESP_LOGE(TAG, "Server start failed with error: %s", esp_err_to_name(result));
@@ -100,6 +113,16 @@ esp_err_t Webserver::start() {
         .supported_subprotocol    = NULL};
     httpd_register_uri_handler(server, &dht_history_uri);
 
+    httpd_uri_t dht_log_uri = {
+        .uri                      = "/dht_log",
+        .method                   = HTTP_GET,
+        .handler                  = dht_log_get_handler,
+        .user_ctx                 = this,
+        .is_websocket             = false,
+        .handle_ws_control_frames = false,
+        .supported_subprotocol    = NULL};
+    httpd_register_uri_handler(server, &dht_log_uri);
+
     httpd_uri_t lcd_toggle_uri = {
         .uri = "/lcd_toggle",
         .method = HTTP_POST, 
@@ -141,6 +164,108 @@ esp_err_t Webserver::start() {
     httpd_register_uri_handler(server, &websocket_uri);
     s_websocket_handle = server;
 
+    httpd_uri_t bus_stats_uri = {
+        .uri                      = "/bus_stats",
+        .method                   = HTTP_GET,
+        .handler                  = bus_stats_get_handler,
+        .user_ctx                 = this,
+        .is_websocket             = false,
+        .handle_ws_control_frames = false,
+        .supported_subprotocol    = NULL};
+    httpd_register_uri_handler(server, &bus_stats_uri);
+
+    httpd_uri_t lcd_stats_uri = {
+        .uri                      = "/lcd_stats",
+        .method                   = HTTP_GET,
+        .handler                  = lcd_stats_get_handler,
+        .user_ctx                 = this,
+        .is_websocket             = false,
+        .handle_ws_control_frames = false,
+        .supported_subprotocol    = NULL};
+    httpd_register_uri_handler(server, &lcd_stats_uri);
+
+    httpd_uri_t i2c_stats_uri = {
+        .uri                      = "/i2c_stats",
+        .method                   = HTTP_GET,
+        .handler                  = i2c_stats_get_handler,
+        .user_ctx                 = this,
+        .is_websocket             = false,
+        .handle_ws_control_frames = false,
+        .supported_subprotocol    = NULL};
+    httpd_register_uri_handler(server, &i2c_stats_uri);
+
+    httpd_uri_t ir_learn_uri = {
+        .uri                      = "/ir_learn",
+        .method                   = HTTP_POST,
+        .handler                  = ir_learn_handler,
+        .user_ctx                 = this,
+        .is_websocket             = false,
+        .handle_ws_control_frames = false,
+        .supported_subprotocol    = NULL};
+    httpd_register_uri_handler(server, &ir_learn_uri);
+
+    httpd_uri_t ir_keymap_uri = {
+        .uri                      = "/ir_keymap",
+        .method                   = HTTP_GET,
+        .handler                  = ir_keymap_get_handler,
+        .user_ctx                 = this,
+        .is_websocket             = false,
+        .handle_ws_control_frames = false,
+        .supported_subprotocol    = NULL};
+    httpd_register_uri_handler(server, &ir_keymap_uri);
+
+    httpd_uri_t ir_capture_uri = {
+        .uri                      = "/ir_capture",
+        .method                   = HTTP_GET,
+        .handler                  = ir_capture_get_handler,
+        .user_ctx                 = this,
+        .is_websocket             = false,
+        .handle_ws_control_frames = false,
+        .supported_subprotocol    = NULL};
+    httpd_register_uri_handler(server, &ir_capture_uri);
+
+    httpd_uri_t ir_capture_mode_uri = {
+        .uri                      = "/ir_capture",
+        .method                   = HTTP_POST,
+        .handler                  = ir_capture_mode_handler,
+        .user_ctx                 = this,
+        .is_websocket             = false,
+        .handle_ws_control_frames = false,
+        .supported_subprotocol    = NULL};
+    httpd_register_uri_handler(server, &ir_capture_mode_uri);
+
+    httpd_uri_t ir_stats_uri = {
+        .uri                      = "/ir_stats",
+        .method                   = HTTP_GET,
+        .handler                  = ir_stats_get_handler,
+        .user_ctx                 = this,
+        .is_websocket             = false,
+        .handle_ws_control_frames = false,
+        .supported_subprotocol    = NULL};
+    httpd_register_uri_handler(server, &ir_stats_uri);
+
+    httpd_uri_t speaker_stats_uri = {
+        .uri                      = "/speaker_stats",
+        .method                   = HTTP_GET,
+        .handler                  = speaker_stats_get_handler,
+        .user_ctx                 = this,
+        .is_websocket             = false,
+        .handle_ws_control_frames = false,
+        .supported_subprotocol    = NULL};
+    httpd_register_uri_handler(server, &speaker_stats_uri);
+
+    if (!notifier_handle) {
+        if (xTaskCreate(notifier_task_wrapper, "ws_notifier", NOTIFIER_TASK_STACK, this, NOTIFIER_TASK_PRIORITY, &notifier_handle) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create WebSocket notifier task");
+        } else {
+            EventBus::get_instance()->subscribe(&events,
+                                                EVENT_TOPIC_BIT(EVENT_TOPIC_NEW_READING) |
+                                                    EVENT_TOPIC_BIT(EVENT_TOPIC_DISPLAY_STATE) |
+                                                    EVENT_TOPIC_BIT(EVENT_TOPIC_SPEAKER_STATE) |
+                                                    EVENT_TOPIC_BIT(EVENT_TOPIC_INPUT));
+        }
+    }
+
     ESP_LOGI(TAG, "Server start successful");
 
     return ESP_OK;
@@ -157,6 +282,73 @@ void Webserver::stop() {
     }
 }
 
+static void send_history_readings(httpd_req_t* req, DHT11Sensor* dht_sensor, time_t since) {
+    dht_history_store_t::Cursor cursor = dht_sensor->history_cursor();
+
+    char header[64];
+    snprintf(header, sizeof(header), "{\"tier\":\"raw\",\"bucket_seconds\":%d,\"history\":[", READ_INTERVAL_MS / 1000);
+    std::string json_chunk = header;
+
+    float temperature;
+    float humidity;
+    time_t timestamp;
+    bool first = true;
+    while (cursor.next(&temperature, &humidity, &timestamp)) {
+        if (timestamp < since) {
+            continue;
+        }
+
+        char buffer[128];
+        snprintf(buffer, sizeof(buffer), "%s{\"temperature\":%.2f,\"humidity\":%.1f,\"timestamp\":%lld}",
+                 first ? "" : ",", temperature, humidity, (long long)timestamp);
+        json_chunk += buffer;
+        first = false;
+
+        if (json_chunk.length() >= HISTORY_CHUNK_SIZE) {
+            httpd_resp_send_chunk(req, json_chunk.c_str(), json_chunk.length());
+            json_chunk.clear();
+        }
+    }
+    json_chunk += "]}";
+
+    httpd_resp_send_chunk(req, json_chunk.c_str(), json_chunk.length());
+    httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static void send_history_rollups(httpd_req_t* req, DHT11Sensor* dht_sensor, const RollupTierView* tier, time_t since) {
+    std::vector<rollup_bucket_t> buckets(tier->size());
+    size_t num_buckets = dht_sensor->copy_rollups(tier, (uint32_t)since, buckets.data(), buckets.size());
+
+    char header[64];
+    snprintf(header, sizeof(header), "{\"tier\":\"%lum\",\"bucket_seconds\":%lu,\"history\":[",
+             (unsigned long)(tier->get_bucket_seconds() / 60), (unsigned long)tier->get_bucket_seconds());
+    std::string json_chunk = header;
+
+    for (size_t i = 0; i < num_buckets; i++) {
+        const rollup_bucket_t& bucket = buckets[i];
+        char buffer[256];
+        snprintf(buffer, sizeof(buffer),
+                 "%s{\"temperature\":%.2f,\"humidity\":%.1f,\"timestamp\":%lu,"
+                 "\"temperature_min\":%.1f,\"temperature_max\":%.1f,"
+                 "\"humidity_min\":%.1f,\"humidity_max\":%.1f,\"count\":%u}",
+                 i == 0 ? "" : ",",
+                 bucket.temperature_sum / (10.0f * bucket.count), bucket.humidity_sum / (10.0f * bucket.count),
+                 (unsigned long)bucket.start,
+                 bucket.temperature_min / 10.0f, bucket.temperature_max / 10.0f,
+                 bucket.humidity_min / 10.0f, bucket.humidity_max / 10.0f, bucket.count);
+        json_chunk += buffer;
+
+        if (json_chunk.length() >= HISTORY_CHUNK_SIZE) {
+            httpd_resp_send_chunk(req, json_chunk.c_str(), json_chunk.length());
+            json_chunk.clear();
+        }
+    }
+    json_chunk += "]}";
+
+    httpd_resp_send_chunk(req, json_chunk.c_str(), json_chunk.length());
+    httpd_resp_send_chunk(req, NULL, 0);
+}
+
 esp_err_t Webserver::dht_history_get_handler(httpd_req_t* req) {
     DHT11Sensor* dht_sensor = DHT11Sensor::get_instance();
 
@@ -165,25 +357,71 @@ esp_err_t Webserver::dht_history_get_handler(httpd_req_t* req) {
         return ESP_FAIL;
     }
 
-    dht11_reading_t history_buffer[DHT_HISTORY_SIZE];
-    uint32_t num_readings = 0;
-    dht_sensor->get_history(history_buffer, &num_readings);
+    uint32_t range_seconds = 0;
+    uint32_t max_points    = HISTORY_DEFAULT_POINTS;
 
-    std::string json_response = "{\"history\":[";
-    for (uint32_t i = 0; i < num_readings; ++i) {
-        char buffer[128];
-        snprintf(buffer, sizeof(buffer), "{\"temperature\":%.2f,\"humidity\":%.1f,\"timestamp\":%lld}",
-                 history_buffer[i].temperature, history_buffer[i].humidity, (long long)history_buffer[i].timestamp);
-        json_response += buffer;
-        if (i < num_readings - 1) {
-            json_response += ",";
+    char query[64];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[16];
+        if (httpd_query_key_value(query, "range", value, sizeof(value)) == ESP_OK) {
+            range_seconds = strtoul(value, NULL, 10);
+        }
+        if (httpd_query_key_value(query, "points", value, sizeof(value)) == ESP_OK) {
+            max_points = strtoul(value, NULL, 10);
         }
     }
-    json_response += "]}";
 
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_response.c_str(), json_response.length());
-    ESP_LOGI(TAG, "Sent history data.");
+
+    if (range_seconds == 0) {
+        send_history_readings(req, dht_sensor, 0);
+        ESP_LOGI(TAG, "Sent history data.");
+        return ESP_OK;
+    }
+
+    time_t since               = time(NULL) - range_seconds;
+    const RollupTierView* tier = dht_sensor->select_rollup_tier(range_seconds, max_points > 0 ? max_points : 1);
+    if (tier) {
+        send_history_rollups(req, dht_sensor, tier, since);
+    } else {
+        send_history_readings(req, dht_sensor, since);
+    }
+    ESP_LOGI(TAG, "Sent history data for the last %lu seconds.", (unsigned long)range_seconds);
+    return ESP_OK;
+}
+
+esp_err_t Webserver::dht_log_get_handler(httpd_req_t* req) {
+    DHT11Sensor* dht_sensor = DHT11Sensor::get_instance();
+
+    flash_log_iter_t iter;
+    if (!dht_sensor || !dht_sensor->log_iter_begin(&iter)) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Persistent log not available");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "application/json");
+
+    std::string json_chunk = "{\"log\":[";
+    flash_log_record_t record;
+    uint32_t num_records = 0;
+    while (dht_sensor->log_iter_next(&iter, &record)) {
+        char buffer[128];
+        snprintf(buffer, sizeof(buffer), "%s{\"temperature\":%.1f,\"humidity\":%.1f,\"timestamp\":%lu}",
+                 num_records == 0 ? "" : ",", record.temperature_deci / 10.0f, record.humidity_deci / 10.0f,
+                 (unsigned long)record.timestamp);
+        json_chunk += buffer;
+        num_records++;
+
+        if (json_chunk.length() >= HISTORY_CHUNK_SIZE) {
+            httpd_resp_send_chunk(req, json_chunk.c_str(), json_chunk.length());
+            json_chunk.clear();
+        }
+    }
+    json_chunk += "]}";
+
+    httpd_resp_send_chunk(req, json_chunk.c_str(), json_chunk.length());
+    httpd_resp_send_chunk(req, NULL, 0);
+    ESP_LOGI(TAG, "Streamed %lu logged readings.", num_records);
     return ESP_OK;
 }
 
@@ -194,17 +432,36 @@ esp_err_t Webserver::dht_data_get_handler(httpd_req_t* req) {
         return ESP_FAIL;
     }
 
-    dhtSensor->notify_read();
+    bool wait_for_fresh = false;
+    char query[32];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[8];
+        if (httpd_query_key_value(query, "fresh", value, sizeof(value)) == ESP_OK) {
+            wait_for_fresh = strcmp(value, "1") == 0;
+        }
+    }
 
-    float temperature = dhtSensor->get_temperature();
-    float humidity    = dhtSensor->get_humidity();
+    dht11_snapshot_t reading;
+    const char* outcome = "cached";
+    if (wait_for_fresh) {
+        outcome = dht11_read_outcome_name(dhtSensor->read_fresh(pdMS_TO_TICKS(FRESH_READ_TIMEOUT_MS), &reading));
+    } else {
+        reading = dhtSensor->snapshot();
+    }
 
     std::string json_response;
-    if (isnan(temperature) || isnan(humidity)) {
-        json_response = "{\"temperature\": null, \"humidity\": null}";
+    if (isnan(reading.temperature) || isnan(reading.humidity)) {
+        char buffer[96];
+        snprintf(buffer, sizeof(buffer), "{\"temperature\": null, \"humidity\": null, \"outcome\": \"%s\"}", outcome);
+        json_response = buffer;
     } else {
-        char buffer[64];
-        snprintf(buffer, sizeof(buffer), "{\"temperature\": %.2f, \"humidity\": %.1f}", temperature, humidity);
+        uint64_t age_ms = (esp_timer_get_time() - reading.monotonic_us) / 1000;
+        char buffer[224];
+        snprintf(buffer, sizeof(buffer),
+                 "{\"temperature\": %.2f, \"humidity\": %.1f, \"timestamp\": %lld, \"sequence\": %lu, "
+                 "\"age_ms\": %llu, \"outcome\": \"%s\"}",
+                 reading.temperature, reading.humidity, (long long)reading.timestamp, (unsigned long)reading.sequence,
+                 (unsigned long long)age_ms, outcome);
         json_response = buffer;
     }
 
@@ -235,16 +492,9 @@ esp_err_t Webserver::script_js_get_handler(httpd_req_t* req) {
 }
 
 esp_err_t Webserver::lcd_toggle_handler(httpd_req_t* req) {
+    // Clients learn the new state from the display state event
     LCDDisplay::get_instance()->toggle_power();
 
-    vTaskDelay(pdMS_TO_TICKS(200));
-
-    Webserver::get_instance()->send_state_update(
-        "{\"lcd_on\": " + std::string(LCDDisplay::get_instance()->is_on() ? "true" : "false") +
-        ", \"speaker_on\": " + std::string(Speaker::get_instance()->is_on() ? "true" : "false") +
-        "}"
-    );
-
     httpd_resp_send(req, "OK", HTTPD_RESP_USE_STRLEN);
     return ESP_OK;
 }
@@ -252,12 +502,6 @@ esp_err_t Webserver::lcd_toggle_handler(httpd_req_t* req) {
 esp_err_t Webserver::speaker_toggle_handler(httpd_req_t* req) {
     Speaker::get_instance()->toggle_power();
 
-    Webserver::get_instance()->send_state_update(
-        "{\"lcd_on\": " + std::string(LCDDisplay::get_instance()->is_on() ? "true" : "false") +
-        ", \"speaker_on\": " + std::string(Speaker::get_instance()->is_on() ? "true" : "false") +
-        "}"
-    );
-
     httpd_resp_send(req, "OK", HTTPD_RESP_USE_STRLEN);
     return ESP_OK;
 }
@@ -322,6 +566,372 @@ esp_err_t Webserver::websocket_handler(httpd_req_t* req) {
     return ESP_OK;
 }
 
+esp_err_t Webserver::bus_stats_get_handler(httpd_req_t* req) {
+    char json_string[1024];
+    int len = snprintf(json_string, sizeof(json_string), "{");
+
+    for (int topic = 0; topic < EVENT_TOPIC_MAX && len > 0 && len < sizeof(json_string); topic++) {
+        event_topic_stats_t stats = EventBus::get_instance()->get_stats((event_topic_t)topic);
+        len += snprintf(json_string + len, sizeof(json_string) - len,
+                        "%s\"%s\": {\"published\": %lu, \"dropped\": %lu, \"queue_high_water\": %lu, \"max_publish_us\": %lu}",
+                        topic > 0 ? ", " : "",
+                        event_topic_name((event_topic_t)topic),
+                        (unsigned long)stats.published,
+                        (unsigned long)stats.dropped,
+                        (unsigned long)stats.queue_high_water,
+                        (unsigned long)stats.max_publish_us);
+    }
+
+    command_channel_stats_t channels[] = {LCDDisplay::get_instance()->get_command_stats(), Speaker::get_instance()->get_command_stats()};
+    const char* channel_names[]        = {"lcd_commands", "speaker_commands"};
+    for (int i = 0; i < 2 && len > 0 && len < sizeof(json_string); i++) {
+        len += snprintf(json_string + len, sizeof(json_string) - len,
+                        ", \"%s\": {\"submitted\": %lu, \"coalesced\": %lu, \"dropped\": %lu}",
+                        channel_names[i],
+                        (unsigned long)channels[i].submitted,
+                        (unsigned long)channels[i].coalesced,
+                        (unsigned long)channels[i].dropped);
+    }
+    if (len > 0 && len < sizeof(json_string)) {
+        len += snprintf(json_string + len, sizeof(json_string) - len, "}");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    if (len > 0 && len < sizeof(json_string)) {
+        httpd_resp_send(req, json_string, len);
+    } else {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to format JSON data");
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t Webserver::lcd_stats_get_handler(httpd_req_t* req) {
+    lcd_refresh_stats_t refresh;
+    lcd_i2c_stats_t driver;
+    if (!LCDDisplay::get_instance()->get_driver_stats(&refresh, &driver)) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "LCD not initialized");
+        return ESP_OK;
+    }
+
+    char json_string[384];
+    int len = snprintf(json_string, sizeof(json_string),
+                       "{\"refreshes\": %lu, \"refresh_last_us\": %lu, \"refresh_max_us\": %lu, \"refresh_avg_us\": %lu, "
+                       "\"flushes\": %lu, \"cells_written\": %lu, \"cursor_moves\": %lu, "
+                       "\"i2c_transactions\": %lu, \"i2c_bytes\": %lu, \"settle_waits\": %lu, \"settle_wait_us\": %lu}",
+                       (unsigned long)refresh.refreshes,
+                       (unsigned long)refresh.last_us,
+                       (unsigned long)refresh.max_us,
+                       (unsigned long)(refresh.refreshes ? refresh.total_us / refresh.refreshes : 0),
+                       (unsigned long)driver.flushes,
+                       (unsigned long)driver.cells_written,
+                       (unsigned long)driver.cursor_moves,
+                       (unsigned long)driver.i2c_transactions,
+                       (unsigned long)driver.i2c_bytes,
+                       (unsigned long)driver.settle_waits,
+                       (unsigned long)driver.settle_wait_us);
+
+    httpd_resp_set_type(req, "application/json");
+    if (len > 0 && len < sizeof(json_string)) {
+        httpd_resp_send(req, json_string, len);
+    } else {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to format JSON data");
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t Webserver::i2c_stats_get_handler(httpd_req_t* req) {
+    i2c_bus_stats_t bus;
+    i2c_bus_get_stats(&bus);
+
+    char json_string[1024];
+    int len = snprintf(json_string, sizeof(json_string),
+                       "{\"transactions\": %lu, \"bus_resets\": %lu, \"reset_failures\": %lu, \"queue_full\": %lu, "
+                       "\"queue_high_water\": %lu, \"devices\": [",
+                       (unsigned long)bus.transactions,
+                       (unsigned long)bus.bus_resets,
+                       (unsigned long)bus.reset_failures,
+                       (unsigned long)bus.queue_full,
+                       (unsigned long)bus.queue_high_water);
+
+    bool first = true;
+    for (size_t i = 0; i < i2c_bus_get_device_count() && len > 0 && len < sizeof(json_string); i++) {
+        const i2c_bus_device_t* device = i2c_bus_get_device(i);
+        if (device == nullptr) {
+            continue;
+        }
+
+        i2c_bus_device_stats_t stats;
+        i2c_bus_get_device_stats(device, &stats);
+        len += snprintf(json_string + len, sizeof(json_string) - len,
+                        "%s{\"name\": \"%s\", \"address\": %u, \"transfers\": %lu, \"bytes\": %lu, \"merged\": %lu, "
+                        "\"errors\": %lu, \"timeouts\": %lu, \"retries\": %lu, \"deadline_misses\": %lu, "
+                        "\"latency_last_us\": %lu, \"latency_max_us\": %lu, \"latency_avg_us\": %lu}",
+                        first ? "" : ", ",
+                        device->name,
+                        (unsigned)device->address,
+                        (unsigned long)stats.transfers,
+                        (unsigned long)stats.bytes,
+                        (unsigned long)stats.merged,
+                        (unsigned long)stats.errors,
+                        (unsigned long)stats.timeouts,
+                        (unsigned long)stats.retries,
+                        (unsigned long)stats.deadline_misses,
+                        (unsigned long)stats.last_latency_us,
+                        (unsigned long)stats.max_latency_us,
+                        (unsigned long)(stats.transfers ? stats.total_latency_us / stats.transfers : 0));
+        first = false;
+    }
+    if (len > 0 && len < sizeof(json_string)) {
+        len += snprintf(json_string + len, sizeof(json_string) - len, "]}");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    if (len > 0 && len < sizeof(json_string)) {
+        httpd_resp_send(req, json_string, len);
+    } else {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to format JSON data");
+    }
+
+    return ESP_OK;
+}
+
+static std::string format_learn_status(const ir_learn_status_t& status) {
+    char json_string[128];
+    snprintf(json_string, sizeof(json_string),
+             "{\"active\": %s, \"all_actions\": %s, \"action\": \"%s\", \"remaining_ms\": %lu}",
+             status.active ? "true" : "false",
+             status.all_actions ? "true" : "false",
+             ir_action_name(status.action),
+             (unsigned long)status.remaining_ms);
+    return json_string;
+}
+
+// ?action=<name> learns one action, no action learns every action in turn, ?cancel=1 stops learning
+esp_err_t Webserver::ir_learn_handler(httpd_req_t* req) {
+    IRDecoder* decoder = IRDecoder::get_instance();
+    ir_action_t action = IR_ACTION_NONE;
+    bool cancel        = false;
+
+    char query[64];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[24];
+        if (httpd_query_key_value(query, "action", value, sizeof(value)) == ESP_OK) {
+            action = ir_action_from_name(value);
+        }
+        if (httpd_query_key_value(query, "cancel", value, sizeof(value)) == ESP_OK) {
+            cancel = strcmp(value, "0") != 0;
+        }
+    }
+
+    if (cancel) {
+        decoder->stop_learning();
+    } else if (decoder->start_learning(action) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown action");
+        return ESP_FAIL;
+    }
+
+    std::string json = format_learn_status(decoder->get_learn_status());
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json.c_str(), json.length());
+    return ESP_OK;
+}
+
+esp_err_t Webserver::ir_keymap_get_handler(httpd_req_t* req) {
+    IRDecoder* decoder = IRDecoder::get_instance();
+
+    ir_binding_t bindings[IR_KEYMAP_MAX_LISTED];
+    size_t count = decoder->get_bindings(bindings, IR_KEYMAP_MAX_LISTED);
+
+    std::string json = "{\"learning\": " + format_learn_status(decoder->get_learn_status()) + ", \"bindings\": [";
+    for (size_t i = 0; i < count; i++) {
+        char entry[160];
+        snprintf(entry, sizeof(entry),
+                 "%s{\"protocol\": \"%s\", \"address\": %s, \"command\": %u, \"action\": \"%s\"}",
+                 i > 0 ? ", " : "",
+                 ir_protocol_name(bindings[i].protocol),
+                 bindings[i].any_address ? "null" : std::to_string(bindings[i].address).c_str(),
+                 (unsigned)bindings[i].command,
+                 ir_action_name(bindings[i].action));
+        json += entry;
+    }
+    json += "]}";
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json.c_str(), json.length());
+    return ESP_OK;
+}
+
+// Recorded captures as an IR frame corpus, labelled with what the device decoded them as
+esp_err_t Webserver::ir_capture_get_handler(httpd_req_t* req) {
+    IRDecoder* decoder = IRDecoder::get_instance();
+    httpd_resp_set_type(req, "text/plain");
+    httpd_resp_sendstr_chunk(req, IR_CORPUS_HEADER "\n");
+
+    // Static: a full capture line does not fit comfortably on the httpd stack
+    static ir_capture_t capture;
+    static char line[IR_CAPTURE_MAX_DURATIONS * 6 + 64];
+    for (size_t i = 0; decoder->get_capture(i, &capture); i++) {
+        snprintf(line, sizeof(line), "# t=%lu us, %s\n", (unsigned long)capture.timestamp_us,
+                 ir_decode_status_name(capture.status));
+        httpd_resp_sendstr_chunk(req, line);
+
+        int len = ir_corpus_format_line(&capture.result, capture.durations, capture.num_durations, line, sizeof(line) - 1);
+        if (len > 0 && len < (int)sizeof(line) - 1) {
+            line[len++] = '\n';
+            httpd_resp_send_chunk(req, line, len);
+        }
+    }
+    httpd_resp_send_chunk(req, NULL, 0);
+    return ESP_OK;
+}
+
+// ?enable=1|0 switches recording, ?clear=1 drops what was recorded
+esp_err_t Webserver::ir_capture_mode_handler(httpd_req_t* req) {
+    IRDecoder* decoder = IRDecoder::get_instance();
+
+    char query[64];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[8];
+        if (httpd_query_key_value(query, "enable", value, sizeof(value)) == ESP_OK) {
+            decoder->set_capture_mode(strcmp(value, "0") != 0);
+        }
+        if (httpd_query_key_value(query, "clear", value, sizeof(value)) == ESP_OK && strcmp(value, "0") != 0) {
+            decoder->clear_captures();
+        }
+    }
+
+    char json_string[64];
+    int len = snprintf(json_string, sizeof(json_string), "{\"capture_mode\": %s, \"captures\": %u}",
+                       decoder->is_capture_mode() ? "true" : "false", (unsigned)decoder->get_capture_count());
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json_string, len);
+    return ESP_OK;
+}
+
+esp_err_t Webserver::ir_stats_get_handler(httpd_req_t* req) {
+    ir_capture_stats_t capture;
+    ir_decoder_get_stats(&capture);
+    ir_decode_stats_t decode;
+    IRDecoder::get_instance()->get_decode_stats(&decode);
+
+    char json_string[1024];
+    int len = snprintf(json_string, sizeof(json_string),
+                       "{\"captures\": %lu, \"edges\": %lu, \"dropped_captures\": %lu, \"ring_overflows\": %lu, "
+                       "\"ring_high_water\": %lu, \"rearm_failures\": %lu, \"repeats\": %lu, \"protocols\": {",
+                       (unsigned long)capture.captures,
+                       (unsigned long)capture.edges,
+                       (unsigned long)capture.dropped_captures,
+                       (unsigned long)capture.ring_overflows,
+                       (unsigned long)capture.ring_high_water,
+                       (unsigned long)capture.rearm_failures,
+                       (unsigned long)decode.repeats);
+
+    // Tolerances as compiled into the decoder, which may be overridden for the build
+    for (int i = 0; i < IR_PROTOCOL_DECODERS && len > 0 && len < sizeof(json_string); i++) {
+        len += snprintf(json_string + len, sizeof(json_string) - len, "%s\"%s\": {\"frames\": %lu, \"tolerance_percent\": %u}",
+                        i > 0 ? ", " : "",
+                        ir_protocols[i].name,
+                        (unsigned long)decode.frames[ir_protocols[i].id],
+                        (unsigned)ir_protocols[i].tolerance_percent);
+    }
+    for (int status = IR_DECODE_BAD_HEADER; status < IR_DECODE_STATUS_MAX && len > 0 && len < sizeof(json_string); status++) {
+        len += snprintf(json_string + len, sizeof(json_string) - len, "%s\"%s\": %lu",
+                        status == IR_DECODE_BAD_HEADER ? "}, \"rejects\": {" : ", ",
+                        ir_decode_status_name((ir_decode_status_t)status),
+                        (unsigned long)decode.rejects[status]);
+    }
+    if (len > 0 && len < sizeof(json_string)) {
+        len += snprintf(json_string + len, sizeof(json_string) - len, "}}");
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    if (len > 0 && len < sizeof(json_string)) {
+        httpd_resp_send(req, json_string, len);
+    } else {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to format JSON data");
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t Webserver::speaker_stats_get_handler(httpd_req_t* req) {
+    speaker_stats_t stats;
+    Speaker::get_instance()->get_stats(&stats);
+
+    char json_string[512];
+    int len = snprintf(json_string, sizeof(json_string),
+                       "{\"powered\": %s, \"power_ups\": %lu, \"powered_ms\": %llu, \"buffers\": %lu, \"underruns\": %lu, "
+                       "\"wakeups\": %lu, \"render_us\": %llu, \"render_max_us\": %lu, \"render_avg_us\": %lu, "
+                       "\"plays\": %lu, \"steals\": %lu, \"rejects\": %lu, \"play_rejects\": %lu, \"clipped_samples\": %lu}",
+                       speaker_driver_is_powered() ? "true" : "false",
+                       (unsigned long)stats.driver.power_ups,
+                       (unsigned long long)(stats.driver.powered_us / 1000),
+                       (unsigned long)stats.driver.buffers,
+                       (unsigned long)stats.driver.underruns,
+                       (unsigned long)stats.wakeups,
+                       (unsigned long long)stats.render_us,
+                       (unsigned long)stats.render_max_us,
+                       (unsigned long)(stats.driver.buffers ? stats.render_us / stats.driver.buffers : 0),
+                       (unsigned long)stats.mixer.plays,
+                       (unsigned long)stats.mixer.steals,
+                       (unsigned long)stats.mixer.rejects,
+                       (unsigned long)stats.play_rejects,
+                       (unsigned long)stats.mixer.clipped_samples);
+
+    httpd_resp_set_type(req, "application/json");
+    if (len > 0 && len < sizeof(json_string)) {
+        httpd_resp_send(req, json_string, len);
+    } else {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to format JSON data");
+    }
+
+    return ESP_OK;
+}
+
+void Webserver::notifier_task_wrapper(void* pvParameters) {
+    Webserver* instance = static_cast<Webserver*>(pvParameters);
+    if (instance) {
+        instance->notifier_task_loop();
+    }
+    vTaskDelete(nullptr);
+}
+
+void Webserver::notifier_task_loop() {
+    ESP_LOGI(TAG, "WebSocket notifier task started");
+    while (true) {
+        bus_event_t event;
+        if (!events.wait(&event, portMAX_DELAY)) {
+            continue;
+        }
+
+        char json_buffer[128];
+        switch (event.topic) {
+        case EVENT_TOPIC_NEW_READING:
+            snprintf(json_buffer, sizeof(json_buffer),
+                     "{\"temperature\": %.2f, \"humidity\": %.1f, \"timestamp\": %lld, \"sequence\": %lu}",
+                     event.reading.temperature, event.reading.humidity,
+                     (long long)event.reading.timestamp, (unsigned long)event.reading.sequence);
+            break;
+        case EVENT_TOPIC_DISPLAY_STATE:
+            snprintf(json_buffer, sizeof(json_buffer), "{\"lcd_on\": %s}", event.state.on ? "true" : "false");
+            break;
+        case EVENT_TOPIC_SPEAKER_STATE:
+            snprintf(json_buffer, sizeof(json_buffer), "{\"speaker_on\": %s}", event.state.on ? "true" : "false");
+            break;
+        case EVENT_TOPIC_INPUT:
+            snprintf(json_buffer, sizeof(json_buffer), "{\"input_source\": \"%s\", \"input_code\": %u}",
+                     event.input.source == EVENT_INPUT_SOURCE_IR ? "ir" : "button", event.input.code);
+            break;
+        default:
+            continue;
+        }
+
+        send_state_update(json_buffer);
+    }
+}
+
 void Webserver::send_state_update(const std::string& state_json) {
     httpd_ws_frame_t ws_pkt;
     memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
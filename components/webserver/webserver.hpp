@@ -4,8 +4,12 @@
 
 #include "esp_err.h"
 #include "esp_http_server.h"
+#include "event_bus.hpp"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#define WS_EVENT_QUEUE_DEPTH 8
 
 #ifdef __cplusplus
 #include <string>
@@ -16,11 +20,14 @@ class Webserver {
     static Webserver* s_webserver_instance;
     static SemaphoreHandle_t s_clients_mutex;
     httpd_handle_t server = nullptr;
+    TaskHandle_t notifier_handle = nullptr;
+    EventSubscriber<WS_EVENT_QUEUE_DEPTH> events;
 
     static std::vector<int> s_connected_clients;
 
     static esp_err_t dht_history_get_handler(httpd_req_t* req);
     static esp_err_t dht_data_get_handler(httpd_req_t* req);
+    static esp_err_t dht_log_get_handler(httpd_req_t* req);
     static esp_err_t root_get_handler(httpd_req_t* req);
     static esp_err_t style_css_get_handler(httpd_req_t* req);
     static esp_err_t script_js_get_handler(httpd_req_t* req);
@@ -28,6 +35,17 @@ class Webserver {
     static esp_err_t speaker_toggle_handler(httpd_req_t* req);
     static esp_err_t status_get_handler(httpd_req_t* req);
     static esp_err_t websocket_handler(httpd_req_t* req);
+    static esp_err_t bus_stats_get_handler(httpd_req_t* req);
+    static esp_err_t lcd_stats_get_handler(httpd_req_t* req);
+    static esp_err_t i2c_stats_get_handler(httpd_req_t* req);
+    static esp_err_t ir_learn_handler(httpd_req_t* req);
+    static esp_err_t ir_keymap_get_handler(httpd_req_t* req);
+    static esp_err_t ir_capture_get_handler(httpd_req_t* req);
+    static esp_err_t ir_capture_mode_handler(httpd_req_t* req);
+    static esp_err_t ir_stats_get_handler(httpd_req_t* req);
+    static esp_err_t speaker_stats_get_handler(httpd_req_t* req);
+    static void notifier_task_wrapper(void* pvParameters);
+    void notifier_task_loop();
     static httpd_handle_t s_websocket_handle;
 
   public:
@@ -0,0 +1,136 @@
+// flash_file.c
+
+#include "flash_file.h"
+#include <string.h>
+
+static esp_err_t _file_read(flash_file_t* flash, size_t offset, void* dst, size_t len) {
+    if (fseek(flash->file, (long)offset, SEEK_SET) != 0) {
+        return ESP_FAIL;
+    }
+    return fread(dst, 1, len, flash->file) == len ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t _file_write(flash_file_t* flash, size_t offset, const void* src, size_t len) {
+    if (fseek(flash->file, (long)offset, SEEK_SET) != 0) {
+        return ESP_FAIL;
+    }
+    return fwrite(src, 1, len, flash->file) == len ? ESP_OK : ESP_FAIL;
+}
+
+// How much of an operation of len bytes completes before the power goes
+static size_t _before_cut(flash_file_t* flash, size_t len) {
+    if (flash->cut_after_bytes == FLASH_FILE_NO_CUT) {
+        return len;
+    }
+    if (flash->cut_after_bytes >= len) {
+        flash->cut_after_bytes -= len;
+        return len;
+    }
+    size_t done            = flash->cut_after_bytes;
+    flash->cut_after_bytes = 0;
+    flash->powered_off     = true;
+    return done;
+}
+
+static esp_err_t _read(void* ctx, size_t offset, void* dst, size_t len) {
+    flash_file_t* flash = (flash_file_t*)ctx;
+    if (flash->powered_off || offset + len > flash->size) {
+        return ESP_FAIL;
+    }
+    flash->operations++;
+    flash->bytes_read += len;
+    return _file_read(flash, offset, dst, len);
+}
+
+static esp_err_t _write(void* ctx, size_t offset, const void* src, size_t len) {
+    flash_file_t* flash = (flash_file_t*)ctx;
+    if (flash->powered_off || offset + len > flash->size) {
+        return ESP_FAIL;
+    }
+    if (flash->fail_writes > 0) {
+        flash->fail_writes--;
+        return ESP_FAIL;
+    }
+    flash->operations++;
+
+    uint8_t cells[FLASH_LOG_SECTOR_SIZE];
+    size_t done = _before_cut(flash, len);
+    for (size_t pos = 0; pos < done; pos += sizeof(cells)) {
+        size_t chunk = done - pos < sizeof(cells) ? done - pos : sizeof(cells);
+        if (_file_read(flash, offset + pos, cells, chunk) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        for (size_t i = 0; i < chunk; i++) {
+            cells[i] &= ((const uint8_t*)src)[pos + i];
+        }
+        if (_file_write(flash, offset + pos, cells, chunk) != ESP_OK) {
+            return ESP_FAIL;
+        }
+    }
+    flash->bytes_programmed += done;
+    return done == len ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t _erase_sector(void* ctx, size_t offset) {
+    flash_file_t* flash = (flash_file_t*)ctx;
+    if (flash->powered_off || offset % FLASH_LOG_SECTOR_SIZE != 0 || offset + FLASH_LOG_SECTOR_SIZE > flash->size) {
+        return ESP_FAIL;
+    }
+    flash->operations++;
+
+    uint8_t blank[FLASH_LOG_SECTOR_SIZE];
+    memset(blank, 0xFF, sizeof(blank));
+    size_t done = _before_cut(flash, sizeof(blank));
+    if (_file_write(flash, offset, blank, done) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    if (done < sizeof(blank)) {
+        return ESP_FAIL;
+    }
+    flash->sectors_erased++;
+    return ESP_OK;
+}
+
+esp_err_t flash_file_open(flash_file_t* flash, const char* path, size_t size, bool erase) {
+    memset(flash, 0, sizeof(*flash));
+    flash->size            = size;
+    flash->cut_after_bytes = FLASH_FILE_NO_CUT;
+    flash->file            = fopen(path, erase ? "w+b" : "r+b");
+    if (!flash->file) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (erase) {
+        uint8_t blank[FLASH_LOG_SECTOR_SIZE];
+        memset(blank, 0xFF, sizeof(blank));
+        for (size_t offset = 0; offset < size; offset += sizeof(blank)) {
+            if (fwrite(blank, 1, sizeof(blank), flash->file) != sizeof(blank)) {
+                return ESP_FAIL;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+void flash_file_close(flash_file_t* flash) {
+    if (flash->file) {
+        fclose(flash->file);
+        flash->file = NULL;
+    }
+}
+
+void flash_file_power_on(flash_file_t* flash) {
+    flash->powered_off     = false;
+    flash->cut_after_bytes = FLASH_FILE_NO_CUT;
+    flash->fail_writes     = 0;
+}
+
+flash_log_io_t flash_file_io(flash_file_t* flash) {
+    flash_log_io_t io = {
+        .read         = _read,
+        .write        = _write,
+        .erase_sector = _erase_sector,
+        .ctx          = flash,
+        .size         = flash->size,
+    };
+    return io;
+}
@@ -0,0 +1,34 @@
+// flash_file.h
+//
+// NOR flash stand-in backed by a file, for flash_log_io_t. Programming can only clear bits and erasing sets a whole
+// sector to 0xFF, as on the chip. Power can be cut part way through an operation to leave it torn.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "flash_log.h"
+
+#define FLASH_FILE_NO_CUT SIZE_MAX
+
+typedef struct {
+    FILE* file;
+    size_t size;
+    // Power goes after this many more bytes are programmed or erased; every later operation fails until power_on
+    size_t cut_after_bytes;
+    bool powered_off;
+    // The next fail_writes writes return ESP_FAIL without touching the flash
+    uint32_t fail_writes;
+    uint64_t bytes_read;
+    uint64_t bytes_programmed;
+    uint64_t sectors_erased;
+    uint64_t operations;
+} flash_file_t;
+
+// With erase the file is created or reset to a blank chip; without it the previous contents are kept
+esp_err_t flash_file_open(flash_file_t* flash, const char* path, size_t size, bool erase);
+void flash_file_close(flash_file_t* flash);
+void flash_file_power_on(flash_file_t* flash);
+flash_log_io_t flash_file_io(flash_file_t* flash);
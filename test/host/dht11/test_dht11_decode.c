@@ -0,0 +1,157 @@
+// test_dht11_decode.c
+//
+// Decodes every frame in dht11_waveforms.txt and checks the status and bytes, then times the decoder and sweeps
+// extra jitter over the good frames.
+
+#include <stdlib.h>
+#include <string.h>
+#include "dht11_decode.h"
+#include "host_test.h"
+
+#define MAX_FRAMES 128
+#define MAX_PULSES 96
+
+typedef struct {
+    dht11_decode_status_t status;
+    int check_data;
+    uint8_t data[DHT11_FRAME_BYTES];
+    dht11_pulse_t pulses[MAX_PULSES];
+    size_t num_pulses;
+    int line;
+} waveform_t;
+
+static const char* status_names[] = {"ok", "no_response", "truncated", "timing", "checksum"};
+
+static int parse_status(const char* name, dht11_decode_status_t* status) {
+    for (int i = 0; i < (int)(sizeof(status_names) / sizeof(status_names[0])); i++) {
+        if (strcmp(name, status_names[i]) == 0) {
+            *status = (dht11_decode_status_t)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static size_t load(const char* path, waveform_t* frames) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+
+    char text[2048];
+    size_t count = 0;
+    int line     = 0;
+    while (fgets(text, sizeof(text), f) && count < MAX_FRAMES) {
+        line++;
+        if (text[0] == '#' || text[0] == '\n') {
+            continue;
+        }
+
+        waveform_t* w = &frames[count];
+        memset(w, 0, sizeof(*w));
+        w->line      = line;
+        char* status = strtok(text, ",");
+        char* data   = strtok(NULL, ",");
+        char* pulses = strtok(NULL, "\n");
+        if (!status || !data || !pulses || !parse_status(status, &w->status)) {
+            fprintf(stderr, "%s:%d: malformed line\n", path, line);
+            exit(1);
+        }
+
+        w->check_data = strcmp(data, "-") != 0;
+        for (int i = 0; w->check_data && i < DHT11_FRAME_BYTES; i++) {
+            char byte[3] = {data[2 * i], data[2 * i + 1], 0};
+            w->data[i]   = (uint8_t)strtoul(byte, NULL, 16);
+        }
+        for (char* p = strtok(pulses, " "); p && w->num_pulses < MAX_PULSES; p = strtok(NULL, " ")) {
+            w->pulses[w->num_pulses].level       = p[0] == 'H';
+            w->pulses[w->num_pulses].duration_us = (uint16_t)atoi(p + 1);
+            w->num_pulses++;
+        }
+        count++;
+    }
+    fclose(f);
+    return count;
+}
+
+static void test_fixtures(const waveform_t* frames, size_t count) {
+    size_t per_status[5] = {0};
+    for (size_t i = 0; i < count; i++) {
+        uint8_t data[DHT11_FRAME_BYTES];
+        dht11_decode_status_t status = dht11_decode_pulses(frames[i].pulses, frames[i].num_pulses, data);
+        if (status != frames[i].status) {
+            fprintf(stderr, "line %d: got %s, expected %s\n", frames[i].line, status_names[status],
+                    status_names[frames[i].status]);
+        }
+        CHECK(status == frames[i].status);
+        if (frames[i].check_data) {
+            CHECK(memcmp(data, frames[i].data, DHT11_FRAME_BYTES) == 0);
+        }
+        per_status[frames[i].status]++;
+    }
+    printf("%zu waveforms: %zu ok, %zu no_response, %zu truncated, %zu timing, %zu checksum\n", count, per_status[0],
+           per_status[1], per_status[2], per_status[3], per_status[4]);
+    CHECK(per_status[DHT11_DECODE_OK] > 0 && per_status[DHT11_DECODE_TRUNCATED] > 0);
+}
+
+static void test_values(void) {
+    const uint8_t data[DHT11_FRAME_BYTES] = {55, 3, 21, 7, 86};
+    float temperature, humidity;
+    dht11_decode_to_values(data, &temperature, &humidity);
+    CHECK(humidity > 55.29f && humidity < 55.31f);
+    CHECK(temperature > 21.69f && temperature < 21.71f);
+}
+
+// Extra uniform jitter on every pulse of the good frames; up to the sensor's own +-6 us nothing may be lost
+static void sweep_jitter(const waveform_t* frames, size_t count) {
+    uint32_t seed = 1;
+    for (int jitter = 0; jitter <= 20; jitter += 4) {
+        size_t total = 0, decoded = 0;
+        for (int round = 0; round < 50; round++) {
+            for (size_t i = 0; i < count; i++) {
+                if (frames[i].status != DHT11_DECODE_OK) {
+                    continue;
+                }
+                waveform_t w = frames[i];
+                for (size_t p = 0; p < w.num_pulses; p++) {
+                    int d                   = w.pulses[p].duration_us + (int)(host_rand(&seed) % (2 * jitter + 1)) - jitter;
+                    w.pulses[p].duration_us = (uint16_t)(d < 1 ? 1 : d);
+                }
+                uint8_t data[DHT11_FRAME_BYTES];
+                total++;
+                decoded += dht11_decode_pulses(w.pulses, w.num_pulses, data) == DHT11_DECODE_OK &&
+                           memcmp(data, w.data, DHT11_FRAME_BYTES) == 0;
+            }
+        }
+        printf("extra jitter +-%2d us: %6.2f%% decoded\n", jitter, 100.0 * decoded / total);
+        if (jitter <= 4) {
+            CHECK(decoded == total);
+        }
+    }
+}
+
+static void bench_decode(const waveform_t* frames, size_t count) {
+    const int rounds   = 2000;
+    volatile int sink  = 0;
+    uint64_t start     = host_now_ns();
+    for (int round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < count; i++) {
+            uint8_t data[DHT11_FRAME_BYTES];
+            sink += dht11_decode_pulses(frames[i].pulses, frames[i].num_pulses, data);
+        }
+    }
+    double ns = (double)(host_now_ns() - start) / ((double)rounds * count);
+    printf("decode: %.0f ns per frame over %zu waveforms\n", ns, count);
+}
+
+int main(int argc, char** argv) {
+    static waveform_t frames[MAX_FRAMES];
+    size_t count = load(argc > 1 ? argv[1] : "dht11/dht11_waveforms.txt", frames);
+
+    test_fixtures(frames, count);
+    test_values();
+    sweep_jitter(frames, count);
+    bench_decode(frames, count);
+    return host_test_result("dht11_decode");
+}
@@ -0,0 +1,194 @@
+// test_history_store.cpp
+//
+// Entry i of every test stores values and a timestamp derived from i, so anything a cursor returns can be checked on
+// its own. Covers wrap-around, a cursor whose block is overwritten between reads, a concurrent writer, and times
+// append and a full scan at the device capacity.
+
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include "history_store.hpp"
+#include "host_test.h"
+
+static const time_t BASE_TIME = 1700000000;
+
+static float temperature_of(uint32_t i) {
+    return (float)(i % 700) / 10.0f - 20.0f;
+}
+
+static float humidity_of(uint32_t i) {
+    return (float)(i % 1000) / 10.0f;
+}
+
+static time_t time_of(uint32_t i) {
+    return BASE_TIME + (time_t)i * 60;
+}
+
+template <size_t N>
+static void fill(HistoryStore<N>& store, uint32_t from, uint32_t to) {
+    for (uint32_t i = from; i < to; i++) {
+        store.append(temperature_of(i), humidity_of(i), time_of(i));
+    }
+}
+
+// Returns the entry index a reading belongs to, or -1 if its fields do not agree with each other
+static long index_of(float temperature, float humidity, time_t time) {
+    if (time < BASE_TIME || (time - BASE_TIME) % 60 != 0) {
+        return -1;
+    }
+    uint32_t i = (uint32_t)((time - BASE_TIME) / 60);
+    if (fabsf(temperature - temperature_of(i)) > 0.01f || fabsf(humidity - humidity_of(i)) > 0.01f) {
+        return -1;
+    }
+    return i;
+}
+
+static void test_wrap(void) {
+    HistoryStore<64> store;
+    fill(store, 0, 40);
+    CHECK_EQ_INT(store.size(), 40);
+    CHECK_EQ_INT(store.oldest_index(), 0);
+
+    fill(store, 40, 200);
+    CHECK_EQ_INT(store.size(), 64);
+    CHECK_EQ_INT(store.oldest_index(), 136);
+
+    auto cursor = store.cursor();
+    float temperature, humidity;
+    time_t time;
+    long expected = 136;
+    while (cursor.next(&temperature, &humidity, &time)) {
+        CHECK_EQ_INT(index_of(temperature, humidity, time), expected);
+        expected++;
+    }
+    CHECK_EQ_INT(expected, 200);
+}
+
+// A cursor paused mid-scan while the writer laps it must resume at the oldest surviving entry, not return
+// overwritten slots or a timestamp rebuilt from another block's deltas
+static void test_reseek_on_overwrite(void) {
+    HistoryStore<64> store;
+    fill(store, 0, 64);
+
+    float temperature, humidity;
+    time_t time;
+    auto cursor = store.cursor();
+    for (long i = 0; i < 20; i++) {
+        CHECK(cursor.next(&temperature, &humidity, &time));
+        CHECK_EQ_INT(index_of(temperature, humidity, time), i);
+    }
+
+    // Overwrites entries 0..39, including the rest of the block the cursor is in and the one after it
+    fill(store, 64, 104);
+    CHECK_EQ_INT(store.oldest_index(), 40);
+
+    long expected = 40;
+    while (cursor.next(&temperature, &humidity, &time)) {
+        CHECK_EQ_INT(index_of(temperature, humidity, time), expected);
+        expected++;
+    }
+    // The cursor keeps the end it was created with
+    CHECK_EQ_INT(expected, 64);
+
+    // Lapped completely: nothing it was created to cover survives
+    auto lapped = store.cursor();
+    CHECK(lapped.next(&temperature, &humidity, &time));
+    fill(store, 104, 104 + 64 + 16);
+    CHECK(!lapped.next(&temperature, &humidity, &time));
+}
+
+// Gaps too long for a 16-bit delta saturate, and the next keyframe puts the time right again
+static void test_long_gap(void) {
+    HistoryStore<32> store;
+    store.append(20.0f, 50.0f, BASE_TIME);
+    store.append(20.0f, 50.0f, BASE_TIME + 100000);
+    for (int i = 2; i < 16; i++) {
+        store.append(20.0f, 50.0f, BASE_TIME + 100000 + i);
+    }
+    store.append(20.0f, 50.0f, BASE_TIME + 200000);
+
+    auto cursor = store.cursor();
+    float temperature, humidity;
+    time_t time;
+    CHECK(cursor.next(&temperature, &humidity, &time) && time == BASE_TIME);
+    CHECK(cursor.next(&temperature, &humidity, &time) && time == BASE_TIME + UINT16_MAX);
+    for (int i = 2; i < 16; i++) {
+        cursor.next(&temperature, &humidity, &time);
+    }
+    CHECK(cursor.next(&temperature, &humidity, &time) && time == BASE_TIME + 200000);
+}
+
+static void test_concurrent_writer(void) {
+    static HistoryStore<256> store;
+    fill(store, 0, 256);
+
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        uint32_t i = 256;
+        while (!stop.load(std::memory_order_relaxed)) {
+            store.append(temperature_of(i), humidity_of(i), time_of(i));
+            i++;
+        }
+    });
+
+    uint64_t scans = 0, entries = 0, torn = 0, out_of_order = 0;
+    uint64_t end = host_now_ns() + 300000000ull;
+    while (host_now_ns() < end) {
+        auto cursor = store.cursor();
+        float temperature, humidity;
+        time_t time;
+        long last = -1;
+        while (cursor.next(&temperature, &humidity, &time)) {
+            long index = index_of(temperature, humidity, time);
+            torn += index < 0;
+            out_of_order += index >= 0 && index <= last;
+            last = index;
+            entries++;
+        }
+        scans++;
+    }
+    stop = true;
+    writer.join();
+
+    printf("concurrent writer: %llu scans, %llu entries, %llu torn, %llu out of order\n", (unsigned long long)scans,
+           (unsigned long long)entries, (unsigned long long)torn, (unsigned long long)out_of_order);
+    CHECK(entries > 0);
+    CHECK_EQ_INT(torn, 0);
+    CHECK_EQ_INT(out_of_order, 0);
+}
+
+// Same capacity as the device with PSRAM: three days at one reading a minute
+static void bench(void) {
+    static HistoryStore<4320> store;
+    const int rounds = 50;
+
+    uint64_t start = host_now_ns();
+    for (int round = 0; round < rounds; round++) {
+        fill(store, round * 4320, (round + 1) * 4320);
+    }
+    double append_ns = (double)(host_now_ns() - start) / (rounds * 4320.0);
+
+    volatile float sink = 0;
+    start               = host_now_ns();
+    for (int round = 0; round < rounds; round++) {
+        auto cursor = store.cursor();
+        float temperature, humidity;
+        time_t time;
+        while (cursor.next(&temperature, &humidity, &time)) {
+            sink = sink + temperature + humidity + (float)time;
+        }
+    }
+    double scan_us = (double)(host_now_ns() - start) / (rounds * 1000.0);
+
+    printf("capacity 4320, %zu bytes (%.2f per entry): append %.1f ns, full scan %.1f us (%.1f ns per entry)\n",
+           sizeof(store), (double)sizeof(store) / 4320, append_ns, scan_us, scan_us * 1000.0 / 4320);
+}
+
+int main() {
+    test_wrap();
+    test_reseek_on_overwrite();
+    test_long_gap();
+    test_concurrent_writer();
+    bench();
+    return host_test_result("history_store");
+}
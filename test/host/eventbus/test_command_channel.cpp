@@ -0,0 +1,178 @@
+// test_command_channel.cpp
+//
+// Synthetic command bursts against a task that runs the LCD task's command loop: submitters on several threads
+// fire cycle-mode and power-toggle commands while the task is busy rendering through lcd_i2c on the emulator
+// transport (sleeping for the bus time at 100 kHz). No command may be lost: the mode must advance by exactly the
+// number of cycle requests, an even number of toggles must leave the backlight as it was, and the channel counters
+// must account for every submission.
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "command_channel.hpp"
+#include "host_test.h"
+#include "lcd_geometry.hpp"
+
+#define WAKE_BIT        BIT0
+#define SUBMITTERS      4
+#define CYCLE_BURST     250
+
+enum { COMMAND_CYCLE_MODE, COMMAND_TOGGLE_POWER, COMMAND_MAX };
+
+static CommandChannel<COMMAND_MAX> commands;
+static std::atomic<bool> requested_on{true};
+static std::atomic<TaskHandle_t> task{nullptr};
+static std::atomic<bool> idle{false};
+
+// Written by the task, read once it is idle
+static uint32_t mode;
+static uint32_t cycles_taken;
+static uint32_t nonzero_takes;
+static uint32_t renders;
+static const lcd_emulator_t* emu;
+
+static const char* const screens[3][2] = {
+    {"Temp: 72.50 \xdf" "F  ", "Next: Hum       "},
+    {"Hum: 41.00%     ", "Next: LR        "},
+    {"LR: 7 secs ago  ", "Next: Temp      "},
+};
+
+static void render(LcdPanel<Lcd16x2>& panel) {
+    uint64_t bus_bits = emu->stats.bus_bits;
+    panel.clear();
+    switch (mode) {
+        case 0:
+            panel.write_at<0>("Temp: %.2f %cF", 72.5, 223);
+            panel.write_at<1>("Next: Hum");
+            break;
+        case 1:
+            panel.write_at<0>("Hum: %.2f%%", 41.0);
+            panel.write_at<1>("Next: LR");
+            break;
+        default:
+            panel.write_at<0>("LR: %lu secs ago", 7ul);
+            panel.write_at<1>("Next: Temp");
+            break;
+    }
+    panel.flush();
+    renders++;
+    vTaskDelay(pdMS_TO_TICKS((emu->stats.bus_bits - bus_bits) * 1000 / 100000 + 1));
+}
+
+static void display_task(void* arg) {
+    LcdPanel<Lcd16x2> panel;
+    panel.init();
+    emu            = lcd_i2c_get_emulator();
+    bool backlight = true;
+    commands.bind(xTaskGetCurrentTaskHandle(), WAKE_BIT);
+    task = xTaskGetCurrentTaskHandle();
+
+    while (true) {
+        uint32_t bits = 0;
+        idle          = xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(50)) != pdTRUE;
+        if (idle) {
+            continue;
+        }
+
+        commands.take(COMMAND_TOGGLE_POWER);
+        bool on = requested_on.load();
+        if (on != backlight) {
+            backlight = on;
+            panel.backlight(on);
+        }
+
+        uint32_t cycles = commands.take(COMMAND_CYCLE_MODE);
+        if (cycles > 0) {
+            cycles_taken += cycles;
+            nonzero_takes++;
+            mode = (mode + cycles) % 3;
+            render(panel);
+        }
+    }
+}
+
+static void toggle_power() {
+    bool was_on = requested_on.load();
+    while (!requested_on.compare_exchange_weak(was_on, !was_on)) {
+    }
+    commands.submit(COMMAND_TOGGLE_POWER);
+}
+
+static void wait_idle() {
+    idle = false;
+    while (!idle.load()) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+static void burst(int per_thread, void (*submit)()) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < SUBMITTERS; t++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < per_thread; i++) {
+                submit();
+                if (i % 16 == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    wait_idle();
+}
+
+static void check_screen(uint32_t expected_mode) {
+    char row[LCD_COLS + 1];
+    for (uint8_t r = 0; r < 2; r++) {
+        lcd_emulator_read_row(emu, r, row);
+        CHECK(strcmp(row, screens[expected_mode][r]) == 0);
+    }
+}
+
+int main() {
+    // Commands sent before the task listens are dropped and counted
+    CHECK(!commands.submit(COMMAND_CYCLE_MODE));
+    CHECK(!commands.submit(COMMAND_TOGGLE_POWER));
+    CHECK_EQ_INT(commands.get_stats().dropped, 2);
+
+    xTaskCreate(display_task, "display", 4096, nullptr, 5, nullptr);
+    while (!task.load()) {
+        vTaskDelay(1);
+    }
+
+    burst(CYCLE_BURST, [] { commands.submit(COMMAND_CYCLE_MODE); });
+    command_channel_stats_t stats = commands.get_stats();
+    printf("%d cycle requests from %d threads: %u renders, %u coalesced, mode %u\n", SUBMITTERS * CYCLE_BURST,
+           SUBMITTERS, renders, stats.coalesced, mode);
+    CHECK_EQ_INT(cycles_taken, SUBMITTERS * CYCLE_BURST);
+    CHECK_EQ_INT(mode, SUBMITTERS * CYCLE_BURST % 3);
+    CHECK_EQ_INT(stats.submitted, SUBMITTERS * CYCLE_BURST);
+    CHECK_EQ_INT(stats.submitted - stats.coalesced, nonzero_takes);
+    CHECK(renders < SUBMITTERS * CYCLE_BURST);
+    check_screen(mode);
+
+    // One more request renders the next screen on its own
+    uint32_t renders_before = renders;
+    commands.submit(COMMAND_CYCLE_MODE);
+    wait_idle();
+    CHECK_EQ_INT(renders, renders_before + 1);
+    check_screen((SUBMITTERS * CYCLE_BURST + 1) % 3);
+
+    // Every toggle flips the requested state before the wake, so a burst reconciles to the right backlight
+    burst(10, toggle_power);
+    CHECK(requested_on.load() && lcd_emulator_backlight(emu));
+    toggle_power();
+    wait_idle();
+    CHECK(!requested_on.load() && !lcd_emulator_backlight(emu));
+    burst(5, toggle_power);
+    CHECK(!requested_on.load() && !lcd_emulator_backlight(emu));
+
+    stats = commands.get_stats();
+    printf("channel: %u submitted, %u coalesced, %u dropped\n", stats.submitted, stats.coalesced, stats.dropped);
+    CHECK_EQ_INT(stats.submitted, SUBMITTERS * CYCLE_BURST + 1 + SUBMITTERS * 10 + 1 + SUBMITTERS * 5);
+    CHECK_EQ_INT(emu->stats.enable_errors + emu->stats.rw_errors + emu->stats.busy_errors, 0);
+    return host_test_result("command_channel");
+}
@@ -0,0 +1,122 @@
+// test_event_bus.cpp
+//
+// A publisher sends a reading every millisecond to two subscriber tasks. The fast one only counts what it gets. The
+// slow one stands in for the LCD: it renders each reading through lcd_i2c on the emulator transport and then sleeps
+// for the bus time the render would take at 100 kHz, so it falls far behind. Publishing must not wait for it: the
+// slow subscriber loses events instead, every event is either delivered or counted as dropped, and publishing
+// almost always takes less time than even the cheapest render.
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include "event_bus.hpp"
+#include "host_test.h"
+#include "lcd_geometry.hpp"
+
+#define READINGS        300
+#define SUBSCRIBER_BIT  BIT0
+
+static EventBus* bus;
+static std::atomic<bool> stop{false};
+static std::atomic<uint32_t> fast_received{0};
+static std::atomic<uint32_t> slow_received{0};
+static std::atomic<uint32_t> min_render_us{UINT32_MAX};
+
+static EventSubscriber<8> fast_subscriber;
+static EventSubscriber<4> slow_subscriber;
+static std::atomic<TaskHandle_t> slow_task{nullptr};
+
+static void fast_task(void* arg) {
+    bus_event_t event;
+    while (!stop.load()) {
+        if (fast_subscriber.wait(&event, pdMS_TO_TICKS(10))) {
+            fast_received++;
+        }
+    }
+    vTaskDelete(nullptr);
+}
+
+static void lcd_subscriber_task(void* arg) {
+    LcdPanel<Lcd16x2> panel;
+    panel.init();
+    const lcd_emulator_t* emu = lcd_i2c_get_emulator();
+    slow_task                 = xTaskGetCurrentTaskHandle();
+
+    while (!stop.load()) {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, SUBSCRIBER_BIT, &bits, pdMS_TO_TICKS(10));
+
+        bus_event_t event;
+        while (slow_subscriber.receive(&event)) {
+            slow_received++;
+            uint64_t bus_bits = emu->stats.bus_bits;
+            panel.clear();
+            if (event.reading.sequence % 2) {
+                panel.write_at<0>("Temp: %.2f %cF", event.reading.temperature, 223);
+                panel.write_at<1>("Next: Hum");
+            } else {
+                panel.write_at<0>("Hum: %.2f%%", event.reading.humidity);
+                panel.write_at<1>("Next: LR");
+            }
+            panel.flush();
+
+            uint32_t render_us = (uint32_t)((emu->stats.bus_bits - bus_bits) * 1000000ull / 100000);
+            if (render_us < min_render_us) {
+                min_render_us = render_us;
+            }
+            vTaskDelay(pdMS_TO_TICKS((render_us + 999) / 1000));
+        }
+    }
+    vTaskDelete(nullptr);
+}
+
+int main() {
+    bus = EventBus::get_instance();
+    TaskHandle_t fast;
+    xTaskCreate(fast_task, "fast", 2048, nullptr, 5, &fast);
+    xTaskCreate(lcd_subscriber_task, "lcd", 4096, nullptr, 5, nullptr);
+    while (!slow_task.load()) {
+        vTaskDelay(1);
+    }
+    CHECK(bus->subscribe(&fast_subscriber, EVENT_TOPIC_BIT(EVENT_TOPIC_NEW_READING)) == ESP_OK);
+    CHECK(bus->subscribe(&slow_subscriber, EVENT_TOPIC_BIT(EVENT_TOPIC_NEW_READING), slow_task.load(), SUBSCRIBER_BIT) ==
+          ESP_OK);
+
+    std::vector<uint64_t> latency_ns;
+    for (uint32_t i = 0; i < READINGS; i++) {
+        bus_event_t event         = {};
+        event.topic               = EVENT_TOPIC_NEW_READING;
+        event.reading.temperature = 60.0f + (float)(i % 40) / 4;
+        event.reading.humidity    = 30.0f + (float)(i % 20);
+        event.reading.sequence    = i;
+
+        uint64_t start = host_now_ns();
+        bus->publish(event);
+        latency_ns.push_back(host_now_ns() - start);
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+
+    // Wait for both subscribers to drain what they were given
+    event_topic_stats_t stats = bus->get_stats(EVENT_TOPIC_NEW_READING);
+    for (int i = 0; i < 500 && fast_received + slow_received + stats.dropped < 2 * READINGS; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        stats = bus->get_stats(EVENT_TOPIC_NEW_READING);
+    }
+    stop = true;
+
+    std::sort(latency_ns.begin(), latency_ns.end());
+    printf("%u readings: fast subscriber got %u, LCD subscriber got %u, %u dropped, queue high water %u\n", READINGS,
+           fast_received.load(), slow_received.load(), stats.dropped, stats.queue_high_water);
+    printf("publish latency: median %.1f us, p99 %.1f us, max %.1f us (bus max %u us); the cheapest LCD render takes %u us\n",
+           latency_ns[READINGS / 2] / 1000.0, latency_ns[READINGS * 99 / 100] / 1000.0, latency_ns.back() / 1000.0,
+           stats.max_publish_us, min_render_us.load());
+
+    CHECK_EQ_INT(stats.published, READINGS);
+    CHECK_EQ_INT(fast_received + slow_received + stats.dropped, 2 * READINGS);
+    CHECK_EQ_INT(fast_received, READINGS);
+    CHECK(stats.dropped > 0);
+    CHECK(stats.queue_high_water <= 8);
+    // Not the maximum: on the host the publishing thread can be preempted by the subscribers it wakes
+    CHECK(latency_ns[READINGS * 99 / 100] < min_render_us * 1000ull);
+    return host_test_result("event_bus");
+}
@@ -0,0 +1,52 @@
+// host_test.h
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// Minimal checks for the host tests: every failed CHECK is reported and the test exits non-zero at the end
+static int host_test_failures = 0;
+
+#define CHECK(cond)                                                                          \
+    do {                                                                                     \
+        if (!(cond)) {                                                                       \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond);         \
+            host_test_failures++;                                                            \
+        }                                                                                    \
+    } while (0)
+
+#define CHECK_EQ_INT(actual, expected)                                                                          \
+    do {                                                                                                        \
+        long long _a = (long long)(actual), _e = (long long)(expected);                                         \
+        if (_a != _e) {                                                                                         \
+            fprintf(stderr, "%s:%d: CHECK failed: %s == %lld, expected %lld\n", __FILE__, __LINE__, #actual, _a, \
+                    _e);                                                                                        \
+            host_test_failures++;                                                                               \
+        }                                                                                                       \
+    } while (0)
+
+static inline int host_test_result(const char* name) {
+    if (host_test_failures) {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, host_test_failures);
+        return 1;
+    }
+    printf("%s: passed\n", name);
+    return 0;
+}
+
+static inline uint64_t host_now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+}
+
+// Deterministic across platforms, unlike rand()
+static inline uint32_t host_rand(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
@@ -0,0 +1,300 @@
+// test_i2c_bus.c
+//
+// Runs the bus worker on a simulated transport that logs every transaction. To get requests queued behind each
+// other, the worker is first held inside a transfer to a "gate" device; the requests under test are submitted from
+// their own threads while it waits, then released together.
+
+#include <pthread.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_rtos.h"
+#include "host_test.h"
+#include "i2c_bus.h"
+
+#define SIM_MAX_TRANSACTIONS 64
+
+typedef struct {
+    uint16_t address;
+    uint8_t tx[32];
+    size_t tx_len;
+    esp_err_t result;
+} sim_transaction_t;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    uint16_t gate_address;
+    bool hold;
+    bool holding;
+    int timeouts_to_inject;
+    esp_err_t reset_result;
+    int resets;
+    sim_transaction_t log[SIM_MAX_TRANSACTIONS];
+    size_t count;
+} sim = {
+    .lock         = PTHREAD_MUTEX_INITIALIZER,
+    .changed      = PTHREAD_COND_INITIALIZER,
+    .reset_result = ESP_OK,
+};
+
+static esp_err_t _sim_transfer(void* ctx, i2c_bus_device_t* device, const uint8_t* tx, size_t tx_len, uint8_t* rx,
+                               size_t rx_len, uint32_t timeout_ms) {
+    (void)ctx;
+    (void)timeout_ms;
+    pthread_mutex_lock(&sim.lock);
+    esp_err_t result = ESP_OK;
+    if (sim.timeouts_to_inject > 0) {
+        sim.timeouts_to_inject--;
+        result = ESP_ERR_TIMEOUT;
+    }
+
+    if (sim.count < SIM_MAX_TRANSACTIONS) {
+        sim_transaction_t* t = &sim.log[sim.count++];
+        t->address           = device->address;
+        t->tx_len            = tx_len < sizeof(t->tx) ? tx_len : sizeof(t->tx);
+        t->result            = result;
+        memcpy(t->tx, tx, t->tx_len);
+    }
+    for (size_t i = 0; i < rx_len; i++) {
+        rx[i] = (uint8_t)(device->address + i);
+    }
+
+    if (device->address == sim.gate_address && sim.hold) {
+        sim.holding = true;
+        pthread_cond_broadcast(&sim.changed);
+        while (sim.hold) {
+            pthread_cond_wait(&sim.changed, &sim.lock);
+        }
+        sim.holding = false;
+    }
+    pthread_mutex_unlock(&sim.lock);
+    return result;
+}
+
+static esp_err_t _sim_reset(void* ctx) {
+    (void)ctx;
+    pthread_mutex_lock(&sim.lock);
+    sim.resets++;
+    esp_err_t result = sim.reset_result;
+    pthread_mutex_unlock(&sim.lock);
+    return result;
+}
+
+static const i2c_bus_transport_t sim_transport = {
+    .attach   = NULL,
+    .transfer = _sim_transfer,
+    .reset    = _sim_reset,
+    .ctx      = NULL,
+};
+
+typedef struct {
+    pthread_t thread;
+    i2c_bus_device_t* device;
+    uint8_t data[8];
+    size_t len;
+    i2c_bus_priority_t priority;
+    uint32_t deadline_ms;
+    esp_err_t result;
+} submission_t;
+
+static void* _submit_thread(void* arg) {
+    submission_t* s = (submission_t*)arg;
+    s->result       = i2c_bus_write(s->device, s->data, s->len, s->priority, s->deadline_ms);
+    return NULL;
+}
+
+// Starts a blocking write on its own thread and returns once it is in the bus queue
+static void submit(submission_t* s, i2c_bus_device_t* device, const char* data, i2c_bus_priority_t priority,
+                   uint32_t deadline_ms) {
+    memset(s, 0, sizeof(*s));
+    s->device      = device;
+    s->len         = strlen(data);
+    s->priority    = priority;
+    s->deadline_ms = deadline_ms;
+    memcpy(s->data, data, s->len);
+
+    uint32_t sends = host_rtos_queue_sends();
+    pthread_create(&s->thread, NULL, _submit_thread, s);
+    while (host_rtos_queue_sends() == sends) {
+        vTaskDelay(0);
+    }
+}
+
+static i2c_bus_device_t* gate;
+static submission_t gate_write;
+
+static void hold_worker(void) {
+    pthread_mutex_lock(&sim.lock);
+    sim.hold = true;
+    pthread_mutex_unlock(&sim.lock);
+
+    submit(&gate_write, gate, "g", I2C_BUS_PRIORITY_HIGH, 0);
+    pthread_mutex_lock(&sim.lock);
+    while (!sim.holding) {
+        pthread_cond_wait(&sim.changed, &sim.lock);
+    }
+    sim.count = 0;
+    pthread_mutex_unlock(&sim.lock);
+}
+
+static void release_worker(void) {
+    pthread_mutex_lock(&sim.lock);
+    sim.hold = false;
+    pthread_cond_broadcast(&sim.changed);
+    pthread_mutex_unlock(&sim.lock);
+    pthread_join(gate_write.thread, NULL);
+}
+
+static bool logged(size_t index, uint16_t address, const char* data) {
+    return index < sim.count && sim.log[index].address == address && sim.log[index].tx_len == strlen(data) &&
+           memcmp(sim.log[index].tx, data, strlen(data)) == 0;
+}
+
+static i2c_bus_device_t* add_device(const char* name, uint16_t address, uint32_t flags) {
+    i2c_bus_device_t* device = NULL;
+    CHECK(i2c_bus_add_device(name, address, 100000, flags, &device) == ESP_OK);
+    return device;
+}
+
+// High before normal before low, first come first served within a priority
+static void test_priority_order(void) {
+    i2c_bus_device_t* device = add_device("order", 0x21, 0);
+    submission_t s[4];
+
+    hold_worker();
+    submit(&s[0], device, "low", I2C_BUS_PRIORITY_LOW, 0);
+    submit(&s[1], device, "n1", I2C_BUS_PRIORITY_NORMAL, 0);
+    submit(&s[2], device, "high", I2C_BUS_PRIORITY_HIGH, 0);
+    submit(&s[3], device, "n2", I2C_BUS_PRIORITY_NORMAL, 0);
+    release_worker();
+    for (int i = 0; i < 4; i++) {
+        pthread_join(s[i].thread, NULL);
+        CHECK(s[i].result == ESP_OK);
+    }
+
+    CHECK_EQ_INT(sim.count, 4);
+    CHECK(logged(0, 0x21, "high"));
+    CHECK(logged(1, 0x21, "n1"));
+    CHECK(logged(2, 0x21, "n2"));
+    CHECK(logged(3, 0x21, "low"));
+}
+
+// Back-to-back writes to a stream device go out as one transaction; a read or another device ends the run
+static void test_stream_merge(void) {
+    i2c_bus_device_t* stream = add_device("stream", 0x27, I2C_BUS_DEVICE_FLAG_STREAM);
+    i2c_bus_device_t* other  = add_device("other", 0x22, 0);
+    submission_t s[5];
+
+    hold_worker();
+    submit(&s[0], stream, "ab", I2C_BUS_PRIORITY_NORMAL, 0);
+    submit(&s[1], stream, "cd", I2C_BUS_PRIORITY_NORMAL, 0);
+    submit(&s[2], stream, "ef", I2C_BUS_PRIORITY_NORMAL, 0);
+    submit(&s[3], other, "x", I2C_BUS_PRIORITY_NORMAL, 0);
+    submit(&s[4], stream, "gh", I2C_BUS_PRIORITY_NORMAL, 0);
+    release_worker();
+    for (int i = 0; i < 5; i++) {
+        pthread_join(s[i].thread, NULL);
+        CHECK(s[i].result == ESP_OK);
+    }
+
+    CHECK_EQ_INT(sim.count, 3);
+    CHECK(logged(0, 0x27, "abcdef"));
+    CHECK(logged(1, 0x22, "x"));
+    CHECK(logged(2, 0x27, "gh"));
+
+    i2c_bus_device_stats_t stats;
+    i2c_bus_get_device_stats(stream, &stats);
+    CHECK_EQ_INT(stats.merged, 2);
+    CHECK_EQ_INT(stats.transfers, 4);
+    CHECK_EQ_INT(stats.bytes, 8);
+}
+
+// A request whose deadline passes while it is queued is completed with a timeout and never reaches the bus
+static void test_expired_deadline(void) {
+    i2c_bus_device_t* device = add_device("deadline", 0x23, 0);
+    submission_t late, patient;
+
+    hold_worker();
+    submit(&late, device, "late", I2C_BUS_PRIORITY_NORMAL, 5);
+    submit(&patient, device, "ok", I2C_BUS_PRIORITY_NORMAL, 0);
+    vTaskDelay(pdMS_TO_TICKS(20));
+    release_worker();
+    pthread_join(late.thread, NULL);
+    pthread_join(patient.thread, NULL);
+
+    CHECK(late.result == ESP_ERR_TIMEOUT);
+    CHECK(patient.result == ESP_OK);
+    CHECK_EQ_INT(sim.count, 1);
+    CHECK(logged(0, 0x23, "ok"));
+
+    i2c_bus_device_stats_t stats;
+    i2c_bus_get_device_stats(device, &stats);
+    CHECK_EQ_INT(stats.deadline_misses, 1);
+    CHECK_EQ_INT(stats.errors, 1);
+    CHECK_EQ_INT(stats.transfers, 2);
+}
+
+// A timeout resets the bus; whole transactions are then retried once, stream writes are not
+static void test_reset_then_retry(void) {
+    i2c_bus_device_t* device = add_device("retry", 0x24, 0);
+    i2c_bus_device_t* stream = add_device("stream2", 0x25, I2C_BUS_DEVICE_FLAG_STREAM);
+    i2c_bus_stats_t before, after;
+    i2c_bus_get_stats(&before);
+
+    sim.count              = 0;
+    sim.resets             = 0;
+    sim.timeouts_to_inject = 1;
+    CHECK(i2c_bus_write(device, (const uint8_t*)"rt", 2, I2C_BUS_PRIORITY_NORMAL, 0) == ESP_OK);
+    CHECK_EQ_INT(sim.count, 2);
+    CHECK(logged(0, 0x24, "rt") && sim.log[0].result == ESP_ERR_TIMEOUT);
+    CHECK(logged(1, 0x24, "rt") && sim.log[1].result == ESP_OK);
+    CHECK_EQ_INT(sim.resets, 1);
+
+    i2c_bus_device_stats_t stats;
+    i2c_bus_get_device_stats(device, &stats);
+    CHECK_EQ_INT(stats.retries, 1);
+    CHECK_EQ_INT(stats.timeouts, 1);
+    CHECK_EQ_INT(stats.errors, 0);
+
+    sim.timeouts_to_inject = 1;
+    CHECK(i2c_bus_write(stream, (const uint8_t*)"st", 2, I2C_BUS_PRIORITY_NORMAL, 0) == ESP_ERR_TIMEOUT);
+    CHECK_EQ_INT(sim.count, 3);
+    CHECK_EQ_INT(sim.resets, 2);
+
+    // Both attempts time out and the resets themselves fail
+    sim.reset_result       = ESP_FAIL;
+    sim.timeouts_to_inject = 2;
+    CHECK(i2c_bus_write(device, (const uint8_t*)"rf", 2, I2C_BUS_PRIORITY_NORMAL, 0) == ESP_ERR_TIMEOUT);
+    sim.reset_result = ESP_OK;
+    CHECK_EQ_INT(sim.count, 5);
+
+    i2c_bus_get_stats(&after);
+    CHECK_EQ_INT(after.bus_resets - before.bus_resets, 2);
+    CHECK_EQ_INT(after.reset_failures - before.reset_failures, 2);
+    CHECK_EQ_INT(after.transactions - before.transactions, 5);
+}
+
+static void test_read(void) {
+    i2c_bus_device_t* device = add_device("read", 0x40, 0);
+    uint8_t reg              = 0x10;
+    uint8_t rx[3]            = {0};
+    CHECK(i2c_bus_transfer(device, &reg, 1, rx, sizeof(rx), I2C_BUS_PRIORITY_NORMAL, 0) == ESP_OK);
+    CHECK(rx[0] == 0x40 && rx[1] == 0x41 && rx[2] == 0x42);
+    CHECK(i2c_bus_transfer(device, NULL, 0, NULL, 0, I2C_BUS_PRIORITY_NORMAL, 0) == ESP_ERR_INVALID_ARG);
+}
+
+int main() {
+    i2c_bus_config_t config = I2C_BUS_DEFAULT_CONFIG();
+    config.transport        = &sim_transport;
+    CHECK(i2c_bus_init(&config) == ESP_OK);
+    sim.gate_address = 0x70;
+    gate             = add_device("gate", sim.gate_address, 0);
+
+    test_priority_order();
+    test_stream_merge();
+    test_expired_deadline();
+    test_reset_then_retry();
+    test_read();
+    return host_test_result("i2c_bus");
+}
@@ -0,0 +1,107 @@
+// bench_ir_corpus.c
+//
+// Decodes the committed frame corpus with ir_decode_frame under receiver error and reports, per condition, how many
+// real frames decode as recorded, how many are missed or decoded wrongly (false accepts), how much noise decodes,
+// and the decode cost per frame. Built once per timing tolerance; each build prints one row of the tuning table.
+// Only the default tolerance is held to its figures: every real frame decodes up to ±25% jitter, 99% at ±30%, no
+// condition produces a false accept, and the only noise that decodes is NEC repeat codes.
+
+#include <stdlib.h>
+#include "host_test.h"
+#include "ir_corpus.h"
+
+#define ROUNDS 20
+
+typedef struct {
+    const char* name;
+    int jitter_percent;
+    int mark_stretch_us;
+} condition_t;
+
+static const condition_t conditions[] = {
+    {"±20% jitter", 20, 0},
+    {"±25% jitter", 25, 0},
+    {"±30% jitter", 30, 0},
+    {"±10% + 150us mark stretch", 10, 150},
+};
+
+typedef struct {
+    uint32_t counts[IR_CORPUS_NOISE_ACCEPTED + 1];
+    // Noise accepted as a data frame rather than a repeat code, which only extends a key already held
+    uint32_t noise_data_frames;
+    uint64_t elapsed_ns;
+    uint32_t frames;
+} run_t;
+
+static run_t run(const ir_corpus_frame_t* corpus, size_t count, const condition_t* condition) {
+    run_t result                 = {0};
+    uint32_t rand_state          = 42;
+    ir_corpus_frame_t* distorted = malloc(count * sizeof(*distorted));
+    ir_decode_status_t* statuses = malloc(count * sizeof(*statuses));
+    ir_result_t* results         = malloc(count * sizeof(*results));
+
+    for (int round = 0; round < ROUNDS; round++) {
+        for (size_t i = 0; i < count; i++) {
+            ir_corpus_perturb(&corpus[i], &distorted[i], condition->jitter_percent, condition->mark_stretch_us,
+                              &rand_state);
+        }
+
+        uint64_t start = host_now_ns();
+        for (size_t i = 0; i < count; i++) {
+            statuses[i] = ir_decode_frame(distorted[i].durations, distorted[i].num_durations, &results[i]);
+        }
+        result.elapsed_ns += host_now_ns() - start;
+        result.frames += count;
+
+        for (size_t i = 0; i < count; i++) {
+            ir_corpus_outcome_t outcome = ir_corpus_classify(&corpus[i], statuses[i], &results[i]);
+            result.counts[outcome]++;
+            if (outcome == IR_CORPUS_NOISE_ACCEPTED && results[i].type != IR_FRAME_TYPE_REPEAT) {
+                result.noise_data_frames++;
+            }
+        }
+    }
+    free(distorted);
+    free(statuses);
+    free(results);
+    return result;
+}
+
+static double percent(uint32_t part, uint32_t whole) {
+    return whole ? 100.0 * part / whole : 0;
+}
+
+int main(int argc, char** argv) {
+    ir_corpus_frame_t* corpus;
+    size_t count = ir_corpus_load(argc > 1 ? argv[1] : "ir_corpus.txt", &corpus);
+    CHECK(count > 0);
+    if (count == 0) {
+        return host_test_result("ir_corpus");
+    }
+
+    bool is_default = NEC_TOLERANCE_PERCENT == 30;
+    printf("tolerance %d%%, %zu corpus frames x %d rounds\n", NEC_TOLERANCE_PERCENT, count, ROUNDS);
+    for (size_t c = 0; c < sizeof(conditions) / sizeof(conditions[0]); c++) {
+        run_t r        = run(corpus, count, &conditions[c]);
+        uint32_t real  = r.counts[IR_CORPUS_DECODED] + r.counts[IR_CORPUS_MISSED] + r.counts[IR_CORPUS_FALSE_ACCEPT];
+        uint32_t noise = r.counts[IR_CORPUS_NOISE_REJECTED] + r.counts[IR_CORPUS_NOISE_ACCEPTED];
+        double decoded = percent(r.counts[IR_CORPUS_DECODED], real);
+        printf("  %-26s decode %6.2f%%  miss %6.2f%%  false accept %6.2f%%  noise accepted %5.2f%%  %5.0f ns/frame\n",
+               conditions[c].name, decoded, percent(r.counts[IR_CORPUS_MISSED], real),
+               percent(r.counts[IR_CORPUS_FALSE_ACCEPT], real), percent(r.counts[IR_CORPUS_NOISE_ACCEPTED], noise),
+               (double)r.elapsed_ns / r.frames);
+
+        if (is_default) {
+            CHECK_EQ_INT(r.counts[IR_CORPUS_FALSE_ACCEPT], 0);
+            CHECK_EQ_INT(r.noise_data_frames, 0);
+            if (conditions[c].jitter_percent <= 25 && conditions[c].mark_stretch_us == 0) {
+                CHECK_EQ_INT(r.counts[IR_CORPUS_MISSED], 0);
+            } else if (conditions[c].jitter_percent == 30) {
+                CHECK(decoded >= 99.0);
+            }
+        }
+    }
+
+    free(corpus);
+    return host_test_result("ir_corpus");
+}
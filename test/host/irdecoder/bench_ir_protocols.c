@@ -0,0 +1,169 @@
+// bench_ir_protocols.c
+//
+// The corpus frames grouped by protocol: each group must decode completely, clean and with ±20% jitter, and its
+// decode rate through the full engine is reported in frames per second. SIRC has to cover 12, 15 and 20 bits and RC5
+// both plain and RC5X commands. Frames of each protocol damaged the way the engine has to catch (bad
+// checksum, SIRC of an unsupported length, an RC5 half-bit out of timing) must be rejected, and a glitch ahead of a
+// frame skipped.
+
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "ir_corpus.h"
+
+#define ROUNDS 200
+
+typedef struct {
+    const char* name;
+    ir_protocol_id_t protocol;
+    ir_frame_type_t type;
+} group_t;
+
+static const group_t groups[] = {
+    {"NEC", IR_PROTOCOL_NEC, IR_FRAME_TYPE_DATA},
+    {"NEC extended", IR_PROTOCOL_NEC_EXTENDED, IR_FRAME_TYPE_DATA},
+    {"Samsung", IR_PROTOCOL_SAMSUNG, IR_FRAME_TYPE_DATA},
+    {"Sony SIRC", IR_PROTOCOL_SONY_SIRC, IR_FRAME_TYPE_DATA},
+    {"RC5", IR_PROTOCOL_RC5, IR_FRAME_TYPE_DATA},
+    {"NEC repeat", IR_PROTOCOL_NEC, IR_FRAME_TYPE_REPEAT},
+};
+
+static size_t select_group(const ir_corpus_frame_t* corpus, size_t count, const group_t* group,
+                           ir_corpus_frame_t* frames) {
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (corpus[i].expected.protocol == group->protocol && corpus[i].expected.type == group->type) {
+            frames[n++] = corpus[i];
+        }
+    }
+    return n;
+}
+
+static uint32_t count_decoded(const ir_corpus_frame_t* frames, size_t n, int jitter_percent) {
+    uint32_t rand_state = 3, decoded = 0;
+    for (size_t i = 0; i < n; i++) {
+        ir_corpus_frame_t frame;
+        ir_result_t result;
+        ir_corpus_perturb(&frames[i], &frame, jitter_percent, 0, &rand_state);
+        ir_decode_status_t status = ir_decode_frame(frame.durations, frame.num_durations, &result);
+        decoded += ir_corpus_classify(&frame, status, &result) == IR_CORPUS_DECODED;
+    }
+    return decoded;
+}
+
+static double frames_per_s(const ir_corpus_frame_t* frames, size_t n) {
+    ir_result_t result;
+    uint32_t decoded = 0;
+    uint64_t start   = host_now_ns();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (size_t i = 0; i < n; i++) {
+            decoded += ir_decode_frame(frames[i].durations, frames[i].num_durations, &result) == IR_DECODE_OK;
+        }
+    }
+    uint64_t elapsed = host_now_ns() - start;
+    CHECK_EQ_INT(decoded, ROUNDS * n);
+    return elapsed ? ROUNDS * n * 1e9 / elapsed : 0;
+}
+
+// SIRC is the only protocol whose length varies; its durations are the header then one space and mark per bit
+static void check_coverage(const group_t* group, const ir_corpus_frame_t* frames, size_t n) {
+    if (group->protocol == IR_PROTOCOL_SONY_SIRC) {
+        bool lengths[21] = {false};
+        for (size_t i = 0; i < n; i++) {
+            lengths[(frames[i].num_durations - 1) / 2] = true;
+        }
+        CHECK(lengths[12] && lengths[15] && lengths[20]);
+    } else if (group->protocol == IR_PROTOCOL_RC5) {
+        bool rc5x = false, rc5 = false;
+        for (size_t i = 0; i < n; i++) {
+            rc5x |= frames[i].expected.command >= 0x40;
+            rc5 |= frames[i].expected.command < 0x40;
+        }
+        CHECK(rc5 && rc5x);
+    }
+}
+
+static ir_decode_status_t decode(const ir_corpus_frame_t* frame, ir_result_t* result) {
+    return ir_decode_frame(frame->durations, frame->num_durations, result);
+}
+
+static void check_glitch_skipped(const ir_corpus_frame_t* original) {
+    ir_corpus_frame_t frame = *original;
+    memmove(&frame.durations[2], &frame.durations[0], frame.num_durations * sizeof(uint16_t));
+    frame.durations[0] = 300;
+    frame.durations[1] = 700;
+    frame.num_durations += 2;
+
+    ir_result_t result;
+    ir_decode_status_t status = decode(&frame, &result);
+    CHECK(ir_corpus_classify(&frame, status, &result) == IR_CORPUS_DECODED);
+}
+
+static void test_rejections(const ir_corpus_frame_t* corpus, size_t count) {
+    const ir_corpus_frame_t *samsung = NULL, *sirc15 = NULL, *rc5 = NULL;
+    for (size_t i = 0; i < count; i++) {
+        const ir_corpus_frame_t* frame = &corpus[i];
+        if (!samsung && frame->expected.protocol == IR_PROTOCOL_SAMSUNG) {
+            samsung = frame;
+        } else if (!sirc15 && frame->expected.protocol == IR_PROTOCOL_SONY_SIRC && frame->num_durations == 31) {
+            sirc15 = frame;
+        } else if (!rc5 && frame->expected.protocol == IR_PROTOCOL_RC5) {
+            rc5 = frame;
+        }
+    }
+    CHECK(samsung && sirc15 && rc5);
+    if (!samsung || !sirc15 || !rc5) {
+        return;
+    }
+
+    ir_result_t result;
+    ir_corpus_frame_t frame;
+
+    // The two address bytes of Samsung must match
+    frame              = *samsung;
+    frame.durations[3] = frame.durations[3] > 1000 ? 560 : 1690;
+    CHECK_EQ_INT(decode(&frame, &result), IR_DECODE_CHECKSUM);
+
+    // 13 bits is no SIRC length
+    frame               = *sirc15;
+    frame.num_durations = 1 + 2 * 13;
+    CHECK_EQ_INT(decode(&frame, &result), IR_DECODE_TRUNCATED);
+
+    // Three half-bits in one level is not Manchester
+    frame              = *rc5;
+    frame.durations[2] = 3 * 889;
+    CHECK(decode(&frame, &result) != IR_DECODE_OK);
+
+    check_glitch_skipped(samsung);
+    check_glitch_skipped(sirc15);
+    check_glitch_skipped(rc5);
+}
+
+int main(int argc, char** argv) {
+    ir_corpus_frame_t* corpus;
+    size_t count = ir_corpus_load(argc > 1 ? argv[1] : "ir_corpus.txt", &corpus);
+    CHECK(count > 0);
+    if (count == 0) {
+        return host_test_result("ir_protocols");
+    }
+
+    ir_corpus_frame_t* frames = malloc(count * sizeof(*frames));
+    printf("%-13s %6s %8s %8s %12s\n", "protocol", "frames", "clean", "±20%", "frames/s");
+    for (size_t g = 0; g < sizeof(groups) / sizeof(groups[0]); g++) {
+        size_t n = select_group(corpus, count, &groups[g], frames);
+        CHECK(n > 0);
+        check_coverage(&groups[g], frames, n);
+
+        uint32_t clean    = count_decoded(frames, n, 0);
+        uint32_t jittered = count_decoded(frames, n, 20);
+        double rate       = frames_per_s(frames, n);
+        printf("%-13s %6zu %8u %8u %11.2fM\n", groups[g].name, n, clean, jittered, rate / 1e6);
+        CHECK_EQ_INT(clean, n);
+        CHECK_EQ_INT(jittered, n);
+    }
+    test_rejections(corpus, count);
+
+    free(frames);
+    free(corpus);
+    return host_test_result("ir_protocols");
+}
@@ -0,0 +1,226 @@
+// bench_ir_stream.c
+//
+// Builds a noisy capture set from the frame corpus and decodes it two ways: each capture on its own with
+// ir_decode_frame, and streamed edge by edge through one engine the way the decoder task drains the edge ring
+// (ir_engine_feed per edge, ir_engine_finish on the end-of-capture marker, a reset after a decoded frame). Both must
+// agree on every capture and match what the capture should give. On top of ±25% jitter on everything, NEC-family
+// frames are also added corrupted (a bit space no protocol accepts), truncated mid-frame, and behind a leading
+// glitch; the first two must be rejected and the glitch skipped.
+
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "ir_corpus.h"
+
+#define ROUNDS          10
+#define JITTER_PERCENT  25
+// Between the Samsung and NEC header marks, outside every bit and header window at the default tolerance
+#define CORRUPT_US      6000
+#define GLITCH_MARK_US  300
+#define GLITCH_SPACE_US 700
+
+typedef enum {
+    VARIANT_JITTER,
+    VARIANT_CORRUPTED,
+    VARIANT_TRUNCATED,
+    VARIANT_GLITCH,
+    VARIANT_MAX,
+} variant_t;
+
+static const char* const variant_names[VARIANT_MAX] = {"jittered", "corrupted", "truncated", "leading glitch"};
+
+typedef struct {
+    ir_corpus_frame_t frame;
+    variant_t variant;
+} capture_t;
+
+// One entry of the edge ring as the task sees it
+typedef struct {
+    uint16_t duration_us;
+    uint8_t mark;
+    uint8_t end_of_capture;
+} edge_t;
+
+static bool nec_family(const ir_corpus_frame_t* frame) {
+    return frame->expected.type == IR_FRAME_TYPE_DATA &&
+           (frame->expected.protocol == IR_PROTOCOL_NEC || frame->expected.protocol == IR_PROTOCOL_NEC_EXTENDED ||
+            frame->expected.protocol == IR_PROTOCOL_SAMSUNG);
+}
+
+// Durations 2 + 2k and 3 + 2k are the mark and space of bit k; a damaged frame is expected to be rejected
+static void damage(ir_corpus_frame_t* frame, variant_t variant, uint32_t* rand_state) {
+    uint32_t bit = host_rand(rand_state) % 32;
+    switch (variant) {
+    case VARIANT_CORRUPTED:
+        frame->durations[3 + 2 * bit] = CORRUPT_US;
+        frame->expected.type          = IR_FRAME_TYPE_INVALID;
+        break;
+    case VARIANT_TRUNCATED:
+        frame->num_durations = 2 + 2 * bit + 1;
+        frame->expected.type = IR_FRAME_TYPE_INVALID;
+        break;
+    case VARIANT_GLITCH:
+        memmove(&frame->durations[2], &frame->durations[0], frame->num_durations * sizeof(uint16_t));
+        frame->durations[0] = GLITCH_MARK_US;
+        frame->durations[1] = GLITCH_SPACE_US;
+        frame->num_durations += 2;
+        break;
+    default:
+        break;
+    }
+}
+
+static size_t build_captures(const ir_corpus_frame_t* corpus, size_t count, capture_t** captures) {
+    uint32_t rand_state = 16;
+    size_t num_captures = 0;
+    *captures           = malloc(ROUNDS * count * VARIANT_MAX * sizeof(**captures));
+
+    for (int round = 0; round < ROUNDS; round++) {
+        for (size_t i = 0; i < count; i++) {
+            for (int v = 0; v < (nec_family(&corpus[i]) ? VARIANT_MAX : 1); v++) {
+                capture_t* capture = &(*captures)[num_captures++];
+                capture->variant   = (variant_t)v;
+                ir_corpus_perturb(&corpus[i], &capture->frame, JITTER_PERCENT, 0, &rand_state);
+                damage(&capture->frame, capture->variant, &rand_state);
+            }
+        }
+    }
+    return num_captures;
+}
+
+static size_t build_edges(const capture_t* captures, size_t num_captures, edge_t** edges) {
+    size_t num_edges = 0;
+    for (size_t i = 0; i < num_captures; i++) {
+        num_edges += captures[i].frame.num_durations + 1;
+    }
+    *edges = malloc(num_edges * sizeof(**edges));
+
+    edge_t* edge = *edges;
+    for (size_t i = 0; i < num_captures; i++) {
+        for (size_t d = 0; d < captures[i].frame.num_durations; d++) {
+            *edge++ = (edge_t){.duration_us = captures[i].frame.durations[d], .mark = d % 2 == 0, .end_of_capture = 0};
+        }
+        *edge++ = (edge_t){.duration_us = 0, .mark = 0, .end_of_capture = 1};
+    }
+    return num_edges;
+}
+
+typedef struct {
+    ir_decode_status_t status;
+    ir_result_t result;
+    // Edges of the capture still to come when the frame decoded, the stop mark for a streamed NEC frame
+    uint32_t edges_early;
+} outcome_t;
+
+static uint64_t decode_batch(const capture_t* captures, size_t num_captures, outcome_t* outcomes) {
+    uint64_t start = host_now_ns();
+    for (size_t i = 0; i < num_captures; i++) {
+        outcomes[i].status = ir_decode_frame(captures[i].frame.durations, captures[i].frame.num_durations,
+                                             &outcomes[i].result);
+    }
+    return host_now_ns() - start;
+}
+
+// The loop of IRDecoder::decoder_task_loop without the logging and event publishing
+static uint64_t decode_stream(const edge_t* edges, size_t num_edges, outcome_t* outcomes) {
+    ir_engine_t engine;
+    ir_engine_reset(&engine);
+    bool frame_decoded = false;
+    size_t capture     = 0;
+    uint32_t remaining = 0;
+
+    uint64_t start = host_now_ns();
+    for (size_t i = 0; i < num_edges; i++) {
+        const edge_t* edge        = &edges[i];
+        ir_result_t frame         = {0};
+        ir_decode_status_t status = IR_DECODE_IN_PROGRESS;
+
+        if (!edge->end_of_capture) {
+            status = ir_engine_feed(&engine, edge->mark, edge->duration_us, &frame);
+            remaining++;
+        } else if (frame_decoded) {
+            ir_engine_reset(&engine);
+        } else {
+            status = ir_engine_finish(&engine, &frame);
+            outcomes[capture].status = status;
+            outcomes[capture].result = frame;
+        }
+
+        if (status == IR_DECODE_OK && !frame_decoded) {
+            outcomes[capture].status = IR_DECODE_OK;
+            outcomes[capture].result = frame;
+            frame_decoded            = true;
+            remaining                = 0;
+        }
+        if (edge->end_of_capture) {
+            outcomes[capture].edges_early = frame_decoded ? remaining : 0;
+            frame_decoded                 = false;
+            remaining                     = 0;
+            capture++;
+        }
+    }
+    return host_now_ns() - start;
+}
+
+int main(int argc, char** argv) {
+    ir_corpus_frame_t* corpus;
+    size_t count = ir_corpus_load(argc > 1 ? argv[1] : "ir_corpus.txt", &corpus);
+    CHECK(count > 0);
+    if (count == 0) {
+        return host_test_result("ir_stream");
+    }
+
+    capture_t* captures;
+    edge_t* edges;
+    size_t num_captures = build_captures(corpus, count, &captures);
+    size_t num_edges    = build_edges(captures, num_captures, &edges);
+    outcome_t* batch    = calloc(num_captures, sizeof(*batch));
+    outcome_t* stream   = calloc(num_captures, sizeof(*stream));
+
+    uint64_t batch_ns  = decode_batch(captures, num_captures, batch);
+    uint64_t stream_ns = decode_stream(edges, num_edges, stream);
+    printf("%zu captures, %zu edges, ±%d%% jitter: batch %.0f ns/capture, streaming %.0f ns/capture\n", num_captures,
+           num_edges, JITTER_PERCENT, (double)batch_ns / num_captures, (double)stream_ns / num_captures);
+
+    uint32_t outcomes[VARIANT_MAX][IR_CORPUS_NOISE_ACCEPTED + 1] = {{0}};
+    uint32_t disagreements = 0, nec_frames = 0, nec_edges_early = 0;
+    for (size_t i = 0; i < num_captures; i++) {
+        const outcome_t* b = &batch[i];
+        const outcome_t* s = &stream[i];
+        if (b->status != s->status ||
+            (b->status == IR_DECODE_OK && memcmp(&b->result, &s->result, sizeof(b->result)) != 0)) {
+            disagreements++;
+        }
+        outcomes[captures[i].variant][ir_corpus_classify(&captures[i].frame, s->status, &s->result)]++;
+        if (s->status == IR_DECODE_OK && s->result.type == IR_FRAME_TYPE_DATA &&
+            s->result.protocol == IR_PROTOCOL_NEC) {
+            nec_frames++;
+            nec_edges_early += s->edges_early;
+        }
+    }
+
+    for (int v = 0; v < VARIANT_MAX; v++) {
+        const uint32_t* o = outcomes[v];
+        printf("  %-15s decoded %5u  missed %3u  wrong %3u  rejected %5u  accepted %3u\n", variant_names[v],
+               o[IR_CORPUS_DECODED], o[IR_CORPUS_MISSED], o[IR_CORPUS_FALSE_ACCEPT], o[IR_CORPUS_NOISE_REJECTED],
+               o[IR_CORPUS_NOISE_ACCEPTED]);
+        CHECK_EQ_INT(o[IR_CORPUS_MISSED], 0);
+        CHECK_EQ_INT(o[IR_CORPUS_FALSE_ACCEPT], 0);
+    }
+    printf("  batch and streaming disagree on %u captures; streamed NEC frames decode %.1f edges before the end\n",
+           disagreements, nec_frames ? (double)nec_edges_early / nec_frames : 0.0);
+
+    CHECK_EQ_INT(disagreements, 0);
+    CHECK_EQ_INT(outcomes[VARIANT_CORRUPTED][IR_CORPUS_NOISE_ACCEPTED], 0);
+    CHECK_EQ_INT(outcomes[VARIANT_TRUNCATED][IR_CORPUS_NOISE_ACCEPTED], 0);
+    CHECK(outcomes[VARIANT_GLITCH][IR_CORPUS_DECODED] > 0);
+    // Only the stop mark follows the 32nd bit's space
+    CHECK(nec_frames > 0 && nec_edges_early == nec_frames);
+
+    free(stream);
+    free(batch);
+    free(edges);
+    free(captures);
+    free(corpus);
+    return host_test_result("ir_stream");
+}
@@ -0,0 +1,130 @@
+// ir_corpus.c
+
+#include "ir_corpus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+
+static bool _parse_protocol(const char* name, ir_protocol_id_t* protocol) {
+    for (int p = 0; p < IR_PROTOCOL_MAX; p++) {
+        if (strcmp(ir_protocol_name((ir_protocol_id_t)p), name) == 0) {
+            *protocol = (ir_protocol_id_t)p;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool _parse_type(const char* name, ir_frame_type_t* type) {
+    for (int t = IR_FRAME_TYPE_DATA; t <= IR_FRAME_TYPE_INVALID; t++) {
+        if (strcmp(ir_frame_type_name((ir_frame_type_t)t), name) == 0) {
+            *type = (ir_frame_type_t)t;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool _parse_line(char* line, ir_corpus_frame_t* frame) {
+    char* fields[5];
+    char* cursor = line;
+    for (int i = 0; i < 4; i++) {
+        fields[i] = cursor;
+        cursor    = strchr(cursor, ',');
+        if (!cursor) {
+            return false;
+        }
+        *cursor++ = '\0';
+    }
+    fields[4] = cursor;
+
+    memset(frame, 0, sizeof(*frame));
+    if (!_parse_protocol(fields[0], &frame->expected.protocol) || !_parse_type(fields[1], &frame->expected.type)) {
+        return false;
+    }
+    frame->expected.address = (uint16_t)strtoul(fields[2], NULL, 16);
+    frame->expected.command = (uint8_t)strtoul(fields[3], NULL, 16);
+
+    char* end;
+    for (char* p = fields[4]; frame->num_durations < IR_CORPUS_MAX_DURATIONS; p = end) {
+        unsigned long duration = strtoul(p, &end, 10);
+        if (end == p) {
+            break;
+        }
+        frame->durations[frame->num_durations++] = (uint16_t)duration;
+    }
+    return frame->num_durations > 0;
+}
+
+size_t ir_corpus_load(const char* path, ir_corpus_frame_t** frames) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "cannot open corpus %s\n", path);
+        return 0;
+    }
+
+    size_t count = 0, capacity = 1024;
+    ir_corpus_frame_t* loaded = malloc(capacity * sizeof(*loaded));
+    char line[4096];
+    bool header = false;
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (strcmp(line, IR_CORPUS_HEADER) == 0) {
+            header = true;
+        }
+        if (line[0] == '#' || line[0] == '\0') {
+            continue;
+        }
+        if (count == capacity) {
+            capacity *= 2;
+            loaded = realloc(loaded, capacity * sizeof(*loaded));
+        }
+        if (!_parse_line(line, &loaded[count])) {
+            fprintf(stderr, "%s: malformed frame %zu\n", path, count + 1);
+            count = 0;
+            break;
+        }
+        count++;
+    }
+    fclose(file);
+
+    if (!header || count == 0) {
+        free(loaded);
+        *frames = NULL;
+        return 0;
+    }
+    *frames = loaded;
+    return count;
+}
+
+void ir_corpus_perturb(const ir_corpus_frame_t* in, ir_corpus_frame_t* out, int jitter_percent, int mark_stretch_us,
+                       uint32_t* rand_state) {
+    *out = *in;
+    for (size_t i = 0; i < in->num_durations; i++) {
+        int value   = in->durations[i];
+        int spread  = value * jitter_percent / 100;
+        int jitter  = spread ? (int)(host_rand(rand_state) % (uint32_t)(2 * spread + 1)) - spread : 0;
+        int stretch = i % 2 == 0 ? mark_stretch_us : -mark_stretch_us;
+        int result  = value + jitter + stretch;
+
+        out->durations[i] = (uint16_t)(result < 1 ? 1 : result > UINT16_MAX ? UINT16_MAX : result);
+    }
+}
+
+ir_corpus_outcome_t ir_corpus_classify(const ir_corpus_frame_t* frame, ir_decode_status_t status,
+                                       const ir_result_t* result) {
+    const ir_result_t* expected = &frame->expected;
+    if (expected->type == IR_FRAME_TYPE_INVALID) {
+        return status == IR_DECODE_OK ? IR_CORPUS_NOISE_ACCEPTED : IR_CORPUS_NOISE_REJECTED;
+    }
+    if (status != IR_DECODE_OK) {
+        return IR_CORPUS_MISSED;
+    }
+
+    bool same = result->type == expected->type && result->protocol == expected->protocol;
+    if (same && expected->type == IR_FRAME_TYPE_DATA) {
+        same = result->address == expected->address && result->command == expected->command;
+    }
+    return same ? IR_CORPUS_DECODED : IR_CORPUS_FALSE_ACCEPT;
+}
@@ -0,0 +1,45 @@
+// ir_corpus.h
+//
+// Loads the frame corpus (IR_CORPUS_HEADER format) for the decoder tests and benchmarks, and distorts frames the
+// way a receiver does: random jitter on every duration and a demodulator that stretches marks at the expense of
+// the following spaces.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ir_decode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IR_CORPUS_MAX_DURATIONS 140
+
+typedef struct {
+    uint16_t durations[IR_CORPUS_MAX_DURATIONS];
+    size_t num_durations;
+    ir_result_t expected;
+} ir_corpus_frame_t;
+
+typedef enum {
+    IR_CORPUS_DECODED,          // Real frame, decoded as recorded
+    IR_CORPUS_MISSED,           // Real frame, rejected
+    IR_CORPUS_FALSE_ACCEPT,     // Real frame, decoded to the wrong protocol, address or command
+    IR_CORPUS_NOISE_REJECTED,
+    IR_CORPUS_NOISE_ACCEPTED,
+} ir_corpus_outcome_t;
+
+// Returns the number of frames loaded into a malloc'd array, or 0 if the file is missing or malformed
+size_t ir_corpus_load(const char* path, ir_corpus_frame_t** frames);
+
+// Each duration moves by up to ±jitter_percent; marks grow by mark_stretch_us and spaces shrink by as much
+void ir_corpus_perturb(const ir_corpus_frame_t* in, ir_corpus_frame_t* out, int jitter_percent, int mark_stretch_us,
+                       uint32_t* rand_state);
+
+ir_corpus_outcome_t ir_corpus_classify(const ir_corpus_frame_t* frame, ir_decode_status_t status,
+                                       const ir_result_t* result);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,182 @@
+// ir_corpus_gen.c
+//
+// Writes the synthesized frame corpus committed as components/irdecoder/ir_corpus.txt:
+//   ir_corpus_gen <path> [frames per kind]
+// Every round adds one frame of each kind with random fields: NEC, extended NEC, Samsung, SIRC (12, 15 and 20 bits
+// in turn), RC5 with alternating toggle, an NEC repeat and a burst of random noise that must not decode. Durations
+// are the nominal protocol timings; the benchmarks add the receiver error themselves.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "ir_corpus.h"
+
+#define NEC_MARK        560
+#define NEC_ZERO        560
+#define NEC_ONE         1690
+#define SIRC_HEADER     2400
+#define SIRC_SPACE      600
+#define SIRC_ZERO       600
+#define SIRC_ONE        1200
+#define RC5_HALF_BIT    889
+#define RC5_BITS        14
+
+static uint32_t seed = 1;
+
+static void put(ir_corpus_frame_t* frame, uint32_t duration) {
+    frame->durations[frame->num_durations++] = (uint16_t)duration;
+}
+
+static ir_corpus_frame_t expect(ir_protocol_id_t protocol, ir_frame_type_t type, uint16_t address, uint8_t command) {
+    ir_corpus_frame_t frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.expected.protocol = protocol;
+    frame.expected.type     = type;
+    frame.expected.address  = address;
+    frame.expected.command  = command;
+    return frame;
+}
+
+// Header, 32 bits most significant first, stop mark
+static void pulse_distance(ir_corpus_frame_t* frame, uint32_t header_mark, uint32_t header_space, uint32_t bits) {
+    put(frame, header_mark);
+    put(frame, header_space);
+    for (int i = 31; i >= 0; i--) {
+        put(frame, NEC_MARK);
+        put(frame, (bits >> i) & 1 ? NEC_ONE : NEC_ZERO);
+    }
+    put(frame, NEC_MARK);
+}
+
+static ir_corpus_frame_t nec(uint8_t address, uint8_t command) {
+    ir_corpus_frame_t frame = expect(IR_PROTOCOL_NEC, IR_FRAME_TYPE_DATA, address, command);
+    pulse_distance(&frame, 9000, 4500,
+                   (uint32_t)address << 24 | (uint32_t)(uint8_t)~address << 16 | command << 8 | (uint8_t)~command);
+    return frame;
+}
+
+static ir_corpus_frame_t nec_extended(uint16_t address, uint8_t command) {
+    ir_corpus_frame_t frame = expect(IR_PROTOCOL_NEC_EXTENDED, IR_FRAME_TYPE_DATA, address, command);
+    pulse_distance(&frame, 9000, 4500, (uint32_t)address << 16 | command << 8 | (uint8_t)~command);
+    return frame;
+}
+
+static ir_corpus_frame_t samsung(uint8_t address, uint8_t command) {
+    ir_corpus_frame_t frame = expect(IR_PROTOCOL_SAMSUNG, IR_FRAME_TYPE_DATA, address, command);
+    pulse_distance(&frame, 4500, 4500, (uint32_t)address << 24 | (uint32_t)address << 16 | command << 8 | (uint8_t)~command);
+    return frame;
+}
+
+static ir_corpus_frame_t nec_repeat(void) {
+    ir_corpus_frame_t frame = expect(IR_PROTOCOL_NEC, IR_FRAME_TYPE_REPEAT, 0, 0);
+    put(&frame, 9000);
+    put(&frame, 2250);
+    put(&frame, NEC_MARK);
+    return frame;
+}
+
+// 7 command bits then the address, least significant first, each bit a mark after a fixed space
+static ir_corpus_frame_t sirc(int num_bits, uint16_t address, uint8_t command) {
+    ir_corpus_frame_t frame = expect(IR_PROTOCOL_SONY_SIRC, IR_FRAME_TYPE_DATA, address, command);
+    uint32_t fields         = command | (uint32_t)address << 7;
+    put(&frame, SIRC_HEADER);
+    for (int i = 0; i < num_bits; i++) {
+        put(&frame, SIRC_SPACE);
+        put(&frame, (fields >> i) & 1 ? SIRC_ONE : SIRC_ZERO);
+    }
+    return frame;
+}
+
+// A one is a space half then a mark half; the leading and trailing space halves merge with the idle line
+static ir_corpus_frame_t rc5(bool toggle, uint8_t address, uint8_t command) {
+    ir_corpus_frame_t frame = expect(IR_PROTOCOL_RC5, IR_FRAME_TYPE_DATA, address, command);
+    int bits[RC5_BITS]      = {1, !(command & 0x40), toggle};
+    for (int i = 0; i < 5; i++) {
+        bits[3 + i] = (address >> (4 - i)) & 1;
+    }
+    for (int i = 0; i < 6; i++) {
+        bits[8 + i] = (command >> (5 - i)) & 1;
+    }
+
+    int halves[2 * RC5_BITS];
+    for (int i = 0; i < RC5_BITS; i++) {
+        halves[2 * i]     = !bits[i];
+        halves[2 * i + 1] = bits[i];
+    }
+    int first = 0, last = 2 * RC5_BITS - 1;
+    while (!halves[first]) {
+        first++;
+    }
+    while (!halves[last]) {
+        last--;
+    }
+    for (int i = first; i <= last;) {
+        int level = halves[i], units = 0;
+        for (; i <= last && halves[i] == level; i++) {
+            units++;
+        }
+        put(&frame, units * RC5_HALF_BIT);
+    }
+    return frame;
+}
+
+// An odd number of durations, so it starts and ends with a mark like a capture
+static ir_corpus_frame_t noise(void) {
+    ir_corpus_frame_t frame = expect(IR_PROTOCOL_NONE, IR_FRAME_TYPE_INVALID, 0, 0);
+    int count               = 1 + host_rand(&seed) % 69;
+    count |= 1;
+    for (int i = 0; i < count; i++) {
+        put(&frame, 200 + host_rand(&seed) % 9800);
+    }
+    return frame;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <corpus> [frames per kind]\n", argv[0]);
+        return 2;
+    }
+    int rounds = argc > 2 ? atoi(argv[2]) : 300;
+    FILE* file = fopen(argv[1], "w");
+    if (!file) {
+        fprintf(stderr, "cannot write %s\n", argv[1]);
+        return 1;
+    }
+
+    fprintf(file, "%s\n", IR_CORPUS_HEADER);
+    fprintf(file, "# Synthesized by test/host/irdecoder/ir_corpus_gen.c: nominal timings, %d frames per kind\n", rounds);
+
+    static const int sirc_bits[] = {12, 15, 20};
+    char line[2048];
+    for (int i = 0; i < rounds; i++) {
+        // Fields are drawn one statement at a time, the order of calls inside an initializer is unspecified
+        ir_corpus_frame_t frames[7];
+        uint16_t address = host_rand(&seed) & 0xFF;
+        frames[0]        = nec(address, host_rand(&seed));
+
+        // An extended address whose bytes are complements would be read as standard NEC
+        uint16_t extended = 0x1200 | (host_rand(&seed) & 0xFF);
+        extended          = (extended & 0xFF) == 0xED ? extended ^ 1 : extended;
+        frames[1]         = nec_extended(extended, host_rand(&seed));
+
+        address   = host_rand(&seed) & 0xFF;
+        frames[2] = samsung(address, host_rand(&seed));
+
+        int bits  = sirc_bits[i % 3];
+        address   = host_rand(&seed) & ((1 << (bits - 7)) - 1);
+        frames[3] = sirc(bits, address, host_rand(&seed) & 0x7F);
+
+        address   = host_rand(&seed) & 0x1F;
+        frames[4] = rc5(i & 1, address, host_rand(&seed) & 0x7F);
+        frames[5] = nec_repeat();
+        frames[6] = noise();
+
+        for (size_t k = 0; k < sizeof(frames) / sizeof(frames[0]); k++) {
+            ir_corpus_format_line(&frames[k].expected, frames[k].durations, frames[k].num_durations, line, sizeof(line));
+            fprintf(file, "%s\n", line);
+        }
+    }
+    fclose(file);
+    return 0;
+}
@@ -0,0 +1,135 @@
+// test_ir_decode.c
+//
+// ir_decode_frame over the frame corpus: every frame decodes as recorded, clean and with ±20% receiver jitter, and
+// noise only ever decodes as an NEC repeat code. Then NEC frames from the corpus are damaged in the ways a capture
+// goes wrong (bad checksum, cut short, a bit out of timing, a glitch ahead of the header) and must be rejected with
+// the matching status or, for the glitch, still decode.
+
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "ir_corpus.h"
+
+#define NEC_STOP_MARK 1
+
+static void decode_corpus(const ir_corpus_frame_t* corpus, size_t count, int jitter_percent) {
+    uint32_t rand_state = 7;
+    uint32_t outcomes[IR_CORPUS_NOISE_ACCEPTED + 1] = {0};
+
+    for (size_t i = 0; i < count; i++) {
+        ir_corpus_frame_t frame;
+        ir_corpus_perturb(&corpus[i], &frame, jitter_percent, 0, &rand_state);
+
+        ir_result_t result;
+        ir_decode_status_t status   = ir_decode_frame(frame.durations, frame.num_durations, &result);
+        ir_corpus_outcome_t outcome = ir_corpus_classify(&frame, status, &result);
+        outcomes[outcome]++;
+        if (outcome == IR_CORPUS_MISSED || outcome == IR_CORPUS_FALSE_ACCEPT) {
+            fprintf(stderr, "frame %zu (%s %s 0x%04X 0x%02X, ±%d%%): %s, got %s 0x%04X 0x%02X\n", i + 1,
+                    ir_protocol_name(frame.expected.protocol), ir_frame_type_name(frame.expected.type),
+                    frame.expected.address, frame.expected.command, jitter_percent, ir_decode_status_name(status),
+                    ir_protocol_name(result.protocol), result.address, result.command);
+        }
+        if (outcome == IR_CORPUS_NOISE_ACCEPTED) {
+            CHECK(result.type == IR_FRAME_TYPE_REPEAT);
+        }
+    }
+
+    printf("±%d%% jitter: %u decoded, %u missed, %u wrong, %u of %u noise frames read as repeats\n", jitter_percent,
+           outcomes[IR_CORPUS_DECODED], outcomes[IR_CORPUS_MISSED], outcomes[IR_CORPUS_FALSE_ACCEPT],
+           outcomes[IR_CORPUS_NOISE_ACCEPTED], outcomes[IR_CORPUS_NOISE_ACCEPTED] + outcomes[IR_CORPUS_NOISE_REJECTED]);
+    CHECK_EQ_INT(outcomes[IR_CORPUS_MISSED], 0);
+    CHECK_EQ_INT(outcomes[IR_CORPUS_FALSE_ACCEPT], 0);
+}
+
+static const ir_corpus_frame_t* first_of(const ir_corpus_frame_t* corpus, size_t count, ir_protocol_id_t protocol,
+                                         ir_frame_type_t type) {
+    for (size_t i = 0; i < count; i++) {
+        if (corpus[i].expected.protocol == protocol && corpus[i].expected.type == type) {
+            return &corpus[i];
+        }
+    }
+    return NULL;
+}
+
+static ir_decode_status_t decode(const ir_corpus_frame_t* frame, ir_result_t* result) {
+    return ir_decode_frame(frame->durations, frame->num_durations, result);
+}
+
+// Durations 2 + 2k and 3 + 2k are the mark and space of bit k
+static void test_damaged_nec(const ir_corpus_frame_t* nec) {
+    ir_result_t result;
+    ir_corpus_frame_t frame;
+
+    frame = *nec;
+    CHECK(decode(&frame, &result) == IR_DECODE_OK);
+    CHECK(result.protocol == IR_PROTOCOL_NEC && result.type == IR_FRAME_TYPE_DATA);
+
+    // Flipping a command bit breaks the inverted-command check of every NEC-family protocol
+    size_t command_bit           = 3 + 2 * 16;
+    frame.durations[command_bit] = frame.durations[command_bit] > 1000 ? 560 : 1690;
+    CHECK_EQ_INT(decode(&frame, &result), IR_DECODE_CHECKSUM);
+    CHECK(result.type == IR_FRAME_TYPE_INVALID);
+
+    frame               = *nec;
+    frame.num_durations = 2 + 2 * 20;
+    CHECK_EQ_INT(decode(&frame, &result), IR_DECODE_TRUNCATED);
+
+    frame                       = *nec;
+    frame.durations[3 + 2 * 10] = 1100;
+    CHECK_EQ_INT(decode(&frame, &result), IR_DECODE_TIMING);
+
+    frame              = *nec;
+    frame.durations[0] = 6000;
+    CHECK_EQ_INT(decode(&frame, &result), IR_DECODE_BAD_HEADER);
+
+    // A glitch ahead of the capture: the header mark that follows starts the frame over
+    frame = *nec;
+    memmove(&frame.durations[2], &frame.durations[0], nec->num_durations * sizeof(uint16_t));
+    frame.durations[0] = 300;
+    frame.durations[1] = 700;
+    frame.num_durations += 2;
+    CHECK(decode(&frame, &result) == IR_DECODE_OK);
+    CHECK(result.protocol == IR_PROTOCOL_NEC && result.address == nec->expected.address &&
+          result.command == nec->expected.command);
+
+    // The stop mark is not needed, the command is complete with the space of the 32nd bit
+    frame = *nec;
+    frame.num_durations -= NEC_STOP_MARK;
+    CHECK(decode(&frame, &result) == IR_DECODE_OK);
+    CHECK(result.command == nec->expected.command);
+}
+
+static void test_repeat(const ir_corpus_frame_t* repeat) {
+    ir_result_t result;
+    CHECK(decode(repeat, &result) == IR_DECODE_OK);
+    CHECK(result.type == IR_FRAME_TYPE_REPEAT && result.protocol == IR_PROTOCOL_NEC);
+
+    // Without its closing mark a repeat code is only a header
+    ir_corpus_frame_t frame = *repeat;
+    frame.num_durations     = 2;
+    CHECK_EQ_INT(decode(&frame, &result), IR_DECODE_TRUNCATED);
+}
+
+int main(int argc, char** argv) {
+    ir_corpus_frame_t* corpus;
+    size_t count = ir_corpus_load(argc > 1 ? argv[1] : "ir_corpus.txt", &corpus);
+    CHECK(count > 0);
+    if (count == 0) {
+        return host_test_result("ir_decode");
+    }
+
+    decode_corpus(corpus, count, 0);
+    decode_corpus(corpus, count, 20);
+
+    const ir_corpus_frame_t* nec    = first_of(corpus, count, IR_PROTOCOL_NEC, IR_FRAME_TYPE_DATA);
+    const ir_corpus_frame_t* repeat = first_of(corpus, count, IR_PROTOCOL_NEC, IR_FRAME_TYPE_REPEAT);
+    CHECK(nec && repeat);
+    if (nec && repeat) {
+        test_damaged_nec(nec);
+        test_repeat(repeat);
+    }
+
+    free(corpus);
+    return host_test_result("ir_decode");
+}
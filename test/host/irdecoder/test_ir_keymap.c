@@ -0,0 +1,317 @@
+// test_ir_keymap.c
+//
+// ir_keymap lookups and bindings, the keymap's round trip through an in-memory NVS defined here, and the held-key
+// timing the decoder task repeats actions by: NEC repeat codes and resent frames keep a key held, a repeating action
+// fires again after IR_REPEAT_DELAY_MS and then every IR_REPEAT_INTERVAL_MS, and a gap longer than IR_REPEAT_GAP_MS
+// makes the next frame a new press.
+
+#include <string.h>
+#include "host_test.h"
+#include "ir_keymap.h"
+#include "ir_repeat.h"
+#include "nvs.h"
+
+#define NEC_REPEAT_PERIOD_US    108000
+#define SIRC_FRAME_PERIOD_US    45000
+
+static struct {
+    bool namespace_exists;
+    uint8_t blob[2 * sizeof(ir_keymap_t)];
+    size_t blob_len;
+    uint8_t pending[2 * sizeof(ir_keymap_t)];
+    size_t pending_len;
+    int open_handles;
+} nvs;
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle) {
+    if (strcmp(name, IR_KEYMAP_NVS_NAMESPACE) != 0 || (!nvs.namespace_exists && open_mode == NVS_READONLY)) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    nvs.namespace_exists = true;
+    nvs.open_handles++;
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    nvs.open_handles--;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length) {
+    if (strcmp(key, IR_KEYMAP_NVS_KEY) != 0 || nvs.blob_len == 0) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (*length < nvs.blob_len) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out_value, nvs.blob, nvs.blob_len);
+    *length = nvs.blob_len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+    if (strcmp(key, IR_KEYMAP_NVS_KEY) != 0 || length > sizeof(nvs.pending)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(nvs.pending, value, length);
+    nvs.pending_len = length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    memcpy(nvs.blob, nvs.pending, nvs.pending_len);
+    nvs.blob_len = nvs.pending_len;
+    return ESP_OK;
+}
+
+static void test_defaults(void) {
+    ir_keymap_t keymap;
+    ir_keymap_load_defaults(&keymap);
+
+    // The shipped remote answers on every NEC address, and only NEC
+    CHECK_EQ_INT(ir_keymap_lookup(&keymap, IR_PROTOCOL_NEC, 0x00FF, BUTTON_CYCLE), IR_ACTION_CYCLE_DISPLAY);
+    CHECK_EQ_INT(ir_keymap_lookup(&keymap, IR_PROTOCOL_NEC, 0x1234, BUTTON_MUTE), IR_ACTION_TOGGLE_SPEAKER);
+    CHECK_EQ_INT(ir_keymap_lookup(&keymap, IR_PROTOCOL_NEC, 0x00FF, BUTTON_7), IR_ACTION_NONE);
+    CHECK_EQ_INT(ir_keymap_lookup(&keymap, IR_PROTOCOL_SAMSUNG, 0x00FF, BUTTON_CYCLE), IR_ACTION_NONE);
+}
+
+static void test_exact_address_first(void) {
+    ir_keymap_t keymap;
+    ir_keymap_load_defaults(&keymap);
+    CHECK(ir_keymap_bind(&keymap, IR_PROTOCOL_NEC, 0x00FF, BUTTON_CYCLE, IR_ACTION_READ_SENSOR) == ESP_OK);
+
+    CHECK_EQ_INT(ir_keymap_lookup(&keymap, IR_PROTOCOL_NEC, 0x00FF, BUTTON_CYCLE), IR_ACTION_READ_SENSOR);
+    // Other addresses still go to the any-address remote
+    CHECK_EQ_INT(ir_keymap_lookup(&keymap, IR_PROTOCOL_NEC, 0x00FE, BUTTON_CYCLE), IR_ACTION_CYCLE_DISPLAY);
+    // Keys the exact remote leaves unbound fall through to the any-address remote
+    CHECK_EQ_INT(ir_keymap_lookup(&keymap, IR_PROTOCOL_NEC, 0x00FF, BUTTON_EQ), IR_ACTION_PLAY_SOUND);
+
+    // The order of the slots does not matter: an any-address remote after the exact one loses to it as well
+    ir_keymap_t swapped = keymap;
+    swapped.remotes[0]  = keymap.remotes[1];
+    swapped.remotes[1]  = keymap.remotes[0];
+    CHECK_EQ_INT(ir_keymap_lookup(&swapped, IR_PROTOCOL_NEC, 0x00FF, BUTTON_CYCLE), IR_ACTION_READ_SENSOR);
+    CHECK_EQ_INT(ir_keymap_lookup(&swapped, IR_PROTOCOL_NEC, 0x00FE, BUTTON_CYCLE), IR_ACTION_CYCLE_DISPLAY);
+}
+
+static void test_rebind(void) {
+    ir_keymap_t keymap;
+    ir_keymap_load_defaults(&keymap);
+    CHECK(ir_keymap_bind(&keymap, IR_PROTOCOL_SONY_SIRC, 0x01, 0x12, IR_ACTION_TOGGLE_LCD) == ESP_OK);
+    CHECK(ir_keymap_bind(&keymap, IR_PROTOCOL_SONY_SIRC, 0x01, 0x13, IR_ACTION_READ_SENSOR) == ESP_OK);
+
+    // Moving an action to another key frees the old one and leaves the remote's other keys alone
+    CHECK(ir_keymap_bind(&keymap, IR_PROTOCOL_SONY_SIRC, 0x01, 0x14, IR_ACTION_TOGGLE_LCD) == ESP_OK);
+    CHECK_EQ_INT(ir_keymap_lookup(&keymap, IR_PROTOCOL_SONY_SIRC, 0x01, 0x12), IR_ACTION_NONE);
+    CHECK_EQ_INT(ir_keymap_lookup(&keymap, IR_PROTOCOL_SONY_SIRC, 0x01, 0x14), IR_ACTION_TOGGLE_LCD);
+    CHECK_EQ_INT(ir_keymap_lookup(&keymap, IR_PROTOCOL_SONY_SIRC, 0x01, 0x13), IR_ACTION_READ_SENSOR);
+    // Other remotes keep the action on their own keys
+    CHECK_EQ_INT(ir_keymap_lookup(&keymap, IR_PROTOCOL_NEC, 0x00FF, BUTTON_U_SD), IR_ACTION_TOGGLE_LCD);
+
+    // Rebinding a key replaces its action, and binding none clears it
+    CHECK(ir_keymap_bind(&keymap, IR_PROTOCOL_SONY_SIRC, 0x01, 0x13, IR_ACTION_PLAY_SOUND) == ESP_OK);
+    CHECK_EQ_INT(ir_keymap_lookup(&keymap, IR_PROTOCOL_SONY_SIRC, 0x01, 0x13), IR_ACTION_PLAY_SOUND);
+    CHECK(ir_keymap_bind(&keymap, IR_PROTOCOL_SONY_SIRC, 0x01, 0x13, IR_ACTION_NONE) == ESP_OK);
+    CHECK_EQ_INT(ir_keymap_lookup(&keymap, IR_PROTOCOL_SONY_SIRC, 0x01, 0x13), IR_ACTION_NONE);
+    CHECK_EQ_INT(ir_keymap_lookup(&keymap, IR_PROTOCOL_SONY_SIRC, 0x01, 0x14), IR_ACTION_TOGGLE_LCD);
+}
+
+static void test_slots_full(void) {
+    ir_keymap_t keymap;
+    ir_keymap_load_defaults(&keymap);
+    // The defaults take the first slot
+    for (uint16_t address = 1; address < IR_KEYMAP_MAX_REMOTES; address++) {
+        CHECK(ir_keymap_bind(&keymap, IR_PROTOCOL_RC5, address, 0x0C, IR_ACTION_TOGGLE_SPEAKER) == ESP_OK);
+    }
+
+    ir_keymap_t before = keymap;
+    CHECK(ir_keymap_bind(&keymap, IR_PROTOCOL_RC5, IR_KEYMAP_MAX_REMOTES, 0x0C, IR_ACTION_TOGGLE_SPEAKER) ==
+          ESP_ERR_NO_MEM);
+    CHECK(ir_keymap_bind(&keymap, IR_PROTOCOL_SAMSUNG, 0x0707, 0x02, IR_ACTION_READ_SENSOR) == ESP_ERR_NO_MEM);
+    CHECK(memcmp(&before, &keymap, sizeof(keymap)) == 0);
+
+    // Remotes that already have a slot can still be bound
+    CHECK(ir_keymap_bind(&keymap, IR_PROTOCOL_RC5, 1, 0x0D, IR_ACTION_READ_SENSOR) == ESP_OK);
+    CHECK_EQ_INT(ir_keymap_lookup(&keymap, IR_PROTOCOL_RC5, 1, 0x0D), IR_ACTION_READ_SENSOR);
+}
+
+static void test_invalid_args(void) {
+    ir_keymap_t keymap;
+    ir_keymap_load_defaults(&keymap);
+    ir_keymap_t before = keymap;
+
+    CHECK(ir_keymap_bind(&keymap, IR_PROTOCOL_NONE, 0, 0x01, IR_ACTION_READ_SENSOR) == ESP_ERR_INVALID_ARG);
+    CHECK(ir_keymap_bind(&keymap, IR_PROTOCOL_MAX, 0, 0x01, IR_ACTION_READ_SENSOR) == ESP_ERR_INVALID_ARG);
+    CHECK(ir_keymap_bind(&keymap, IR_PROTOCOL_NEC, 0, 0x01, IR_ACTION_MAX) == ESP_ERR_INVALID_ARG);
+    CHECK(memcmp(&before, &keymap, sizeof(keymap)) == 0);
+
+    CHECK_EQ_INT(ir_action_from_name("cycle_display"), IR_ACTION_CYCLE_DISPLAY);
+    CHECK_EQ_INT(ir_action_from_name("reboot"), IR_ACTION_MAX);
+    CHECK(strcmp(ir_action_name(IR_ACTION_MAX), "unknown") == 0);
+}
+
+static void test_storage(void) {
+    ir_keymap_t keymap, loaded;
+    ir_keymap_load_defaults(&keymap);
+
+    // Nothing stored yet
+    memset(&loaded, 0xAA, sizeof(loaded));
+    CHECK(ir_keymap_load(&loaded) == ESP_OK);
+    CHECK(memcmp(&loaded, &keymap, sizeof(keymap)) == 0);
+
+    CHECK(ir_keymap_bind(&keymap, IR_PROTOCOL_SAMSUNG, 0x0707, 0x02, IR_ACTION_TOGGLE_LCD) == ESP_OK);
+    CHECK(ir_keymap_save(&keymap) == ESP_OK);
+    CHECK(ir_keymap_load(&loaded) == ESP_OK);
+    CHECK(memcmp(&loaded, &keymap, sizeof(keymap)) == 0);
+    CHECK_EQ_INT(ir_keymap_lookup(&loaded, IR_PROTOCOL_SAMSUNG, 0x0707, 0x02), IR_ACTION_TOGGLE_LCD);
+
+    ir_keymap_t defaults;
+    ir_keymap_load_defaults(&defaults);
+
+    // A keymap of another version or layout is ignored
+    ((ir_keymap_t*)nvs.blob)->version = IR_KEYMAP_VERSION + 1;
+    CHECK(ir_keymap_load(&loaded) == ESP_OK);
+    CHECK(memcmp(&loaded, &defaults, sizeof(defaults)) == 0);
+
+    ((ir_keymap_t*)nvs.blob)->version = IR_KEYMAP_VERSION;
+    nvs.blob_len                      = sizeof(ir_keymap_t) - sizeof(ir_remote_map_t);
+    CHECK(ir_keymap_load(&loaded) == ESP_OK);
+    CHECK(memcmp(&loaded, &defaults, sizeof(defaults)) == 0);
+
+    nvs.blob_len = sizeof(ir_keymap_t) + sizeof(ir_remote_map_t);
+    CHECK(ir_keymap_load(&loaded) == ESP_OK);
+    CHECK(memcmp(&loaded, &defaults, sizeof(defaults)) == 0);
+
+    CHECK_EQ_INT(nvs.open_handles, 0);
+}
+
+typedef struct {
+    ir_held_key_t held;
+    uint32_t fires[16];
+    int num_fires;
+    int presses;
+} key_sim_t;
+
+// What IRDecoder::handle_frame does with each frame, with the action looked up in the default keymap
+static void _frame(key_sim_t* sim, const ir_keymap_t* keymap, ir_frame_type_t type, uint8_t command,
+                   uint32_t timestamp_us) {
+    ir_result_t frame = {type, IR_PROTOCOL_NEC, 0x00FF, command};
+    switch (ir_held_key_frame(&sim->held, &frame, timestamp_us)) {
+        case IR_KEY_EVENT_PRESS:
+            sim->presses++;
+            ir_held_key_press(&sim->held, &frame,
+                              ir_keymap_lookup(keymap, frame.protocol, frame.address, frame.command), timestamp_us);
+            break;
+        case IR_KEY_EVENT_REPEAT:
+            if (sim->num_fires < 16) {
+                sim->fires[sim->num_fires] = timestamp_us;
+            }
+            sim->num_fires++;
+            break;
+        case IR_KEY_EVENT_NONE:
+            break;
+    }
+}
+
+// A key held from start for duration_us, as a frame and then NEC repeat codes every 108 ms
+static void _hold_nec(key_sim_t* sim, const ir_keymap_t* keymap, uint8_t command, uint32_t start_us,
+                      uint32_t duration_us) {
+    _frame(sim, keymap, IR_FRAME_TYPE_DATA, command, start_us);
+    for (uint32_t t = NEC_REPEAT_PERIOD_US; t <= duration_us; t += NEC_REPEAT_PERIOD_US) {
+        _frame(sim, keymap, IR_FRAME_TYPE_REPEAT, 0, start_us + t);
+    }
+}
+
+static void _check_fire_timing(const key_sim_t* sim, uint32_t start_us, uint32_t frame_period_us) {
+    CHECK(sim->num_fires > 0 && sim->num_fires <= 16);
+    for (int i = 0; i < sim->num_fires && i < 16; i++) {
+        uint32_t since = sim->fires[i] - (i == 0 ? start_us : sim->fires[i - 1]);
+        uint32_t due   = (i == 0 ? IR_REPEAT_DELAY_MS : IR_REPEAT_INTERVAL_MS) * 1000;
+        // On the first frame at or after the time it is due
+        CHECK(since >= due && since < due + frame_period_us);
+    }
+}
+
+static void test_repeat_timing(void) {
+    ir_keymap_t keymap;
+    ir_keymap_load_defaults(&keymap);
+
+    // Held for 1.2 s: fires at 540, 756, 972 and 1188 ms
+    key_sim_t sim = {0};
+    _hold_nec(&sim, &keymap, BUTTON_CYCLE, 1000000, 1200000);
+    CHECK_EQ_INT(sim.presses, 1);
+    CHECK_EQ_INT(sim.num_fires, 4);
+    _check_fire_timing(&sim, 1000000, NEC_REPEAT_PERIOD_US);
+
+    // Released before the delay: nothing repeats
+    sim = (key_sim_t){0};
+    _hold_nec(&sim, &keymap, BUTTON_CYCLE, 0, 4 * NEC_REPEAT_PERIOD_US);
+    CHECK_EQ_INT(sim.presses, 1);
+    CHECK_EQ_INT(sim.num_fires, 0);
+
+    // Actions that do not repeat stay held without firing
+    sim = (key_sim_t){0};
+    _hold_nec(&sim, &keymap, BUTTON_FORWARD, 0, 2000000);
+    CHECK_EQ_INT(sim.presses, 1);
+    CHECK_EQ_INT(sim.num_fires, 0);
+
+    // A remote that resends the whole frame holds the key the same way
+    sim = (key_sim_t){0};
+    for (uint32_t t = 0; t <= 1000000; t += SIRC_FRAME_PERIOD_US) {
+        _frame(&sim, &keymap, IR_FRAME_TYPE_DATA, BUTTON_CYCLE, t);
+    }
+    CHECK_EQ_INT(sim.presses, 1);
+    CHECK_EQ_INT(sim.num_fires, 3);
+    _check_fire_timing(&sim, 0, SIRC_FRAME_PERIOD_US);
+
+    // Timestamps wrap every 71 minutes
+    sim = (key_sim_t){0};
+    _hold_nec(&sim, &keymap, BUTTON_CYCLE, UINT32_MAX - 300000, 1200000);
+    CHECK_EQ_INT(sim.presses, 1);
+    CHECK_EQ_INT(sim.num_fires, 4);
+    _check_fire_timing(&sim, UINT32_MAX - 300000, NEC_REPEAT_PERIOD_US);
+}
+
+static void test_hold_ends(void) {
+    ir_keymap_t keymap;
+    ir_keymap_load_defaults(&keymap);
+    key_sim_t sim = {0};
+
+    // A repeat code with no key held, and frames that are not keys, do nothing
+    _frame(&sim, &keymap, IR_FRAME_TYPE_REPEAT, 0, 0);
+    _frame(&sim, &keymap, IR_FRAME_TYPE_INVALID, BUTTON_CYCLE, 1000);
+    CHECK_EQ_INT(sim.presses, 0);
+
+    // A repeat code after a gap longer than IR_REPEAT_GAP_MS belongs to no held key
+    _hold_nec(&sim, &keymap, BUTTON_CYCLE, 0, 432000);
+    _frame(&sim, &keymap, IR_FRAME_TYPE_REPEAT, 0, 432000 + IR_REPEAT_GAP_MS * 1000 + 1);
+    _frame(&sim, &keymap, IR_FRAME_TYPE_REPEAT, 0, 432000 + IR_REPEAT_GAP_MS * 1000 + 1 + NEC_REPEAT_PERIOD_US);
+    CHECK_EQ_INT(sim.presses, 1);
+    CHECK_EQ_INT(sim.num_fires, 0);
+
+    // The same key after the gap is a new press, and its delay starts again
+    sim = (key_sim_t){0};
+    _hold_nec(&sim, &keymap, BUTTON_CYCLE, 0, 432000);
+    _hold_nec(&sim, &keymap, BUTTON_CYCLE, 432000 + IR_REPEAT_GAP_MS * 1000 + 1, 432000);
+    CHECK_EQ_INT(sim.presses, 2);
+    CHECK_EQ_INT(sim.num_fires, 0);
+
+    // Another key while one is held is a new press
+    sim = (key_sim_t){0};
+    _hold_nec(&sim, &keymap, BUTTON_CYCLE, 0, 432000);
+    _frame(&sim, &keymap, IR_FRAME_TYPE_DATA, BUTTON_EQ, 432000 + 50000);
+    CHECK_EQ_INT(sim.presses, 2);
+    CHECK_EQ_INT(sim.held.action, IR_ACTION_PLAY_SOUND);
+}
+
+int main(void) {
+    test_defaults();
+    test_exact_address_first();
+    test_rebind();
+    test_slots_full();
+    test_invalid_args();
+    test_storage();
+    test_repeat_timing();
+    test_hold_ends();
+    return host_test_result("ir_keymap");
+}
@@ -0,0 +1,211 @@
+// test_spsc_ring.cpp
+//
+// Unit checks of SpscRing (full and empty, overflow counting, wraparound, high water), then a producer thread standing
+// in for the RMT interrupt: it queues bursts of ir_edge_t captures whole or not at all, as the receive callback does,
+// while the main thread drains them like the decoder task. Every edge must arrive once and in order, every capture
+// must arrive complete, and what was received plus what was dropped must add up to what was produced. A second run
+// pushes without checking for room so the ring's own overflow count is exercised. Benchmark: push+pop cost on one
+// thread and edges per second across threads.
+
+#include <atomic>
+#include <thread>
+#include "host_test.h"
+#include "irdecoder.h"
+#include "spsc_ring.hpp"
+
+using EdgeRing = SpscRing<ir_edge_t, IR_EDGE_RING_SIZE>;
+
+static void test_full_empty() {
+    SpscRing<uint32_t, 8> ring;
+    uint32_t item;
+    CHECK(ring.empty());
+    CHECK(!ring.pop(item));
+    CHECK_EQ_INT(ring.write_available(), 8);
+
+    for (uint32_t i = 0; i < 8; i++) {
+        CHECK(ring.push(i));
+    }
+    CHECK_EQ_INT(ring.size(), 8);
+    CHECK_EQ_INT(ring.write_available(), 0);
+
+    // A full ring keeps what it has and counts the rejected item
+    CHECK(!ring.push(100));
+    CHECK(!ring.push(101));
+    CHECK_EQ_INT(ring.overflow_count(), 2);
+    for (uint32_t i = 0; i < 8; i++) {
+        CHECK(ring.pop(item) && item == i);
+    }
+    CHECK(ring.empty());
+    CHECK(!ring.pop(item));
+}
+
+static void test_wraparound() {
+    SpscRing<uint32_t, 8> ring;
+    uint32_t next_in = 0, next_out = 0, item;
+
+    // Uneven batches walk head and tail across the end of the slot array many times over
+    for (int round = 0; round < 1000; round++) {
+        int batch = 1 + round % 7;
+        for (int i = 0; i < batch; i++) {
+            CHECK(ring.push(next_in++));
+        }
+        CHECK_EQ_INT(ring.size(), batch);
+        while (ring.pop(item)) {
+            CHECK_EQ_INT(item, next_out);
+            next_out++;
+        }
+    }
+    CHECK_EQ_INT(next_out, next_in);
+    CHECK_EQ_INT(ring.overflow_count(), 0);
+}
+
+static void test_high_water() {
+    SpscRing<uint32_t, 16> ring;
+    uint32_t item;
+    CHECK_EQ_INT(ring.high_water_mark(), 0);
+    for (uint32_t i = 0; i < 5; i++) {
+        ring.push(i);
+    }
+    while (ring.pop(item)) {
+    }
+    for (uint32_t i = 0; i < 3; i++) {
+        ring.push(i);
+    }
+    // The peak stays after the ring drains and a smaller burst follows
+    CHECK_EQ_INT(ring.high_water_mark(), 5);
+    for (uint32_t i = 0; i < 20; i++) {
+        ring.push(i);
+    }
+    CHECK_EQ_INT(ring.high_water_mark(), 16);
+}
+
+struct BurstResult {
+    uint64_t produced_edges;
+    uint64_t produced_captures;
+    uint64_t dropped_edges;
+    uint64_t dropped_captures;
+    uint64_t received_edges;
+    uint64_t received_captures;
+    uint64_t out_of_order;
+    uint64_t incomplete;
+    uint32_t overflows;
+    uint32_t high_water;
+};
+
+// Every edge carries a global sequence number in timestamp_us and its capture's length in duration_us; the end
+// marker carries the sequence number of the capture's first edge
+static BurstResult run_bursts(uint32_t captures, bool whole_captures) {
+    EdgeRing ring;
+    BurstResult r = {};
+    std::atomic<bool> done{false};
+
+    std::thread producer([&] {
+        uint32_t rand_state = 99, sequence = 0;
+        for (uint32_t c = 0; c < captures; c++) {
+            // 1 to 67 edges: a stray pulse up to a full NEC frame
+            uint16_t num_edges = (uint16_t)(1 + host_rand(&rand_state) % 67);
+            uint32_t first     = sequence;
+            sequence += num_edges;
+            r.produced_captures++;
+            r.produced_edges += num_edges + 1;
+
+            if (whole_captures && ring.write_available() < num_edges + 1u) {
+                r.dropped_captures++;
+                r.dropped_edges += num_edges + 1;
+            } else {
+                for (uint16_t i = 0; i < num_edges; i++) {
+                    ring.push({.timestamp_us = first + i, .duration_us = num_edges, .mark = (uint8_t)(i % 2 == 0),
+                               .end_of_capture = 0});
+                }
+                ring.push({.timestamp_us = first, .duration_us = num_edges, .mark = 0, .end_of_capture = 1});
+            }
+            // Captures come in bursts of a few, then the line is quiet
+            if (host_rand(&rand_state) % 4 == 0) {
+                std::this_thread::yield();
+            }
+        }
+        done = true;
+    });
+
+    uint32_t last_sequence = 0, capture_edges = 0;
+    bool first_edge = true;
+    ir_edge_t edge;
+    while (true) {
+        if (!ring.pop(edge)) {
+            if (done.load() && ring.empty()) {
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        r.received_edges++;
+        if (edge.end_of_capture) {
+            r.received_captures++;
+            r.incomplete += capture_edges != edge.duration_us;
+            capture_edges = 0;
+            continue;
+        }
+        r.out_of_order += !first_edge && edge.timestamp_us <= last_sequence;
+        last_sequence = edge.timestamp_us;
+        first_edge    = false;
+        capture_edges++;
+    }
+    producer.join();
+
+    r.overflows  = ring.overflow_count();
+    r.high_water = ring.high_water_mark();
+    return r;
+}
+
+static void test_bursts() {
+    BurstResult whole = run_bursts(200000, true);
+    printf("whole captures: %llu produced, %llu received, %llu dropped, high water %u of %u\n",
+           (unsigned long long)whole.produced_captures, (unsigned long long)whole.received_captures,
+           (unsigned long long)whole.dropped_captures, whole.high_water, IR_EDGE_RING_SIZE);
+    CHECK_EQ_INT(whole.received_edges + whole.dropped_edges, whole.produced_edges);
+    CHECK_EQ_INT(whole.received_captures + whole.dropped_captures, whole.produced_captures);
+    CHECK_EQ_INT(whole.out_of_order, 0);
+    CHECK_EQ_INT(whole.incomplete, 0);
+    // Room is checked first, so the ring itself never refuses an edge
+    CHECK_EQ_INT(whole.overflows, 0);
+    CHECK(whole.high_water <= IR_EDGE_RING_SIZE);
+
+    // Without the check the ring drops single edges and captures arrive short, but nothing arrives twice or late
+    BurstResult blind = run_bursts(200000, false);
+    printf("unchecked pushes: %llu edges produced, %llu received, %u overflows\n",
+           (unsigned long long)blind.produced_edges, (unsigned long long)blind.received_edges, blind.overflows);
+    CHECK_EQ_INT(blind.received_edges + blind.overflows, blind.produced_edges);
+    CHECK_EQ_INT(blind.out_of_order, 0);
+}
+
+static void bench() {
+    EdgeRing ring;
+    const uint32_t edges = 10000000;
+    ir_edge_t edge       = {.timestamp_us = 0, .duration_us = 560, .mark = 1, .end_of_capture = 0};
+    uint64_t sum         = 0;
+
+    uint64_t start = host_now_ns();
+    for (uint32_t i = 0; i < edges; i++) {
+        edge.timestamp_us = i;
+        ring.push(edge);
+        ring.pop(edge);
+        sum += edge.timestamp_us;
+    }
+    double push_pop_ns = (double)(host_now_ns() - start) / edges;
+    CHECK_EQ_INT(sum, (uint64_t)edges * (edges - 1) / 2);
+
+    start                 = host_now_ns();
+    BurstResult r         = run_bursts(200000, true);
+    double cross_thread_s = (host_now_ns() - start) / 1e9;
+    printf("push+pop %.1f ns per edge on one thread, %.1f M edges/s across threads (%u hardware threads)\n",
+           push_pop_ns, r.received_edges / cross_thread_s / 1e6, std::thread::hardware_concurrency());
+}
+
+int main() {
+    test_full_empty();
+    test_wraparound();
+    test_high_water();
+    test_bursts();
+    bench();
+    return host_test_result("spsc_ring");
+}
@@ -0,0 +1,172 @@
+// test_lcd_emulator.c
+//
+// Feeds the emulator hand-built PCF8574 byte streams: a clean 4-bit session, each kind of protocol error, and the
+// stream lcd_i2c.c queues for back-to-back characters, which the controller can only keep up with below 1 MHz.
+
+#include <string.h>
+#include "host_test.h"
+#include "lcd_emulator.h"
+
+#define RS 0x01
+#define RW 0x02
+#define EN 0x04
+#define BL 0x08
+
+typedef struct {
+    uint8_t bytes[256];
+    size_t len;
+} stream_t;
+
+// The driver's pattern: the nibble with EN high, then the same pins with EN low
+static void nibble(stream_t* s, uint8_t value, uint8_t rs) {
+    uint8_t pins       = (uint8_t)(value << 4) | rs | BL;
+    s->bytes[s->len++] = pins | EN;
+    s->bytes[s->len++] = pins;
+}
+
+static void byte(stream_t* s, uint8_t value, uint8_t rs) {
+    nibble(s, value >> 4, rs);
+    nibble(s, value & 0x0F, rs);
+}
+
+static uint64_t send(lcd_emulator_t* emu, stream_t* s, uint64_t start_us) {
+    lcd_emulator_transmit(emu, s->bytes, s->len, start_us);
+    s->len = 0;
+    return emu->now_ns / 1000;
+}
+
+// Power-on entry into 4-bit mode, one transaction per step with the waits the datasheet asks for
+static uint64_t enter_4bit(lcd_emulator_t* emu) {
+    stream_t s = {0};
+    uint64_t t = 50000;
+    nibble(&s, 0x03, 0);
+    t = send(emu, &s, t) + 4100;
+    nibble(&s, 0x03, 0);
+    t = send(emu, &s, t) + 100;
+    nibble(&s, 0x03, 0);
+    t = send(emu, &s, t) + 100;
+    nibble(&s, 0x02, 0);
+    t = send(emu, &s, t) + 100;
+    byte(&s, 0x28, 0);
+    byte(&s, 0x0C, 0);
+    byte(&s, 0x01, 0);
+    return send(emu, &s, t) + 2000;
+}
+
+static void test_clean_session(void) {
+    lcd_emulator_t emu;
+    char row[17];
+    lcd_emulator_init(&emu, 16, 2, 100000);
+    uint64_t t = enter_4bit(&emu);
+
+    stream_t s = {0};
+    byte(&s, 0x80 | 0x40 | 3, 0);
+    for (const char* c = "Hello"; *c; c++) {
+        byte(&s, (uint8_t)*c, RS);
+    }
+    send(&emu, &s, t);
+
+    lcd_emulator_read_row(&emu, 1, row);
+    CHECK(strcmp(row, "   Hello        ") == 0);
+    lcd_emulator_read_row(&emu, 0, row);
+    CHECK(strcmp(row, "                ") == 0);
+    CHECK(lcd_emulator_backlight(&emu));
+    CHECK_EQ_INT(emu.stats.data_writes, 5);
+    CHECK_EQ_INT(emu.stats.enable_errors + emu.stats.rw_errors + emu.stats.busy_errors, 0);
+}
+
+static void test_enable_edges(void) {
+    lcd_emulator_t emu;
+    lcd_emulator_init(&emu, 16, 2, 100000);
+    uint64_t t = enter_4bit(&emu);
+
+    // Data changing while EN stays high
+    const uint8_t while_high[] = {0x40 | BL | RS | EN, 0x50 | BL | RS | EN, 0x50 | BL | RS};
+    lcd_emulator_transmit(&emu, while_high, sizeof(while_high), t);
+    CHECK_EQ_INT(emu.stats.enable_errors, 1);
+
+    // Data changing in the same write that drops EN, so it is not held through the falling edge
+    const uint8_t at_falling_edge[] = {0x10 | BL | RS | EN, 0x20 | BL | RS};
+    lcd_emulator_transmit(&emu, at_falling_edge, sizeof(at_falling_edge), t + 1000);
+    CHECK_EQ_INT(emu.stats.enable_errors, 2);
+
+    // RS is latched like the data lines
+    const uint8_t rs_flip[] = {0x40 | BL | RS | EN, 0x40 | BL};
+    lcd_emulator_transmit(&emu, rs_flip, sizeof(rs_flip), t + 2000);
+    CHECK_EQ_INT(emu.stats.enable_errors, 3);
+
+    // A read strobe: the backpack has nothing to drive the bus with
+    const uint8_t read[] = {BL | RW | EN, BL | RW};
+    lcd_emulator_transmit(&emu, read, sizeof(read), t + 3000);
+    CHECK_EQ_INT(emu.stats.rw_errors, 1);
+}
+
+// Characters queued back to back, as lcd_i2c_flush() sends a run of dirty cells
+static uint32_t busy_errors_for_run(uint32_t scl_hz) {
+    lcd_emulator_t emu;
+    lcd_emulator_init(&emu, 16, 2, scl_hz);
+    uint64_t t        = enter_4bit(&emu);
+    uint32_t at_start = emu.stats.busy_errors;
+
+    stream_t s = {0};
+    byte(&s, 0x80, 0);
+    for (int i = 0; i < 16; i++) {
+        byte(&s, (uint8_t)('A' + i), RS);
+    }
+    send(&emu, &s, t);
+
+    char row[17];
+    lcd_emulator_read_row(&emu, 0, row);
+    CHECK(strcmp(row, "ABCDEFGHIJKLMNOP") == 0);
+    CHECK_EQ_INT(emu.stats.enable_errors, 0);
+    return emu.stats.busy_errors - at_start;
+}
+
+static void test_busy_by_clock(void) {
+    // Two bytes separate one write's last falling edge from the next one's first: 180 us at 100 kHz, 45 us at
+    // 400 kHz, but only 18 us at 1 MHz. Both nibbles of every character then land inside the 37 us the controller
+    // is still executing the previous write.
+    CHECK_EQ_INT(busy_errors_for_run(100000), 0);
+    CHECK_EQ_INT(busy_errors_for_run(400000), 0);
+    CHECK_EQ_INT(busy_errors_for_run(1000000), 2 * 16);
+}
+
+static void test_clear_needs_settle(void) {
+    lcd_emulator_t emu;
+    lcd_emulator_init(&emu, 16, 2, 400000);
+    uint64_t t = enter_4bit(&emu);
+
+    stream_t s = {0};
+    byte(&s, 0x01, 0);
+    byte(&s, 'X', RS);
+    send(&emu, &s, t);
+    CHECK_EQ_INT(emu.stats.busy_errors, 2);
+
+    // As the driver does it: flush after the clear and wait it out before the next transaction
+    byte(&s, 0x01, 0);
+    t = send(&emu, &s, t + 1000);
+    byte(&s, 'X', RS);
+    send(&emu, &s, t + 2000);
+    CHECK_EQ_INT(emu.stats.busy_errors, 2);
+}
+
+static void test_bus_time(void) {
+    lcd_emulator_t emu;
+    lcd_emulator_init(&emu, 16, 2, 100000);
+    const uint8_t pins[4] = {BL, BL, BL, BL};
+    lcd_emulator_transmit(&emu, pins, sizeof(pins), 0);
+    lcd_emulator_transmit(&emu, pins, 1, 0);
+
+    CHECK_EQ_INT(emu.stats.bus_bits, 2 * LCD_EMU_TRANSACTION_BITS + 5 * LCD_EMU_BYTE_BITS);
+    CHECK_EQ_INT(lcd_emulator_bus_time_us(&emu, 100000), 670);
+    CHECK_EQ_INT(lcd_emulator_bus_time_us(&emu, 400000), 167);
+}
+
+int main(void) {
+    test_clean_session();
+    test_enable_edges();
+    test_busy_by_clock();
+    test_clear_needs_settle();
+    test_bus_time();
+    return host_test_result("lcd_emulator");
+}
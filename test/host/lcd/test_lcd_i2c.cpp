@@ -0,0 +1,215 @@
+// test_lcd_i2c.cpp
+//
+// Runs lcd_i2c.c built with LCD_I2C_EMULATOR, so its transactions go through the I2C bus worker into the emulator,
+// and drives it through LcdPanel with the screens the LCD task shows. The panel rows rebuilt from the byte stream
+// must match what was drawn, and any protocol error the emulator sees fails the test. Built once per SCL clock
+// (LCD_I2C_FREQ_HZ), since the busy check depends on how fast bytes reach the controller.
+
+#include <cstring>
+#include "host_test.h"
+#include "lcd_geometry.hpp"
+
+static const lcd_emulator_t* emu;
+
+static void check_rows(const char* const* expected, uint8_t rows) {
+    char row[LCD_MAX_COLS + 1];
+    for (uint8_t r = 0; r < rows; r++) {
+        lcd_emulator_read_row(emu, r, row);
+        if (strcmp(row, expected[r]) != 0) {
+            fprintf(stderr, "row %u: \"%s\", expected \"%s\"\n", r, row, expected[r]);
+        }
+        CHECK(strcmp(row, expected[r]) == 0);
+    }
+}
+
+static void check_protocol() {
+    CHECK_EQ_INT(emu->stats.enable_errors, 0);
+    CHECK_EQ_INT(emu->stats.rw_errors, 0);
+    CHECK_EQ_INT(emu->stats.busy_errors, 0);
+}
+
+static void report(const char* what, const lcd_emulator_stats_t& before) {
+    lcd_emulator_t delta = *emu;
+    delta.stats.transactions -= before.transactions;
+    delta.stats.bytes -= before.bytes;
+    delta.stats.bus_bits -= before.bus_bits;
+    printf("%-22s %3u transactions %5u bytes, bus time %6llu us at 100 kHz, %5llu us at 400 kHz\n", what,
+           delta.stats.transactions, delta.stats.bytes,
+           (unsigned long long)lcd_emulator_bus_time_us(&delta, 100000),
+           (unsigned long long)lcd_emulator_bus_time_us(&delta, 400000));
+}
+
+// The two-line screens of LCDDisplay, one per display mode
+static void test_16x2() {
+    LcdPanel<Lcd16x2> panel;
+    CHECK(panel.init() != nullptr);
+    emu = lcd_i2c_get_emulator();
+    report("16x2 init", lcd_emulator_stats_t{});
+    check_protocol();
+    CHECK(lcd_emulator_backlight(emu));
+
+    const char* blank[] = {"                ", "                "};
+    check_rows(blank, 2);
+
+    lcd_emulator_stats_t before = emu->stats;
+    panel.clear();
+    panel.write_at<0>("Temp: %.2f %cF", 72.5, 223);
+    panel.write_at<1>("Next: Hum");
+    CHECK(panel.flush() == ESP_OK);
+    report("16x2 temperature", before);
+    const char* temperature[] = {"Temp: 72.50 \xdf" "F  ", "Next: Hum       "};
+    check_rows(temperature, 2);
+
+    before = emu->stats;
+    panel.clear();
+    panel.write_at<0>("Hum: %.2f%%", 41.0);
+    panel.write_at<1>("Next: LR");
+    CHECK(panel.flush() == ESP_OK);
+    report("16x2 humidity", before);
+    const char* humidity[] = {"Hum: 41.00%     ", "Next: LR        "};
+    check_rows(humidity, 2);
+
+    before = emu->stats;
+    panel.clear();
+    panel.write_at<0>("LR: %lu secs ago", 7ul);
+    panel.write_at<1>("Next: Temp");
+    CHECK(panel.flush() == ESP_OK);
+    report("16x2 last read", before);
+    const char* last_read[] = {"LR: 7 secs ago  ", "Next: Temp      "};
+    check_rows(last_read, 2);
+
+    panel.backlight(false);
+    CHECK(!lcd_emulator_backlight(emu));
+    check_protocol();
+}
+
+static uint32_t render_temperature(LcdPanel<Lcd16x2>& panel, double fahrenheit) {
+    lcd_i2c_stats_t before, after;
+    lcd_i2c_get_stats(panel.get_handle(), &before);
+    uint32_t emulator_bytes = emu->stats.bytes;
+
+    panel.clear();
+    panel.write_at<0>("Temp: %.2f %cF", fahrenheit, 223);
+    panel.write_at<1>("Next: Hum");
+    CHECK(panel.flush() == ESP_OK);
+
+    lcd_i2c_get_stats(panel.get_handle(), &after);
+    CHECK_EQ_INT(after.i2c_bytes - before.i2c_bytes, emu->stats.bytes - emulator_bytes);
+    return after.i2c_bytes - before.i2c_bytes;
+}
+
+// Only changed cells go out: 4 PCF8574 bytes per character or cursor move
+static void test_dirty_cells() {
+    LcdPanel<Lcd16x2> panel;
+    CHECK(panel.init() != nullptr);
+
+    // 14 characters on row 0, then a cursor move and 9 characters on row 1
+    uint32_t first = render_temperature(panel, 72.5);
+    // A cursor move and the two digits that changed
+    uint32_t digits = render_temperature(panel, 72.61);
+    uint32_t same   = render_temperature(panel, 72.61);
+    printf("bytes per render: first %u, two digits changed %u, unchanged %u\n", first, digits, same);
+    CHECK_EQ_INT(first, 96);
+    CHECK_EQ_INT(digits, 12);
+    CHECK_EQ_INT(same, 0);
+
+    const char* rows[] = {"Temp: 72.61 \xdf" "F  ", "Next: Hum       "};
+    check_rows(rows, 2);
+    check_protocol();
+}
+
+// The driver before batching sent every PCF8574 byte as its own transaction, waiting 1 us after raising EN, 50 us
+// after lowering it and another 50 us after each character. Replays that for `chars` characters on an emulator.
+static double unbatched_chars_per_s(uint32_t chars) {
+    lcd_emulator_t old;
+    lcd_emulator_init(&old, LCD_COLS, LCD_ROWS, LCD_I2C_FREQ_HZ);
+    const uint8_t four_bit[] = {0x20 | PCF8574_BL | PCF8574_EN, 0x20 | PCF8574_BL};
+    lcd_emulator_transmit(&old, four_bit, sizeof(four_bit), 0);
+
+    uint64_t start_us = old.now_ns / 1000 + 100;
+    uint64_t t        = start_us;
+    for (uint32_t i = 0; i < chars; i++) {
+        uint8_t c          = (uint8_t)('A' + i % 26);
+        uint8_t nibbles[2] = {(uint8_t)(c >> 4), (uint8_t)(c & 0x0F)};
+        for (uint8_t nibble : nibbles) {
+            uint8_t pins = (uint8_t)(nibble << 4) | PCF8574_BL | LCD_RS_DATA;
+            uint8_t high = pins | PCF8574_EN;
+            lcd_emulator_transmit(&old, &high, 1, t);
+            t = old.now_ns / 1000 + 1;
+            lcd_emulator_transmit(&old, &pins, 1, t);
+            t = old.now_ns / 1000 + 50;
+        }
+        t += 50;
+    }
+    CHECK_EQ_INT(old.stats.data_writes, chars);
+    CHECK_EQ_INT(old.stats.enable_errors + old.stats.busy_errors, 0);
+    return chars * 1e6 / (double)(t - start_us);
+}
+
+// Full-screen repaints, every cell changing, at the clock this test is built for
+static void bench_throughput() {
+    LcdPanel<Lcd16x2> panel;
+    CHECK(panel.init() != nullptr);
+
+    const int repaints = 50;
+    lcd_i2c_stats_t before, after;
+    lcd_i2c_get_stats(panel.get_handle(), &before);
+    uint64_t bus_bits = emu->stats.bus_bits;
+    for (int i = 0; i < repaints; i++) {
+        char fill[LCD_COLS + 1] = {};
+        memset(fill, 'A' + i % 26, LCD_COLS);
+        panel.write_at<0>("%s", fill);
+        panel.write_at<1>("%s", fill);
+        CHECK(panel.flush() == ESP_OK);
+    }
+    lcd_i2c_get_stats(panel.get_handle(), &after);
+
+    uint32_t chars  = after.cells_written - before.cells_written;
+    double bus_us   = (double)(emu->stats.bus_bits - bus_bits) * 1e6 / LCD_I2C_FREQ_HZ;
+    double batched  = chars * 1e6 / bus_us;
+    double steady   = LCD_I2C_FREQ_HZ / (4.0 * LCD_EMU_BYTE_BITS);
+    double previous = unbatched_chars_per_s(chars);
+    printf("%u chars in %u transactions: %.0f chars/s batched (%.0f chars/s within a run), %.0f chars/s unbatched, "
+           "%.1fx\n",
+           chars, after.i2c_transactions - before.i2c_transactions, batched, steady, previous, batched / previous);
+
+    CHECK_EQ_INT(chars, repaints * 2 * LCD_COLS);
+    // 32 characters and the cursor move to row 1 are 132 bytes, so the 128-byte buffer drains once mid-flush
+    uint32_t per_flush = (2 * LCD_COLS + 1) * 4;
+    CHECK_EQ_INT(after.i2c_transactions - before.i2c_transactions,
+                 repaints * ((per_flush + LCD_TX_BUFFER_SIZE - 1) / LCD_TX_BUFFER_SIZE));
+    // The cursor move and the transaction overhead cost a few percent of the 36 bits per character
+    CHECK(batched > 0.9 * steady);
+    CHECK(batched > 2 * previous);
+    check_protocol();
+}
+
+// Rows 2 and 3 continue rows 0 and 1 in DDRAM; a wrong offset shows up as text on the wrong row
+static void test_20x4() {
+    LcdPanel<Lcd20x4> panel;
+    CHECK(panel.init() != nullptr);
+
+    lcd_emulator_stats_t before = emu->stats;
+    panel.write_at<0>("Temp: %.2f %cF", 72.5, 223);
+    panel.write_at<1>("Hum:  %.2f%%", 41.0);
+    panel.write_at<2>("LR: %lu secs ago", 7ul);
+    panel.write_at<3>("At: %02d:%02d:%02d", 12, 34, 56);
+    CHECK(panel.flush() == ESP_OK);
+    report("20x4 all readings", before);
+
+    const char* rows[] = {"Temp: 72.50 \xdf" "F      ", "Hum:  41.00%        ", "LR: 7 secs ago      ",
+                          "At: 12:34:56        "};
+    check_rows(rows, 4);
+    check_protocol();
+}
+
+int main() {
+    printf("lcd_i2c at %u Hz through the emulator\n", (unsigned)LCD_I2C_FREQ_HZ);
+    test_16x2();
+    test_dirty_cells();
+    test_20x4();
+    bench_throughput();
+    printf("total: %u transactions, %u bytes, %u commands, %u data writes\n", emu->stats.transactions,
+           emu->stats.bytes, emu->stats.commands, emu->stats.data_writes);
+    return host_test_result("lcd_i2c");
+}
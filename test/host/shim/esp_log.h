@@ -0,0 +1,37 @@
+// esp_log.h
+//
+// Warnings and errors go to stderr; info and debug lines only with HOST_LOG_VERBOSE set in the environment
+
+#pragma once
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int host_log_verbose(void);
+
+#define HOST_LOG(level, tag, format, ...) fprintf(stderr, level " (%s) " format "\n", tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) HOST_LOG("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)                           \
+    do {                                                     \
+        if (host_log_verbose()) {                            \
+            HOST_LOG("I", tag, format, ##__VA_ARGS__);       \
+        }                                                    \
+    } while (0)
+#define ESP_LOGD(tag, format, ...)                           \
+    do {                                                     \
+        if (host_log_verbose() > 1) {                        \
+            HOST_LOG("D", tag, format, ##__VA_ARGS__);       \
+        }                                                    \
+    } while (0)
+#define ESP_LOGV ESP_LOGD
+
+#define ESP_ERROR_CHECK(x) ((void)(x))
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,16 @@
+// esp_timer.h
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Microseconds of the monotonic clock since the process started
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,62 @@
+// FreeRTOS.h
+//
+// Host stand-in for the parts of FreeRTOS the components use, implemented on pthreads in freertos_host.c. Tasks are
+// threads and run truly concurrently; a tick is one millisecond of the monotonic clock.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  pdTRUE
+#define pdFAIL  pdFALSE
+
+#define portMAX_DELAY       ((TickType_t)0xFFFFFFFF)
+#define configTICK_RATE_HZ  1000
+#define portTICK_PERIOD_MS  (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+#define pdTICKS_TO_MS(t)    ((uint32_t)(t))
+
+#define portYIELD_FROM_ISR(x) ((void)(x))
+
+// Every spinlock maps onto one process-wide recursive lock
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {0}
+
+void host_rtos_enter_critical(portMUX_TYPE* mux);
+void host_rtos_exit_critical(portMUX_TYPE* mux);
+
+#define taskENTER_CRITICAL(mux)     host_rtos_enter_critical(mux)
+#define taskEXIT_CRITICAL(mux)      host_rtos_exit_critical(mux)
+#define taskENTER_CRITICAL_ISR(mux) host_rtos_enter_critical(mux)
+#define taskEXIT_CRITICAL_ISR(mux)  host_rtos_exit_critical(mux)
+#define portENTER_CRITICAL(mux)     host_rtos_enter_critical(mux)
+#define portEXIT_CRITICAL(mux)      host_rtos_exit_critical(mux)
+
+#define BIT0 0x00000001
+#define BIT1 0x00000002
+#define BIT2 0x00000004
+#define BIT3 0x00000008
+#define BIT4 0x00000010
+#define BIT5 0x00000020
+#define BIT6 0x00000040
+#define BIT7 0x00000080
+
+#ifdef __cplusplus
+}
+#endif
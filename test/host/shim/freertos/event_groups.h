@@ -0,0 +1,33 @@
+// event_groups.h
+
+#pragma once
+
+#include <pthread.h>
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint32_t EventBits_t;
+
+typedef struct host_event_group {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    EventBits_t bits;
+} StaticEventGroup_t;
+
+typedef StaticEventGroup_t* EventGroupHandle_t;
+
+EventGroupHandle_t xEventGroupCreate(void);
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t* group);
+void vEventGroupDelete(EventGroupHandle_t group);
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks);
+
+#ifdef __cplusplus
+}
+#endif
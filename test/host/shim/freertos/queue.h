@@ -0,0 +1,43 @@
+// queue.h
+
+#pragma once
+
+#include <pthread.h>
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    uint8_t* storage;
+    bool owns_storage;
+    size_t item_size;
+    size_t depth;
+    size_t head;
+    size_t count;
+} StaticQueue_t;
+
+typedef StaticQueue_t* QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t depth, UBaseType_t item_size);
+QueueHandle_t xQueueCreateStatic(UBaseType_t depth, UBaseType_t item_size, uint8_t* storage, StaticQueue_t* queue);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks);
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticks);
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void* item);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks);
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticks);
+BaseType_t xQueueReset(QueueHandle_t queue);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue);
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken);
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void* item, BaseType_t* woken);
+
+#define xQueueSendToBack(queue, item, ticks) xQueueSend(queue, item, ticks)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,28 @@
+// semphr.h
+
+#pragma once
+
+#include "queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Semaphores are queues of empty items, as in FreeRTOS; a mutex starts given and is not recursive
+typedef StaticQueue_t StaticSemaphore_t;
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t* semaphore);
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t* semaphore);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* woken);
+
+#define vSemaphoreDelete(semaphore) vQueueDelete(semaphore)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,522 @@
+// freertos_host.c
+//
+// pthread implementation of the FreeRTOS and ESP-IDF calls declared in the shim headers. Blocking calls wait on a
+// condition variable of the monotonic clock; the FromISR variants are the plain calls, since nothing here runs in an
+// interrupt.
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "host_rtos.h"
+
+struct host_task {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    uint32_t value;
+    bool notified;
+    TaskFunction_t fn;
+    void* arg;
+    const char* name;
+};
+
+static pthread_once_t s_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t s_critical;
+static pthread_condattr_t s_monotonic;
+static __thread struct host_task* s_current;
+static volatile uint32_t s_queue_sends;
+static int64_t s_start_us;
+
+static int64_t _monotonic_us(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64_t)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+static void _init_once(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&s_critical, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    pthread_condattr_init(&s_monotonic);
+    pthread_condattr_setclock(&s_monotonic, CLOCK_MONOTONIC);
+
+    // Like the device, time starts near zero when the program does
+    s_start_us = _monotonic_us() - 1;
+}
+
+static void _init(void) {
+    pthread_once(&s_once, _init_once);
+}
+
+static void _init_sync(pthread_mutex_t* lock, pthread_cond_t* changed) {
+    _init();
+    pthread_mutex_init(lock, NULL);
+    pthread_cond_init(changed, &s_monotonic);
+}
+
+static struct timespec _deadline(TickType_t ticks) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    uint64_t ns = (uint64_t)t.tv_nsec + (uint64_t)pdTICKS_TO_MS(ticks) * 1000000ull;
+    t.tv_sec += (time_t)(ns / 1000000000ull);
+    t.tv_nsec = (long)(ns % 1000000000ull);
+    return t;
+}
+
+// Waits once for a change; false when the deadline has passed. The caller re-checks its condition either way.
+static bool _wait(pthread_cond_t* changed, pthread_mutex_t* lock, TickType_t ticks, const struct timespec* deadline) {
+    if (ticks == 0) {
+        return false;
+    }
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(changed, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(changed, lock, deadline) != ETIMEDOUT;
+}
+
+void host_rtos_enter_critical(portMUX_TYPE* mux) {
+    (void)mux;
+    _init();
+    pthread_mutex_lock(&s_critical);
+}
+
+void host_rtos_exit_critical(portMUX_TYPE* mux) {
+    (void)mux;
+    pthread_mutex_unlock(&s_critical);
+}
+
+uint32_t host_rtos_queue_sends(void) {
+    return __atomic_load_n(&s_queue_sends, __ATOMIC_ACQUIRE);
+}
+
+int host_log_verbose(void) {
+    static int verbose = -1;
+    if (verbose < 0) {
+        const char* env = getenv("HOST_LOG_VERBOSE");
+        verbose         = env ? atoi(env) : 0;
+    }
+    return verbose;
+}
+
+int64_t esp_timer_get_time(void) {
+    _init();
+    return _monotonic_us() - s_start_us;
+}
+
+// Queues
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t depth, UBaseType_t item_size, uint8_t* storage, StaticQueue_t* queue) {
+    memset(queue, 0, sizeof(*queue));
+    _init_sync(&queue->lock, &queue->changed);
+    queue->storage   = storage;
+    queue->item_size = item_size;
+    queue->depth     = depth;
+    return queue;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t depth, UBaseType_t item_size) {
+    StaticQueue_t* queue = malloc(sizeof(*queue));
+    uint8_t* storage     = item_size ? malloc((size_t)depth * item_size) : NULL;
+    xQueueCreateStatic(depth, item_size, storage, queue);
+    queue->owns_storage = true;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->changed);
+    if (queue->owns_storage) {
+        free(queue->storage);
+        free(queue);
+    }
+}
+
+static BaseType_t _queue_send(QueueHandle_t queue, const void* item, TickType_t ticks, bool front, bool overwrite) {
+    struct timespec deadline = _deadline(ticks);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->depth && !overwrite) {
+        if (!_wait(&queue->changed, &queue->lock, ticks, &deadline) && queue->count == queue->depth) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+    }
+
+    size_t slot;
+    if (overwrite && queue->count == queue->depth) {
+        slot = queue->head;
+    } else if (front) {
+        queue->head = (queue->head + queue->depth - 1) % queue->depth;
+        slot        = queue->head;
+        queue->count++;
+    } else {
+        slot = (queue->head + queue->count) % queue->depth;
+        queue->count++;
+    }
+    if (queue->item_size) {
+        memcpy(queue->storage + slot * queue->item_size, item, queue->item_size);
+    }
+    __atomic_add_fetch(&s_queue_sends, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+static BaseType_t _queue_receive(QueueHandle_t queue, void* item, TickType_t ticks, bool peek) {
+    struct timespec deadline = _deadline(ticks);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (!_wait(&queue->changed, &queue->lock, ticks, &deadline) && queue->count == 0) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+    }
+
+    if (queue->item_size && item) {
+        memcpy(item, queue->storage + queue->head * queue->item_size, queue->item_size);
+    }
+    if (!peek) {
+        queue->head = (queue->head + 1) % queue->depth;
+        queue->count--;
+        pthread_cond_broadcast(&queue->changed);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    return _queue_send(queue, item, ticks, false, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    return _queue_send(queue, item, ticks, true, false);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void* item) {
+    return _queue_send(queue, item, 0, false, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+    return _queue_receive(queue, item, ticks, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticks) {
+    return _queue_receive(queue, item, ticks, true);
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->head  = 0;
+    queue->count = 0;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = (UBaseType_t)queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t spaces = (UBaseType_t)(queue->depth - queue->count);
+    pthread_mutex_unlock(&queue->lock);
+    return spaces;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void* item, BaseType_t* woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xQueueReceive(queue, item, 0);
+}
+
+// Semaphores
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t* semaphore) {
+    return xQueueCreateStatic(1, 0, NULL, semaphore);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t* semaphore) {
+    SemaphoreHandle_t mutex = xSemaphoreCreateBinaryStatic(semaphore);
+    mutex->count            = 1;
+    return mutex;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    SemaphoreHandle_t mutex = xSemaphoreCreateBinary();
+    mutex->count            = 1;
+    return mutex;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+    SemaphoreHandle_t semaphore = xQueueCreate(max_count, 0);
+    semaphore->count            = initial_count;
+    return semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    return xQueueReceive(semaphore, NULL, ticks);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    return xQueueSend(semaphore, NULL, 0);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* woken) {
+    return xQueueSendFromISR(semaphore, NULL, woken);
+}
+
+// Event groups
+
+EventGroupHandle_t xEventGroupCreateStatic(StaticEventGroup_t* group) {
+    memset(group, 0, sizeof(*group));
+    _init_sync(&group->lock, &group->changed);
+    return group;
+}
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    return xEventGroupCreateStatic(malloc(sizeof(StaticEventGroup_t)));
+}
+
+void vEventGroupDelete(EventGroupHandle_t group) {
+    pthread_mutex_destroy(&group->lock);
+    pthread_cond_destroy(&group->changed);
+    free(group);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&group->lock);
+    group->bits |= bits;
+    EventBits_t now = group->bits;
+    pthread_cond_broadcast(&group->changed);
+    pthread_mutex_unlock(&group->lock);
+    return now;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&group->lock);
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    pthread_mutex_unlock(&group->lock);
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    pthread_mutex_lock(&group->lock);
+    EventBits_t bits = group->bits;
+    pthread_mutex_unlock(&group->lock);
+    return bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks) {
+    struct timespec deadline = _deadline(ticks);
+    pthread_mutex_lock(&group->lock);
+    while (true) {
+        bool satisfied = wait_for_all ? (group->bits & bits) == bits : (group->bits & bits) != 0;
+        if (satisfied) {
+            EventBits_t result = group->bits;
+            if (clear_on_exit) {
+                group->bits &= ~bits;
+            }
+            pthread_mutex_unlock(&group->lock);
+            return result;
+        }
+        if (!_wait(&group->changed, &group->lock, ticks, &deadline)) {
+            break;
+        }
+    }
+    EventBits_t result = group->bits;
+    pthread_mutex_unlock(&group->lock);
+    return result;
+}
+
+// Tasks
+
+static struct host_task* _new_task(const char* name) {
+    struct host_task* task = calloc(1, sizeof(*task));
+    _init_sync(&task->lock, &task->changed);
+    task->name = name;
+    return task;
+}
+
+static void* _task_entry(void* arg) {
+    s_current = (struct host_task*)arg;
+    s_current->fn(s_current->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack_depth, void* arg, UBaseType_t priority,
+                       TaskHandle_t* handle) {
+    (void)stack_depth;
+    (void)priority;
+    struct host_task* task = _new_task(name);
+    task->fn               = fn;
+    task->arg              = arg;
+    if (handle) {
+        *handle = task;
+    }
+    if (pthread_create(&task->thread, NULL, _task_entry, task) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack_depth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    (void)core;
+    return xTaskCreate(fn, name, stack_depth, arg, priority, handle);
+}
+
+// Only a task deleting itself is supported; its handle stays valid so late notifications are harmless
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL || task == s_current) {
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    if (ticks == 0) {
+        sched_yield();
+        return;
+    }
+    struct timespec t = {.tv_sec = (time_t)(ticks / 1000), .tv_nsec = (long)(ticks % 1000) * 1000000};
+    while (nanosleep(&t, &t) != 0 && errno == EINTR) {
+    }
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+// Threads that were not created through xTaskCreate, such as main, get a handle the first time they ask
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    if (s_current == NULL) {
+        s_current         = _new_task("host");
+        s_current->thread = pthread_self();
+    }
+    return s_current;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    BaseType_t ret = pdPASS;
+    pthread_mutex_lock(&task->lock);
+    switch (action) {
+        case eSetBits:
+            task->value |= value;
+            break;
+        case eIncrement:
+            task->value++;
+            break;
+        case eSetValueWithOverwrite:
+            task->value = value;
+            break;
+        case eSetValueWithoutOverwrite:
+            if (task->notified) {
+                ret = pdFAIL;
+            } else {
+                task->value = value;
+            }
+            break;
+        case eNoAction:
+            break;
+    }
+    task->notified = true;
+    pthread_cond_broadcast(&task->changed);
+    pthread_mutex_unlock(&task->lock);
+    return ret;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    return xTaskNotify(task, 0, eIncrement);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    struct host_task* self   = xTaskGetCurrentTaskHandle();
+    struct timespec deadline = _deadline(ticks);
+    pthread_mutex_lock(&self->lock);
+    while (self->value == 0 && _wait(&self->changed, &self->lock, ticks, &deadline)) {
+    }
+    uint32_t value = self->value;
+    if (value != 0) {
+        self->value = clear_on_exit ? 0 : value - 1;
+    }
+    self->notified = false;
+    pthread_mutex_unlock(&self->lock);
+    return value;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t* value, TickType_t ticks) {
+    struct host_task* self   = xTaskGetCurrentTaskHandle();
+    struct timespec deadline = _deadline(ticks);
+    pthread_mutex_lock(&self->lock);
+    if (!self->notified) {
+        self->value &= ~clear_on_entry;
+    }
+    while (!self->notified && _wait(&self->changed, &self->lock, ticks, &deadline)) {
+    }
+    if (value) {
+        *value = self->value;
+    }
+    BaseType_t received = self->notified ? pdTRUE : pdFALSE;
+    if (received) {
+        self->value &= ~clear_on_exit;
+        self->notified = false;
+    }
+    pthread_mutex_unlock(&self->lock);
+    return received;
+}
+
+BaseType_t xTaskNotifyStateClear(TaskHandle_t task) {
+    if (task == NULL) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    pthread_mutex_lock(&task->lock);
+    BaseType_t was_notified = task->notified ? pdTRUE : pdFALSE;
+    task->notified          = false;
+    pthread_mutex_unlock(&task->lock);
+    return was_notified;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t* woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xTaskNotify(task, value, action);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken) {
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    xTaskNotifyGive(task);
+}
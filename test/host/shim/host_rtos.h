@@ -0,0 +1,18 @@
+// host_rtos.h
+//
+// Hooks into the host FreeRTOS stand-in that tests use to wait for the code under test instead of sleeping
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Items successfully sent to any queue or semaphore since the process started
+uint32_t host_rtos_queue_sends(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,8 @@
+// sdkconfig.h
+//
+// What the components see of the configuration when built for the host
+
+#pragma once
+
+#define CONFIG_IDF_TARGET_LINUX 1
+#define CONFIG_FREERTOS_HZ      1000
@@ -0,0 +1,231 @@
+// adpcm_roundtrip.c
+//
+// Decodes the vectors written by adpcm_vectors.py at build time with adpcm.c, which must match the Python reference
+// decoder sample for sample, whole and in the chunks the mixer decodes, reports the quality against the source at DAC
+// resolution, and times the decode. Exits non-zero on any mismatch.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "adpcm.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// The mixer's block and the DMA buffer size
+static const size_t chunk_sizes[] = {128, 1024};
+
+#define BENCH_CHUNK  1024
+#define SAMPLE_RATE  16000
+// Real sounds land between 25 and 28 dB; anything far below means the decode or the packing is off. Vectors named
+// stress_* are built to defeat the predictor and are exempt.
+#define MIN_SNR_DB   20.0
+
+typedef struct {
+    char name[33];
+    uint32_t num_samples;
+    adpcm_state_t initial;
+    uint8_t* adpcm;
+    int16_t* reference;
+    int16_t* source;
+} vector_t;
+
+static uint32_t _get_u32(const uint8_t* p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static int16_t _get_i16(const uint8_t* p) {
+    return (int16_t)(p[0] | p[1] << 8);
+}
+
+static double _now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static uint64_t _cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Returns the number of vectors, 0 if the file is missing or malformed
+static size_t _load(const char* path, vector_t** vectors) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 0;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* file = malloc(len);
+    size_t got    = fread(file, 1, len, f);
+    fclose(f);
+
+    size_t count = 0;
+    if (got == (size_t)len && len >= 8 && memcmp(file, "ADPV", 4) == 0) {
+        count    = _get_u32(file + 4);
+        *vectors = calloc(count, sizeof(vector_t));
+        size_t p = 8;
+        for (size_t v = 0; v < count; v++) {
+            vector_t* vec = &(*vectors)[v];
+            if (p + 40 > (size_t)len) {
+                count = 0;
+                break;
+            }
+            memcpy(vec->name, file + p, 32);
+            vec->num_samples        = _get_u32(file + p + 32);
+            vec->initial.predictor  = _get_i16(file + p + 36);
+            vec->initial.step_index = file[p + 38];
+            p += 40;
+
+            size_t adpcm_len = (vec->num_samples + 1) / 2;
+            if (p + adpcm_len + 4 * (size_t)vec->num_samples > (size_t)len) {
+                count = 0;
+                break;
+            }
+            vec->adpcm     = malloc(adpcm_len);
+            vec->reference = malloc(vec->num_samples * sizeof(int16_t));
+            vec->source    = malloc(vec->num_samples * sizeof(int16_t));
+            memcpy(vec->adpcm, file + p, adpcm_len);
+            p += adpcm_len;
+            for (uint32_t i = 0; i < vec->num_samples; i++, p += 2) {
+                vec->reference[i] = _get_i16(file + p);
+            }
+            for (uint32_t i = 0; i < vec->num_samples; i++, p += 2) {
+                vec->source[i] = _get_i16(file + p);
+            }
+        }
+    }
+    free(file);
+    if (count == 0) {
+        fprintf(stderr, "%s: not an adpcm_vectors.py file\n", path);
+    }
+    return count;
+}
+
+// Decodes in chunks of chunk samples, carrying the state across calls as the mixer does
+static void _decode(const vector_t* vec, uint32_t num_samples, size_t chunk, int16_t* out) {
+    adpcm_state_t state = vec->initial;
+    const uint8_t* data = vec->adpcm;
+    for (uint32_t done = 0; done < num_samples;) {
+        size_t count = num_samples - done < chunk ? num_samples - done : chunk;
+        adpcm_decode(&state, data, count, out + done);
+        data += count / 2;
+        done += count;
+    }
+}
+
+static int _first_mismatch(const int16_t* a, const int16_t* b, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        if (a[i] != b[i]) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static int _check(const vector_t* vec) {
+    int failures    = 0;
+    int16_t* output = malloc(vec->num_samples * sizeof(int16_t));
+
+    _decode(vec, vec->num_samples, vec->num_samples, output);
+    int at = _first_mismatch(output, vec->reference, vec->num_samples);
+    if (at >= 0) {
+        printf("%s: whole decode differs from the reference at sample %d: %d, expected %d\n", vec->name, at,
+               output[at], vec->reference[at]);
+        failures++;
+    }
+    for (size_t c = 0; c < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); c++) {
+        _decode(vec, vec->num_samples, chunk_sizes[c], output);
+        if (_first_mismatch(output, vec->reference, vec->num_samples) >= 0) {
+            printf("%s: decode in %zu-sample chunks differs from the reference\n", vec->name, chunk_sizes[c]);
+            failures++;
+        }
+    }
+    // An odd count ends on the low nibble of the last byte
+    uint32_t odd = vec->num_samples & 1 ? vec->num_samples : vec->num_samples - 1;
+    _decode(vec, odd, chunk_sizes[0], output);
+    if (_first_mismatch(output, vec->reference, odd) >= 0) {
+        printf("%s: decode of the first %u samples differs from the reference\n", vec->name, odd);
+        failures++;
+    }
+
+    // Quality at the DAC's 8 bits, which is what the listener gets
+    double signal = 0, noise = 0;
+    int max_error = 0;
+    for (uint32_t i = 0; i < vec->num_samples; i++) {
+        int source  = vec->source[i] >> 8;
+        int decoded = vec->reference[i] >> 8;
+        signal += (double)source * source;
+        noise += (double)(decoded - source) * (decoded - source);
+        max_error = abs(decoded - source) > max_error ? abs(decoded - source) : max_error;
+    }
+    double snr_db = 10 * log10(signal / (noise > 0 ? noise : 1e-9));
+    printf("%-30s %5u samples, %5u bytes (%u as 8-bit PCM), SNR at DAC resolution %.1f dB, max error %d LSB\n",
+           vec->name, vec->num_samples, (vec->num_samples + 1) / 2, vec->num_samples, snr_db, max_error);
+    if (snr_db < MIN_SNR_DB && strncmp(vec->name, "stress_", 7) != 0) {
+        printf("%s: SNR below %.0f dB\n", vec->name, MIN_SNR_DB);
+        failures++;
+    }
+
+    free(output);
+    return failures;
+}
+
+// Decodes the first BENCH_CHUNK samples of the vector over and over from its initial state
+static void _bench(const vector_t* vec) {
+    static int16_t output[BENCH_CHUNK];
+    const int rounds     = 20000;
+    volatile int32_t sum = 0;
+
+    double start        = _now_ns();
+    uint64_t start_tick = _cycles();
+    for (int r = 0; r < rounds; r++) {
+        adpcm_state_t state = vec->initial;
+        adpcm_decode(&state, vec->adpcm, BENCH_CHUNK, output);
+        sum += output[r % BENCH_CHUNK];
+    }
+    uint64_t ticks = _cycles() - start_tick;
+    double ns      = (_now_ns() - start) / ((double)rounds * BENCH_CHUNK);
+
+    printf("decode: %.2f ns/sample", ns);
+    if (ticks) {
+        printf(", %.1f TSC cycles/sample", (double)ticks / ((double)rounds * BENCH_CHUNK));
+    }
+    printf(", %.1f us per %d-sample chunk, which plays for %.0f ms\n", ns * BENCH_CHUNK / 1000, BENCH_CHUNK,
+           1000.0 * BENCH_CHUNK / SAMPLE_RATE);
+}
+
+int main(int argc, char** argv) {
+    vector_t* vectors;
+    size_t count = _load(argc > 1 ? argv[1] : "adpcm_vectors.bin", &vectors);
+    if (count == 0) {
+        return 1;
+    }
+
+    int failures = 0;
+    const vector_t* longest = &vectors[0];
+    for (size_t v = 0; v < count; v++) {
+        failures += _check(&vectors[v]);
+        longest = vectors[v].num_samples > longest->num_samples ? &vectors[v] : longest;
+    }
+    if (longest->num_samples >= BENCH_CHUNK) {
+        _bench(longest);
+    }
+
+    for (size_t v = 0; v < count; v++) {
+        free(vectors[v].adpcm);
+        free(vectors[v].reference);
+        free(vectors[v].source);
+    }
+    free(vectors);
+    printf("%s\n", failures ? "FAILED" : "all vectors match the reference decoder");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+import math
+import os
+import random
+import struct
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "..", "components", "speaker"))
+import audio_asset_compiler as compiler
+
+# Test vectors for adpcm.c: short test sounds written as WAVs in the formats parse_wav accepts, compiled exactly as
+# audio_asset_compiler.py compiles assets, then decoded by the reference decoder below.
+#   adpcm_vectors.py <output_file>
+#
+# Output layout, all little-endian; adpcm_roundtrip.c reads the same structures:
+#   header  magic "ADPV", u32 count
+#   vector  char name[32], u32 samples, i16 initial predictor, u8 initial step index, u8 pad,
+#           u8 adpcm[(samples + 1) / 2], i16 reference[samples], i16 source[samples]
+VECTORS_MAGIC = b'ADPV'
+VECTORS_HEADER = struct.Struct('<4sI')
+VECTOR_HEADER = struct.Struct('<32sIhBx')
+
+SAMPLE_RATE = 16000
+
+# Straight from the IMA ADPCM specification, deliberately not sharing code with either the encoder or adpcm.c
+def reference_decode(encoded, num_samples, predictor, step_index):
+    samples = []
+    for k in range(num_samples):
+        nibble = (encoded[k // 2] >> (4 * (k & 1))) & 0x0F
+        step = compiler.STEP_TABLE[step_index]
+        diff = step >> 3
+        if nibble & 1:
+            diff += step >> 2
+        if nibble & 2:
+            diff += step >> 1
+        if nibble & 4:
+            diff += step
+        predictor = predictor - diff if nibble & 8 else predictor + diff
+        predictor = max(-32768, min(32767, predictor))
+        step_index = max(0, min(88, step_index + compiler.INDEX_TABLE[nibble & 7]))
+        samples.append(predictor)
+    return samples
+
+def write_wav(path, channels, rate, bits, frames):
+    if bits == 8:
+        data = bytes((max(-32768, min(32767, s)) >> 8) + 128 for frame in frames for s in frame)
+    else:
+        data = b''.join(struct.pack('<h', max(-32768, min(32767, s))) for frame in frames for s in frame)
+    block_align = channels * bits // 8
+    with open(path, "wb") as f:
+        f.write(b'RIFF' + struct.pack('<I', 36 + len(data)) + b'WAVE')
+        f.write(b'fmt ' + struct.pack('<IHHIIHH', 16, 1, channels, rate, rate * block_align, block_align, bits))
+        f.write(b'data' + struct.pack('<I', len(data)) + data)
+
+# A rising chirp that decays: quiet tails make the step size shrink back down
+def chirp(rate, seconds=0.25):
+    n = int(rate * seconds)
+    return [round(30000 * math.exp(-4 * i / n) * math.sin(2 * math.pi * (300 + 3000 * i / n) * i / rate))
+            for i in range(n)]
+
+# Silence, then full-scale steps and white noise: the predictor saturates and the step index hits both ends. ADPCM
+# cannot follow this, so it only has to decode exactly; the stress_ prefix exempts it from the quality floor.
+def steps_and_noise(rate, seconds=0.2):
+    rng = random.Random(5)
+    n = int(rate * seconds)
+    samples = []
+    for i in range(n):
+        if i < n // 8:
+            samples.append(0)
+        elif i < n // 2:
+            samples.append(32767 if (i // 40) % 2 else -32768)
+        else:
+            samples.append(rng.randint(-20000, 20000))
+    return samples
+
+# A click and two tone bursts with gaps, like a key click followed by a confirmation
+def bursts(rate, seconds=0.3):
+    n = int(rate * seconds)
+    samples = [0] * n
+    for i in range(rate // 500):
+        samples[i] = round(25000 * (1 - i * 500 / rate))
+    for start, freq in ((n // 3, 880), (2 * n // 3, 1320)):
+        for i in range(rate // 20):
+            samples[start + i] = round(18000 * math.sin(2 * math.pi * freq * i / rate))
+    return samples
+
+# Name, channels, WAV rate, bits per sample, frames. parse_wav averages stereo to mono; the 44.1 kHz chirp is on the
+# right channel only, so it would be lost if a channel were dropped.
+def test_sounds():
+    chirp_44k = chirp(44100)
+    return [
+        ("chirp_16k_mono16", 1, 16000, 16, [(s,) for s in chirp(16000)]),
+        ("chirp_44k_stereo16", 2, 44100, 16, [(0, s) for s in chirp_44k]),
+        ("stress_steps_noise_16k_mono16", 1, 16000, 16, [(s,) for s in steps_and_noise(16000)]),
+        ("bursts_8k_mono8", 1, 8000, 8, [(s,) for s in bursts(8000)]),
+    ]
+
+def build_vectors(directory):
+    vectors = []
+    for name, channels, rate, bits, frames in test_sounds():
+        wav_path = os.path.join(directory, name + ".wav")
+        write_wav(wav_path, channels, rate, bits, frames)
+
+        # compile_asset without the encode, to keep the samples the encoder was given
+        samples, wav_rate = compiler.parse_wav(wav_path)
+        samples = compiler.resample(samples, wav_rate, SAMPLE_RATE)
+        samples = compiler.normalize(compiler.trim_silence(samples, SAMPLE_RATE))
+        encoded, (predictor, step_index), _ = compiler.adpcm_encode(samples, compiler.best_initial_step_index(samples))
+        if compiler.compile_asset(wav_path, SAMPLE_RATE) != (len(samples), predictor, step_index, encoded):
+            raise ValueError(f"{name}: compile_asset encoded differently")
+
+        reference = reference_decode(encoded, len(samples), predictor, step_index)
+        vectors.append((name, samples, predictor, step_index, encoded, reference))
+    return vectors
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        print("Usage: python adpcm_vectors.py <output_file>")
+        sys.exit(1)
+
+    with tempfile.TemporaryDirectory() as directory:
+        vectors = build_vectors(directory)
+
+    with open(sys.argv[1], "wb") as f:
+        f.write(VECTORS_HEADER.pack(VECTORS_MAGIC, len(vectors)))
+        for name, samples, predictor, step_index, encoded, reference in vectors:
+            f.write(VECTOR_HEADER.pack(name.encode(), len(samples), predictor, step_index))
+            f.write(encoded)
+            f.write(struct.pack(f'<{len(reference)}h', *reference))
+            f.write(struct.pack(f'<{len(samples)}h', *samples))
+            print(f"{name}: {len(samples)} samples, {len(encoded)} bytes")
@@ -0,0 +1,78 @@
+import math
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "..", "components", "speaker"))
+import audio_asset_compiler as compiler
+
+# Fixture sounds for test_speaker_assets.c, packed by audio_asset_compiler.py exactly as the firmware build packs them.
+#   asset_fixtures.py <output_dir>
+# Writes the WAVs, audio_assets.h, and audio_assets_blob.c, which defines the _binary_audio_assets_bin_start/_end
+# symbols that target_add_binary_data gives the firmware. The blob is writable so the test can damage it.
+
+SAMPLE_RATE = 16000
+
+def write_wav(path, channels, rate, bits, frames):
+    if bits == 8:
+        data = bytes((max(-32768, min(32767, s)) >> 8) + 128 for frame in frames for s in frame)
+    else:
+        data = b''.join(struct.pack('<h', max(-32768, min(32767, s))) for frame in frames for s in frame)
+    block_align = channels * bits // 8
+    with open(path, "wb") as f:
+        f.write(b'RIFF' + struct.pack('<I', 36 + len(data)) + b'WAVE')
+        f.write(b'fmt ' + struct.pack('<IHHIIHH', 16, 1, channels, rate, rate * block_align, block_align, bits))
+        f.write(b'data' + struct.pack('<I', len(data)) + data)
+
+def tones(rate, seconds, components, silence_s=0.05):
+    pad = [0] * int(rate * silence_s)
+    body = [round(sum(level * math.sin(2 * math.pi * freq * i / rate) for freq, level in components))
+            for i in range(int(rate * seconds))]
+    return pad + body + pad
+
+# Name, channels, WAV rate, bits per sample, frames; test_speaker_assets.c expects these IDs, rates and lengths
+def fixture_sounds():
+    tone = tones(44100, 0.25, [(1000, 8000)])
+    return [
+        # 250 ms of 1 kHz between 50 ms of silence, on the right channel only
+        ("tone_stereo_44k", 2, 44100, 16, [(0, s) for s in tone]),
+        # The same bytes under another name, which the blob stores once
+        ("tone_stereo_44k_copy", 2, 44100, 16, [(0, s) for s in tone]),
+        # 1 kHz and 10 kHz; at 16 kHz the 10 kHz tone must be filtered out, not folded down to 6 kHz
+        ("two_tones_44k", 1, 44100, 16, [(s,) for s in tones(44100, 0.25, [(1000, 12000), (10000, 12000)])]),
+        # 100 ms of 440 Hz at 8 kHz in 8-bit, upsampled
+        ("tone_mono8_8k", 1, 8000, 8, [(s,) for s in tones(8000, 0.1, [(440, 20000)])]),
+    ]
+
+def write_embedded_blob(path, blob):
+    with open(path, "w") as f:
+        f.write("// audio_assets_blob.c\n\n")
+        f.write("// Generated by asset_fixtures.py\n")
+        f.write("__asm__(\n")
+        f.write('    "    .data\\n"\n')
+        f.write('    "    .balign 4\\n"\n')
+        f.write('    "    .global _binary_audio_assets_bin_start\\n"\n')
+        f.write('    "_binary_audio_assets_bin_start:\\n"\n')
+        for i in range(0, len(blob), 16):
+            f.write(f'    "    .byte {",".join(str(b) for b in blob[i : i + 16])}\\n"\n')
+        f.write('    "    .global _binary_audio_assets_bin_end\\n"\n')
+        f.write('    "_binary_audio_assets_bin_end:\\n"\n')
+        f.write('    "    .text\\n");\n')
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        print("Usage: python asset_fixtures.py <output_dir>")
+        sys.exit(1)
+
+    output_dir = sys.argv[1]
+    os.makedirs(output_dir, exist_ok=True)
+    wav_paths = []
+    for name, channels, rate, bits, frames in fixture_sounds():
+        wav_paths.append(os.path.join(output_dir, name + ".wav"))
+        write_wav(wav_paths[-1], channels, rate, bits, frames)
+
+    assets = [compiler.compile_asset(wav_path, SAMPLE_RATE) for wav_path in wav_paths]
+    blob, unique = compiler.build_blob(assets, SAMPLE_RATE)
+    compiler.generate_header(os.path.join(output_dir, "audio_assets.h"), wav_paths)
+    write_embedded_blob(os.path.join(output_dir, "audio_assets_blob.c"), blob)
+    print(f"{len(assets)} fixture sounds ({unique} unique), {len(blob)} bytes")
@@ -0,0 +1,98 @@
+// bench_earcon_synth.c
+//
+// Renders every earcon at the speaker's sample rate the way the mixer pulls it, in DMA-buffer-sized chunks: it must
+// last exactly speaker_earcon_samples, come out the same in chunks of any size, and be audible without reaching full
+// scale. The synthesis cost is reported per 1024-sample buffer and as a share of the time that buffer plays for, and
+// must stay far below real time.
+
+#include <stdlib.h>
+#include <string.h>
+#include "host_test.h"
+#include "speaker.h"
+#include "speaker_earcons.h"
+
+#define BUFFER_SAMPLES  1024
+#define ROUNDS          20000
+// Generous, so a loaded build machine does not fail the test; the figure printed is the one that matters
+#define MAX_SHARE_OF_REAL_TIME  0.05
+
+typedef struct {
+    const char* name;
+    const speaker_earcon_t* earcon;
+} named_earcon_t;
+
+static const named_earcon_t earcons[] = {
+    {"power_on", &speaker_earcon_power_on},
+    {"power_off", &speaker_earcon_power_off},
+    {"reading_taken", &speaker_earcon_reading_taken},
+};
+
+static size_t _render(const speaker_earcon_t* earcon, int16_t* out, size_t chunk) {
+    speaker_synth_t synth;
+    speaker_synth_start(&synth, earcon, SPEAKER_SAMPLE_RATE_HZ);
+    size_t rendered = 0;
+    while (!speaker_synth_done(&synth)) {
+        size_t n = speaker_synth_render(&synth, out + rendered, chunk);
+        if (n == 0) {
+            break;
+        }
+        rendered += n;
+    }
+    return rendered;
+}
+
+static void _check(const named_earcon_t* e) {
+    uint32_t expected = speaker_earcon_samples(e->earcon, SPEAKER_SAMPLE_RATE_HZ);
+    int16_t* whole    = malloc((expected + BUFFER_SAMPLES) * sizeof(int16_t));
+    int16_t* chunked  = malloc((expected + BUFFER_SAMPLES) * sizeof(int16_t));
+
+    CHECK_EQ_INT(_render(e->earcon, whole, BUFFER_SAMPLES), expected);
+    // An odd chunk size puts the chunk boundaries inside notes and their envelopes
+    CHECK_EQ_INT(_render(e->earcon, chunked, 37), expected);
+    CHECK(memcmp(whole, chunked, expected * sizeof(int16_t)) == 0);
+
+    int peak = 0;
+    for (uint32_t i = 0; i < expected; i++) {
+        peak = abs(whole[i]) > peak ? abs(whole[i]) : peak;
+    }
+    CHECK(peak > 1000 && peak < 32767);
+
+    printf("%-14s %2u notes, %5u samples (%u ms), peak %d\n", e->name, e->earcon->num_notes, expected,
+           expected * 1000 / SPEAKER_SAMPLE_RATE_HZ, peak);
+    free(whole);
+    free(chunked);
+}
+
+// Full buffers only, looping the earcon, so the figure is per buffer of sound
+static void _bench(const named_earcon_t* e) {
+    static int16_t buffer[BUFFER_SAMPLES];
+    speaker_synth_t synth;
+    speaker_synth_start(&synth, e->earcon, SPEAKER_SAMPLE_RATE_HZ);
+
+    uint64_t start = host_now_ns();
+    for (int r = 0; r < ROUNDS; r++) {
+        size_t filled = 0;
+        while (filled < BUFFER_SAMPLES) {
+            if (speaker_synth_done(&synth)) {
+                speaker_synth_start(&synth, e->earcon, SPEAKER_SAMPLE_RATE_HZ);
+            }
+            filled += speaker_synth_render(&synth, buffer + filled, BUFFER_SAMPLES - filled);
+        }
+    }
+    double us      = (double)(host_now_ns() - start) / ROUNDS / 1000;
+    double play_us = 1e6 * BUFFER_SAMPLES / SPEAKER_SAMPLE_RATE_HZ;
+
+    printf("%-14s %.2f us per %d-sample buffer, %.3f%% of the %.0f ms it plays for\n", e->name, us, BUFFER_SAMPLES,
+           100 * us / play_us, play_us / 1000);
+    CHECK(us < play_us * MAX_SHARE_OF_REAL_TIME);
+}
+
+int main(void) {
+    for (size_t e = 0; e < sizeof(earcons) / sizeof(earcons[0]); e++) {
+        _check(&earcons[e]);
+    }
+    for (size_t e = 0; e < sizeof(earcons) / sizeof(earcons[0]); e++) {
+        _bench(&earcons[e]);
+    }
+    return host_test_result("earcon_synth");
+}
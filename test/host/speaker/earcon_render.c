@@ -0,0 +1,112 @@
+// earcon_render.c
+//
+// Renders every earcon to a WAV file for review and times the synthesis; built with the host tests but not run by
+// them (bench_earcon_synth checks and times the same rendering).
+//   earcon_render [sample_rate_hz] [output_dir]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "speaker_earcons.h"
+
+#define RENDER_BUFFER 1024
+
+typedef struct {
+    const char* name;
+    const speaker_earcon_t* earcon;
+} named_earcon_t;
+
+static const named_earcon_t earcons[] = {
+    {"power_on", &speaker_earcon_power_on},
+    {"power_off", &speaker_earcon_power_off},
+    {"reading_taken", &speaker_earcon_reading_taken},
+};
+
+static void _put_u32(FILE* f, uint32_t v) {
+    uint8_t b[4] = {v & 0xFF, (v >> 8) & 0xFF, (v >> 16) & 0xFF, v >> 24};
+    fwrite(b, 1, 4, f);
+}
+
+static void _put_u16(FILE* f, uint16_t v) {
+    uint8_t b[2] = {v & 0xFF, v >> 8};
+    fwrite(b, 1, 2, f);
+}
+
+static int _write_wav(const char* path, const int16_t* samples, uint32_t num_samples, uint32_t sample_rate) {
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    fwrite("RIFF", 1, 4, f);
+    _put_u32(f, 36 + num_samples * 2);
+    fwrite("WAVEfmt ", 1, 8, f);
+    _put_u32(f, 16);
+    _put_u16(f, 1);
+    _put_u16(f, 1);
+    _put_u32(f, sample_rate);
+    _put_u32(f, sample_rate * 2);
+    _put_u16(f, 2);
+    _put_u16(f, 16);
+    fwrite("data", 1, 4, f);
+    _put_u32(f, num_samples * 2);
+    for (uint32_t i = 0; i < num_samples; i++) {
+        _put_u16(f, (uint16_t)samples[i]);
+    }
+    return fclose(f);
+}
+
+static double _now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+int main(int argc, char** argv) {
+    uint32_t sample_rate = argc > 1 ? (uint32_t)atoi(argv[1]) : 16000;
+    const char* out_dir  = argc > 2 ? argv[2] : ".";
+
+    for (size_t e = 0; e < sizeof(earcons) / sizeof(earcons[0]); e++) {
+        uint32_t total   = speaker_earcon_samples(earcons[e].earcon, sample_rate);
+        int16_t* samples = malloc((total + RENDER_BUFFER) * sizeof(int16_t));
+        if (!samples) {
+            return 1;
+        }
+
+        speaker_synth_t synth;
+        speaker_synth_start(&synth, earcons[e].earcon, sample_rate);
+        uint32_t rendered = 0;
+        while (!speaker_synth_done(&synth)) {
+            rendered += speaker_synth_render(&synth, samples + rendered, RENDER_BUFFER);
+        }
+
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s.wav", out_dir, earcons[e].name);
+        if (_write_wav(path, samples, rendered, sample_rate) != 0) {
+            free(samples);
+            return 1;
+        }
+
+        // Full buffers only, looping the earcon, so the figure is per 1024 samples of sound
+        static int16_t buffer[RENDER_BUFFER];
+        const int rounds = 20000;
+        double start     = _now_ns();
+        for (int r = 0; r < rounds; r++) {
+            size_t filled = 0;
+            while (filled < RENDER_BUFFER) {
+                if (speaker_synth_done(&synth)) {
+                    speaker_synth_start(&synth, earcons[e].earcon, sample_rate);
+                }
+                filled += speaker_synth_render(&synth, buffer + filled, RENDER_BUFFER - filled);
+            }
+        }
+        double per_buffer_us = (_now_ns() - start) / rounds / 1000;
+
+        printf("%-14s %2u notes, %zu bytes of notes, %5u samples (%u ms) -> %s, %.2f us per %d-sample buffer\n",
+               earcons[e].name, earcons[e].earcon->num_notes, earcons[e].earcon->num_notes * sizeof(speaker_note_t),
+               rendered, rendered * 1000 / sample_rate, path, per_buffer_us, RENDER_BUFFER);
+        free(samples);
+    }
+    return 0;
+}
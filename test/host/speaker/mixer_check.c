@@ -0,0 +1,248 @@
+// mixer_check.c
+//
+// Checks speaker_mixer.c against a straightforward reference mix and times it. Voices that overflow must pin the DAC
+// at 0 or 255 instead of wrapping, a mix of ADPCM and earcon voices at different gains must equal the saturated sum
+// of the voices rendered on their own, a voice that ends mid-buffer must leave silence, and voice stealing must
+// follow the priorities. Exits non-zero on any failure.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "speaker_earcons.h"
+#include "speaker_mixer.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// One DMA buffer
+#define BUFFER_SAMPLES  1024
+#define STREAM_SAMPLES  (16 * BUFFER_SAMPLES)
+
+static int failures = 0;
+
+#define EXPECT(cond)                                                         \
+    do {                                                                     \
+        if (!(cond)) {                                                       \
+            printf("%s:%d: expected %s\n", __FILE__, __LINE__, #cond);       \
+            failures++;                                                      \
+        }                                                                    \
+    } while (0)
+
+static double _now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static uint64_t _cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// With the smallest step a zero nibble adds nothing, so all-zero data holds the initial predictor
+static speaker_sound_t _constant(const uint8_t* zeros, uint32_t num_samples, int16_t level) {
+    speaker_sound_t sound = {
+        .data = zeros, .num_samples = num_samples, .initial_predictor = level, .initial_step_index = 0};
+    return sound;
+}
+
+// Any byte string is a valid stream; random nibbles give a busy signal that keeps the step size moving
+static speaker_sound_t _random(uint8_t* data, uint32_t num_samples, uint32_t seed) {
+    for (uint32_t i = 0; i < (num_samples + 1) / 2; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        data[i] = (uint8_t)seed;
+    }
+    speaker_sound_t sound = {
+        .data = data, .num_samples = num_samples, .initial_predictor = 0, .initial_step_index = 40};
+    return sound;
+}
+
+static bool _all(const uint8_t* out, size_t n, uint8_t value) {
+    for (size_t i = 0; i < n; i++) {
+        if (out[i] != value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void _check_clipping(const uint8_t* zeros) {
+    speaker_mixer_t mixer;
+    uint8_t out[BUFFER_SAMPLES];
+
+    speaker_sound_t loud = _constant(zeros, BUFFER_SAMPLES, 30000);
+    speaker_mixer_init(&mixer, NULL, NULL);
+    speaker_mixer_play(&mixer, &loud, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_NORMAL, 0);
+    speaker_mixer_play(&mixer, &loud, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_NORMAL, 1);
+    speaker_mixer_render(&mixer, out, BUFFER_SAMPLES);
+    EXPECT(_all(out, BUFFER_SAMPLES, 255));
+    EXPECT(mixer.stats.clipped_samples == BUFFER_SAMPLES);
+
+    speaker_sound_t low = _constant(zeros, BUFFER_SAMPLES, -30000);
+    speaker_mixer_init(&mixer, NULL, NULL);
+    for (int v = 0; v < SPEAKER_MIXER_VOICES; v++) {
+        speaker_mixer_play(&mixer, &low, SPEAKER_GAIN_MAX, SPEAKER_PRIORITY_NORMAL, v);
+    }
+    speaker_mixer_render(&mixer, out, BUFFER_SAMPLES);
+    EXPECT(_all(out, BUFFER_SAMPLES, 0));
+    EXPECT(mixer.stats.clipped_samples == BUFFER_SAMPLES);
+
+    speaker_mixer_init(&mixer, NULL, NULL);
+    speaker_mixer_play(&mixer, &loud, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_NORMAL, 0);
+    speaker_mixer_play(&mixer, &low, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_NORMAL, 1);
+    speaker_mixer_render(&mixer, out, BUFFER_SAMPLES);
+    EXPECT(_all(out, BUFFER_SAMPLES, 128));
+    EXPECT(mixer.stats.clipped_samples == 0);
+}
+
+// Two ADPCM voices and an earcon at gains 1, 0.5 and 1.5 against each voice decoded on its own and summed
+static void _check_gains(uint8_t* data) {
+    static int16_t decoded[2][STREAM_SAMPLES], synthesized[STREAM_SAMPLES];
+    static uint8_t out[STREAM_SAMPLES];
+    const uint16_t gains[3] = {SPEAKER_GAIN_UNITY, SPEAKER_GAIN_UNITY / 2, SPEAKER_GAIN_UNITY * 3 / 2};
+
+    speaker_sound_t sounds[2];
+    for (int s = 0; s < 2; s++) {
+        sounds[s]           = _random(data + s * STREAM_SAMPLES / 2, STREAM_SAMPLES, 0x1234u + s);
+        adpcm_state_t state = {sounds[s].initial_predictor, sounds[s].initial_step_index};
+        adpcm_decode(&state, sounds[s].data, STREAM_SAMPLES, decoded[s]);
+    }
+    speaker_synth_t synth;
+    speaker_synth_start(&synth, &speaker_earcon_power_on, SPEAKER_SAMPLE_RATE_HZ);
+    size_t earcon_samples = speaker_synth_render(&synth, synthesized, STREAM_SAMPLES);
+
+    speaker_mixer_t mixer;
+    speaker_mixer_init(&mixer, NULL, NULL);
+    speaker_mixer_play(&mixer, &sounds[0], gains[0], SPEAKER_PRIORITY_NORMAL, 0);
+    speaker_mixer_play(&mixer, &sounds[1], gains[1], SPEAKER_PRIORITY_NORMAL, 1);
+    speaker_mixer_play_earcon(&mixer, &speaker_earcon_power_on, gains[2], SPEAKER_PRIORITY_NORMAL, 2);
+    for (size_t done = 0; done < STREAM_SAMPLES; done += BUFFER_SAMPLES) {
+        speaker_mixer_render(&mixer, out + done, BUFFER_SAMPLES);
+    }
+
+    size_t mismatches = 0, clipped = 0;
+    for (size_t i = 0; i < STREAM_SAMPLES; i++) {
+        int32_t sum = decoded[0][i] * gains[0] + decoded[1][i] * gains[1];
+        sum += i < earcon_samples ? synthesized[i] * gains[2] : 0;
+        sum >>= 8;
+        if (sum > INT16_MAX || sum < INT16_MIN) {
+            clipped++;
+            sum = sum > INT16_MAX ? INT16_MAX : INT16_MIN;
+        }
+        mismatches += out[i] != (uint8_t)((sum >> 8) + 128);
+    }
+    printf("three voices at gains 1, 0.5, 1.5: %zu samples, %zu saturated, %zu differ from the reference sum\n",
+           (size_t)STREAM_SAMPLES, clipped, mismatches);
+    EXPECT(mismatches == 0);
+    EXPECT(mixer.stats.clipped_samples == clipped);
+}
+
+static void _check_end_mid_buffer(const uint8_t* zeros) {
+    speaker_mixer_t mixer;
+    uint8_t out[BUFFER_SAMPLES];
+    speaker_sound_t sound = _constant(zeros, 300, 16384);
+
+    speaker_mixer_init(&mixer, NULL, NULL);
+    speaker_mixer_play(&mixer, &sound, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_NORMAL, 0);
+    EXPECT(speaker_mixer_render(&mixer, out, BUFFER_SAMPLES) == 0);
+    EXPECT(_all(out, 300, 128 + 64));
+    EXPECT(_all(out + 300, BUFFER_SAMPLES - 300, 128));
+}
+
+typedef struct {
+    uint32_t tag;
+    bool played;
+    int calls;
+} done_log_t;
+
+static void _on_done(uint32_t tag, bool played, void* arg) {
+    done_log_t* log = arg;
+    log->tag        = tag;
+    log->played     = played;
+    log->calls++;
+}
+
+static void _check_priorities(const uint8_t* zeros) {
+    speaker_mixer_t mixer;
+    done_log_t log = {0};
+    speaker_sound_t sound = _constant(zeros, BUFFER_SAMPLES, 0);
+
+    speaker_mixer_init(&mixer, _on_done, &log);
+    for (int v = 0; v < SPEAKER_MIXER_VOICES; v++) {
+        EXPECT(speaker_mixer_play(&mixer, &sound, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_NORMAL, 10 + v) == ESP_OK);
+    }
+    // Every voice outranks a low-priority sound
+    EXPECT(speaker_mixer_play(&mixer, &sound, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_LOW, 20) == ESP_ERR_NO_MEM);
+    EXPECT(mixer.stats.rejects == 1 && log.calls == 0);
+
+    // An equal one steals the oldest voice, which is reported as not played
+    EXPECT(speaker_mixer_play(&mixer, &sound, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_NORMAL, 21) == ESP_OK);
+    EXPECT(mixer.stats.steals == 1 && log.calls == 1 && log.tag == 10 && !log.played);
+
+    EXPECT(speaker_mixer_play(&mixer, &sound, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_HIGH, 22) == ESP_OK);
+    EXPECT(log.tag == 11);
+    // The high-priority voice is now the only one a normal sound cannot take
+    for (int i = 0; i < SPEAKER_MIXER_VOICES; i++) {
+        speaker_mixer_play(&mixer, &sound, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_NORMAL, 30 + i);
+    }
+    bool high_kept = false;
+    for (int v = 0; v < SPEAKER_MIXER_VOICES; v++) {
+        high_kept |= mixer.voices[v].active && mixer.voices[v].tag == 22;
+    }
+    EXPECT(high_kept);
+}
+
+// Full buffers of ADPCM voices, restarting any that run out so every buffer mixes the same number
+static void _bench(uint8_t* data) {
+    static uint8_t out[BUFFER_SAMPLES];
+    speaker_sound_t sounds[SPEAKER_MIXER_VOICES];
+    for (int s = 0; s < SPEAKER_MIXER_VOICES; s++) {
+        sounds[s] = _random(data + s * STREAM_SAMPLES / 2, STREAM_SAMPLES, 0x9E37u + s);
+    }
+
+    for (int voices = 1; voices <= SPEAKER_MIXER_VOICES; voices *= 2) {
+        speaker_mixer_t mixer;
+        speaker_mixer_init(&mixer, NULL, NULL);
+        const int rounds = 5000;
+
+        double start        = _now_ns();
+        uint64_t start_tick = _cycles();
+        for (int r = 0; r < rounds; r++) {
+            for (size_t v = speaker_mixer_active_voices(&mixer); v < (size_t)voices; v++) {
+                speaker_mixer_play(&mixer, &sounds[v], SPEAKER_GAIN_UNITY / 2, SPEAKER_PRIORITY_NORMAL, v);
+            }
+            speaker_mixer_render(&mixer, out, BUFFER_SAMPLES);
+        }
+        uint64_t ticks = _cycles() - start_tick;
+        double us      = (_now_ns() - start) / rounds / 1000;
+        double play_us = 1e6 * BUFFER_SAMPLES / SPEAKER_SAMPLE_RATE_HZ;
+
+        printf("%d voice(s): %.1f us per %d-sample buffer", voices, us, BUFFER_SAMPLES);
+        if (ticks) {
+            printf(", %.0f TSC cycles per output sample", (double)ticks / ((double)rounds * BUFFER_SAMPLES));
+        }
+        printf(", %.3f%% of the %.0f ms it plays for\n", 100 * us / play_us, play_us / 1000);
+    }
+}
+
+int main(void) {
+    uint8_t* zeros = calloc(STREAM_SAMPLES / 2, 1);
+    uint8_t* data  = malloc(SPEAKER_MIXER_VOICES * STREAM_SAMPLES / 2);
+
+    _check_clipping(zeros);
+    _check_gains(data);
+    _check_end_mid_buffer(zeros);
+    _check_priorities(zeros);
+    _bench(data);
+
+    free(data);
+    free(zeros);
+    printf("%s\n", failures ? "FAILED" : "mixer matches the reference");
+    return failures ? 1 : 0;
+}
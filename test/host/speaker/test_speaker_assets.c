@@ -0,0 +1,191 @@
+// test_speaker_assets.c
+//
+// Looks up the fixture sounds from asset_fixtures.py through speaker_assets.c and decodes them with adpcm.c, checking
+// what audio_asset_compiler.py did to them: stereo averaged to mono, resampled to 16 kHz without aliasing, silence
+// trimmed to a 2 ms margin, normalized to -1 dBFS, and identical streams stored once. Then damages the blob in place
+// to check that speaker_assets_get rejects out-of-range IDs, blobs of another version, rate or sound count, and index
+// entries that point past the end.
+
+#include <math.h>
+#include <stdlib.h>
+#include "adpcm.h"
+#include "audio_assets.h"
+#include "host_test.h"
+#include "speaker_assets.h"
+
+// Defined by the generated audio_assets_blob.c, writable there
+extern uint8_t _binary_audio_assets_bin_start[];
+extern uint8_t _binary_audio_assets_bin_end[];
+
+#define MARGIN_SAMPLES  (SPEAKER_SAMPLE_RATE_HZ * 2 / 1000)
+// round(32767 * 10^(-1/20)); ADPCM overshoots peaks by up to about one step
+#define PEAK_TARGET     29204
+#define PEAK_TOLERANCE  2048
+
+static int16_t* _decode(const speaker_sound_t* sound) {
+    int16_t* out        = malloc(sound->num_samples * sizeof(int16_t));
+    adpcm_state_t state = {sound->initial_predictor, sound->initial_step_index};
+    adpcm_decode(&state, sound->data, sound->num_samples, out);
+    return out;
+}
+
+static int _peak(const int16_t* samples, uint32_t n) {
+    int peak = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        peak = abs(samples[i]) > peak ? abs(samples[i]) : peak;
+    }
+    return peak;
+}
+
+// With hysteresis, so ADPCM noise around zero in the trimmed margins does not count
+static uint32_t _zero_crossings(const int16_t* samples, uint32_t n) {
+    uint32_t crossings = 0;
+    int sign           = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        int now = samples[i] > 4000 ? 1 : samples[i] < -4000 ? -1 : sign;
+        crossings += sign != 0 && now != sign;
+        sign = now;
+    }
+    return crossings;
+}
+
+// Amplitude of one frequency, by the Goertzel algorithm
+static double _level(const int16_t* samples, uint32_t n, double freq_hz) {
+    double coeff = 2 * cos(2 * M_PI * freq_hz / SPEAKER_SAMPLE_RATE_HZ);
+    double s1 = 0, s2 = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        double s0 = samples[i] + coeff * s1 - s2;
+        s2        = s1;
+        s1        = s0;
+    }
+    return sqrt(s1 * s1 + s2 * s2 - coeff * s1 * s2) * 2 / n;
+}
+
+static void _check_length(const char* name, uint32_t num_samples, double seconds) {
+    uint32_t expected = (uint32_t)(seconds * SPEAKER_SAMPLE_RATE_HZ) + 2 * MARGIN_SAMPLES;
+    printf("%s: %u samples, expected about %u\n", name, num_samples, expected);
+    // The resampler's ringing reaches a few samples into the silence either side
+    CHECK(num_samples + 4 >= expected && num_samples <= expected + 24);
+}
+
+static void test_tone(void) {
+    speaker_sound_t sound, copy;
+    CHECK(speaker_assets_get(SPEAKER_SOUND_TONE_STEREO_44K, &sound) == ESP_OK);
+    CHECK(speaker_assets_get(SPEAKER_SOUND_TONE_STEREO_44K_COPY, &copy) == ESP_OK);
+    CHECK(copy.data == sound.data && copy.num_samples == sound.num_samples);
+
+    // Only on the right channel in the WAV, so a dropped channel would leave nothing here
+    _check_length("tone_stereo_44k", sound.num_samples, 0.25);
+    int16_t* decoded = _decode(&sound);
+    int peak         = _peak(decoded, sound.num_samples);
+    CHECK(abs(peak - PEAK_TARGET) <= PEAK_TOLERANCE);
+    // 1 kHz for 250 ms
+    uint32_t crossings = _zero_crossings(decoded, sound.num_samples);
+    CHECK(crossings >= 497 && crossings <= 501);
+    free(decoded);
+}
+
+static void test_anti_aliasing(void) {
+    speaker_sound_t sound;
+    CHECK(speaker_assets_get(SPEAKER_SOUND_TWO_TONES_44K, &sound) == ESP_OK);
+    _check_length("two_tones_44k", sound.num_samples, 0.25);
+
+    int16_t* decoded = _decode(&sound);
+    double kept      = _level(decoded, sound.num_samples, 1000);
+    double folded    = _level(decoded, sound.num_samples, 6000);
+    printf("two_tones_44k: 1 kHz at %.0f, its 10 kHz partner folded to 6 kHz at %.1f (%.0f dB down)\n", kept, folded,
+           20 * log10(kept / (folded > 0 ? folded : 1e-9)));
+    CHECK(kept > 20000);
+    CHECK(folded < kept / 100);
+    free(decoded);
+}
+
+static void test_upsampled_8bit(void) {
+    speaker_sound_t sound;
+    CHECK(speaker_assets_get(SPEAKER_SOUND_TONE_MONO8_8K, &sound) == ESP_OK);
+    _check_length("tone_mono8_8k", sound.num_samples, 0.1);
+
+    int16_t* decoded = _decode(&sound);
+    CHECK(abs(_peak(decoded, sound.num_samples) - PEAK_TARGET) <= PEAK_TOLERANCE);
+    // 440 Hz for 100 ms
+    uint32_t crossings = _zero_crossings(decoded, sound.num_samples);
+    CHECK(crossings >= 86 && crossings <= 89);
+    free(decoded);
+}
+
+static void test_bounds(void) {
+    speaker_sound_t sound;
+    CHECK(speaker_assets_get(SPEAKER_SOUND_MAX, &sound) == ESP_ERR_NOT_FOUND);
+    CHECK(speaker_assets_get(UINT16_MAX, &sound) == ESP_ERR_NOT_FOUND);
+
+    size_t blob_len = _binary_audio_assets_bin_end - _binary_audio_assets_bin_start;
+    for (int id = 0; id < SPEAKER_SOUND_MAX; id++) {
+        CHECK(speaker_assets_get(id, &sound) == ESP_OK);
+        CHECK(sound.data > _binary_audio_assets_bin_start &&
+              sound.data + (sound.num_samples + 1) / 2 <= _binary_audio_assets_bin_end);
+    }
+    printf("%d sounds in a %zu-byte blob\n", SPEAKER_SOUND_MAX, blob_len);
+}
+
+// Each damage is undone before the next
+static void test_rejects_other_blobs(void) {
+    speaker_assets_header_t* header = (speaker_assets_header_t*)_binary_audio_assets_bin_start;
+    speaker_assets_header_t saved   = *header;
+    speaker_sound_t sound;
+
+    header->magic = 0x56415721;
+    CHECK(speaker_assets_get(0, &sound) == ESP_ERR_INVALID_VERSION);
+    *header = saved;
+
+    header->version = SPEAKER_ASSETS_VERSION + 1;
+    CHECK(speaker_assets_get(0, &sound) == ESP_ERR_INVALID_VERSION);
+    *header = saved;
+
+    header->sample_rate = 44100;
+    CHECK(speaker_assets_get(0, &sound) == ESP_ERR_INVALID_VERSION);
+    *header = saved;
+
+    // Built from a different sound list than audio_assets.h
+    header->count = SPEAKER_SOUND_MAX + 1;
+    CHECK(speaker_assets_get(0, &sound) == ESP_ERR_INVALID_VERSION);
+    *header = saved;
+
+    CHECK(speaker_assets_get(0, &sound) == ESP_OK);
+}
+
+static void test_rejects_bad_entries(void) {
+    speaker_assets_entry_t* entries = (speaker_assets_entry_t*)(_binary_audio_assets_bin_start +
+                                                                sizeof(speaker_assets_header_t));
+    size_t blob_len = _binary_audio_assets_bin_end - _binary_audio_assets_bin_start;
+    speaker_sound_t sound;
+
+    // The stream stored last ends exactly at the end of the blob
+    int last = 0;
+    for (int id = 1; id < SPEAKER_SOUND_MAX; id++) {
+        last = entries[id].offset > entries[last].offset ? id : last;
+    }
+    speaker_assets_entry_t saved = entries[last];
+    CHECK_EQ_INT(saved.offset + (saved.num_samples + 1) / 2, blob_len);
+
+    entries[last].num_samples = saved.num_samples + 2;
+    CHECK(speaker_assets_get(last, &sound) == ESP_ERR_INVALID_SIZE);
+    entries[last].num_samples = UINT32_MAX;
+    CHECK(speaker_assets_get(last, &sound) == ESP_ERR_INVALID_SIZE);
+    entries[last] = saved;
+
+    entries[last].offset = (uint32_t)blob_len + 1;
+    CHECK(speaker_assets_get(last, &sound) == ESP_ERR_INVALID_SIZE);
+    entries[last] = saved;
+
+    CHECK(speaker_assets_get(last, &sound) == ESP_OK);
+}
+
+int main(void) {
+    test_tone();
+    test_anti_aliasing();
+    test_upsampled_8bit();
+    test_bounds();
+    test_rejects_other_blobs();
+    test_rejects_bad_entries();
+    return host_test_result("speaker_assets");
+}
@@ -0,0 +1,408 @@
+// test_speaker_driver.cpp
+//
+// Runs the speaker task and driver on a simulated DAC. A player thread stands in for the DMA: it plays the descriptor
+// ring in real time, records every sample, and calls on_convert_done from "the interrupt" as each buffer finishes. Like
+// the ESP-IDF 5.x driver, dac_continuous_start_async_writing zeroes every buffer and starts on the first, and misuse
+// of the driver (writing while stopped, deleting while enabled) is counted. The checks:
+//   - a cold start and a re-power each play a ramp up to silence and then the sound, sample for sample as an offline
+//     mixer renders it, with nothing lost
+//   - completion callbacks report played for sounds that played out, not played for stolen and stopped ones
+//   - the DAC powers down SPEAKER_IDLE_TIMEOUT_MS after the last sound, and is released when switched off
+//   - a task that misses its refills shows up as DMA underruns, and none happen otherwise
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "driver/dac_continuous.h"
+#include "esp_timer.h"
+#include "host_test.h"
+#include "speaker_earcons.h"
+#include "speaker_task.hpp"
+
+#if CONFIG_DAC_DMA_AUTO_16BIT_ALIGN
+#define SIM_BYTES_PER_SAMPLE 2
+#else
+#define SIM_BYTES_PER_SAMPLE 1
+#endif
+
+struct dac_continuous_s {
+    dac_continuous_config_t config;
+    std::vector<std::vector<uint8_t>> bufs;
+    dac_event_callbacks_t callbacks;
+    void* user_data;
+    bool enabled;
+    bool async;
+    bool stopping;
+    std::condition_variable changed;
+    std::thread player;
+};
+
+static struct {
+    std::mutex lock;
+    std::vector<uint8_t> played;
+    // Index into played where each start_async_writing began
+    std::vector<size_t> starts;
+    std::vector<int64_t> disable_us;
+    int64_t last_audible_us;
+    int deletes;
+    int misuse;
+} sim;
+
+static void _misuse(const char* what) {
+    fprintf(stderr, "simulated DAC: %s\n", what);
+    sim.misuse++;
+}
+
+static void _play(dac_continuous_handle_t handle) {
+    size_t samples = handle->config.buf_size / SIM_BYTES_PER_SAMPLE;
+    auto period    = std::chrono::microseconds(1000000ull * samples / handle->config.freq_hz);
+    auto next      = std::chrono::steady_clock::now();
+    for (size_t desc = 0;; desc = (desc + 1) % handle->bufs.size()) {
+        next += period;
+        {
+            std::unique_lock<std::mutex> guard(sim.lock);
+            if (handle->changed.wait_until(guard, next, [&] { return handle->stopping; })) {
+                return;
+            }
+            bool audible = false;
+            for (size_t i = 0; i < samples; i++) {
+                uint8_t sample = handle->bufs[desc][i * SIM_BYTES_PER_SAMPLE + SIM_BYTES_PER_SAMPLE - 1];
+                audible |= sample != SPEAKER_DAC_SILENCE;
+                sim.played.push_back(sample);
+            }
+            if (audible) {
+                sim.last_audible_us = esp_timer_get_time();
+            }
+        }
+        dac_event_data_t event = {handle->bufs[desc].data(), handle->config.buf_size, handle->config.buf_size};
+        handle->callbacks.on_convert_done(handle, &event, handle->user_data);
+    }
+}
+
+extern "C" {
+
+esp_err_t dac_continuous_new_channels(const dac_continuous_config_t* config, dac_continuous_handle_t* ret_handle) {
+    auto handle    = new dac_continuous_s{};
+    handle->config = *config;
+    handle->bufs.assign(config->desc_num, std::vector<uint8_t>(config->buf_size));
+    *ret_handle = handle;
+    return ESP_OK;
+}
+
+esp_err_t dac_continuous_del_channels(dac_continuous_handle_t handle) {
+    std::lock_guard<std::mutex> guard(sim.lock);
+    if (handle->enabled) {
+        _misuse("deleted while enabled");
+        return ESP_ERR_INVALID_STATE;
+    }
+    sim.deletes++;
+    delete handle;
+    return ESP_OK;
+}
+
+esp_err_t dac_continuous_enable(dac_continuous_handle_t handle) {
+    std::lock_guard<std::mutex> guard(sim.lock);
+    if (handle->enabled) {
+        _misuse("enabled twice");
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t dac_continuous_disable(dac_continuous_handle_t handle) {
+    std::lock_guard<std::mutex> guard(sim.lock);
+    if (!handle->enabled || handle->async) {
+        _misuse("disabled while stopped or running");
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->enabled = false;
+    sim.disable_us.push_back(esp_timer_get_time());
+    return ESP_OK;
+}
+
+esp_err_t dac_continuous_register_event_callback(dac_continuous_handle_t handle,
+                                                 const dac_event_callbacks_t* callbacks, void* user_data) {
+    std::lock_guard<std::mutex> guard(sim.lock);
+    if (handle->enabled) {
+        _misuse("callback registered while enabled");
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->callbacks = *callbacks;
+    handle->user_data = user_data;
+    return ESP_OK;
+}
+
+// As in ESP-IDF, every buffer is cleared before the ring is linked and the DMA starts on the first
+esp_err_t dac_continuous_start_async_writing(dac_continuous_handle_t handle) {
+    std::lock_guard<std::mutex> guard(sim.lock);
+    if (!handle->enabled || handle->async || handle->callbacks.on_convert_done == nullptr) {
+        _misuse("started while disabled, running or without a callback");
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (auto& buf : handle->bufs) {
+        std::fill(buf.begin(), buf.end(), 0);
+    }
+    handle->async    = true;
+    handle->stopping = false;
+    sim.starts.push_back(sim.played.size());
+    handle->player = std::thread(_play, handle);
+    return ESP_OK;
+}
+
+esp_err_t dac_continuous_stop_async_writing(dac_continuous_handle_t handle) {
+    {
+        std::lock_guard<std::mutex> guard(sim.lock);
+        if (!handle->async) {
+            _misuse("stopped while not running");
+            return ESP_ERR_INVALID_STATE;
+        }
+        handle->stopping = true;
+        handle->changed.notify_all();
+    }
+    handle->player.join();
+    std::lock_guard<std::mutex> guard(sim.lock);
+    handle->async = false;
+    return ESP_OK;
+}
+
+esp_err_t dac_continuous_write_asynchronously(dac_continuous_handle_t handle, uint8_t* dma_buf, size_t dma_buf_len,
+                                              const uint8_t* data, size_t data_len, size_t* bytes_loaded) {
+    std::lock_guard<std::mutex> guard(sim.lock);
+    bool known = false;
+    for (auto& buf : handle->bufs) {
+        known |= buf.data() == dma_buf && buf.size() == dma_buf_len;
+    }
+    if (!handle->async || !known) {
+        _misuse("wrote while stopped or to an unknown buffer");
+        return ESP_ERR_INVALID_STATE;
+    }
+    size_t count = std::min(data_len, dma_buf_len / SIM_BYTES_PER_SAMPLE);
+    for (size_t i = 0; i < count; i++) {
+        dma_buf[i * SIM_BYTES_PER_SAMPLE + SIM_BYTES_PER_SAMPLE - 1] = data[i];
+    }
+    *bytes_loaded = count;
+    return ESP_OK;
+}
+
+}
+
+struct Completion {
+    speaker_handle_t handle;
+    bool played;
+};
+
+static std::mutex completions_lock;
+static std::vector<Completion> completions;
+static std::atomic<uint32_t> stall_ms{0};
+
+static void on_done(speaker_handle_t handle, bool played, void* arg) {
+    {
+        std::lock_guard<std::mutex> guard(completions_lock);
+        completions.push_back({handle, played});
+    }
+    // Holds up the speaker task, as a misbehaving callback would
+    uint32_t stall = stall_ms.exchange(0);
+    if (stall) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(stall));
+    }
+}
+
+template <typename Predicate>
+static bool wait_for(Predicate done, uint32_t timeout_ms) {
+    int64_t deadline = esp_timer_get_time() + timeout_ms * 1000ll;
+    while (!done()) {
+        if (esp_timer_get_time() > deadline) {
+            return false;
+        }
+        vTaskDelay(1);
+    }
+    return true;
+}
+
+static size_t completions_count() {
+    std::lock_guard<std::mutex> guard(completions_lock);
+    return completions.size();
+}
+
+static size_t disables() {
+    std::lock_guard<std::mutex> guard(sim.lock);
+    return sim.disable_us.size();
+}
+
+static std::vector<uint8_t> offline_render(const speaker_earcon_t* earcon, uint16_t gain, speaker_priority_t priority) {
+    static speaker_mixer_t mixer;
+    speaker_mixer_init(&mixer, nullptr, nullptr);
+    speaker_mixer_play_earcon(&mixer, earcon, gain, priority, 0);
+    std::vector<uint8_t> out;
+    uint8_t block[SPEAKER_DMA_BUF_SIZE / SIM_BYTES_PER_SAMPLE];
+    while (speaker_mixer_active_voices(&mixer) > 0) {
+        speaker_mixer_render(&mixer, block, sizeof(block));
+        out.insert(out.end(), block, block + sizeof(block));
+    }
+    return out;
+}
+
+// From the start-th DMA start: zero_buffers of the driver's cleared buffers, one buffer rising from 0 to silence,
+// then the sound exactly, then silence until the DMA stopped
+static void check_power_up(size_t start, size_t zero_buffers, const std::vector<uint8_t>& sound, const char* what) {
+    std::lock_guard<std::mutex> guard(sim.lock);
+    const size_t buffer = SPEAKER_DMA_BUF_SIZE / SIM_BYTES_PER_SAMPLE;
+    if (start >= sim.starts.size()) {
+        CHECK(start < sim.starts.size());
+        return;
+    }
+    size_t at  = sim.starts[start];
+    size_t end = start + 1 < sim.starts.size() ? sim.starts[start + 1] : sim.played.size();
+    if (end - at < (zero_buffers + 1) * buffer + sound.size()) {
+        fprintf(stderr, "%s: only %zu samples played\n", what, end - at);
+        CHECK(end - at >= (zero_buffers + 1) * buffer + sound.size());
+        return;
+    }
+    const uint8_t* p = sim.played.data() + at;
+
+    size_t nonzero = 0;
+    for (size_t i = 0; i < zero_buffers * buffer; i++) {
+        nonzero += p[i] != 0;
+    }
+    CHECK_EQ_INT(nonzero, 0);
+    p += zero_buffers * buffer;
+
+    int max_step = 0;
+    bool falls   = false;
+    for (size_t i = 1; i < buffer; i++) {
+        max_step = std::max(max_step, p[i] - p[i - 1]);
+        falls |= p[i] < p[i - 1];
+    }
+    CHECK_EQ_INT(p[0], 0);
+    CHECK_EQ_INT(p[buffer - 1], SPEAKER_DAC_SILENCE);
+    CHECK(max_step <= 1 && !falls);
+    p += buffer;
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < sound.size(); i++) {
+        mismatches += p[i] != sound[i];
+    }
+    size_t after = 0;
+    for (const uint8_t* q = p + sound.size(); q < sim.played.data() + end; q++) {
+        after += *q != SPEAKER_DAC_SILENCE;
+    }
+    CHECK_EQ_INT(mismatches, 0);
+    CHECK_EQ_INT(after, 0);
+    printf("%s: %zu-sample lead-in after %zu zeroed buffers, then %zu samples bit-exact\n", what, buffer, zero_buffers,
+           sound.size());
+}
+
+static void test_cold_start(Speaker* speaker) {
+    CHECK(speaker->start_task(5, 4096) == ESP_OK);
+    speaker->toggle_power();
+    CHECK(wait_for([] { return disables() == 1; }, 5000));
+
+    // Nothing is known of the buffers yet, so the first ring plays as the driver zeroed it
+    check_power_up(0, SPEAKER_DMA_DESC_NUM, offline_render(&speaker_earcon_power_on, SPEAKER_GAIN_UNITY,
+                                                           SPEAKER_PRIORITY_HIGH), "cold start");
+
+    std::lock_guard<std::mutex> guard(sim.lock);
+    int64_t idle_ms = (sim.disable_us[0] - sim.last_audible_us) / 1000;
+    printf("powered down %lld ms after the last audible buffer\n", (long long)idle_ms);
+    CHECK(idle_ms >= SPEAKER_IDLE_TIMEOUT_MS - 4 * 32 && idle_ms <= SPEAKER_IDLE_TIMEOUT_MS + 250);
+}
+
+static void test_repower(Speaker* speaker) {
+    speaker_handle_t handle =
+        speaker->play_earcon(&speaker_earcon_reading_taken, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_NORMAL, on_done);
+    CHECK(handle != SPEAKER_HANDLE_INVALID);
+    CHECK(!speaker->is_done(handle));
+    CHECK(wait_for([] { return completions_count() == 1; }, 2000));
+    CHECK(speaker->is_done(handle));
+    {
+        std::lock_guard<std::mutex> guard(completions_lock);
+        CHECK(completions[0].handle == handle && completions[0].played);
+    }
+
+    CHECK(wait_for([] { return disables() == 2; }, 5000));
+    check_power_up(1, 0, offline_render(&speaker_earcon_reading_taken, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_NORMAL),
+                   "re-power");
+}
+
+// With every voice busy, a more important sound steals the oldest of the least important
+static void test_steal(Speaker* speaker) {
+    size_t before = completions_count();
+    speaker_handle_t low[SPEAKER_MIXER_VOICES];
+    for (int i = 0; i < SPEAKER_MIXER_VOICES; i++) {
+        low[i] = speaker->play_earcon(&speaker_earcon_reading_taken, SPEAKER_GAIN_UNITY / 4, SPEAKER_PRIORITY_LOW,
+                                      on_done);
+    }
+    CHECK(speaker->play_earcon(&speaker_earcon_reading_taken, SPEAKER_GAIN_UNITY / 4, SPEAKER_PRIORITY_HIGH,
+                               on_done) != SPEAKER_HANDLE_INVALID);
+    CHECK(wait_for([&] { return completions_count() == before + SPEAKER_MIXER_VOICES + 1; }, 2000));
+
+    std::lock_guard<std::mutex> guard(completions_lock);
+    for (size_t i = before; i < completions.size(); i++) {
+        CHECK(completions[i].played == (completions[i].handle != low[0]));
+    }
+    CHECK(completions[before].handle == low[0]);
+}
+
+static void test_underruns(Speaker* speaker) {
+    speaker_stats_t stats;
+    speaker->get_stats(&stats);
+    CHECK_EQ_INT(stats.driver.underruns, 0);
+    printf("%u buffers before the stall, render %.1f us per buffer on average, %u us at most\n",
+           (unsigned)stats.driver.buffers, (double)stats.render_us / (stats.driver.buffers ? stats.driver.buffers : 1),
+           (unsigned)stats.render_max_us);
+
+    // Over two trips round the ring with the task stuck in a callback
+    stall_ms = 300;
+    size_t before = completions_count();
+    speaker->play_earcon(&speaker_earcon_reading_taken, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_NORMAL, on_done);
+    CHECK(wait_for([&] { return completions_count() == before + 1 && stall_ms == 0; }, 2000));
+    vTaskDelay(pdMS_TO_TICKS(300));
+
+    speaker->get_stats(&stats);
+    printf("a 300 ms stall cost %u underruns\n", (unsigned)stats.driver.underruns);
+    CHECK(stats.driver.underruns >= 3);
+}
+
+static void test_switch_off(Speaker* speaker) {
+    size_t before = completions_count();
+    speaker_handle_t handle =
+        speaker->play_earcon(&speaker_earcon_reading_taken, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_NORMAL, on_done);
+    speaker->toggle_power();
+    CHECK(wait_for([&] { return completions_count() == before + 1; }, 2000));
+    {
+        std::lock_guard<std::mutex> guard(completions_lock);
+        CHECK(completions.back().handle == handle && !completions.back().played);
+    }
+
+    // The channel goes once the power-off sound has played, without waiting out the idle timeout
+    CHECK(wait_for([] {
+        std::lock_guard<std::mutex> guard(sim.lock);
+        return sim.deletes == 1;
+    }, 1500));
+
+    speaker_stats_t stats;
+    speaker->get_stats(&stats);
+    uint32_t rejects = stats.play_rejects;
+    CHECK(speaker->play_earcon(&speaker_earcon_reading_taken, SPEAKER_GAIN_UNITY, SPEAKER_PRIORITY_NORMAL, on_done) ==
+          SPEAKER_HANDLE_INVALID);
+    speaker->get_stats(&stats);
+    CHECK_EQ_INT(stats.play_rejects, rejects + 1);
+    CHECK_EQ_INT(completions_count(), before + 1);
+}
+
+int main() {
+    Speaker* speaker = Speaker::get_instance();
+    test_cold_start(speaker);
+    test_repower(speaker);
+    test_steal(speaker);
+    test_underruns(speaker);
+    test_switch_off(speaker);
+
+    std::lock_guard<std::mutex> guard(sim.lock);
+    CHECK_EQ_INT(sim.misuse, 0);
+    return host_test_result("speaker_driver");
+}